@@ -0,0 +1,953 @@
+/** @file    bench_main.cpp
+ *  @brief   The main program of a set of benchmarks which time the
+ *           firmware's busiest code on a PC.
+ *  @details Each benchmark calls one piece of the firmware over and over:
+ *           shares with and without other threads using them at the same
+ *           time, the listing of all shares, the statistics and rollup
+ *           filters, one pass of the heater controller, the MQTT task's JSON
+ *           encoder, the telemetry framer, the buffered file helpers, the
+ *           settings store and the compressed data log, whose flash regions
+ *           are image files, and the web server's rate limiter.
+ *           The code is the firmware's own, built for the PC with the
+ *           headers in @c sim/hal, so a change which makes it slower shows
+ *           up here even though the times aren't those of an ESP32.
+ *
+ *           A benchmark is run with more and more iterations until it takes
+ *           at least @c --min-ms, then timed @c BENCH_REPEATS times; the
+ *           fastest run is kept, as it's the one least disturbed by the rest
+ *           of the PC. The results are printed as JSON, which
+ *           @c tools/bench_compare.py compares between two commits. Some
+ *           benchmarks also report a figure of their own, such as how well
+ *           the data log compresses samples.
+ *
+ *           Usage: @c program [--filter TEXT] [--min-ms MS]
+ *
+ *           With @c --broker the benchmarks aren't run; instead the MQTT
+ *           task's messages are published to a real broker for a while and
+ *           its throughput is printed. See @c bench_mqtt.cpp.
+ *
+ *           Usage: @c program --broker HOST[:PORT] [--seconds S]
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <Arduino.h>
+#include <FS.h>
+#include <pthread.h>
+#include <time.h>
+#include "taskshare.h"
+#include "taskqueue.h"
+#include "baseshare.h"
+#include "sample.h"
+#include "stats.h"
+#include "rollup.h"
+#include "crc.h"
+#include "ringbuffer.h"
+#include "ratelimit.h"
+#include "fileio.h"
+#include "configstore.h"
+#include "tslog.h"
+#include "task_mqtt.h"
+#include "telemetry.h"
+#include "control.h"
+#include "bench_mqtt.h"
+
+
+/// Number of timed runs of each benchmark, of which the fastest is kept
+#define BENCH_REPEATS 5
+
+/// Bytes in the file written, read and copied by the file benchmarks
+#define BENCH_FILE_BYTES 4096
+
+/// Bytes in the buffers given to the file helpers, as the firmware uses
+#define BENCH_BUFFER_BYTES 512
+
+/// Largest number of figures of its own which a benchmark can report
+#define BENCH_METRICS 2
+
+/// Size of the settings store's region, as in @c partitions.csv
+#define BENCH_CONFIG_BYTES 0x10000
+
+/// Size of the data log's region, as in @c partitions.csv
+#define BENCH_LOG_BYTES 0x13E000
+
+/// Sizes of the smaller data logs in which seeking is timed
+#define BENCH_LOG_SMALL_BYTES 0x10000
+#define BENCH_LOG_MEDIUM_BYTES 0x40000
+
+
+/// Share to communicate the desired temperature setpoint
+Share<int16_t> desired_temp ("Temperature");
+
+/// Share to communicate the current temperature reading
+Share<int16_t> temp_reading ("Curr Temp");
+
+/// Share to communicate the thermocouple reading at full resolution
+Share<float> therm_temp ("Therm Temp");
+
+/// Share to communicate whether the heater is turned on
+Share<bool> heater_on ("Heater On");
+
+/// Share to communicate windowed statistics of the chamber's data
+Share<stats_snapshot_t> chamber_stats ("Statistics");
+
+/// Queue of samples for the logger; the sensor task isn't run here
+Queue<sample_t> log_queue (32, "Log Queue");
+
+/// Rate limits of the page and of @c /get, as in @c main_enviro.cpp
+static const route_limit_t bench_route_limits[] = { { 5, 10 }, { 1, 3 } };
+
+
+/// A benchmark, which runs its code a number of times
+typedef void (*bench_function_t) (uint32_t iterations);
+
+/** @brief   One benchmark and how to run it.
+ */
+struct bench_entry_t
+{
+    const char*      name;                    ///< Shown in the results
+    bench_function_t function;                ///< Runs the benchmark
+    uint8_t          threads;                 ///< Threads using it at once
+    const char*      metrics[BENCH_METRICS];  ///< Names of its own figures,
+                                              ///< @c NULL where it has none
+};
+
+
+/// Results are put here so that the compiler can't leave out the work
+static volatile uint32_t sink;
+
+/// A benchmark which has figures of its own puts them here
+static double bench_metrics[BENCH_METRICS];
+
+/// Set to stop the threads which make contention for a share
+static volatile bool stop_contention;
+
+/// Directory on the PC in which the file benchmarks' files are kept
+static char bench_directory[] = "/tmp/chamber_bench_XXXXXX";
+
+/// The file system used by the file benchmarks, inside @c bench_directory
+static FS bench_fs (bench_directory);
+
+/// A block of data for the file benchmarks
+static uint8_t file_data[BENCH_FILE_BYTES];
+
+/// The buffer given to the file helpers
+static uint8_t file_buffer[BENCH_BUFFER_BYTES + 1];
+
+/// Path of the settings store's image file, without its extension
+static char config_label[64];
+
+/// The flash region of the settings store, an image file in the directory
+static FlashRegion config_flash (config_label, BENCH_CONFIG_BYTES);
+
+/// The settings store which is written by the benchmarks
+static ConfigStore config (config_flash);
+
+/// Paths of the data logs' image files, without their extensions
+static char log_labels[3][64];
+
+/// Flash regions of the data logs, from small to the size of the partition
+static FlashRegion log_flash[3] =
+{
+    FlashRegion (log_labels[0], BENCH_LOG_SMALL_BYTES),
+    FlashRegion (log_labels[1], BENCH_LOG_MEDIUM_BYTES),
+    FlashRegion (log_labels[2], BENCH_LOG_BYTES)
+};
+
+/// Data logs which are filled once, then scanned and searched
+static TsLog data_logs[3] = { TsLog (log_flash[0]), TsLog (log_flash[1]),
+                              TsLog (log_flash[2]) };
+
+/// Set when each data log has been filled
+static bool log_filled[3];
+
+
+/** @brief   A printer which throws away what's printed, counting the bytes.
+ */
+class NullPrint : public Print
+{
+public:
+    size_t bytes = 0;                         ///< Bytes printed so far
+
+    using Print::write;
+
+    size_t write (uint8_t byte)
+    {
+        (void)byte;
+        bytes++;
+        return 1;
+    }
+    size_t write (const uint8_t* p_buffer, size_t size)
+    {
+        (void)p_buffer;
+        bytes += size;
+        return size;
+    }
+};
+
+
+/** @brief   Return the time from the PC's monotonic clock.
+ *  @return  The time in nanoseconds
+ */
+static uint64_t now_ns (void)
+{
+    struct timespec now;
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+
+/** @brief   Make a sample like those which the sensor task takes.
+ *  @param   index Which sample it is; they're 500 ms apart
+ *  @return  The sample
+ */
+static sample_t make_sample (uint32_t index)
+{
+    sample_t smp;
+    smp.time_ms = index * 500;
+    smp.temperature = 40.0f + 0.25f * (float)(index % 17) - 2.0f;
+    smp.setpoint = 40;
+    smp.heater_on = (index & 4) ? 1 : 0;
+    return smp;
+}
+
+
+/** @brief   Make a sample for the data log like those the logger adds.
+ *  @param   index Which sample it is; they're 500 ms apart
+ *  @return  The sample, timed as if the clock had been set
+ */
+static log_record_t make_record (uint32_t index)
+{
+    sample_t smp = make_sample (index);
+    log_record_t record;
+    record.time_ms = 1790000000000ULL + smp.time_ms;
+    record.temperature = smp.temperature;
+    record.setpoint = smp.setpoint;
+    record.heater_on = smp.heater_on;
+    return record;
+}
+
+
+/** @brief   Get one of the data logs, filling it the first time it's used.
+ *  @details The log is filled until every block has been written once, so
+ *           that it's as full as the logger would keep it.
+ *  @param   which Which log, 0 for the smallest
+ *  @return  Reference to the log
+ */
+static TsLog& filled_log (uint8_t which)
+{
+    TsLog& log = data_logs[which];
+    if (!log_filled[which])
+    {
+        log_filled[which] = true;
+        log.begin ();
+        uint32_t index = 0;
+        while (log.bytes () < (uint32_t)log.capacity () * TSLOG_BLOCK_SIZE)
+        {
+            log.append (make_record (index++));
+        }
+    }
+    return log;
+}
+
+
+/** @brief   Put a reading in a share and get it back.
+ */
+static void bench_share_float (uint32_t iterations)
+{
+    float value = 0.0f;
+    for (uint32_t count = 0; count < iterations; count++)
+    {
+        therm_temp.put ((float)count);
+        therm_temp.get (value);
+    }
+    sink = (uint32_t)value;
+}
+
+
+/** @brief   Put a statistics snapshot, 100's of bytes, in a share and get it
+ *           back.
+ */
+static void bench_share_snapshot (uint32_t iterations)
+{
+    stats_snapshot_t snapshot;
+    memset (&snapshot, 0, sizeof (snapshot));
+    for (uint32_t count = 0; count < iterations; count++)
+    {
+        snapshot.time_ms = count;
+        chamber_stats.put (snapshot);
+        chamber_stats.get (snapshot);
+    }
+    sink = snapshot.time_ms;
+}
+
+
+/** @brief   Thread which keeps using a share until told to stop, so that a
+ *           benchmark running at the same time finds it busy.
+ *  @param   p_arg Not used
+ *  @return  @c NULL
+ */
+static void* contend (void* p_arg)
+{
+    (void)p_arg;
+    float value = 0.0f;
+    while (!stop_contention)
+    {
+        therm_temp.put (value + 1.0f);
+        therm_temp.get (value);
+    }
+    return NULL;
+}
+
+
+/** @brief   List all the shares, as the web page's diagnostics do.
+ */
+static void bench_print_all_shares (uint32_t iterations)
+{
+    NullPrint printer;
+    for (uint32_t count = 0; count < iterations; count++)
+    {
+        print_all_shares (printer);
+    }
+    sink = printer.bytes;
+}
+
+
+/** @brief   Add a sample to the sliding window statistics.
+ */
+static void bench_stats_add (uint32_t iterations)
+{
+    static uint32_t index = 0;
+    for (uint32_t count = 0; count < iterations; count++)
+    {
+        stats_add_sample (make_sample (index++));
+    }
+}
+
+
+/** @brief   Add a sample to the minute, hour and day rollups.
+ */
+static void bench_rollup_add (uint32_t iterations)
+{
+    static uint32_t index = 0;
+    for (uint32_t count = 0; count < iterations; count++)
+    {
+        rollup_add_sample (make_sample (index++));
+    }
+}
+
+
+/** @brief   Find the CRC-32 of a telemetry frame's worth of data.
+ */
+static void bench_crc32 (uint32_t iterations)
+{
+    uint32_t crc = 0;
+    for (uint32_t count = 0; count < iterations; count++)
+    {
+        crc = crc32 (file_data, sizeof (telemetry_record_t), crc);
+    }
+    sink = crc;
+}
+
+
+/** @brief   Run the heater controller once, readings going up and down
+ *           through the setpoint so that the heater switches.
+ */
+static void bench_control_step (uint32_t iterations)
+{
+    uint32_t on = 0;
+    desired_temp.put (40);
+    for (uint32_t count = 0; count < iterations; count++)
+    {
+        temp_reading.put ((int16_t)(25 + (count & 15)));
+        on += control_step () ? 1 : 0;
+    }
+    sink = on;
+}
+
+
+/** @brief   Encode a whole batch of samples as a JSON message for MQTT.
+ */
+static void bench_mqtt_json (uint32_t iterations)
+{
+    sample_t samples[MQTT_BATCH_SIZE];
+    char message[MQTT_PACKET_SIZE];
+    size_t length = 0;
+
+    for (uint16_t index = 0; index < MQTT_BATCH_SIZE; index++)
+    {
+        samples[index] = make_sample (index);
+    }
+    for (uint32_t count = 0; count < iterations; count++)
+    {
+        length += mqtt_encode_batch (message, sizeof (message), samples,
+                                     MQTT_BATCH_SIZE);
+    }
+    sink = (uint32_t)length;
+}
+
+
+/** @brief   Put a batch of samples into the MQTT task's ring buffer, then
+ *           take them out and encode them as the task does when publishing;
+ *           the figures are messages and bytes per second.
+ */
+static void bench_mqtt_pipeline (uint32_t iterations)
+{
+    static RingBuffer<sample_t, MQTT_BUFFER_SAMPLES> ring;
+    static uint32_t index = 0;
+    sample_t batch[MQTT_BATCH_SIZE];
+    char message[MQTT_PACKET_SIZE];
+    uint64_t bytes = 0;
+    uint64_t started = now_ns ();
+
+    for (uint32_t count = 0; count < iterations; count++)
+    {
+        for (uint16_t sample = 0; sample < MQTT_BATCH_SIZE; sample++)
+        {
+            ring.put (make_sample (index++));
+        }
+        uint16_t how_many = ring.available ();
+        how_many = (how_many < MQTT_BATCH_SIZE) ? how_many : MQTT_BATCH_SIZE;
+        for (uint16_t sample = 0; sample < how_many; sample++)
+        {
+            batch[sample] = ring.peek (sample);
+        }
+        bytes += mqtt_encode_batch (message, sizeof (message), batch,
+                                    how_many);
+        ring.discard (how_many);
+    }
+    double seconds = (now_ns () - started) / 1e9;
+    bench_metrics[0] = seconds > 0.0 ? iterations / seconds : 0.0;
+    bench_metrics[1] = seconds > 0.0 ? bytes / seconds : 0.0;
+    sink = (uint32_t)bytes;
+}
+
+
+/** @brief   Frame a telemetry record for the serial port.
+ */
+static void bench_telemetry_frame (uint32_t iterations)
+{
+    telemetry_record_t record = { TELEMETRY_SAMPLE, 1, 0, 0, 39.5f, 40, 0 };
+    uint8_t frame[TELEMETRY_MAX_FRAME];
+    size_t length = 0;
+
+    for (uint32_t count = 0; count < iterations; count++)
+    {
+        record.sequence = (uint16_t)count;
+        record.time_us = count * 10000;
+        length += telemetry_frame (record, frame);
+    }
+    sink = (uint32_t)length;
+}
+
+
+/** @brief   Write a block of data as a whole file.
+ */
+static void bench_write_file (uint32_t iterations)
+{
+    for (uint32_t count = 0; count < iterations; count++)
+    {
+        sink = write_file (bench_fs, "/block.bin", file_data,
+                           sizeof (file_data));
+    }
+}
+
+
+/** @brief   Read a whole file one character at a time into a @c String, as
+ *           the web page's file reader did before the file helpers; this is
+ *           the baseline for @c read_file_4k.
+ */
+static void bench_read_file_string (uint32_t iterations)
+{
+    for (uint32_t count = 0; count < iterations; count++)
+    {
+        File file = bench_fs.open ("/block.bin", "r");
+        String content;
+        while (file.available ())
+        {
+            content += String ((char)file.read ());
+        }
+        sink = content.length ();
+    }
+}
+
+
+/** @brief   Read a whole file through a buffer.
+ */
+static void bench_read_file (uint32_t iterations)
+{
+    for (uint32_t count = 0; count < iterations; count++)
+    {
+        text_view_t text = read_file (bench_fs, "/block.bin",
+                                      (char*)file_buffer, sizeof (file_buffer));
+        sink = text.length;
+    }
+}
+
+
+/** @brief   Copy a file through a buffer.
+ */
+static void bench_copy_file (uint32_t iterations)
+{
+    for (uint32_t count = 0; count < iterations; count++)
+    {
+        sink = copy_file (bench_fs, "/block.bin", bench_fs, "/copy.bin",
+                          file_buffer, BENCH_BUFFER_BYTES);
+    }
+}
+
+
+/** @brief   Print lines of CSV to a file through a @c FileWriter, as the
+ *           logger does; each iteration is one line.
+ */
+static void bench_file_writer (uint32_t iterations)
+{
+    FileWriter writer (file_buffer, BENCH_BUFFER_BYTES);
+    if (!writer.open (bench_fs, "/log.csv", "w"))
+    {
+        return;
+    }
+    for (uint32_t count = 0; count < iterations; count++)
+    {
+        sample_t smp = make_sample (count);
+        writer.printf ("%lu,%.2f,%d,%u\n", (unsigned long)smp.time_ms,
+                       (double)smp.temperature, smp.setpoint, smp.heater_on);
+    }
+    writer.close ();
+    sink = writer.good ();
+}
+
+
+/** @brief   Save a changed setting in the store; each iteration is one
+ *           record, and now and then a sector is erased and compacted.
+ */
+static void bench_config_put (uint32_t iterations)
+{
+    static int32_t value = 0;
+    for (uint32_t count = 0; count < iterations; count++)
+    {
+        sink = config.put_int (CONFIG_SETPOINT + (count & 3), ++value);
+    }
+}
+
+
+/** @brief   Load the settings store as at startup, reading every sector.
+ */
+static void bench_config_begin (uint32_t iterations)
+{
+    for (uint32_t count = 0; count < iterations; count++)
+    {
+        ConfigStore store (config_flash);
+        sink = store.begin ();
+    }
+}
+
+
+/** @brief   Encode a sample into a data log block; the figure is how many
+ *           times smaller the encoded samples are than raw ones.
+ */
+static void bench_tslog_encode (uint32_t iterations)
+{
+    static uint8_t payload[TSLOG_PAYLOAD_SIZE];
+    TsEncoder encoder;
+    uint32_t index = 0;
+    uint64_t bits = 0;
+
+    encoder.begin (payload, sizeof (payload));
+    for (uint32_t count = 0; count < iterations; count++)
+    {
+        if (!encoder.add (make_record (index++)))
+        {
+            bits += encoder.bits ();
+            encoder.begin (payload, sizeof (payload));
+            encoder.add (make_record (index - 1));
+        }
+    }
+    bits += encoder.bits ();
+    bench_metrics[0] = bits ? (double)iterations * sizeof (sample_t) * 8
+                              / bits : 0.0;
+    sink = (uint32_t)bits;
+}
+
+
+/// Called with each sample found when scanning the data log
+static void count_record (const log_record_t& record, void* p_count)
+{
+    *(uint32_t*)p_count += record.heater_on;
+}
+
+
+/** @brief   Decode every sample in a data log the size of its partition,
+ *           read in place through the mapping; the figure is MB per second.
+ */
+static void bench_tslog_scan (uint32_t iterations)
+{
+    TsLog& log = filled_log (2);
+    uint32_t heated = 0;
+    uint64_t started = now_ns ();
+
+    for (uint32_t count = 0; count < iterations; count++)
+    {
+        log.query (0, UINT64_MAX, count_record, &heated);
+    }
+    double seconds = (now_ns () - started) / 1e9;
+    bench_metrics[0] = (double)iterations * log.capacity ()
+                       * TSLOG_BLOCK_SIZE / 1048576.0 / seconds;
+    sink = heated;
+}
+
+
+/** @brief   Seek to a time in a full data log and read the first sample
+ *           there, as the web page's history download does.
+ *  @details Reading the first sample checks and starts to decode a block,
+ *           which takes the same time whatever the size of the log, so the
+ *           seek can also be timed without it to show the index search alone.
+ *  @param   which Which log, 0 for the smallest
+ *  @param   read_first @c true to read the first sample after each seek
+ *  @param   iterations The number of seeks
+ */
+static void seek_log (uint8_t which, bool read_first, uint32_t iterations)
+{
+    TsLog& log = filled_log (which);
+    tslog_cursor_t cursor;
+    log_record_t record;
+    uint64_t first_ms = make_record (0).time_ms;
+    uint64_t span_ms = (uint64_t)log.samples () * 500;
+    uint32_t found = 0;
+
+    for (uint32_t count = 0; count < iterations; count++)
+    {
+        // Spread the times over the log so that caches don't flatter it
+        uint64_t from_ms = first_ms + (count * 2654435761UL) % span_ms;
+        log.seek (cursor, from_ms, UINT64_MAX);
+        if (read_first)
+        {
+            found += log.next (cursor, record) ? 1 : 0;
+        }
+        else
+        {
+            found += cursor.block;
+        }
+    }
+    sink = found;
+}
+
+
+/** @brief   Seek in a data log of 64 KB.
+ */
+static void bench_tslog_seek_small (uint32_t iterations)
+{
+    seek_log (0, true, iterations);
+}
+
+
+/** @brief   Seek in a data log of 256 KB.
+ */
+static void bench_tslog_seek_medium (uint32_t iterations)
+{
+    seek_log (1, true, iterations);
+}
+
+
+/** @brief   Seek in a data log the size of its partition.
+ */
+static void bench_tslog_seek_full (uint32_t iterations)
+{
+    seek_log (2, true, iterations);
+}
+
+
+/** @brief   Search the index of a data log of 64 KB, without reading.
+ */
+static void bench_tslog_find_small (uint32_t iterations)
+{
+    seek_log (0, false, iterations);
+}
+
+
+/** @brief   Search the index of a data log of 256 KB, without reading.
+ */
+static void bench_tslog_find_medium (uint32_t iterations)
+{
+    seek_log (1, false, iterations);
+}
+
+
+/** @brief   Search the index of a data log the size of its partition,
+ *           without reading.
+ */
+static void bench_tslog_find_full (uint32_t iterations)
+{
+    seek_log (2, false, iterations);
+}
+
+
+/** @brief   Check web requests with the rate limiter as a flood of them
+ *           comes in, 100 each millisecond; the figure is the percentage
+ *           which were admitted.
+ *  @param   clients The number of addresses from which the requests come
+ *  @param   iterations The number of requests
+ */
+static void admit_from (uint32_t clients, uint32_t iterations)
+{
+    RateLimiter limiter (bench_route_limits, 2, 4);
+    uint32_t admitted = 0;
+
+    for (uint32_t count = 0; count < iterations; count++)
+    {
+        uint32_t client = 0x0A000000UL + (count * 2654435761UL) % clients;
+        uint8_t route = (count >> 4) & 1;
+        if (limiter.admit (client, route, count / 100) == RATE_LIMIT_OK)
+        {
+            admitted++;
+            limiter.release ();
+        }
+    }
+    bench_metrics[0] = iterations ? admitted * 100.0 / iterations : 0.0;
+    sink = admitted;
+}
+
+
+/** @brief   Check requests from one client, whose bucket is found at once.
+ */
+static void bench_admit_1 (uint32_t iterations)
+{
+    admit_from (1, iterations);
+}
+
+
+/** @brief   Check requests from as many clients as fill the limiter's
+ *           buckets, each using both routes.
+ */
+static void bench_admit_slots (uint32_t iterations)
+{
+    admit_from (RATE_LIMIT_SLOTS / 2, iterations);
+}
+
+
+/** @brief   Check requests from many more clients than there are buckets,
+ *           so that every request has to search them all and reuse one.
+ */
+static void bench_admit_1024 (uint32_t iterations)
+{
+    admit_from (1024, iterations);
+}
+
+
+/// The benchmarks, in the order in which they're run
+static const bench_entry_t bench_table[] =
+{
+//    Name                     Function                 Threads Metrics
+    { "share_put_get",         bench_share_float,       1, { NULL } },
+    { "share_put_get_2_busy",  bench_share_float,       2, { NULL } },
+    { "share_put_get_4_busy",  bench_share_float,       4, { NULL } },
+    { "share_snapshot",        bench_share_snapshot,    1, { NULL } },
+    { "print_all_shares",      bench_print_all_shares,  1, { NULL } },
+    { "stats_add_sample",      bench_stats_add,         1, { NULL } },
+    { "rollup_add_sample",     bench_rollup_add,        1, { NULL } },
+    { "crc32_record",          bench_crc32,             1, { NULL } },
+    { "control_step",          bench_control_step,      1, { NULL } },
+    { "mqtt_encode_batch",     bench_mqtt_json,         1, { NULL } },
+    { "mqtt_pipeline",         bench_mqtt_pipeline,     1, { "msgs_per_s",
+                                                             "bytes_per_s" } },
+    { "telemetry_frame",       bench_telemetry_frame,   1, { NULL } },
+    { "write_file_4k",         bench_write_file,        1, { NULL } },
+    { "read_file_string_4k",   bench_read_file_string,  1, { NULL } },
+    { "read_file_4k",          bench_read_file,         1, { NULL } },
+    { "copy_file_4k",          bench_copy_file,         1, { NULL } },
+    { "file_writer_line",      bench_file_writer,       1, { NULL } },
+    { "config_put",            bench_config_put,        1, { NULL } },
+    { "config_begin",          bench_config_begin,      1, { NULL } },
+    { "tslog_encode",          bench_tslog_encode,      1, { "ratio" } },
+    { "tslog_scan_full",       bench_tslog_scan,        1, { "mb_per_s" } },
+    { "tslog_seek_64k",        bench_tslog_seek_small,  1, { NULL } },
+    { "tslog_seek_256k",       bench_tslog_seek_medium, 1, { NULL } },
+    { "tslog_seek_full",       bench_tslog_seek_full,   1, { NULL } },
+    { "tslog_find_64k",        bench_tslog_find_small,  1, { NULL } },
+    { "tslog_find_256k",       bench_tslog_find_medium, 1, { NULL } },
+    { "tslog_find_full",       bench_tslog_find_full,   1, { NULL } },
+    { "rate_admit_1_client",   bench_admit_1,           1, { "admitted_pct" } },
+    { "rate_admit_8_clients",  bench_admit_slots,       1, { "admitted_pct" } },
+    { "rate_admit_1k_clients", bench_admit_1024,        1, { "admitted_pct" } },
+};
+
+
+/** @brief   Time one benchmark.
+ *  @details Other threads, if any, use the same share as the benchmark for
+ *           as long as it runs, so that it finds the share's lock busy.
+ *  @param   entry The benchmark
+ *  @param   min_ns The shortest time for which a timed run should last
+ *  @param   iterations Set to the number of iterations in each timed run
+ *  @return  The time taken by one iteration in the fastest run, in ns; the
+ *           benchmark's own figures from that run are left in @c bench_metrics
+ */
+static double run_benchmark (const bench_entry_t& entry, uint64_t min_ns,
+                             uint32_t& iterations)
+{
+    pthread_t others[8];
+    uint8_t other_count = entry.threads - 1;
+
+    stop_contention = false;
+    for (uint8_t index = 0; index < other_count; index++)
+    {
+        pthread_create (&others[index], NULL, contend, NULL);
+    }
+
+    // A run of no iterations does any setup, such as filling a data log
+    entry.function (0);
+
+    // Find how many iterations take long enough to be timed well
+    uint64_t elapsed = 0;
+    for (iterations = 1; ; iterations *= 2)
+    {
+        uint64_t started = now_ns ();
+        entry.function (iterations);
+        elapsed = now_ns () - started;
+        if (elapsed >= min_ns || iterations >= 0x40000000UL)
+        {
+            break;
+        }
+    }
+
+    double best = (double)elapsed / iterations;
+    double best_metrics[BENCH_METRICS];
+    memcpy (best_metrics, bench_metrics, sizeof (best_metrics));
+    for (uint8_t run = 0; run < BENCH_REPEATS; run++)
+    {
+        uint64_t started = now_ns ();
+        entry.function (iterations);
+        double per_op = (double)(now_ns () - started) / iterations;
+        if (per_op < best)
+        {
+            best = per_op;
+            memcpy (best_metrics, bench_metrics, sizeof (best_metrics));
+        }
+    }
+    memcpy (bench_metrics, best_metrics, sizeof (bench_metrics));
+
+    stop_contention = true;
+    for (uint8_t index = 0; index < other_count; index++)
+    {
+        pthread_join (others[index], NULL);
+    }
+    return best;
+}
+
+
+/** @brief   Run the benchmarks and print their results as JSON.
+ *  @param   argc The number of words on the command line
+ *  @param   argv The words on the command line
+ *  @return  0 if the benchmarks or the publishing ran, 1 if they couldn't
+ */
+int main (int argc, char** argv)
+{
+    const char* p_filter = NULL;
+    uint32_t min_ms = 100;
+    char* p_broker = NULL;
+    uint32_t seconds = 10;
+
+    for (int index = 1; index < argc; index++)
+    {
+        if (strcmp (argv[index], "--filter") == 0 && index + 1 < argc)
+        {
+            p_filter = argv[++index];
+        }
+        else if (strcmp (argv[index], "--min-ms") == 0 && index + 1 < argc)
+        {
+            min_ms = strtoul (argv[++index], NULL, 0);
+        }
+        else if (strcmp (argv[index], "--broker") == 0 && index + 1 < argc)
+        {
+            p_broker = argv[++index];
+        }
+        else if (strcmp (argv[index], "--seconds") == 0 && index + 1 < argc)
+        {
+            seconds = strtoul (argv[++index], NULL, 0);
+        }
+        else
+        {
+            fprintf (stderr, "Usage: %s [--filter TEXT] [--min-ms MS]\n"
+                     "       %s --broker HOST[:PORT] [--seconds S]\n",
+                     argv[0], argv[0]);
+            return 1;
+        }
+    }
+    if (p_broker != NULL)
+    {
+        char* p_port = strrchr (p_broker, ':');
+        uint16_t port = MQTT_PORT;
+        if (p_port != NULL)
+        {
+            *p_port++ = '\0';
+            port = (uint16_t)strtoul (p_port, NULL, 10);
+        }
+        return bench_mqtt_publish (p_broker, port, seconds);
+    }
+    if (mkdtemp (bench_directory) == NULL)
+    {
+        perror (bench_directory);
+        return 1;
+    }
+
+    for (size_t index = 0; index < sizeof (file_data); index++)
+    {
+        file_data[index] = (uint8_t)(' ' + index % 95);
+    }
+    write_file (bench_fs, "/block.bin", file_data, sizeof (file_data));
+    snprintf (config_label, sizeof (config_label), "%s/config",
+              bench_directory);
+    config.begin ();
+    for (uint8_t which = 0; which < 3; which++)
+    {
+        snprintf (log_labels[which], sizeof (log_labels[which]),
+                  "%s/tslog%u", bench_directory, which);
+    }
+    desired_temp.put (40);
+    temp_reading.put (38);
+    therm_temp.put (38.0f);
+    heater_on.put (false);
+    HeaterPin::begin ();
+
+    printf ("{\n  \"board\": \"%s\",\n  \"compiler\": \"%s\",\n"
+            "  \"benchmarks\": [", board.name, __VERSION__);
+    const char* p_separator = "\n";
+    for (const bench_entry_t& entry : bench_table)
+    {
+        if (p_filter != NULL && strstr (entry.name, p_filter) == NULL)
+        {
+            continue;
+        }
+        uint32_t iterations;
+        double ns_per_op = run_benchmark (entry, min_ms * 1000000ULL,
+                                          iterations);
+        printf ("%s    { \"name\": \"%s\", \"threads\": %u, "
+                "\"iterations\": %lu, \"ns_per_op\": %.2f", p_separator,
+                entry.name, entry.threads, (unsigned long)iterations,
+                ns_per_op);
+        for (uint8_t which = 0; which < BENCH_METRICS; which++)
+        {
+            if (entry.metrics[which] != NULL)
+            {
+                printf (", \"%s\": %.2f", entry.metrics[which],
+                        bench_metrics[which]);
+            }
+        }
+        printf (" }");
+        fflush (stdout);
+        p_separator = ",\n";
+    }
+    printf ("\n  ]\n}\n");
+
+    bench_fs.remove ("/block.bin");
+    bench_fs.remove ("/copy.bin");
+    bench_fs.remove ("/log.csv");
+    bench_fs.remove ("/config.img");
+    for (uint8_t which = 0; which < 3; which++)
+    {
+        char path[16];
+        snprintf (path, sizeof (path), "/tslog%u.img", which);
+        bench_fs.remove (path);
+    }
+    rmdir (bench_directory);
+    return 0;
+}
@@ -0,0 +1,280 @@
+/** @file    bench_mqtt.cpp
+ *  @brief   A harness which publishes the MQTT task's messages to a real
+ *           broker from a PC.
+ *  @details Samples go through the same ring buffer and JSON encoder as in
+ *           the MQTT task and are published to @c MQTT_TOPIC_BASE/samples
+ *           with QoS 0, as fast as the broker takes them. The few MQTT 3.1.1
+ *           packets needed are written here on a plain socket, so that
+ *           nothing but a broker such as Mosquitto is needed:
+ *
+ *           @code
+ *           mosquitto -p 1883 &
+ *           .pio/build/bench/program --broker localhost:1883 --seconds 10
+ *           @endcode
+ *
+ *           At the end a ping is sent and its answer awaited, so the time
+ *           includes the broker's handling of every message. The results are
+ *           printed as JSON in messages and bytes of payload per second.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "ringbuffer.h"
+#include "task_mqtt.h"
+#include "bench_mqtt.h"
+
+
+/// MQTT packet types, in the top four bits of a packet's first byte
+#define MQTT_CONNECT    0x10
+#define MQTT_CONNACK    0x20
+#define MQTT_PUBLISH    0x30
+#define MQTT_PINGREQ    0xC0
+#define MQTT_PINGRESP   0xD0
+#define MQTT_DISCONNECT 0xE0
+
+/// Topic to which the samples are published, as by the MQTT task
+#define BENCH_MQTT_TOPIC MQTT_TOPIC_BASE "/samples"
+
+
+/** @brief   Return the time from the PC's monotonic clock.
+ *  @return  The time in nanoseconds
+ */
+static uint64_t mqtt_now_ns (void)
+{
+    struct timespec now;
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+
+/** @brief   Write the fixed header of an MQTT packet.
+ *  @param   p_packet Pointer to where the header goes; 5 bytes are enough
+ *  @param   type The first byte, which holds the packet type
+ *  @param   remaining The number of bytes in the packet after this header
+ *  @return  The number of bytes in the header
+ */
+static size_t put_fixed_header (uint8_t* p_packet, uint8_t type,
+                                uint32_t remaining)
+{
+    size_t length = 0;
+    p_packet[length++] = type;
+    do
+    {
+        uint8_t digit = remaining & 0x7F;
+        remaining >>= 7;
+        p_packet[length++] = digit | (remaining ? 0x80 : 0);
+    }
+    while (remaining > 0);
+    return length;
+}
+
+
+/** @brief   Write a string as MQTT does, with its length in front.
+ *  @param   p_packet Pointer to where the string goes
+ *  @param   p_text The string
+ *  @return  The number of bytes written
+ */
+static size_t put_string (uint8_t* p_packet, const char* p_text)
+{
+    size_t length = strlen (p_text);
+    p_packet[0] = (uint8_t)(length >> 8);
+    p_packet[1] = (uint8_t)length;
+    memcpy (p_packet + 2, p_text, length);
+    return length + 2;
+}
+
+
+/** @brief   Send all of a buffer through a socket.
+ *  @param   sock The socket
+ *  @param   p_data Pointer to the data
+ *  @param   length The number of bytes to send
+ *  @return  @c true if everything was sent, @c false if the socket failed
+ */
+static bool send_all (int sock, const uint8_t* p_data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t sent = send (sock, p_data, length, MSG_NOSIGNAL);
+        if (sent <= 0)
+        {
+            return false;
+        }
+        p_data += sent;
+        length -= sent;
+    }
+    return true;
+}
+
+
+/** @brief   Wait for a short packet of a given type from the broker.
+ *  @param   sock The socket
+ *  @param   type The packet type expected
+ *  @return  @c true if the packet came, @c false if something else did
+ */
+static bool await_packet (int sock, uint8_t type)
+{
+    uint8_t header[2];
+    uint8_t body[8];
+    if (recv (sock, header, 2, MSG_WAITALL) != 2 || header[1] > sizeof (body)
+        || (header[1] > 0
+            && recv (sock, body, header[1], MSG_WAITALL) != header[1]))
+    {
+        return false;
+    }
+    return (header[0] & 0xF0) == type
+           && (type != MQTT_CONNACK || (header[1] == 2 && body[1] == 0));
+}
+
+
+/** @brief   Connect to the broker and open an MQTT session.
+ *  @param   p_host The broker's host name or address
+ *  @param   port The broker's TCP port
+ *  @return  The socket, or -1 if the broker couldn't be reached
+ */
+static int mqtt_open (const char* p_host, uint16_t port)
+{
+    char service[8];
+    struct addrinfo hints;
+    struct addrinfo* p_addresses;
+
+    memset (&hints, 0, sizeof (hints));
+    hints.ai_socktype = SOCK_STREAM;
+    snprintf (service, sizeof (service), "%u", port);
+    if (getaddrinfo (p_host, service, &hints, &p_addresses) != 0)
+    {
+        return -1;
+    }
+    int sock = -1;
+    for (struct addrinfo* p_addr = p_addresses; p_addr != NULL && sock < 0;
+         p_addr = p_addr->ai_next)
+    {
+        sock = socket (p_addr->ai_family, p_addr->ai_socktype,
+                       p_addr->ai_protocol);
+        if (sock >= 0 && connect (sock, p_addr->ai_addr,
+                                  p_addr->ai_addrlen) != 0)
+        {
+            close (sock);
+            sock = -1;
+        }
+    }
+    freeaddrinfo (p_addresses);
+    if (sock < 0)
+    {
+        return -1;
+    }
+
+    // Protocol name and level, a clean session and a keepalive of 60 s
+    static const uint8_t connect_header[] =
+        { 0, 4, 'M', 'Q', 'T', 'T', 4, 0x02, 0, 60 };
+    uint8_t packet[64];
+    uint8_t body[48];
+    memcpy (body, connect_header, sizeof (connect_header));
+    size_t length = sizeof (connect_header);
+    length += put_string (body + length, MQTT_CLIENT_ID "-bench");
+    size_t header = put_fixed_header (packet, MQTT_CONNECT, length);
+    memcpy (packet + header, body, length);
+
+    if (!send_all (sock, packet, header + length)
+        || !await_packet (sock, MQTT_CONNACK))
+    {
+        close (sock);
+        return -1;
+    }
+    return sock;
+}
+
+
+/** @brief   Publish batches of samples to a broker as fast as it takes them.
+ *  @details Each pass puts a batch of samples, 500 ms apart as the MQTT task
+ *           takes them, into a ring buffer, then takes them out, encodes
+ *           them and publishes them, just as the task does.
+ *  @param   p_host The broker's host name or address
+ *  @param   port The broker's TCP port
+ *  @param   seconds How long to keep publishing
+ *  @return  0 if all went well, 1 if the broker couldn't be reached or
+ *           dropped the connection
+ */
+int bench_mqtt_publish (const char* p_host, uint16_t port, uint32_t seconds)
+{
+    static RingBuffer<sample_t, MQTT_BUFFER_SAMPLES> ring;
+    static uint8_t packet[8 + sizeof (BENCH_MQTT_TOPIC) + MQTT_PACKET_SIZE];
+    char message[MQTT_PACKET_SIZE];
+    sample_t batch[MQTT_BATCH_SIZE];
+    uint32_t index = 0;
+    uint32_t messages = 0;
+    uint64_t bytes = 0;
+
+    int sock = mqtt_open (p_host, port);
+    if (sock < 0)
+    {
+        fprintf (stderr, "Can't open an MQTT session with %s:%u\n", p_host,
+                 port);
+        return 1;
+    }
+
+    bool all_ok = true;
+    uint64_t started = mqtt_now_ns ();
+    uint64_t stop = started + seconds * 1000000000ULL;
+    while (mqtt_now_ns () < stop)
+    {
+        for (uint16_t sample = 0; sample < MQTT_BATCH_SIZE; sample++)
+        {
+            sample_t smp;
+            smp.time_ms = index * MQTT_SAMPLE_MS;
+            smp.temperature = 38.0f + 0.25f * (float)(index % 17);
+            smp.setpoint = 40;
+            smp.heater_on = (index & 4) ? 1 : 0;
+            ring.put (smp);
+            index++;
+        }
+        uint16_t how_many = ring.available ();
+        how_many = (how_many < MQTT_BATCH_SIZE) ? how_many : MQTT_BATCH_SIZE;
+        for (uint16_t sample = 0; sample < how_many; sample++)
+        {
+            batch[sample] = ring.peek (sample);
+        }
+        size_t length = mqtt_encode_batch (message, sizeof (message), batch,
+                                           how_many);
+
+        uint8_t topic[sizeof (BENCH_MQTT_TOPIC) + 2];
+        size_t topic_length = put_string (topic, BENCH_MQTT_TOPIC);
+        size_t header = put_fixed_header (packet, MQTT_PUBLISH,
+                                          topic_length + length);
+        memcpy (packet + header, topic, topic_length);
+        memcpy (packet + header + topic_length, message, length);
+        if (length == 0
+            || !send_all (sock, packet, header + topic_length + length))
+        {
+            all_ok = false;
+            break;
+        }
+
+        // As in the task, samples only leave the ring once they're sent
+        ring.discard (how_many);
+        messages++;
+        bytes += length;
+    }
+
+    // The broker answers a ping after it has handled everything before it
+    static const uint8_t ping[] = { MQTT_PINGREQ, 0 };
+    static const uint8_t disconnect[] = { MQTT_DISCONNECT, 0 };
+    all_ok = all_ok && send_all (sock, ping, sizeof (ping))
+             && await_packet (sock, MQTT_PINGRESP);
+    double elapsed = (mqtt_now_ns () - started) / 1e9;
+    send_all (sock, disconnect, sizeof (disconnect));
+    close (sock);
+
+    printf ("{ \"broker\": \"%s:%u\", \"topic\": \"%s\", \"messages\": %lu, "
+            "\"bytes\": %llu, \"seconds\": %.3f, \"msgs_per_s\": %.2f, "
+            "\"bytes_per_s\": %.2f, \"ok\": %s }\n", p_host, port,
+            BENCH_MQTT_TOPIC, (unsigned long)messages,
+            (unsigned long long)bytes, elapsed, messages / elapsed,
+            bytes / elapsed, all_ok ? "true" : "false");
+    return all_ok ? 0 : 1;
+}
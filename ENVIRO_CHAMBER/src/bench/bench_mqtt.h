@@ -0,0 +1,19 @@
+/** @file    bench_mqtt.h
+ *  @brief   Headers for a harness which publishes the MQTT task's messages to
+ *           a real broker from a PC.
+ *  @details See @c bench_mqtt.cpp for how the messages are made and sent.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _BENCH_MQTT_H_
+#define _BENCH_MQTT_H_
+
+#include <stdint.h>
+
+
+// Publish batches of samples to a broker as fast as it takes them
+int bench_mqtt_publish (const char* p_host, uint16_t port, uint32_t seconds);
+
+#endif // _BENCH_MQTT_H_
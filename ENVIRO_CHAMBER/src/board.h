@@ -0,0 +1,82 @@
+/** @file    board.h
+ *  @brief   Descriptions of the circuit boards on which the chamber's
+ *           controller runs.
+ *  @details Each board is described by a @c constexpr @c board_t, and the
+ *           one which is built is chosen by a define in @c platformio.ini:
+ *           - @c BOARD_CHAMBER_V2 for the second board layout (the
+ *             @c chamber_v2 environment)
+ *           - Otherwise the original Feather board on an ESP32, or the
+ *             simulated board on a PC
+ *
+ *           Because @c board is a compile time constant, its pin numbers can
+ *           be given to the pin templates in @c gpio.h, which then turn into
+ *           register writes for just that pin. Adding a board means adding a
+ *           @c board_t here and an environment which defines its name.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _BOARD_H_
+#define _BOARD_H_
+
+#include <stdint.h>
+
+
+/// Number of thermocouple amplifiers for which a board has chip selects
+#define BOARD_NUM_THERMOCOUPLES 3
+
+
+/** @brief   The pins and settings which differ from one board to another.
+ */
+struct board_t
+{
+    const char* name;                         ///< Printed at startup
+    uint8_t drdy_pin;                         ///< Thermocouple data ready
+    uint8_t cs_pins[BOARD_NUM_THERMOCOUPLES]; ///< Thermocouple chip selects
+    uint8_t heater_pin;                       ///< Turns the heater on
+    uint8_t sck_pin;                          ///< SPI clock
+    uint8_t sdo_pin;                          ///< SPI data out of the chip
+    uint8_t sdi_pin;                          ///< SPI data into the chip
+    int16_t threshold;                        ///< Heat if this far below, C
+};
+
+
+/// The original board, a Feather ESP32 wired to one MAX31856
+constexpr board_t board_feather =
+{
+    "Feather", 25, { 4, 5, 6 }, 27, 30, 31, 37, 10
+};
+
+/// The second board layout, which puts the MAX31856's on the VSPI pins
+constexpr board_t board_chamber_v2 =
+{
+    "Chamber v2", 34, { 15, 32, 33 }, 26, 18, 19, 23, 10
+};
+
+/** @brief   A board which exists only in simulation, for builds on a PC.
+ *  @details Pin levels are kept in @c gpio_sim_level[]; the simulated
+ *           thermocouple drives the data ready pin and the simulated chamber
+ *           reads the heater pin. The numbers match the Feather board so that
+ *           traces from both can be compared.
+ */
+constexpr board_t board_host =
+{
+    "Simulated", 25, { 4, 5, 6 }, 27, 30, 31, 37, 10
+};
+
+
+#if defined (BOARD_CHAMBER_V2)
+    /// The board for which this program is built
+    constexpr board_t board = board_chamber_v2;
+#elif defined (ESP32)
+    constexpr board_t board = board_feather;
+#else
+    constexpr board_t board = board_host;
+#endif
+
+// Pins 34 to 39 on an ESP32 can only be inputs, and there are no pins past 39
+static_assert (board.heater_pin < 34, "The heater needs an output pin");
+static_assert (board.drdy_pin < 40, "The data ready pin doesn't exist");
+
+#endif // _BOARD_H_
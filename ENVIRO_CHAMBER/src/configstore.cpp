@@ -0,0 +1,417 @@
+/** @file    configstore.cpp
+ *  @brief   Source code for a store of settings kept in a log in flash.
+ *  @details See @c configstore.h for a description of the store. The
+ *           values of all keys, live or not, must fit in one sector with room
+ *           to spare; with the limits in @c configstore.h they fill at most
+ *           a third of a sector.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <string.h>
+#include "crc.h"
+#include "configstore.h"
+#include "trace.h"
+
+
+/** @brief   Compute the number of bytes which a record takes in flash.
+ *  @param   length The size of the record's value
+ *  @return  The size of the header plus the value padded to four bytes
+ */
+static inline uint16_t record_size (uint8_t length)
+{
+    return sizeof (config_record_t) + ((length + 3) & ~3);
+}
+
+
+/** @brief   Compute the CRC of a record's key, size and value.
+ *  @param   key The record's key
+ *  @param   p_value Pointer to the value
+ *  @param   length The size of the value
+ *  @return  The CRC-32 of the three together
+ */
+static uint32_t record_crc (uint16_t key, const void* p_value, uint8_t length)
+{
+    uint8_t head[3] = { (uint8_t)key, (uint8_t)(key >> 8), length };
+    return crc32 (p_value, length, crc32 (head, sizeof (head)));
+}
+
+
+/** @brief   Create a store which lives in the given flash region.
+ *  @details Nothing is read or written until @c begin() is called.
+ *  @param   flash The flash region which holds the store
+ */
+ConfigStore::ConfigStore (FlashRegion& flash)
+    : region (flash), num_sectors (0), write_sector (0), write_offset (0),
+      next_seq (0), num_writes (0), num_erases (0)
+{
+    for (uint8_t index = 0; index < CONFIG_MAX_KEYS; index++)
+    {
+        cache[index].key = CONFIG_BLANK_KEY;
+    }
+#if defined ESP32 && defined STATIC_ALLOCATION
+    mutex = xSemaphoreCreateMutexStatic (&mutex_buffer);
+#elif defined ESP32
+    mutex = xSemaphoreCreateMutex ();
+#endif
+}
+
+
+/** @brief   Take the mutex so that no other task can use the store.
+ */
+void ConfigStore::lock (void)
+{
+#ifdef ESP32
+    TRACE_BEGIN (TRACE_LOCK_WAIT, TRACE_LOCK_CONFIG);
+    xSemaphoreTake (mutex, portMAX_DELAY);
+    TRACE_END (TRACE_LOCK_WAIT, TRACE_LOCK_CONFIG);
+    TRACE_BEGIN (TRACE_LOCK_HELD, TRACE_LOCK_CONFIG);
+#endif
+}
+
+
+/** @brief   Release the mutex so that other tasks can use the store.
+ */
+void ConfigStore::unlock (void)
+{
+#ifdef ESP32
+    TRACE_END (TRACE_LOCK_HELD, TRACE_LOCK_CONFIG);
+    xSemaphoreGive (mutex);
+#endif
+}
+
+
+/** @brief   Find a key's place in the cache.
+ *  @param   key The key to be found
+ *  @return  The key's index in the cache, or -1 if it isn't there
+ */
+int16_t ConfigStore::find (uint16_t key) const
+{
+    for (uint8_t index = 0; index < CONFIG_MAX_KEYS; index++)
+    {
+        if (cache[index].key == key)
+        {
+            return index;
+        }
+    }
+    return -1;
+}
+
+
+/** @brief   Read the records in one sector into the cache.
+ *  @details Records are read in order until erased space is found. Each
+ *           good record's value replaces whatever value the key had before.
+ *           The place where the records end is saved in @c write_offset.
+ *  @param   sector The number of the sector
+ *  @return  @c true if the sector ended in erased space, @c false if it ended
+ *           in a damaged record, as when the power failed during a write
+ */
+bool ConfigStore::load_sector (uint16_t sector)
+{
+    uint32_t base = (uint32_t)sector * FLASH_SECTOR_SIZE;
+    uint16_t offset = sizeof (config_sector_t);
+    config_record_t record;
+    uint8_t value[CONFIG_MAX_VALUE];
+
+    while (offset + sizeof (config_record_t) <= FLASH_SECTOR_SIZE)
+    {
+        write_offset = offset;
+        if (!region.read (base + offset, &record, sizeof (record)))
+        {
+            return false;
+        }
+        if (record.key == CONFIG_BLANK_KEY && record.length == 0xFF)
+        {
+            return true;
+        }
+        if (record.length > CONFIG_MAX_VALUE
+            || offset + record_size (record.length) > FLASH_SECTOR_SIZE
+            || !region.read (base + offset + sizeof (record), value,
+                             record.length)
+            || record_crc (record.key, value, record.length) != record.crc)
+        {
+            return false;
+        }
+
+        int16_t index = find (record.key);
+        if (index < 0)
+        {
+            index = find (CONFIG_BLANK_KEY);
+        }
+        if (index >= 0)
+        {
+            cache[index].key = record.key;
+            cache[index].length = record.length;
+            cache[index].sector = sector;
+            memcpy (cache[index].value, value, record.length);
+        }
+        offset += record_size (record.length);
+    }
+    write_offset = offset;
+    return true;
+}
+
+
+/** @brief   Erase a sector and write a header at its start.
+ *  @details The sector becomes the one being written.
+ *  @param   sector The number of the sector
+ *  @return  @c true if all went well, @c false if the flash couldn't be written
+ */
+bool ConfigStore::open_sector (uint16_t sector)
+{
+    config_sector_t header = { CONFIG_SECTOR_MAGIC, next_seq++ };
+    uint32_t base = (uint32_t)sector * FLASH_SECTOR_SIZE;
+
+    write_sector = sector;
+    write_offset = sizeof (header);
+    num_erases++;
+    return region.erase (base, FLASH_SECTOR_SIZE)
+           && region.write (base, &header, sizeof (header));
+}
+
+
+/** @brief   Copy the current values out of a sector, then erase it.
+ *  @details The values are written again from the cache at the end of the
+ *           log. If the power fails before the erase, the sector is simply
+ *           reclaimed again at the next startup.
+ *  @param   sector The number of the sector, which mustn't be the one being
+ *           written
+ *  @return  @c true if all went well, @c false if the flash couldn't be written
+ */
+bool ConfigStore::reclaim (uint16_t sector)
+{
+    bool all_ok = true;
+
+    for (uint8_t index = 0; index < CONFIG_MAX_KEYS; index++)
+    {
+        if (cache[index].key != CONFIG_BLANK_KEY
+            && cache[index].sector == sector)
+        {
+            all_ok &= write_record (cache[index].key, cache[index].value,
+                                    cache[index].length);
+        }
+    }
+    num_erases++;
+    return region.erase ((uint32_t)sector * FLASH_SECTOR_SIZE,
+                         FLASH_SECTOR_SIZE) && all_ok;
+}
+
+
+/** @brief   Write one record at the end of the log.
+ *  @details If the record doesn't fit in the sector being written, writing
+ *           moves to the spare sector and the oldest sector is reclaimed.
+ *           The cache is updated to show where the record now is.
+ *  @param   key The record's key
+ *  @param   p_value Pointer to the value
+ *  @param   length The size of the value
+ *  @return  @c true if all went well, @c false if the flash couldn't be written
+ */
+bool ConfigStore::write_record (uint16_t key, const void* p_value,
+                                uint8_t length)
+{
+    bool all_ok = true;
+
+    if (write_offset + record_size (length) > FLASH_SECTOR_SIZE)
+    {
+        all_ok = open_sector ((write_sector + 1) % num_sectors);
+        all_ok &= reclaim ((write_sector + 1) % num_sectors);
+    }
+
+    uint8_t buffer[sizeof (config_record_t) + CONFIG_MAX_VALUE];
+    config_record_t& record = *(config_record_t*)buffer;
+    memset (buffer, 0xFF, sizeof (buffer));
+    record.key = key;
+    record.length = length;
+    record.crc = record_crc (key, p_value, length);
+    memcpy (buffer + sizeof (record), p_value, length);
+
+    all_ok &= region.write ((uint32_t)write_sector * FLASH_SECTOR_SIZE
+                            + write_offset, buffer, record_size (length));
+    write_offset += record_size (length);
+    num_writes++;
+
+    int16_t index = find (key);
+    if (index >= 0)
+    {
+        cache[index].sector = write_sector;
+    }
+    return all_ok;
+}
+
+
+/** @brief   Find the region and load the newest value of each key.
+ *  @details The sector headers are read to put the sectors in order from
+ *           oldest to newest, then the records in each sector are read into
+ *           the cache. If the newest sector ends in a damaged record, writing
+ *           moves on to a fresh sector at the next write. If an interrupted compaction left
+ *           no erased sector after the newest one, the compaction is redone.
+ *  @return  @c true if the store is ready, @c false if there was an error
+ */
+bool ConfigStore::begin (void)
+{
+    uint16_t order[CONFIG_MAX_SECTORS];
+    uint32_t seqs[CONFIG_MAX_SECTORS];
+    uint16_t num_used = 0;
+    config_sector_t header;
+
+    if (!region.begin ())
+    {
+        return false;
+    }
+    num_sectors = region.size () / FLASH_SECTOR_SIZE;
+    num_sectors = (num_sectors < CONFIG_MAX_SECTORS) ? num_sectors
+                                                     : CONFIG_MAX_SECTORS;
+    if (num_sectors < 3)
+    {
+        return false;
+    }
+
+    lock ();
+
+    // Sort the sectors in use by sequence number with an insertion sort
+    for (uint16_t sector = 0; sector < num_sectors; sector++)
+    {
+        if (!region.read ((uint32_t)sector * FLASH_SECTOR_SIZE, &header,
+                          sizeof (header))
+            || header.magic != CONFIG_SECTOR_MAGIC)
+        {
+            continue;
+        }
+        uint16_t place = num_used++;
+        while (place > 0 && (int32_t)(seqs[place - 1] - header.seq) > 0)
+        {
+            order[place] = order[place - 1];
+            seqs[place] = seqs[place - 1];
+            place--;
+        }
+        order[place] = sector;
+        seqs[place] = header.seq;
+    }
+
+    bool all_ok = true;
+    if (num_used == 0)
+    {
+        all_ok = open_sector (0);
+    }
+    else
+    {
+        bool clean = true;
+        for (uint16_t index = 0; index < num_used; index++)
+        {
+            clean = load_sector (order[index]);
+        }
+        write_sector = order[num_used - 1];
+        next_seq = seqs[num_used - 1] + 1;
+
+        // Don't write after a damaged record; the next write starts afresh
+        if (!clean)
+        {
+            write_offset = FLASH_SECTOR_SIZE;
+        }
+    }
+
+    // Make sure the sector after the one being written is erased
+    uint16_t spare = (write_sector + 1) % num_sectors;
+    if (region.read ((uint32_t)spare * FLASH_SECTOR_SIZE, &header,
+                     sizeof (header))
+        && (header.magic != 0xFFFFFFFF || header.seq != 0xFFFFFFFF))
+    {
+        all_ok &= reclaim (spare);
+    }
+
+    unlock ();
+    return all_ok;
+}
+
+
+/** @brief   Copy the value of a key into a buffer.
+ *  @details The value comes from the copy in RAM; flash isn't read.
+ *  @param   key The key whose value is wanted
+ *  @param   p_value Pointer to a buffer which receives the value
+ *  @param   size The size of the buffer in bytes
+ *  @return  The size of the value, or 0 if the key has no value or the
+ *           value doesn't fit in the buffer
+ */
+uint8_t ConfigStore::get (uint16_t key, void* p_value, uint8_t size)
+{
+    uint8_t length = 0;
+
+    lock ();
+    int16_t index = find (key);
+    if (index >= 0 && cache[index].length <= size)
+    {
+        length = cache[index].length;
+        memcpy (p_value, cache[index].value, length);
+    }
+    unlock ();
+    return length;
+}
+
+
+/** @brief   Save a new value for a key.
+ *  @details Nothing is written if the key already has the same value.
+ *  @param   key The key, which mustn't be @c CONFIG_BLANK_KEY
+ *  @param   p_value Pointer to the value
+ *  @param   length The size of the value, at most @c CONFIG_MAX_VALUE bytes
+ *  @return  @c true if the value was saved, @c false if it was too big, the
+ *           store is full of keys or the flash couldn't be written
+ */
+bool ConfigStore::put (uint16_t key, const void* p_value, uint8_t length)
+{
+    if (num_sectors == 0 || key == CONFIG_BLANK_KEY
+        || length > CONFIG_MAX_VALUE)
+    {
+        return false;
+    }
+
+    lock ();
+    int16_t index = find (key);
+    if (index >= 0 && cache[index].length == length
+        && memcmp (cache[index].value, p_value, length) == 0)
+    {
+        unlock ();
+        return true;
+    }
+    if (index < 0)
+    {
+        index = find (CONFIG_BLANK_KEY);
+    }
+    if (index < 0)
+    {
+        unlock ();
+        return false;
+    }
+
+    // Write first so that a compaction copies the old value, not this one
+    bool written = write_record (key, p_value, length);
+    cache[index].key = key;
+    cache[index].length = length;
+    cache[index].sector = write_sector;
+    memcpy (cache[index].value, p_value, length);
+    unlock ();
+    return written;
+}
+
+
+/** @brief   Get an integer setting, or a default if it has never been saved.
+ *  @param   key The key whose value is wanted
+ *  @param   default_value The number to return if the key has no value
+ *  @return  The setting's value
+ */
+int32_t ConfigStore::get_int (uint16_t key, int32_t default_value)
+{
+    int32_t value;
+    return (get (key, &value, sizeof (value)) == sizeof (value))
+           ? value : default_value;
+}
+
+
+/** @brief   Save an integer setting.
+ *  @param   key The key under which the value is saved
+ *  @param   value The value to be saved
+ *  @return  @c true if the value was saved, @c false if there was an error
+ */
+bool ConfigStore::put_int (uint16_t key, int32_t value)
+{
+    return put (key, &value, sizeof (value));
+}
@@ -0,0 +1,170 @@
+/** @file    configstore.h
+ *  @brief   Headers for a store of settings kept in a log in flash.
+ *  @details Settings such as the temperature setpoint change now and then
+ *           and must survive a reset. Rewriting a file for each change wears
+ *           out the flash under it, so instead each change is appended as a
+ *           small record to a log which runs around a raw flash partition.
+ *           The newest record for each key holds its value. A copy of every
+ *           value is kept in RAM, loaded once at startup, so reading a
+ *           setting never touches the flash.
+ *
+ *           The partition is used as a ring of sectors. Each sector begins
+ *           with a header holding a sequence number, and each record has a
+ *           CRC, so a record cut short by a power failure is recognized and
+ *           ignored. One sector is always kept erased. When the sector being
+ *           written is full, writing moves to the erased one and the oldest
+ *           sector is compacted: the values in it which are still current are
+ *           copied forward from RAM, and then it is erased to become the new
+ *           spare. In this way every sector is erased equally often.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _CONFIGSTORE_H_
+#define _CONFIGSTORE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "flashregion.h"
+#ifdef ESP32
+    #include "FreeRTOS.h"
+    #include "freertos/semphr.h"
+#endif
+
+
+/// Largest number of keys which the store can hold
+#define CONFIG_MAX_KEYS 32
+
+/// Largest size of one value, in bytes
+#define CONFIG_MAX_VALUE 32
+
+/// Largest number of sectors which the store can use
+#define CONFIG_MAX_SECTORS 32
+
+/// Number written at the start of each sector which is in use
+#define CONFIG_SECTOR_MAGIC 0x43464753
+
+/// Key value which marks erased space after the last record in a sector
+#define CONFIG_BLANK_KEY 0xFFFF
+
+
+/** @brief   Keys of the settings which this program keeps in the store.
+ *  @details Numbers must never be reused for a different setting, or an old
+ *           value would be read as the new setting after a firmware update.
+ */
+enum config_key_t
+{
+    CONFIG_SETPOINT = 1,                      ///< Temperature setpoint in C
+};
+
+/// Lowest setpoint accepted from the web page, MQTT or the console, in C
+#define CONFIG_SETPOINT_MIN -50
+
+/// Highest setpoint accepted from the web page, MQTT or the console, in C
+#define CONFIG_SETPOINT_MAX 200
+
+
+/** @brief   The header at the beginning of each sector in use.
+ */
+struct config_sector_t
+{
+    uint32_t magic;                           ///< @c CONFIG_SECTOR_MAGIC
+    uint32_t seq;                             ///< Sector's sequence number
+};
+
+
+/** @brief   The header of each record; the value follows, padded to a
+ *           multiple of four bytes.
+ */
+struct config_record_t
+{
+    uint16_t key;                             ///< Key, or @c CONFIG_BLANK_KEY
+    uint8_t  length;                          ///< Size of the value in bytes
+    uint8_t  reserved;                        ///< Unused, must be 0xFF
+    uint32_t crc;                             ///< CRC-32 of key, size, value
+};
+
+
+/** @brief   Class which keeps settings in a wear-leveled log in flash.
+ *  @details The store locks itself on an ESP32, so any task may use it.
+ */
+class ConfigStore
+{
+    protected:
+        FlashRegion& region;                  ///< Flash in which store lives
+        uint16_t     num_sectors;             ///< Sectors in the region
+        uint16_t     write_sector;            ///< Sector being written
+        uint16_t     write_offset;            ///< Where next record goes
+        uint32_t     next_seq;                ///< Sequence number of next sector
+        uint32_t     num_writes;              ///< Records written since startup
+        uint32_t     num_erases;              ///< Sectors erased since startup
+
+        /// Copy of every value in RAM, with the sector holding its record
+        struct
+        {
+            uint16_t key;                     ///< Key, or @c CONFIG_BLANK_KEY
+            uint8_t  length;                  ///< Size of the value
+            uint8_t  sector;                  ///< Sector holding the record
+            uint8_t  value[CONFIG_MAX_VALUE]; ///< The value itself
+        } cache[CONFIG_MAX_KEYS];
+
+    #ifdef ESP32
+        SemaphoreHandle_t mutex;              ///< Lets one task in at a time
+    #ifdef STATIC_ALLOCATION
+        StaticSemaphore_t mutex_buffer;       ///< Memory for the mutex
+    #endif
+    #endif
+
+        // Find a key's place in the cache
+        int16_t find (uint16_t key) const;
+
+        // Read the records in one sector into the cache
+        bool load_sector (uint16_t sector);
+
+        // Erase a sector and write a header at its start
+        bool open_sector (uint16_t sector);
+
+        // Copy the current values out of a sector, then erase it
+        bool reclaim (uint16_t sector);
+
+        // Write one record at the end of the log
+        bool write_record (uint16_t key, const void* p_value, uint8_t length);
+
+        // Take and release the mutex
+        void lock (void);
+        void unlock (void);
+
+    public:
+        // Create a store which lives in the given flash region
+        ConfigStore (FlashRegion& flash);
+
+        // Find the region and load the newest value of each key
+        bool begin (void);
+
+        // Copy the value of a key into a buffer
+        uint8_t get (uint16_t key, void* p_value, uint8_t size);
+
+        // Save a new value for a key
+        bool put (uint16_t key, const void* p_value, uint8_t length);
+
+        // Get an integer setting, or a default if it has never been saved
+        int32_t get_int (uint16_t key, int32_t default_value);
+
+        // Save an integer setting
+        bool put_int (uint16_t key, int32_t value);
+
+        /// Return the number of records written since startup.
+        uint32_t writes (void) const
+        {
+            return num_writes;
+        }
+
+        /// Return the number of sectors erased since startup.
+        uint32_t erases (void) const
+        {
+            return num_erases;
+        }
+};
+
+#endif // _CONFIGSTORE_H_
@@ -0,0 +1,351 @@
+/** @file    console.cpp
+ *  @brief   Source code for a command console on the serial port.
+ *  @details The serial driver calls @c console_rx_event() from its own task
+ *           when characters arrive, and that function only wakes the
+ *           console task with a notification. A notification which comes
+ *           while the console task is still busy is remembered, so no
+ *           characters are left waiting.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <Arduino.h>
+#include "console.h"
+#ifdef ESP32
+    #include "FreeRTOS.h"
+#endif
+
+
+/// The ASCII escape character, which begins the codes sent by arrow keys
+#define CONSOLE_ESCAPE 0x1B
+
+/// The character sent by Ctrl-U, which erases the whole line
+#define CONSOLE_KILL_LINE 0x15
+
+
+/** @brief   The state of the line editor.
+ */
+struct console_line_t
+{
+    char    text[CONSOLE_LINE_LENGTH];        ///< The line being typed
+    char    previous[CONSOLE_LINE_LENGTH];    ///< The last line entered
+    uint8_t length;                           ///< Characters in @c text
+    uint8_t escape;                           ///< Place in an escape code
+    bool    after_return;                     ///< Last character was a '\r'
+};
+
+
+/// The line which is being typed
+static console_line_t line;
+
+/// The table of commands given to @c console_begin()
+static const console_command_t* p_commands = NULL;
+
+/// The number of commands in the table
+static uint8_t num_commands = 0;
+
+/// Buffer of a task which is waiting for a line, or @c NULL if none is
+static char* p_reader_buffer = NULL;
+
+/// Size of the waiting task's buffer
+static uint8_t reader_size = 0;
+
+#ifdef ESP32
+    /// The task which is waiting for a line
+    static TaskHandle_t reader_task = NULL;
+
+    /// The console task, which is woken when characters arrive
+    static TaskHandle_t console_task_handle = NULL;
+
+    /// A mutex used on ESP32's for critical sections around the reader
+    static portMUX_TYPE reader_mutex = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+
+/** @brief   Give the console its table of commands.
+ *  @details This should be called before the console task is created.
+ *  @param   p_table Pointer to an array of commands which must exist for as
+ *           long as the program runs
+ *  @param   count The number of commands in the array
+ */
+void console_begin (const console_command_t* p_table, uint8_t count)
+{
+    p_commands = p_table;
+    num_commands = count;
+}
+
+
+/** @brief   Print the name and help text of every command.
+ *  @param   printer Reference to a serial device or stream on which to print
+ */
+void console_print_help (Print& printer)
+{
+    for (uint8_t index = 0; index < num_commands; index++)
+    {
+        printer.printf ("%-10s %s\n", p_commands[index].name,
+                        p_commands[index].help);
+    }
+}
+
+
+/** @brief   Find the command named at the start of a line and run it.
+ *  @param   p_text The line, which may be changed by the command
+ *  @param   printer Reference to the stream on which the command prints
+ */
+static void run_command (char* p_text, Print& printer)
+{
+    while (*p_text == ' ')
+    {
+        p_text++;
+    }
+    if (*p_text == '\0')
+    {
+        return;
+    }
+
+    // Split the command's name from its arguments
+    char* p_args = p_text;
+    while (*p_args != '\0' && *p_args != ' ')
+    {
+        p_args++;
+    }
+    if (*p_args != '\0')
+    {
+        *p_args++ = '\0';
+        while (*p_args == ' ')
+        {
+            p_args++;
+        }
+    }
+
+    for (uint8_t index = 0; index < num_commands; index++)
+    {
+        if (strcmp (p_text, p_commands[index].name) == 0)
+        {
+            p_commands[index].handler (printer, p_args);
+            return;
+        }
+    }
+    printer.printf ("Unknown command \"%s\"; type \"help\" for a list\n",
+                    p_text);
+}
+
+
+/** @brief   Give a finished line to a task which is waiting for one.
+ *  @return  @c true if a task was waiting, @c false if none was
+ */
+static bool give_line_to_reader (void)
+{
+    bool given = false;
+
+#ifdef ESP32
+    portENTER_CRITICAL (&reader_mutex);
+#endif
+    if (p_reader_buffer != NULL)
+    {
+        strncpy (p_reader_buffer, line.text, reader_size - 1);
+        p_reader_buffer[reader_size - 1] = '\0';
+        p_reader_buffer = NULL;
+        given = true;
+    }
+#ifdef ESP32
+    TaskHandle_t waiting = reader_task;
+    portEXIT_CRITICAL (&reader_mutex);
+    if (given)
+    {
+        xTaskNotifyGive (waiting);
+    }
+#endif
+    return given;
+}
+
+
+/** @brief   Erase the line on the screen and in the editor.
+ *  @param   printer Reference to the stream on which characters are echoed
+ */
+static void erase_line (Print& printer)
+{
+    for ( ; line.length > 0; line.length--)
+    {
+        printer.print ("\b \b");
+    }
+}
+
+
+/** @brief   Handle one character typed at the console.
+ *  @details Printable characters are added to the line and echoed. A return,
+ *           a newline or both end the line, which is given to a waiting task
+ *           or else run as a command. Other control characters and escape
+ *           codes other than the up arrow are ignored.
+ *  @param   ch The character
+ *  @param   printer Reference to the stream on which characters are echoed
+ *           and commands print
+ */
+void console_feed (int ch, Print& printer)
+{
+    bool after_return = line.after_return;
+    line.after_return = (ch == '\r');
+
+    // Arrow keys send ESC, '[' and a letter; up is 'A'
+    if (line.escape == 1)
+    {
+        line.escape = (ch == '[') ? 2 : 0;
+        return;
+    }
+    if (line.escape == 2)
+    {
+        line.escape = (ch >= '0' && ch <= '9') ? 2 : 0;
+        if (ch == 'A')
+        {
+            erase_line (printer);
+            strcpy (line.text, line.previous);
+            line.length = strlen (line.text);
+            printer.print (line.text);
+        }
+        return;
+    }
+
+    if (ch == '\r' || ch == '\n')
+    {
+        // A newline right after a return ends the same line
+        if (ch == '\n' && after_return)
+        {
+            return;
+        }
+        line.text[line.length] = '\0';
+        line.length = 0;
+        printer.print ("\r\n");
+        if (give_line_to_reader ())
+        {
+            return;
+        }
+        if (line.text[0] != '\0')
+        {
+            strcpy (line.previous, line.text);
+            run_command (line.text, printer);
+        }
+        printer.print (CONSOLE_PROMPT);
+    }
+    else if (ch == '\b' || ch == 0x7F)
+    {
+        if (line.length > 0)
+        {
+            line.length--;
+            printer.print ("\b \b");
+        }
+    }
+    else if (ch == CONSOLE_KILL_LINE)
+    {
+        erase_line (printer);
+    }
+    else if (ch == CONSOLE_ESCAPE)
+    {
+        line.escape = 1;
+    }
+    else if (ch >= ' ' && ch < 0x7F)
+    {
+        if (line.length < CONSOLE_LINE_LENGTH - 1)
+        {
+            line.text[line.length++] = ch;
+            printer.print ((char)ch);
+        }
+        else
+        {
+            printer.print ('\a');
+        }
+    }
+}
+
+
+#ifdef ESP32
+
+/** @brief   Wake the console task because characters have arrived.
+ *  @details The serial driver calls this from its event task, not from an
+ *           interrupt, so the ordinary notification function is used.
+ */
+static void console_rx_event (void)
+{
+    if (console_task_handle != NULL)
+    {
+        xTaskNotifyGive (console_task_handle);
+    }
+}
+
+
+/** @brief   Wait for the user to type a line and return it instead of
+ *           running it.
+ *  @details The calling task sleeps until the console task has a whole line.
+ *           The line is echoed as it's typed, as are commands.
+ *  @param   p_buffer Pointer to a buffer which receives the line
+ *  @param   size The size of the buffer; longer lines are cut short
+ */
+void console_read_line (char* p_buffer, uint8_t size)
+{
+    portENTER_CRITICAL (&reader_mutex);
+    reader_task = xTaskGetCurrentTaskHandle ();
+    reader_size = size;
+    p_reader_buffer = p_buffer;
+    portEXIT_CRITICAL (&reader_mutex);
+
+    ulTaskNotifyTake (pdTRUE, portMAX_DELAY);
+}
+
+
+/** @brief   The task which reads the serial port and runs commands.
+ *  @details The task sleeps until the serial driver says that characters
+ *           have arrived, then handles all the characters which are waiting.
+ *  @param   p_params Pointer to this task's entry in the task table
+ */
+void task_console (void* p_params)
+{
+    (void)p_params;
+
+    console_task_handle = xTaskGetCurrentTaskHandle ();
+    Serial.onReceive (console_rx_event);
+
+    for (;;)
+    {
+        while (Serial.available () > 0)
+        {
+            console_feed (Serial.read (), Serial);
+        }
+        ulTaskNotifyTake (pdTRUE, portMAX_DELAY);
+    }
+}
+
+#else
+
+/** @brief   Wait for the user to type a line and return it instead of
+ *           running it.
+ *  @details On a PC the line is read straight from standard input.
+ *  @param   p_buffer Pointer to a buffer which receives the line
+ *  @param   size The size of the buffer; longer lines are cut short
+ */
+void console_read_line (char* p_buffer, uint8_t size)
+{
+    if (fgets (p_buffer, size, stdin) == NULL)
+    {
+        p_buffer[0] = '\0';
+    }
+    p_buffer[strcspn (p_buffer, "\r\n")] = '\0';
+}
+
+
+/** @brief   Run the console on standard input until it ends.
+ *  @details The terminal does its own echoing and line editing on a PC, so
+ *           what the console echoes shows up twice unless the terminal is
+ *           put in raw mode, for example with @c stty @c raw @c -echo.
+ *  @param   printer Reference to the stream on which commands print
+ */
+void console_run_stdin (Print& printer)
+{
+    int ch;
+
+    printer.print (CONSOLE_PROMPT);
+    while ((ch = getchar ()) != EOF)
+    {
+        console_feed (ch, printer);
+    }
+}
+
+#endif
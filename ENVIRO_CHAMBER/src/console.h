@@ -0,0 +1,71 @@
+/** @file    console.h
+ *  @brief   Headers for a command console on the serial port.
+ *  @details The console task sleeps until the serial driver tells it that
+ *           characters have arrived, so it takes no CPU time while nobody is
+ *           typing. Characters go through a small line editor which echoes
+ *           them and understands backspace, Ctrl-U to erase the line and the
+ *           up arrow to bring back the previous line. Each finished line is
+ *           looked up in a table of commands which the program gives to
+ *           @c console_begin(); the table is a @c const array, so it's built
+ *           by the compiler and kept in flash.
+ *
+ *           Commands run in the console task, which has a low priority and
+ *           runs on the network core, so a slow command or a slow serial
+ *           port never holds up the control tasks. A task which needs a line
+ *           of text from the user, such as the WiFi task asking for a
+ *           password, calls @c console_read_line(); the next line typed goes
+ *           to it instead of being run as a command.
+ *
+ *           On a PC the same console runs on standard input with
+ *           @c console_run_stdin().
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _CONSOLE_H_
+#define _CONSOLE_H_
+
+#include <Arduino.h>
+
+
+/// Longest command line, including the terminating null
+#define CONSOLE_LINE_LENGTH 64
+
+/// The prompt printed when the console is ready for a command
+#define CONSOLE_PROMPT "> "
+
+
+/** @brief   One command which can be typed at the console.
+ *  @details The handler is given the rest of the line after the command's
+ *           name, with leading spaces removed; it may change the text.
+ */
+struct console_command_t
+{
+    const char* name;                         ///< What the user types
+    const char* help;                         ///< One line of help text
+    void (*handler) (Print& printer, char* p_args);  ///< Runs the command
+};
+
+
+// Give the console its table of commands
+void console_begin (const console_command_t* p_table, uint8_t num_commands);
+
+// Handle one character typed at the console
+void console_feed (int ch, Print& printer);
+
+// Wait for the user to type a line and return it instead of running it
+void console_read_line (char* p_buffer, uint8_t size);
+
+// Print the name and help text of every command
+void console_print_help (Print& printer);
+
+#ifdef ESP32
+    // The task which reads the serial port and runs commands
+    void task_console (void* p_params);
+#else
+    // Run the console on standard input until it ends
+    void console_run_stdin (Print& printer);
+#endif
+
+#endif // _CONSOLE_H_
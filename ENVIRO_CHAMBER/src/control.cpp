@@ -0,0 +1,135 @@
+/** @file    control.cpp
+ *  @brief   Source code for the tasks which read the thermocouple and run
+ *           the heater.
+ *  @details These tasks were moved out of @c main_enviro.cpp so that they
+ *           can be built without the WiFi and web server code, which lets
+ *           the simulator in @c sim/ run them on a PC. They talk to the rest
+ *           of the program only through the shares and the log queue.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <Arduino.h>
+#include <Adafruit_MAX31856.h>
+#include "taskshare.h"
+#include "taskqueue.h"
+#include "tasktable.h"
+#include "sample.h"
+#include "stats.h"
+#include "rollup.h"
+#include "warmstart.h"
+#include "trace.h"
+#include "deferlog.h"
+#include "board.h"
+#include "control.h"
+
+
+// The shares and queue which connect these tasks to the others live in
+// main_enviro.cpp, or in the simulator's main file
+extern Share<int16_t> desired_temp;
+extern Share<int16_t> temp_reading;
+extern Share<float> therm_temp;
+extern Share<bool> heater_on;
+extern Queue<sample_t> log_queue;
+
+
+/** @brief   Run the heater controller once.
+ *  @details The heater is turned on if the reading is more than the board's
+ *           threshold below the setpoint and off otherwise, and a snapshot is
+ *           saved for a warm reset. This is the body of the heater task's
+ *           loop, kept apart so that the benchmarks can time it.
+ *  @return  @c true if the heater is now on
+ */
+bool control_step (void)
+{
+    int16_t setpoint = 20;
+    int16_t current = 0;
+    float temperature = 0.0;
+    bool heating = false;
+
+    desired_temp.get(setpoint);
+    temp_reading.get(current);
+    if(current < (setpoint - board.threshold)){
+        HeaterPin::write(1);
+        heating = true;
+    }
+    else{
+        HeaterPin::write(0);
+        heating = false;
+    }
+    heater_on.put(heating);
+    TRACE_COUNTER(TRACE_HEATER_ON, heating);
+
+    // Save a snapshot so a warm reset can carry on from here
+    therm_temp.get(temperature);
+    warmstart_save(setpoint, current, temperature, heating);
+    return heating;
+}
+
+/** @brief   Task which controls the heating element
+ *  @param   p_params Pointer to this task's entry in the task table
+ * 
+ */
+void task_heater(void* p_params){
+    task_entry_t* p_task = (task_entry_t*)p_params;
+
+    //set pin mode to output for heater control
+    HeaterPin::begin();
+
+    for(;;){
+        control_step();
+        task_wait_period(p_task);
+    }
+}
+
+/** @brief   Task which reads data from thermocouples.
+ *  @param   p_params Pointer to this task's entry in the task table
+ * 
+ */
+void task_sensor(void* p_params){
+    task_entry_t* p_task = (task_entry_t*)p_params;
+
+    Adafruit_MAX31856 therm1 = Adafruit_MAX31856(board.cs_pins[0],
+                                                 board.sdi_pin, board.sdo_pin,
+                                                 board.sck_pin);
+    DrdyPin::begin();
+
+    if (!therm1.begin()) {
+        Serial.println("Could not initialize thermocouple.");
+        while (1) delay(10);
+    }
+
+    therm1.setThermocoupleType(MAX31856_TCTYPE_T);
+    therm1.setConversionMode(MAX31856_CONTINUOUS);
+
+    for(;;){
+        int count = 0;
+        TRACE_BEGIN(TRACE_SENSOR_WAIT, 0);
+        while (DrdyPin::read()) {
+            if (count++ > 200) {
+                count = 0;
+                DLOG_DEBUG("Waiting for the thermocouple");
+            }
+        }
+        TRACE_END(TRACE_SENSOR_WAIT, 0);
+        TRACE_BEGIN(TRACE_SENSOR_READ, 0);
+        float reading = therm1.readThermocoupleTemperature();
+        TRACE_END(TRACE_SENSOR_READ, 0);
+        therm_temp.put(reading);
+        temp_reading.put((int16_t)reading);
+        DLOG_INFO("Temperature %.2f C", reading);
+
+        // Update the running statistics with this reading
+        sample_t smp;
+        bool heater;
+        smp.time_ms = millis();
+        smp.temperature = reading;
+        desired_temp.get(smp.setpoint);
+        heater_on.get(heater);
+        smp.heater_on = heater ? 1 : 0;
+        stats_add_sample(smp);
+        rollup_add_sample(smp);
+        log_queue.put(smp);
+        task_wait_period (p_task);
+    }
+}
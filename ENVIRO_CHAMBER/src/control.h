@@ -0,0 +1,33 @@
+/** @file    control.h
+ *  @brief   Headers for the tasks which read the thermocouple and run the
+ *           heater.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _CONTROL_H_
+#define _CONTROL_H_
+
+#include "board.h"
+#include "gpio.h"
+
+
+/// The heater's control pin, on whichever board this is built for
+typedef OutputPin<board.heater_pin> HeaterPin;
+
+/// The thermocouple amplifier's data ready pin, which goes low when a new
+/// reading is ready
+typedef InputPin<board.drdy_pin> DrdyPin;
+
+
+// Run the heater controller once
+bool control_step (void);
+
+// Task which controls the heating element
+void task_heater (void* p_params);
+
+// Task which reads data from thermocouples
+void task_sensor (void* p_params);
+
+#endif // _CONTROL_H_
@@ -0,0 +1,44 @@
+/** @file    crc.cpp
+ *  @brief   Source code for a cyclic redundancy check used on stored data.
+ *  @details This is the common CRC-32 (as used by Ethernet and zip files),
+ *           computed four bits at a time with a 16-entry table so that it is
+ *           reasonably quick without using a kilobyte of table space.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include "crc.h"
+
+
+/// Table of CRC-32 remainders for each value of four bits
+static const uint32_t crc_table[16] =
+{
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+
+/** @brief   Compute or continue computing the CRC-32 of a block of bytes.
+ *  @details To compute the CRC of data which is in several pieces, pass the
+ *           result from each piece as the @c crc of the next.
+ *  @param   p_data Pointer to the data
+ *  @param   length The number of bytes of data
+ *  @param   crc The CRC of any data which came before this block, or 0 for a
+ *           new computation
+ *  @return  The CRC-32 of all the data so far
+ */
+uint32_t crc32 (const void* p_data, size_t length, uint32_t crc)
+{
+    const uint8_t* p_byte = (const uint8_t*)p_data;
+
+    crc = ~crc;
+    while (length--)
+    {
+        crc ^= *p_byte++;
+        crc = (crc >> 4) ^ crc_table[crc & 0x0F];
+        crc = (crc >> 4) ^ crc_table[crc & 0x0F];
+    }
+    return ~crc;
+}
@@ -0,0 +1,21 @@
+/** @file    crc.h
+ *  @brief   Headers for a cyclic redundancy check used on stored data.
+ *  @details Records written to flash carry a CRC so that, after a reset or a
+ *           power failure, partly written or corrupted records can be told
+ *           apart from good ones.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _CRC_H_
+#define _CRC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+// Compute or continue computing the CRC-32 of a block of bytes
+uint32_t crc32 (const void* p_data, size_t length, uint32_t crc = 0);
+
+#endif // _CRC_H_
@@ -0,0 +1,143 @@
+/** @file    ctrlstate.cpp
+ *  @brief   Source code for saving the controller's state so it survives a
+ *           reset.
+ *  @details The journal task sleeps until it is asked to save the state or
+ *           until @c CTRLSTATE_CHECKPOINT_MS has passed. It then gathers the
+ *           state from the shares and saves it if it differs from what was
+ *           saved last, apart from the temperature and heater, which change
+ *           all the time and are only saved with the rest. Because requests
+ *           which arrive while a save is under way are merged into one, a
+ *           burst of setpoint changes costs only one or two erases. The
+ *           setpoint is saved in the settings store here too, so the web
+ *           server and MQTT tasks which change it never write flash.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <Arduino.h>
+#include <PrintStream.h>
+#include "taskshare.h"
+#include "journal.h"
+#include "configstore.h"
+#include "ctrlstate.h"
+#include "task_logger.h"
+
+
+// Shares which hold the chamber's condition; they live in main_enviro.cpp
+extern Share<int16_t> desired_temp;
+extern Share<float> therm_temp;
+extern Share<bool> heater_on;
+
+// The store of settings which survive a reset; it lives in main_enviro.cpp
+extern ConfigStore config;
+
+
+/// The flash partition which holds the two copies of the state
+static FlashRegion journal_flash ("journal", 0x2000);
+
+/// The journal which keeps the state
+static Journal state_journal (journal_flash);
+
+/// The state found at startup, or all zeros if there was none
+static controller_state_t recovered_state;
+
+/// The state as it was last saved
+static controller_state_t saved_state;
+
+/// Handle of the journal task, which is woken to save the state
+static TaskHandle_t journal_task_handle = NULL;
+
+
+/** @brief   Find the saved state and count this startup.
+ *  @details This only reads the headers of the journal's two copies, so it
+ *           takes a short and constant time. It must be called in @c setup()
+ *           before the tasks are created.
+ *  @return  @c true if a saved state was found, @c false if not
+ */
+bool ctrlstate_begin (void)
+{
+    memset (&recovered_state, 0, sizeof (recovered_state));
+    if (!state_journal.begin ())
+    {
+        Serial << "Journal partition \"journal\" not found" << endl;
+        return false;
+    }
+
+    bool found = state_journal.load (&recovered_state,
+                                     sizeof (recovered_state))
+                 == sizeof (recovered_state);
+    saved_state = recovered_state;
+    saved_state.boot_count++;
+    return found;
+}
+
+
+/** @brief   Return the state which was found at startup.
+ *  @return  A reference to the recovered state, which is all zeros if none
+ *           was found
+ */
+const controller_state_t& ctrlstate_recovered (void)
+{
+    return recovered_state;
+}
+
+
+/** @brief   Ask the journal task to save the state soon.
+ *  @details This only wakes the journal task, so it can be called from any
+ *           task without delaying it.
+ */
+void ctrlstate_request_save (void)
+{
+    if (journal_task_handle != NULL)
+    {
+        xTaskNotifyGive (journal_task_handle);
+    }
+}
+
+
+/** @brief   The task which saves the state.
+ *  @details This task should have a low priority, as erasing flash is slow.
+ *           A changed setpoint is written to the settings store as well as
+ *           to the journal; the store writes nothing if it's unchanged.
+ *  @param   p_params Pointer to this task's entry in the task table
+ */
+void task_journal (void* p_params)
+{
+    (void)p_params;
+
+    journal_task_handle = xTaskGetCurrentTaskHandle ();
+
+    // Save once at startup so that the new boot count is recorded
+    bool must_save = true;
+    controller_state_t state = saved_state;
+    for (;;)
+    {
+        bool heater;
+        desired_temp.get (state.setpoint);
+        therm_temp.get (state.temperature);
+        heater_on.get (heater);
+        state.heater_on = heater ? 1 : 0;
+        state.time_ms = logger_time_now ();
+
+        if (!config.put_int (CONFIG_SETPOINT, state.setpoint))
+        {
+            Serial << "Journal: setpoint could not be stored" << endl;
+        }
+        if (must_save || state.setpoint != saved_state.setpoint)
+        {
+            if (state_journal.save (&state, sizeof (state)))
+            {
+                saved_state = state;
+            }
+            else
+            {
+                Serial << "Journal: state could not be saved" << endl;
+            }
+        }
+
+        // Wait for a request or for the next checkpoint, whichever is first
+        must_save = (ulTaskNotifyTake (pdTRUE,
+                                       pdMS_TO_TICKS (CTRLSTATE_CHECKPOINT_MS))
+                     == 0);
+    }
+}
@@ -0,0 +1,51 @@
+/** @file    ctrlstate.h
+ *  @brief   Headers for saving the controller's state so it survives a reset.
+ *  @details The state of the controller is saved in a @c Journal, so that
+ *           after a reset or power failure the newest good copy can be found
+ *           at once. Saving is done by a low priority task, so code which
+ *           changes the state only has to ask for a save, which takes
+ *           almost no time; erasing and writing flash happen later. This
+ *           includes saving the setpoint in the settings store.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _CTRLSTATE_H_
+#define _CTRLSTATE_H_
+
+#include <Arduino.h>
+
+
+#ifndef CTRLSTATE_CHECKPOINT_MS
+/// Time between saves of the state when nothing asks for one, in ms
+#define CTRLSTATE_CHECKPOINT_MS 600000UL
+#endif
+
+
+/** @brief   The state of the controller which is saved in flash.
+ */
+struct controller_state_t
+{
+    uint64_t time_ms;                         ///< When the state was saved
+    float    temperature;                     ///< Chamber temperature in C
+    uint32_t boot_count;                      ///< Number of startups
+    int16_t  setpoint;                        ///< Setpoint in degrees C
+    uint8_t  heater_on;                       ///< 1 if heater was on, else 0
+    uint8_t  reserved;                        ///< Unused, 0
+};
+
+
+// Find the saved state and count this startup
+bool ctrlstate_begin (void);
+
+// Return the state which was found at startup
+const controller_state_t& ctrlstate_recovered (void);
+
+// Ask the journal task to save the state soon
+void ctrlstate_request_save (void);
+
+// The task which saves the state
+void task_journal (void* p_params);
+
+#endif // _CTRLSTATE_H_
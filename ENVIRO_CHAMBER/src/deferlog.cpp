@@ -0,0 +1,290 @@
+/** @file    deferlog.cpp
+ *  @brief   Source code for a logger which lets tasks print messages without
+ *           waiting for the serial port.
+ *  @details The ring is a bounded queue in which each slot has a sequence
+ *           number. A writer claims a slot with a compare and swap on the
+ *           ring's head, fills it in, then sets the slot's sequence number to
+ *           tell the reader that it's ready. Only @c task_deferlog() reads
+ *           the ring, so the tail needs no atomic operations. Each slot keeps
+ *           its sequence number less its own index, so that the ring starts
+ *           out ready without having to be set up.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <Arduino.h>
+#include "deferlog.h"
+#include "tasktable.h"
+
+
+/// The messages waiting to be printed
+static dlog_slot_t slots[DLOG_RING_SIZE];
+
+/// Number of messages ever put into the ring
+static uint32_t head = 0;
+
+/// Number of messages ever taken out of the ring
+static uint32_t tail = 0;
+
+/// Number of messages dropped because the ring was full
+static uint32_t dropped = 0;
+
+/// Number of dropped messages which have been reported
+static uint32_t dropped_reported = 0;
+
+/// The letters printed for each level of message
+static const char level_letters[] = "?EWID";
+
+
+/** @brief   Put a message into the ring, or count it as dropped if the ring
+ *           is full.
+ *  @param   level The level of the message
+ *  @param   p_format The format, as for @c printf()
+ *  @param   p_args Pointer to the arguments' bits
+ *  @param   num_args The number of arguments
+ */
+void dlog_write (uint8_t level, const char* p_format, const uintptr_t* p_args,
+                 uint8_t num_args)
+{
+    uint32_t place = __atomic_load_n (&head, __ATOMIC_RELAXED);
+    dlog_slot_t* p_slot;
+
+    for (;;)
+    {
+        p_slot = &slots[place % DLOG_RING_SIZE];
+        uint32_t lap = place - place % DLOG_RING_SIZE;
+        int32_t diff = (int32_t)(__atomic_load_n (&p_slot->sequence,
+                                                  __ATOMIC_ACQUIRE) - lap);
+        if (diff == 0)
+        {
+            // The slot is free; claim it unless another writer got there first
+            if (__atomic_compare_exchange_n (&head, &place, place + 1, true,
+                                             __ATOMIC_RELAXED,
+                                             __ATOMIC_RELAXED))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // The slot still holds a message from the previous lap
+            __atomic_fetch_add (&dropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        else
+        {
+            place = __atomic_load_n (&head, __ATOMIC_RELAXED);
+        }
+    }
+
+    dlog_record_t& record = p_slot->record;
+    record.p_format = p_format;
+    record.time_ms = millis ();
+    record.level = level;
+    record.num_args = num_args;
+    for (uint8_t index = 0; index < num_args; index++)
+    {
+        record.args[index] = p_args[index];
+    }
+    __atomic_store_n (&p_slot->sequence, place - place % DLOG_RING_SIZE + 1,
+                      __ATOMIC_RELEASE);
+}
+
+
+/** @brief   Take one message out of the ring.
+ *  @details Only one task may call this function.
+ *  @param   record Reference to a record which receives the message
+ *  @return  @c true if there was a message, @c false if the ring was empty
+ *           or the next message is still being written
+ */
+bool dlog_take (dlog_record_t& record)
+{
+    dlog_slot_t& slot = slots[tail % DLOG_RING_SIZE];
+    uint32_t lap = tail - tail % DLOG_RING_SIZE;
+
+    if (__atomic_load_n (&slot.sequence, __ATOMIC_ACQUIRE) != lap + 1)
+    {
+        return false;
+    }
+    record = slot.record;
+    __atomic_store_n (&slot.sequence, lap + DLOG_RING_SIZE, __ATOMIC_RELEASE);
+    tail++;
+    return true;
+}
+
+
+/** @brief   Format one conversion, such as @c %5.2f, with its argument.
+ *  @param   p_spec The conversion, from the @c % to the letter
+ *  @param   length The number of characters in the conversion
+ *  @param   value The argument's bits
+ *  @param   p_out Pointer to where the text is to be written
+ *  @param   size The room there, including a terminating null
+ *  @return  The number of characters which the text needed
+ */
+static int format_one (const char* p_spec, size_t length, uintptr_t value,
+                       char* p_out, size_t size)
+{
+    char spec[16];
+    char letter = p_spec[length - 1];
+    size_t used = 0;
+
+    // Length modifiers are dropped; each type is given as a long or double
+    for (size_t index = 0; index < length - 1 && used < sizeof (spec) - 3;
+         index++)
+    {
+        if (!strchr ("hlLqjzt", p_spec[index]))
+        {
+            spec[used++] = p_spec[index];
+        }
+    }
+    if (strchr ("diouxX", letter))
+    {
+        spec[used++] = 'l';
+    }
+    spec[used++] = letter;
+    spec[used] = '\0';
+
+    switch (letter)
+    {
+        case 'd':
+        case 'i':
+            return snprintf (p_out, size, spec, (long)(intptr_t)value);
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X':
+            return snprintf (p_out, size, spec, (unsigned long)value);
+        case 'c':
+            return snprintf (p_out, size, spec, (int)value);
+        case 's':
+            return snprintf (p_out, size, spec, (const char*)value);
+        case 'p':
+            return snprintf (p_out, size, spec, (void*)value);
+        default:
+        {
+            uint32_t bits = (uint32_t)value;
+            float number;
+            memcpy (&number, &bits, sizeof (number));
+            return snprintf (p_out, size, spec, (double)number);
+        }
+    }
+}
+
+
+/** @brief   Format a message as a line of text.
+ *  @details The line begins with the time in seconds and a letter for the
+ *           level, and ends with a newline. A conversion for which there is
+ *           no argument is printed as it is.
+ *  @param   record The message
+ *  @param   p_line Pointer to a buffer which receives the line
+ *  @param   size The size of the buffer
+ *  @return  The number of characters in the line
+ */
+size_t dlog_format (const dlog_record_t& record, char* p_line, size_t size)
+{
+    const char* p_char = record.p_format;
+    uint8_t next_arg = 0;
+    int written = snprintf (p_line, size, "[%6lu.%03u] %c ",
+                            (unsigned long)(record.time_ms / 1000),
+                            (unsigned)(record.time_ms % 1000),
+                            level_letters[(record.level < 5) ? record.level
+                                                             : 0]);
+    size_t limit = size - 2;
+    size_t used = (written < 0) ? 0 : written;
+
+    // Leave room for the newline and the null
+    used = (used < limit) ? used : limit;
+    while (*p_char && used < limit)
+    {
+        if (*p_char != '%')
+        {
+            p_line[used++] = *p_char++;
+            continue;
+        }
+        if (p_char[1] == '%')
+        {
+            p_line[used++] = '%';
+            p_char += 2;
+            continue;
+        }
+
+        // Find the end of the conversion
+        size_t length = 1;
+        while (p_char[length] && !strchr ("diouxXcspfFeEgGaA",
+                                          p_char[length]))
+        {
+            length++;
+        }
+        if (p_char[length] == '\0' || next_arg >= record.num_args)
+        {
+            p_line[used++] = *p_char++;
+            continue;
+        }
+        length++;
+        written = format_one (p_char, length, record.args[next_arg++],
+                              p_line + used, limit + 1 - used);
+        used += (written < 0) ? 0 : written;
+        used = (used < limit) ? used : limit;
+        p_char += length;
+    }
+    p_line[used++] = '\n';
+    p_line[used] = '\0';
+    return used;
+}
+
+
+/** @brief   Print all the messages which are waiting in the ring.
+ *  @details If messages have been dropped since the last time, the number
+ *           dropped is printed first.
+ *  @param   printer Reference to a serial device or stream on which to print
+ */
+void dlog_drain (Print& printer)
+{
+    char line[DLOG_LINE_LENGTH + 2];
+    dlog_record_t record;
+
+    while (dlog_take (record))
+    {
+        uint32_t lost = __atomic_load_n (&dropped, __ATOMIC_RELAXED);
+        if (lost != dropped_reported)
+        {
+            printer.printf ("(%lu log messages dropped)\n",
+                            (unsigned long)(lost - dropped_reported));
+            dropped_reported = lost;
+        }
+        dlog_format (record, line, sizeof (line));
+        printer.print (line);
+    }
+}
+
+
+/** @brief   Print the number of messages logged and dropped.
+ *  @param   printer Reference to a serial device or stream on which to print
+ */
+void dlog_print_status (Print& printer)
+{
+    printer.printf ("Deferred log: %lu messages, %lu waiting, %lu dropped\n",
+                    (unsigned long)__atomic_load_n (&head, __ATOMIC_RELAXED),
+                    (unsigned long)(__atomic_load_n (&head, __ATOMIC_RELAXED)
+                                    - tail),
+                    (unsigned long)__atomic_load_n (&dropped,
+                                                    __ATOMIC_RELAXED));
+}
+
+
+/** @brief   The task which prints logged messages on the serial port.
+ *  @details Each period, every message waiting in the ring is printed. The
+ *           task should have a low priority, so that it only waits for the
+ *           serial port when nothing more urgent needs to run.
+ *  @param   p_params Pointer to this task's entry in the task table
+ */
+void task_deferlog (void* p_params)
+{
+    task_entry_t* p_task = (task_entry_t*)p_params;
+
+    for (;;)
+    {
+        dlog_drain (Serial);
+        task_wait_period (p_task);
+    }
+}
@@ -0,0 +1,179 @@
+/** @file    deferlog.h
+ *  @brief   Headers for a logger which lets tasks print messages without
+ *           waiting for the serial port.
+ *  @details A message is logged by putting a pointer to its format string
+ *           and up to @c DLOG_MAX_ARGS raw arguments into a ring buffer;
+ *           nothing is formatted until the low priority @c task_deferlog()
+ *           takes the message out of the ring and prints it. Logging a
+ *           message costs a call to @c millis(), an atomic increment and a
+ *           few stores, so it can be done in loops which must keep time.
+ *
+ *           The ring can be written by any number of tasks without a lock.
+ *           If it's full, the message is dropped and counted, and the number
+ *           of dropped messages is printed with the next message which gets
+ *           through.
+ *
+ *           Messages are logged with @c DLOG_ERROR(), @c DLOG_WARN(),
+ *           @c DLOG_INFO() and @c DLOG_DEBUG(), which take a format string
+ *           and arguments as @c printf() does. Those below @c DLOG_LEVEL
+ *           compile to nothing, though their arguments are still checked.
+ *           As only the pointer to the format string is kept, it must be a
+ *           string literal; for the same reason a @c %s argument must be a
+ *           string which is never changed or freed.
+ *           Arguments of type @c double are kept as @c float.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _DEFERLOG_H_
+#define _DEFERLOG_H_
+
+#include <Arduino.h>
+
+
+/// Level of messages which tell that something has failed
+#define DLOG_LEVEL_ERROR 1
+
+/// Level of messages which tell that something may be wrong
+#define DLOG_LEVEL_WARN 2
+
+/// Level of messages which tell what the program is doing
+#define DLOG_LEVEL_INFO 3
+
+/// Level of messages which help find bugs
+#define DLOG_LEVEL_DEBUG 4
+
+#ifndef DLOG_LEVEL
+/// Messages of this level or more important are compiled in
+#define DLOG_LEVEL DLOG_LEVEL_INFO
+#endif
+
+#ifndef DLOG_RING_SIZE
+/// Number of messages which can wait to be printed; a power of two
+#define DLOG_RING_SIZE 64
+#endif
+
+/// Largest number of arguments which a message may have
+#define DLOG_MAX_ARGS 3
+
+/// Longest line, including the time and level, which can be printed
+#define DLOG_LINE_LENGTH 100
+
+static_assert ((DLOG_RING_SIZE & (DLOG_RING_SIZE - 1)) == 0,
+               "DLOG_RING_SIZE must be a power of two");
+
+
+/** @brief   A message which waits in the ring to be printed.
+ */
+struct dlog_record_t
+{
+    const char* p_format;                     ///< Format, as for @c printf()
+    uint32_t    time_ms;                      ///< Time at which it was logged
+    uintptr_t   args[DLOG_MAX_ARGS];          ///< Arguments' raw bits
+    uint8_t     level;                        ///< Level of the message
+    uint8_t     num_args;                     ///< Number of arguments
+};
+
+
+/** @brief   One place in the ring.
+ */
+struct dlog_slot_t
+{
+    uint32_t      sequence;                   ///< Sequence less slot index
+    dlog_record_t record;                     ///< The message
+};
+
+
+/** @brief   Keep the bits of an argument so they can be formatted later.
+ *  @details There is one of these functions for each type of argument which
+ *           can be logged; a @c float is kept as its bit pattern.
+ *  @param   value The argument
+ *  @return  The argument's bits
+ */
+inline uintptr_t dlog_arg (int value)            { return (intptr_t)value; }
+inline uintptr_t dlog_arg (unsigned value)       { return value; }
+inline uintptr_t dlog_arg (long value)           { return (intptr_t)value; }
+inline uintptr_t dlog_arg (unsigned long value)  { return value; }
+inline uintptr_t dlog_arg (const char* p_value)  { return (uintptr_t)p_value; }
+inline uintptr_t dlog_arg (const void* p_value)  { return (uintptr_t)p_value; }
+inline uintptr_t dlog_arg (float value)
+{
+    uint32_t bits;
+    memcpy (&bits, &value, sizeof (bits));
+    return bits;
+}
+inline uintptr_t dlog_arg (double value)
+{
+    return dlog_arg ((float)value);
+}
+
+
+// Put a message into the ring, or count it as dropped if the ring is full
+void dlog_write (uint8_t level, const char* p_format, const uintptr_t* p_args,
+                 uint8_t num_args);
+
+
+/** @brief   Log a message with any number of arguments up to
+ *           @c DLOG_MAX_ARGS.
+ *  @details This is normally called through the @c DLOG_ macros so that
+ *           messages below @c DLOG_LEVEL disappear.
+ *  @param   level The level of the message
+ *  @param   p_format The format, as for @c printf(); a string literal
+ *  @param   args The arguments to be formatted
+ */
+template <typename... Args>
+inline void dlog_put (uint8_t level, const char* p_format, Args... args)
+{
+    static_assert (sizeof... (Args) <= DLOG_MAX_ARGS,
+                   "Too many arguments for a deferred log message");
+    const uintptr_t values[] = { dlog_arg (args)..., 0 };
+    dlog_write (level, p_format, values, sizeof... (Args));
+}
+
+
+#if DLOG_LEVEL >= DLOG_LEVEL_ERROR
+    #define DLOG_ERROR(...)  dlog_put (DLOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+    #define DLOG_ERROR(...)  do { if (0) dlog_put (DLOG_LEVEL_ERROR, \
+                                   __VA_ARGS__); } while (0)
+#endif
+
+#if DLOG_LEVEL >= DLOG_LEVEL_WARN
+    #define DLOG_WARN(...)   dlog_put (DLOG_LEVEL_WARN, __VA_ARGS__)
+#else
+    #define DLOG_WARN(...)   do { if (0) dlog_put (DLOG_LEVEL_WARN, \
+                                   __VA_ARGS__); } while (0)
+#endif
+
+#if DLOG_LEVEL >= DLOG_LEVEL_INFO
+    #define DLOG_INFO(...)   dlog_put (DLOG_LEVEL_INFO, __VA_ARGS__)
+#else
+    #define DLOG_INFO(...)   do { if (0) dlog_put (DLOG_LEVEL_INFO, \
+                                   __VA_ARGS__); } while (0)
+#endif
+
+#if DLOG_LEVEL >= DLOG_LEVEL_DEBUG
+    #define DLOG_DEBUG(...)  dlog_put (DLOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+    #define DLOG_DEBUG(...)  do { if (0) dlog_put (DLOG_LEVEL_DEBUG, \
+                                   __VA_ARGS__); } while (0)
+#endif
+
+
+// Take one message out of the ring
+bool dlog_take (dlog_record_t& record);
+
+// Format a message as a line of text
+size_t dlog_format (const dlog_record_t& record, char* p_line, size_t size);
+
+// Print all the messages which are waiting in the ring
+void dlog_drain (Print& printer);
+
+// Print the number of messages logged and dropped
+void dlog_print_status (Print& printer);
+
+// The task which prints logged messages on the serial port
+void task_deferlog (void* p_params);
+
+#endif // _DEFERLOG_H_
@@ -0,0 +1,252 @@
+/** @file    fileio.cpp
+ *  @brief   Source code for buffered reading and writing of files.
+ *  @details See @c fileio.h for an explanation of why these are used.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <Arduino.h>
+#include "fileio.h"
+
+
+/** @brief   Create a writer which uses the given buffer.
+ *  @details The buffer must last as long as the writer does.
+ *  @param   p_buf Pointer to the buffer which holds data waiting to be written
+ *  @param   size The size of the buffer in bytes
+ *  @param   flush_policy When the buffer is to be passed to the file system
+ *           (default @c FLUSH_WHEN_FULL)
+ */
+FileWriter::FileWriter (uint8_t* p_buf, size_t size,
+                        flush_policy_t flush_policy)
+    : p_buffer (p_buf), buf_size (size), buf_used (0), policy (flush_policy),
+      all_ok (false)
+{
+}
+
+
+/** @brief   Close the file, writing any data which is still in the buffer.
+ */
+FileWriter::~FileWriter (void)
+{
+    close ();
+}
+
+
+/** @brief   Open a file to be written.
+ *  @details If another file was open, it is closed first.
+ *  @param   fs The file system, such as @c LittleFS
+ *  @param   path The full path of the file
+ *  @param   mode @c "w" to replace the file or @c "a" to add to its end
+ *           (default @c "w")
+ *  @return  @c true if the file was opened, @c false if not
+ */
+bool FileWriter::open (fs::FS& fs, const char* path, const char* mode)
+{
+    close ();
+    file = fs.open (path, mode);
+    all_ok = (bool)file;
+    return all_ok;
+}
+
+
+/** @brief   Pass the buffered data to the file system.
+ *  @return  @c true if all the data was written, @c false if not
+ */
+bool FileWriter::write_out (void)
+{
+    if (buf_used > 0)
+    {
+        if (!file || file.write (p_buffer, buf_used) != buf_used)
+        {
+            all_ok = false;
+        }
+        buf_used = 0;
+    }
+    return all_ok;
+}
+
+
+/** @brief   Put one byte into the buffer.
+ *  @param   byte The byte to be written
+ *  @return  1 if the byte was taken, 0 if the file isn't open
+ */
+size_t FileWriter::write (uint8_t byte)
+{
+    if (!file)
+    {
+        return 0;
+    }
+    if (buf_used >= buf_size)
+    {
+        write_out ();
+    }
+    p_buffer[buf_used++] = byte;
+
+    if (policy == FLUSH_EACH_WRITE || (policy == FLUSH_EACH_LINE
+                                       && byte == '\n'))
+    {
+        write_out ();
+    }
+    return 1;
+}
+
+
+/** @brief   Put a block of bytes into the buffer or straight into the file.
+ *  @details A block at least as big as the buffer skips the buffer, after
+ *           whatever was buffered before it has been written, so that it
+ *           isn't copied for nothing.
+ *  @param   p_data Pointer to the bytes to be written
+ *  @param   length The number of bytes
+ *  @return  The number of bytes taken, which is 0 if the file isn't open
+ */
+size_t FileWriter::write (const uint8_t* p_data, size_t length)
+{
+    if (!file)
+    {
+        return 0;
+    }
+
+    if (length >= buf_size)
+    {
+        write_out ();
+        if (file.write (p_data, length) != length)
+        {
+            all_ok = false;
+        }
+        return length;
+    }
+
+    if (buf_used + length > buf_size)
+    {
+        write_out ();
+    }
+    memcpy (p_buffer + buf_used, p_data, length);
+    buf_used += length;
+
+    if (policy == FLUSH_EACH_WRITE || (policy == FLUSH_EACH_LINE
+                                       && memchr (p_data, '\n', length)))
+    {
+        write_out ();
+    }
+    return length;
+}
+
+
+/** @brief   Pass the buffered data to the file system.
+ *  @details The file system may keep the data in its own cache a while
+ *           longer; only @c close() makes sure it has reached the flash.
+ */
+void FileWriter::flush (void)
+{
+    write_out ();
+}
+
+
+/** @brief   Flush the buffer and close the file.
+ *  @return  @c true if every write since the file was opened succeeded
+ */
+bool FileWriter::close (void)
+{
+    if (!file)
+    {
+        return all_ok;
+    }
+    write_out ();
+    file.close ();
+    return all_ok;
+}
+
+
+/** @brief   Read a whole file into the caller's buffer in blocks.
+ *  @details The text is followed by a @c '\0'. If the file is bigger than
+ *           the buffer, only as much as fits is read.
+ *  @param   fs The file system, such as @c LittleFS
+ *  @param   path The full path of the file
+ *  @param   p_buffer Pointer to the buffer which receives the contents
+ *  @param   size The size of the buffer, which must be at least 1
+ *  @return  A view of the text in the buffer; it is empty if the file
+ *           couldn't be opened
+ */
+text_view_t read_file (fs::FS& fs, const char* path, char* p_buffer,
+                       size_t size)
+{
+    text_view_t text = { p_buffer, 0 };
+
+    p_buffer[0] = '\0';
+    File file = fs.open (path, "r");
+    if (!file || file.isDirectory ())
+    {
+        return text;
+    }
+
+    size_t got;
+    do
+    {
+        got = file.read ((uint8_t*)p_buffer + text.length,
+                         size - 1 - text.length);
+        text.length += got;
+    }
+    while (got > 0 && text.length < size - 1);
+
+    p_buffer[text.length] = '\0';
+    file.close ();
+    return text;
+}
+
+
+/** @brief   Write a block of data as the whole contents of a file.
+ *  @details The data is handed to the file system in one call.
+ *  @param   fs The file system, such as @c LittleFS
+ *  @param   path The full path of the file, which is replaced if it exists
+ *  @param   p_data Pointer to the data
+ *  @param   length The number of bytes to write
+ *  @return  @c true if all the data was written, @c false if not
+ */
+bool write_file (fs::FS& fs, const char* path, const void* p_data,
+                 size_t length)
+{
+    File file = fs.open (path, "w");
+    if (!file)
+    {
+        return false;
+    }
+    bool all_ok = (file.write ((const uint8_t*)p_data, length) == length);
+    file.close ();
+    return all_ok;
+}
+
+
+/** @brief   Copy a file, possibly from one file system to another.
+ *  @param   from_fs The file system which holds the original
+ *  @param   from_path The path of the original
+ *  @param   to_fs The file system in which the copy is made
+ *  @param   to_path The path of the copy, which is replaced if it exists
+ *  @param   p_buffer Pointer to a buffer through which the data is moved
+ *  @param   size The size of the buffer; bigger is faster
+ *  @return  @c true if the whole file was copied, @c false if not
+ */
+bool copy_file (fs::FS& from_fs, const char* from_path, fs::FS& to_fs,
+                const char* to_path, uint8_t* p_buffer, size_t size)
+{
+    File source = from_fs.open (from_path, "r");
+    if (!source || source.isDirectory ())
+    {
+        return false;
+    }
+    File dest = to_fs.open (to_path, "w");
+    if (!dest)
+    {
+        source.close ();
+        return false;
+    }
+
+    bool all_ok = true;
+    size_t got;
+    while (all_ok && (got = source.read (p_buffer, size)) > 0)
+    {
+        all_ok = (dest.write (p_buffer, got) == got);
+    }
+    dest.close ();
+    source.close ();
+    return all_ok;
+}
@@ -0,0 +1,142 @@
+/** @file    fileio.h
+ *  @brief   Headers for buffered reading and writing of files.
+ *  @details Reading a file one character at a time into a @c String makes a
+ *           call into the file system and, now and then, a reallocation for
+ *           every byte. The functions and class here move data in blocks
+ *           through buffers which belong to the caller, so no memory is
+ *           allocated from the heap and each file system call moves as many
+ *           bytes as it can.
+ *
+ *           A file which has been read is returned as a @c text_view_t, which
+ *           points into the caller's buffer rather than holding a copy, in
+ *           the manner of @c std::string_view.
+ *
+ *           The firmware uses @c write_file() to move files over from SPIFFS
+ *           when the storage backend changes and @c read_file() to read the
+ *           setpoint which older firmware saved in a file; the
+ *           @c read_file_4k and @c read_file_string_4k benchmarks compare
+ *           block reads with the character loop they replace.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _FILEIO_H_
+#define _FILEIO_H_
+
+#include <Arduino.h>
+#include <FS.h>
+
+
+/** @brief   A piece of text which is held in someone else's buffer.
+ *  @details The text is only valid for as long as the buffer is unchanged.
+ *           When it was read by @c read_file(), it is followed by a
+ *           @c '\0', so @c p_data can also be used as a C string.
+ */
+struct text_view_t
+{
+    const char* p_data;                       ///< Pointer to the first char.
+    size_t      length;                       ///< Number of characters
+
+    /// Return @c true if there is no text.
+    bool empty (void) const
+    {
+        return length == 0;
+    }
+
+    /// Return the text as an integer, as @c String::toInt() would.
+    long to_int (void) const
+    {
+        return length ? atol (p_data) : 0;
+    }
+};
+
+
+/** @brief   When a @c FileWriter passes its buffered data to the file.
+ */
+enum flush_policy_t
+{
+    FLUSH_WHEN_FULL,                          ///< Only when the buffer fills
+    FLUSH_EACH_LINE,                          ///< Also at the end of each line
+    FLUSH_EACH_WRITE                          ///< After every call to write
+};
+
+
+/** @brief   Class which writes to a file through a buffer in large blocks.
+ *  @details The writer is a @c Print, so anything which can print to a
+ *           serial port can print to a file through it. Data is kept in the
+ *           caller's buffer until the flush policy says it's time to pass it
+ *           to the file system, or until @c flush() or @c close() is called.
+ *           The destructor closes the file, so data isn't lost if the writer
+ *           goes out of scope.
+ *
+ *           @section usage_writer Usage
+ *           @code{.cpp}
+ *           uint8_t buffer[256];
+ *           FileWriter writer (buffer, sizeof (buffer), FLUSH_EACH_LINE);
+ *           if (writer.open (LittleFS, "/notes.txt", "a"))
+ *           {
+ *               writer << "Setpoint changed to " << setpoint << endl;
+ *           }
+ *           @endcode
+ */
+class FileWriter : public Print
+{
+    protected:
+        File           file;                  ///< The file being written
+        uint8_t*       p_buffer;              ///< Caller's buffer
+        size_t         buf_size;              ///< Size of the buffer
+        size_t         buf_used;              ///< Bytes waiting in the buffer
+        flush_policy_t policy;                ///< When to flush the buffer
+        bool           all_ok;                ///< No write has failed
+
+        // Pass the buffered data to the file system
+        bool write_out (void);
+
+    public:
+        // Print's other versions of write() send their data to these
+        using Print::write;
+
+        // Create a writer which uses the given buffer
+        FileWriter (uint8_t* p_buf, size_t size,
+                    flush_policy_t flush_policy = FLUSH_WHEN_FULL);
+
+        // Close the file, writing any data which is still in the buffer
+        ~FileWriter (void);
+
+        // Open a file to be written
+        bool open (fs::FS& fs, const char* path, const char* mode = "w");
+
+        // Put one byte into the buffer
+        size_t write (uint8_t byte);
+
+        // Put a block of bytes into the buffer or straight into the file
+        size_t write (const uint8_t* p_data, size_t length);
+
+        // Pass the buffered data to the file system
+        void flush (void);
+
+        // Flush the buffer and close the file
+        bool close (void);
+
+        /// Return @c true if no write has failed since the file was opened.
+        bool good (void) const
+        {
+            return all_ok;
+        }
+};
+
+
+// Read a whole file into the caller's buffer in blocks
+text_view_t read_file (fs::FS& fs, const char* path, char* p_buffer,
+                       size_t size);
+
+// Write a block of data as the whole contents of a file
+bool write_file (fs::FS& fs, const char* path, const void* p_data,
+                 size_t length);
+
+// Copy a file, possibly from one file system to another
+bool copy_file (fs::FS& from_fs, const char* from_path, fs::FS& to_fs,
+                const char* to_path, uint8_t* p_buffer, size_t size);
+
+#endif // _FILEIO_H_
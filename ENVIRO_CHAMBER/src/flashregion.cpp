@@ -0,0 +1,324 @@
+/** @file    flashregion.cpp
+ *  @brief   Source code for raw access to a region of flash memory.
+ *  @details See @c flashregion.h for a description of the regions.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <string.h>
+#include "flashregion.h"
+#ifndef ESP32
+    #include <sys/mman.h>
+#endif
+
+
+/** @brief   Create an object for the region with the given partition label.
+ *  @details Nothing is touched until @c begin() is called.
+ *  @param   p_partition_label The label of the partition in
+ *           @c partitions.csv; the string must not go away
+ *  @param   host_size The size of the image file used in place of the
+ *           partition when not running on an ESP32; ignored on an ESP32
+ */
+FlashRegion::FlashRegion (const char* p_partition_label, uint32_t host_size)
+    : p_label (p_partition_label), region_size (0), p_mapped (NULL)
+{
+#ifdef ESP32
+    (void)host_size;
+    p_partition = NULL;
+#else
+    region_size = host_size;
+    p_file = NULL;
+#endif
+}
+
+
+#ifdef ESP32
+
+/** @brief   Find the partition which holds the region.
+ *  @return  @c true if the partition was found, @c false if not
+ */
+bool FlashRegion::begin (void)
+{
+    p_partition = esp_partition_find_first (ESP_PARTITION_TYPE_DATA,
+                                            ESP_PARTITION_SUBTYPE_ANY,
+                                            p_label);
+    region_size = p_partition ? p_partition->size : 0;
+    return p_partition != NULL;
+}
+
+
+/** @brief   Read bytes from the region.
+ *  @param   offset Where to begin reading, counted from start of the region
+ *  @param   p_buffer Pointer to a buffer which receives the data
+ *  @param   length The number of bytes to read
+ *  @return  @c true if the data was read, @c false if there was an error
+ */
+bool FlashRegion::read (uint32_t offset, void* p_buffer, size_t length)
+{
+    return p_partition
+           && esp_partition_read (p_partition, offset, p_buffer, length)
+              == ESP_OK;
+}
+
+
+/** @brief   Write bytes into erased parts of the region.
+ *  @param   offset Where to begin writing, counted from start of the region
+ *  @param   p_data Pointer to the data to be written
+ *  @param   length The number of bytes to write
+ *  @return  @c true if the data was written, @c false if there was an error
+ */
+bool FlashRegion::write (uint32_t offset, const void* p_data, size_t length)
+{
+    return p_partition
+           && esp_partition_write (p_partition, offset, p_data, length)
+              == ESP_OK;
+}
+
+
+/** @brief   Erase whole sectors of the region.
+ *  @param   offset Start of the first sector to be erased
+ *  @param   length Number of bytes to erase, a multiple of the sector size
+ *  @return  @c true if the sectors were erased, @c false if there was an error
+ */
+bool FlashRegion::erase (uint32_t offset, size_t length)
+{
+    return p_partition
+           && esp_partition_erase_range (p_partition, offset, length)
+              == ESP_OK;
+}
+
+
+/** @brief   Map the whole region into memory so it can be read in place.
+ *  @details The flash cache maps the partition into the data address space.
+ *           Erasing or writing the region through this object is seen
+ *           through the mapping, as the flash driver clears the cache. Data
+ *           which is mapped takes up part of a limited address space, so
+ *           only large regions which are read often should be mapped.
+ *  @return  A pointer to the start of the region, or @c NULL if the region
+ *           couldn't be mapped
+ */
+const uint8_t* FlashRegion::map (void)
+{
+    const void* p_start;
+
+    if (p_mapped == NULL && p_partition != NULL
+        && esp_partition_mmap (p_partition, 0, region_size,
+                               SPI_FLASH_MMAP_DATA, &p_start, &map_handle)
+           == ESP_OK)
+    {
+        p_mapped = (const uint8_t*)p_start;
+    }
+    return p_mapped;
+}
+
+
+/** @brief   Undo the memory mapping.
+ */
+void FlashRegion::unmap (void)
+{
+    if (p_mapped != NULL)
+    {
+        spi_flash_munmap (map_handle);
+        p_mapped = NULL;
+    }
+}
+
+#else  // Not an ESP32, so use an image file
+
+/// Bytes which may still be changed before the power fails, or -1 for ever
+static int32_t power_bytes_left = -1;
+
+/// Set when a write or erase has been stopped by the power failing
+static bool power_cut = false;
+
+
+/** @brief   Make writes and erases in every region stop after a number of
+ *           bytes, as if the power failed then.
+ *  @details Bytes are written and erased in order, so the bytes of an
+ *           operation before the cut are changed and those after it aren't.
+ *           Calling this again restores the power first.
+ *  @param   bytes The number of bytes which may still be changed, or a
+ *           negative number for the power never to fail
+ */
+void FlashRegion::cut_power_after (int32_t bytes)
+{
+    power_bytes_left = (bytes < 0) ? -1 : bytes;
+    power_cut = false;
+}
+
+
+/** @brief   Find whether a write or erase was stopped by the power failing
+ *           since @c cut_power_after() was called.
+ *  @return  @c true if some bytes weren't written or erased
+ */
+bool FlashRegion::power_was_cut (void)
+{
+    return power_cut;
+}
+
+
+/** @brief   Find how many of the bytes in an operation may be changed before
+ *           the power fails, and count them as used.
+ *  @param   length The number of bytes which the operation would change
+ *  @return  The number of bytes which may be changed
+ */
+static size_t powered_bytes (size_t length)
+{
+    if (power_bytes_left < 0)
+    {
+        return length;
+    }
+    if (length > (size_t)power_bytes_left)
+    {
+        length = power_bytes_left;
+        power_cut = true;
+    }
+    power_bytes_left -= length;
+    return length;
+}
+
+
+/** @brief   Open the image file which stands in for the partition.
+ *  @details If the file doesn't exist or is the wrong size, it is created and
+ *           filled with @c 0xFF as if freshly erased.
+ *  @return  @c true if the file is ready, @c false if it couldn't be opened
+ */
+bool FlashRegion::begin (void)
+{
+    char path[64];
+    snprintf (path, sizeof (path), "%s.img", p_label);
+
+    if (p_file != NULL)
+    {
+        unmap ();
+        fclose (p_file);
+    }
+    p_file = fopen (path, "r+b");
+    if (p_file != NULL)
+    {
+        fseek (p_file, 0, SEEK_END);
+        if ((uint32_t)ftell (p_file) == region_size)
+        {
+            return true;
+        }
+        fclose (p_file);
+    }
+    p_file = fopen (path, "w+b");
+    return p_file != NULL && erase (0, region_size);
+}
+
+
+/** @brief   Read bytes from the image file.
+ *  @param   offset Where to begin reading, counted from start of the region
+ *  @param   p_buffer Pointer to a buffer which receives the data
+ *  @param   length The number of bytes to read
+ *  @return  @c true if the data was read, @c false if there was an error
+ */
+bool FlashRegion::read (uint32_t offset, void* p_buffer, size_t length)
+{
+    return p_file != NULL && offset + length <= region_size
+           && fseek (p_file, offset, SEEK_SET) == 0
+           && fread (p_buffer, 1, length, p_file) == length;
+}
+
+
+/** @brief   Write bytes into the image file as NOR flash would.
+ *  @details Each byte written is ANDed with what was there, because writing
+ *           flash can only clear bits.
+ *  @param   offset Where to begin writing, counted from start of the region
+ *  @param   p_data Pointer to the data to be written
+ *  @param   length The number of bytes to write
+ *  @return  @c true if the data was written, @c false if there was an error
+ */
+bool FlashRegion::write (uint32_t offset, const void* p_data, size_t length)
+{
+    uint8_t chunk[256];
+    const uint8_t* p_byte = (const uint8_t*)p_data;
+
+    while (length > 0)
+    {
+        size_t piece = (length < sizeof (chunk)) ? length : sizeof (chunk);
+        if (!read (offset, chunk, piece))
+        {
+            return false;
+        }
+        for (size_t index = 0; index < piece; index++)
+        {
+            chunk[index] &= p_byte[index];
+        }
+        size_t powered = powered_bytes (piece);
+        if (fseek (p_file, offset, SEEK_SET) != 0
+            || fwrite (chunk, 1, powered, p_file) != powered
+            || powered < piece)
+        {
+            fflush (p_file);
+            return false;
+        }
+        offset += piece;
+        p_byte += piece;
+        length -= piece;
+    }
+    return fflush (p_file) == 0;
+}
+
+
+/** @brief   Erase whole sectors of the image file by filling them with 0xFF.
+ *  @param   offset Start of the first sector to be erased
+ *  @param   length Number of bytes to erase, a multiple of the sector size
+ *  @return  @c true if the sectors were erased, @c false if there was an error
+ */
+bool FlashRegion::erase (uint32_t offset, size_t length)
+{
+    uint8_t blank[256];
+    memset (blank, 0xFF, sizeof (blank));
+
+    if (p_file == NULL || offset % FLASH_SECTOR_SIZE
+        || length % FLASH_SECTOR_SIZE || offset + length > region_size
+        || fseek (p_file, offset, SEEK_SET) != 0)
+    {
+        return false;
+    }
+    for (size_t done = 0; done < length; done += sizeof (blank))
+    {
+        size_t powered = powered_bytes (sizeof (blank));
+        if (fwrite (blank, 1, powered, p_file) != powered
+            || powered < sizeof (blank))
+        {
+            fflush (p_file);
+            return false;
+        }
+    }
+    return fflush (p_file) == 0;
+}
+
+
+/** @brief   Map the whole image file into memory so it can be read in place.
+ *  @details The file is mapped shared, so writes made through this object
+ *           are seen through the mapping.
+ *  @return  A pointer to the start of the region, or @c NULL if the file
+ *           couldn't be mapped
+ */
+const uint8_t* FlashRegion::map (void)
+{
+    if (p_mapped == NULL && p_file != NULL)
+    {
+        void* p_start = mmap (NULL, region_size, PROT_READ, MAP_SHARED,
+                              fileno (p_file), 0);
+        p_mapped = (p_start == MAP_FAILED) ? NULL : (const uint8_t*)p_start;
+    }
+    return p_mapped;
+}
+
+
+/** @brief   Undo the memory mapping.
+ */
+void FlashRegion::unmap (void)
+{
+    if (p_mapped != NULL)
+    {
+        munmap ((void*)p_mapped, region_size);
+        p_mapped = NULL;
+    }
+}
+
+#endif // ESP32
@@ -0,0 +1,117 @@
+/** @file    flashregion.h
+ *  @brief   Headers for raw access to a region of flash memory.
+ *  @details Data which is written often, such as the measurement log, is
+ *           kept in its own flash partition rather than in files, so that the
+ *           program controls exactly when sectors are erased. This class
+ *           gives read, write and erase access to one such partition.
+ *
+ *           On the ESP32 the region is a data partition found by its label in
+ *           @c partitions.csv. When compiled for a PC, the region is an image
+ *           file of the same name with the extension @c .img, which behaves
+ *           like NOR flash: erasing sets bytes to @c 0xFF, and writing can
+ *           only change bits from 1 to 0.
+ *
+ *           A region can also be mapped into the address space, so that its
+ *           contents can be read in place through a pointer without being
+ *           copied into RAM. On the ESP32 this uses the flash cache's memory
+ *           mapping; on a PC the image file is mapped with @c mmap().
+ *
+ *           On a PC, tests can make the power fail partway through a write
+ *           or an erase with @c cut_power_after(): once the given number of
+ *           bytes has been changed, nothing more is written or erased in any
+ *           region, just as if the chip had lost its supply.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _FLASHREGION_H_
+#define _FLASHREGION_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#ifdef ESP32
+    #include <esp_partition.h>
+    #include <esp_spi_flash.h>
+#else
+    #include <stdio.h>
+#endif
+
+
+/// Size of the smallest piece of flash which can be erased, in bytes
+#define FLASH_SECTOR_SIZE 4096
+
+
+/** @brief   Class which reads, writes and erases one region of flash.
+ *  @details Offsets are measured from the beginning of the region. Erasing
+ *           must be done in whole sectors of @c FLASH_SECTOR_SIZE bytes.
+ */
+class FlashRegion
+{
+    protected:
+        const char* p_label;                  ///< Partition label
+        uint32_t    region_size;              ///< Size of region in bytes
+
+        const uint8_t* p_mapped;              ///< Region's contents, if mapped
+
+    #ifdef ESP32
+        /// The partition in which the region lives
+        const esp_partition_t* p_partition;
+
+        /// Handle of the memory mapping, used to undo it
+        spi_flash_mmap_handle_t map_handle;
+    #else
+        /// The image file which stands in for the partition
+        FILE* p_file;
+    #endif
+
+    public:
+        // Create an object for the region with the given partition label
+        FlashRegion (const char* p_partition_label, uint32_t host_size);
+
+        // Find the partition or open the image file
+        bool begin (void);
+
+        // Read bytes from the region
+        bool read (uint32_t offset, void* p_buffer, size_t length);
+
+        // Write bytes into erased parts of the region
+        bool write (uint32_t offset, const void* p_data, size_t length);
+
+        // Erase whole sectors of the region
+        bool erase (uint32_t offset, size_t length);
+
+        // Map the whole region into memory so it can be read in place
+        const uint8_t* map (void);
+
+        // Undo the memory mapping
+        void unmap (void);
+
+        /// Return a pointer to the mapped region, or @c NULL if not mapped.
+        const uint8_t* mapped (void) const
+        {
+            return p_mapped;
+        }
+
+        /// Return the size of the region in bytes, or 0 before @c begin().
+        uint32_t size (void) const
+        {
+            return region_size;
+        }
+
+        /// Return the partition label which names the region.
+        const char* label (void) const
+        {
+            return p_label;
+        }
+
+    #ifndef ESP32
+        // Stop writing and erasing after a number of bytes, or never if < 0
+        static void cut_power_after (int32_t bytes);
+
+        // Find whether a write or erase was stopped since power was cut
+        static bool power_was_cut (void);
+    #endif
+};
+
+#endif // _FLASHREGION_H_
@@ -0,0 +1,145 @@
+/** @file    gpio.cpp
+ *  @brief   Source code for the recording mock of the pins used when running
+ *           on a PC, and a benchmark of the pins on an ESP32.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include "board.h"
+#include "gpio.h"
+
+
+#ifdef ESP32
+
+/// Number of times each operation is repeated by @c gpio_benchmark()
+#define GPIO_BENCHMARK_COUNT 1000
+
+
+/** @brief   Compare the cost of the pin template with @c digitalWrite() and
+ *           @c digitalRead().
+ *  @details @c GPIO_BENCHMARK_PIN is toggled high and low and the
+ *           thermocouple's data ready pin is read, each a thousand times, and
+ *           the average number of CPU cycles for each is printed. The time
+ *           taken by an empty loop is taken away. Interrupts can make a run
+ *           a little slower, so it's best to run this from @c setup() before
+ *           the tasks are started.
+ *  @param   printer Reference to a serial device on which to print results
+ */
+void gpio_benchmark (Print& printer)
+{
+    typedef Pin<GPIO_BENCHMARK_PIN, PIN_OUTPUT> BenchPin;
+    typedef Pin<board.drdy_pin, PIN_INPUT> ReadPin;
+    uint32_t start;
+    uint32_t highs = 0;
+
+    BenchPin::begin ();
+    ReadPin::begin ();
+
+    // The loop itself, which is taken out of every other measurement
+    start = ESP.getCycleCount ();
+    for (uint16_t count = 0; count < GPIO_BENCHMARK_COUNT; count++)
+    {
+        __asm__ __volatile__ ("" ::: "memory");
+    }
+    uint32_t loop = ESP.getCycleCount () - start;
+
+    start = ESP.getCycleCount ();
+    for (uint16_t count = 0; count < GPIO_BENCHMARK_COUNT; count++)
+    {
+        BenchPin::set ();
+        BenchPin::clear ();
+        __asm__ __volatile__ ("" ::: "memory");
+    }
+    uint32_t pin_toggle = ESP.getCycleCount () - start - loop;
+
+    start = ESP.getCycleCount ();
+    for (uint16_t count = 0; count < GPIO_BENCHMARK_COUNT; count++)
+    {
+        digitalWrite (GPIO_BENCHMARK_PIN, HIGH);
+        digitalWrite (GPIO_BENCHMARK_PIN, LOW);
+    }
+    uint32_t arduino_toggle = ESP.getCycleCount () - start - loop;
+
+    start = ESP.getCycleCount ();
+    for (uint16_t count = 0; count < GPIO_BENCHMARK_COUNT; count++)
+    {
+        highs += ReadPin::read ();
+        __asm__ __volatile__ ("" ::: "memory");
+    }
+    uint32_t pin_read = ESP.getCycleCount () - start - loop;
+
+    start = ESP.getCycleCount ();
+    for (uint16_t count = 0; count < GPIO_BENCHMARK_COUNT; count++)
+    {
+        highs += digitalRead (board.drdy_pin);
+    }
+    uint32_t arduino_read = ESP.getCycleCount () - start - loop;
+
+    printer.printf ("GPIO cycles: toggle %lu (digitalWrite %lu), "
+                    "read %lu (digitalRead %lu), %lu reads high\n",
+                    (unsigned long)(pin_toggle / GPIO_BENCHMARK_COUNT),
+                    (unsigned long)(arduino_toggle / GPIO_BENCHMARK_COUNT),
+                    (unsigned long)(pin_read / GPIO_BENCHMARK_COUNT),
+                    (unsigned long)(arduino_read / GPIO_BENCHMARK_COUNT),
+                    (unsigned long)highs);
+}
+
+#else
+
+/// Levels of the simulated pins, 0 or 1, when running on a PC
+uint8_t gpio_sim_level[GPIO_NUM_PINS];
+
+/// The time written into records; the simulator keeps this up to date
+uint32_t gpio_sim_time_us = 0;
+
+/// Function called before each read of a simulated pin, if not @c NULL
+void (*gpio_sim_read_hook) (uint8_t pin) = NULL;
+
+/// Ring buffer of the latest writes to simulated pins
+static gpio_sim_record_t sim_records[GPIO_SIM_RECORDS];
+
+/// Total number of writes recorded since the ring was last cleared
+static uint32_t sim_count = 0;
+
+
+/** @brief   Record a write to a simulated pin.
+ *  @details When the ring is full the oldest write is forgotten.
+ *  @param   pin The pin which was written
+ *  @param   level The level written to it, 0 or 1
+ */
+void gpio_sim_record (uint8_t pin, uint8_t level)
+{
+    gpio_sim_record_t& record = sim_records[sim_count++ % GPIO_SIM_RECORDS];
+    record.time_us = gpio_sim_time_us;
+    record.pin = pin;
+    record.level = level;
+}
+
+
+/** @brief   Get one of the recorded writes to simulated pins.
+ *  @param   index Which write to get, 0 being the oldest still kept
+ *  @param   record Reference to a record which receives the write
+ *  @return  @c true if there was such a write, @c false if not
+ */
+bool gpio_sim_history (uint16_t index, gpio_sim_record_t& record)
+{
+    uint32_t kept = (sim_count < GPIO_SIM_RECORDS) ? sim_count
+                                                   : GPIO_SIM_RECORDS;
+    if (index >= kept)
+    {
+        return false;
+    }
+    record = sim_records[(sim_count - kept + index) % GPIO_SIM_RECORDS];
+    return true;
+}
+
+
+/** @brief   Forget the recorded writes to simulated pins.
+ *  @details The pins' levels are left as they are.
+ */
+void gpio_sim_clear (void)
+{
+    sim_count = 0;
+}
+
+#endif
@@ -0,0 +1,198 @@
+/** @file    gpio.h
+ *  @brief   A template for pins whose numbers are known when the program is
+ *           compiled.
+ *  @details @c digitalWrite() and @c digitalRead() look up the pin's
+ *           registers every time they're called. When the pin number is a
+ *           template parameter, as in @c Pin<board.heater_pin, PIN_OUTPUT>,
+ *           the compiler picks the register and mask itself, so setting the
+ *           pin is one store to the ESP32's write-one-to-set or
+ *           write-one-to-clear register and reading it is one load. Using an
+ *           output as an input, or the other way around, doesn't compile.
+ *
+ *           On a PC the pins are entries in @c gpio_sim_level[], which
+ *           simulated devices read and write, and every write is recorded
+ *           with the time in @c gpio_sim_time_us so that tests can check what
+ *           the firmware did to its outputs and when.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _GPIO_H_
+#define _GPIO_H_
+
+#include <Arduino.h>
+#ifdef ESP32
+    #include "soc/gpio_struct.h"
+#endif
+
+
+/// Number of GPIO pins on an ESP32, some of which aren't brought out
+#define GPIO_NUM_PINS 40
+
+/// Number of pin writes kept by the recording mock on a PC
+#define GPIO_SIM_RECORDS 256
+
+#ifndef GPIO_BENCHMARK_PIN
+/// Pin toggled by @c gpio_benchmark(); the Feather's red LED is on GPIO 13
+#define GPIO_BENCHMARK_PIN 13
+#endif
+
+
+/// The ways in which a pin can be used
+enum pin_mode_t : uint8_t
+{
+    PIN_OUTPUT,                               ///< Driven by the ESP32
+    PIN_INPUT,                                ///< Read, driven by a device
+    PIN_INPUT_PULLUP                          ///< Read, with a pullup
+};
+
+
+#ifndef ESP32
+    /** @brief   One write to a simulated pin.
+     */
+    struct gpio_sim_record_t
+    {
+        uint32_t time_us;                     ///< Simulated time of the write
+        uint8_t  pin;                         ///< Which pin was written
+        uint8_t  level;                       ///< Written level, 0 or 1
+    };
+
+    /// Levels of the simulated pins, 0 or 1, when running on a PC
+    extern uint8_t gpio_sim_level[GPIO_NUM_PINS];
+
+    /// The time written into records; the simulator keeps this up to date
+    extern uint32_t gpio_sim_time_us;
+
+    /// Function called before each read of a simulated pin, if not @c NULL,
+    /// so that a simulator can let time pass while a task polls
+    extern void (*gpio_sim_read_hook) (uint8_t pin);
+
+    // Record a write to a simulated pin
+    void gpio_sim_record (uint8_t pin, uint8_t level);
+
+    // Get one of the recorded writes, the oldest first
+    bool gpio_sim_history (uint16_t index, gpio_sim_record_t& record);
+
+    // Forget the recorded writes
+    void gpio_sim_clear (void);
+#endif
+
+
+/** @brief   A pin whose number and use are fixed when the program is
+ *           compiled.
+ *  @tparam  N The pin's GPIO number
+ *  @tparam  M How the pin is used, one of @c pin_mode_t
+ */
+template <uint8_t N, pin_mode_t M>
+class Pin
+{
+    static_assert (N < GPIO_NUM_PINS, "There's no such GPIO pin");
+    static_assert (M != PIN_OUTPUT || N < 34,
+                   "GPIO 34 to 39 can only be inputs");
+
+    /// Mask of the pin's bit in its bank's registers
+    static constexpr uint32_t mask = 1UL << (N & 31);
+
+public:
+    /// Set the pin's mode; call this once before using the pin
+    static void begin (void)
+    {
+        #ifdef ESP32
+            pinMode (N, (M == PIN_OUTPUT) ? OUTPUT
+                        : (M == PIN_INPUT_PULLUP) ? INPUT_PULLUP : INPUT);
+        #else
+            // An input's level belongs to whatever simulated device drives it
+            if (M == PIN_INPUT_PULLUP)
+            {
+                gpio_sim_level[N] = 1;
+            }
+        #endif
+    }
+
+    /// Set an output high
+    static inline void set (void)
+    {
+        static_assert (M == PIN_OUTPUT, "Only an output can be set");
+        #ifdef ESP32
+            if (N < 32)
+            {
+                GPIO.out_w1ts = mask;
+            }
+            else
+            {
+                GPIO.out1_w1ts.val = mask;
+            }
+        #else
+            gpio_sim_level[N] = 1;
+            gpio_sim_record (N, 1);
+        #endif
+    }
+
+    /// Set an output low
+    static inline void clear (void)
+    {
+        static_assert (M == PIN_OUTPUT, "Only an output can be cleared");
+        #ifdef ESP32
+            if (N < 32)
+            {
+                GPIO.out_w1tc = mask;
+            }
+            else
+            {
+                GPIO.out1_w1tc.val = mask;
+            }
+        #else
+            gpio_sim_level[N] = 0;
+            gpio_sim_record (N, 0);
+        #endif
+    }
+
+    /// Set an output high if @c level is @c true or low if it's @c false
+    static inline void write (bool level)
+    {
+        if (level)
+        {
+            set ();
+        }
+        else
+        {
+            clear ();
+        }
+    }
+
+    /// Return @c true if the pin is high
+    static inline bool read (void)
+    {
+        #ifdef ESP32
+            if (N < 32)
+            {
+                return (GPIO.in & mask) != 0;
+            }
+            return (GPIO.in1.data & mask) != 0;
+        #else
+            if (gpio_sim_read_hook != NULL)
+            {
+                gpio_sim_read_hook (N);
+            }
+            return gpio_sim_level[N] != 0;
+        #endif
+    }
+};
+
+
+/// A pin which is used as an output
+template <uint8_t N>
+using OutputPin = Pin<N, PIN_OUTPUT>;
+
+/// A pin which is used as an input
+template <uint8_t N>
+using InputPin = Pin<N, PIN_INPUT>;
+
+
+#ifdef ESP32
+    // Compare the cost of these pins with digitalWrite() and digitalRead()
+    void gpio_benchmark (Print& printer);
+#endif
+
+#endif // _GPIO_H_
@@ -0,0 +1,149 @@
+/** @file    journal.cpp
+ *  @brief   Source code for a record kept in flash which survives power
+ *           failures.
+ *  @details See @c journal.h for how the two copies are used.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <string.h>
+#include "crc.h"
+#include "journal.h"
+
+
+/** @brief   Compute the CRC which protects one copy of the record.
+ *  @param   header The copy's header, whose @c crc field is ignored
+ *  @param   p_record Pointer to the record
+ *  @return  The CRC-32 of the sequence number, size and record
+ */
+static uint32_t copy_crc (const journal_header_t& header, const void* p_record)
+{
+    uint32_t crc = crc32 (&header.seq, sizeof (header.seq));
+    crc = crc32 (&header.length, sizeof (header.length), crc);
+    return crc32 (p_record, header.length, crc);
+}
+
+
+/** @brief   Create a journal which lives in the given flash region.
+ *  @details Nothing is read or written until @c begin() is called.
+ *  @param   flash The flash region which holds the two copies
+ */
+Journal::Journal (FlashRegion& flash)
+    : region (flash), newest_seq (0), newest_slot (-1), num_saves (0)
+{
+}
+
+
+/** @brief   Read and check the copy in one slot.
+ *  @param   slot The slot, 0 or 1
+ *  @param   header Reference to a header which receives the copy's header
+ *  @param   p_record Pointer to a buffer which receives the record
+ *  @param   size The size of the buffer
+ *  @return  @c true if the copy is good and fits in the buffer
+ */
+bool Journal::read_slot (uint8_t slot, journal_header_t& header,
+                         void* p_record, size_t size)
+{
+    uint32_t offset = (uint32_t)slot * FLASH_SECTOR_SIZE;
+
+    return region.read (offset, &header, sizeof (header))
+           && header.magic == JOURNAL_MAGIC
+           && header.length <= JOURNAL_MAX_RECORD && header.length <= size
+           && region.read (offset + sizeof (header), p_record, header.length)
+           && copy_crc (header, p_record) == header.crc;
+}
+
+
+/** @brief   Find the region and the newest good copy of the record.
+ *  @details Only the two copies are read, so this takes the same short time
+ *           however often the record has been saved.
+ *  @return  @c true if the region is usable, even if it holds no record yet
+ */
+bool Journal::begin (void)
+{
+    journal_header_t header;
+    uint8_t record[JOURNAL_MAX_RECORD];
+
+    if (!region.begin () || region.size () < 2 * FLASH_SECTOR_SIZE)
+    {
+        return false;
+    }
+
+    newest_slot = -1;
+    for (uint8_t slot = 0; slot < 2; slot++)
+    {
+        if (read_slot (slot, header, record, sizeof (record))
+            && (newest_slot < 0 || (int32_t)(header.seq - newest_seq) > 0))
+        {
+            newest_slot = slot;
+            newest_seq = header.seq;
+        }
+    }
+    return true;
+}
+
+
+/** @brief   Copy the newest good record into a buffer.
+ *  @param   p_record Pointer to a buffer which receives the record
+ *  @param   size The size of the buffer
+ *  @return  The size of the record, or 0 if there is none or it doesn't fit
+ */
+size_t Journal::load (void* p_record, size_t size)
+{
+    journal_header_t header;
+
+    if (newest_slot < 0
+        || !read_slot (newest_slot, header, p_record, size))
+    {
+        return 0;
+    }
+    return header.length;
+}
+
+
+/** @brief   Save a new version of the record.
+ *  @details The slot which doesn't hold the newest copy is erased and the
+ *           new copy written there. Erasing a sector takes tens of
+ *           milliseconds, so this should be called from a task which can
+ *           afford to wait.
+ *  @param   p_record Pointer to the record
+ *  @param   length The size of the record, at most @c JOURNAL_MAX_RECORD
+ *  @return  @c true if the copy was written and reads back correctly
+ */
+bool Journal::save (const void* p_record, size_t length)
+{
+    if (length > JOURNAL_MAX_RECORD || region.size () == 0)
+    {
+        return false;
+    }
+
+    uint8_t buffer[sizeof (journal_header_t) + JOURNAL_MAX_RECORD];
+    journal_header_t& header = *(journal_header_t*)buffer;
+    header.magic = JOURNAL_MAGIC;
+    header.seq = (newest_slot < 0) ? 0 : newest_seq + 1;
+    header.length = (uint16_t)length;
+    header.reserved = 0xFFFF;
+    header.crc = copy_crc (header, p_record);
+    memcpy (buffer + sizeof (header), p_record, length);
+
+    uint8_t slot = (newest_slot == 0) ? 1 : 0;
+    uint32_t offset = (uint32_t)slot * FLASH_SECTOR_SIZE;
+    if (!region.erase (offset, FLASH_SECTOR_SIZE)
+        || !region.write (offset, buffer, sizeof (header) + length))
+    {
+        return false;
+    }
+
+    // Make sure the copy really is good before counting on it
+    journal_header_t check;
+    uint8_t record[JOURNAL_MAX_RECORD];
+    if (!read_slot (slot, check, record, sizeof (record))
+        || check.seq != header.seq)
+    {
+        return false;
+    }
+    newest_slot = slot;
+    newest_seq = header.seq;
+    num_saves++;
+    return true;
+}
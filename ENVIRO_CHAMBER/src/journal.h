@@ -0,0 +1,91 @@
+/** @file    journal.h
+ *  @brief   Headers for a record kept in flash which survives power failures.
+ *  @details A journal holds one small record, such as the state of the
+ *           controller, in two copies kept in two flash sectors. Each save
+ *           erases and writes the sector holding the older copy, so the newer
+ *           copy is never touched while a save is under way. Each copy has a
+ *           sequence number and a CRC; at startup both headers are read and
+ *           the newest copy whose CRC is good is used. If the power fails
+ *           during a save, that copy is bad and the one before it is found
+ *           instead, so a record is never lost or half written.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _JOURNAL_H_
+#define _JOURNAL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "flashregion.h"
+
+
+/// Largest record which a journal can hold, in bytes
+#define JOURNAL_MAX_RECORD 64
+
+/// Number written at the start of each copy of the record
+#define JOURNAL_MAGIC 0x4C4E524A
+
+
+/** @brief   The header written before each copy of the record.
+ */
+struct journal_header_t
+{
+    uint32_t magic;                           ///< @c JOURNAL_MAGIC
+    uint32_t seq;                             ///< Higher for newer copies
+    uint16_t length;                          ///< Size of the record
+    uint16_t reserved;                        ///< Unused, must be 0xFFFF
+    uint32_t crc;                             ///< CRC-32 of seq, size, record
+};
+
+
+/** @brief   Class which keeps one record in two copies in flash.
+ *  @details The journal uses the first two sectors of its flash region.
+ *           It does no locking of its own.
+ */
+class Journal
+{
+    protected:
+        FlashRegion& region;                  ///< Flash holding the copies
+        uint32_t     newest_seq;              ///< Sequence number of newest
+        int8_t       newest_slot;             ///< Sector of newest, or -1
+        uint32_t     num_saves;               ///< Saves since startup
+
+        // Read and check the copy in one slot
+        bool read_slot (uint8_t slot, journal_header_t& header, void* p_record,
+                        size_t size);
+
+    public:
+        // Create a journal which lives in the given flash region
+        Journal (FlashRegion& flash);
+
+        // Find the region and the newest good copy of the record
+        bool begin (void);
+
+        // Copy the newest good record into a buffer
+        size_t load (void* p_record, size_t size);
+
+        // Save a new version of the record
+        bool save (const void* p_record, size_t length);
+
+        /// Return @c true if a good copy of the record was found or saved.
+        bool has_record (void) const
+        {
+            return newest_slot >= 0;
+        }
+
+        /// Return the sequence number of the newest copy.
+        uint32_t sequence (void) const
+        {
+            return newest_seq;
+        }
+
+        /// Return the number of saves since startup.
+        uint32_t saves (void) const
+        {
+            return num_saves;
+        }
+};
+
+#endif // _JOURNAL_H_
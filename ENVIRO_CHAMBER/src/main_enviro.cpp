@@ -9,35 +9,36 @@
 
 #include <Arduino.h>
 #include <string>
+#include <memory>
 #include <PrintStream.h>
-#include <Adafruit_MAX31856.h>
 #include <WiFi.h>
 #include <SPI.h>
 #include <AsyncTCP.h>
 #include <ESPAsyncWebServer.h>
-#include <SPIFFS.h>
 #include <Wire.h>
 //#include "task_wifi.h"
 #include "taskshare.h"
-
-/// DRDY PIN FOR THERM
-#define DRDY_PIN 25
-/// CHIP SELECT 1 PIN
-#define CS1_PIN 4     
-/// CHIP SELECT 2 PIN
-#define CS2_PIN 5   
-/// CHIP SELECT 3 PIN
-#define CS3_PIN 6   
-/// HEATER CONTROL PIN
-#define HEATER_PIN 27 
-/// SCK PIN NUMBER
-#define SCK 30       
-/// SDO PIN NUMBER 
-#define SDO 31     
-/// SDI PIN NUMBER   
-#define SDI 37       
-/// THRESHOLD FOR HEATER ON/OFF
-#define THRESHOLD 10
+#include "task_mqtt.h"
+#include "tasktable.h"
+#include "ratelimit.h"
+#include "stats.h"
+#include "rollup.h"
+#include "taskqueue.h"
+#include "task_logger.h"
+#include "configstore.h"
+#include "storage.h"
+#include "fileio.h"
+#include "ctrlstate.h"
+#include "warmstart.h"
+#include "membudget.h"
+#include "profiler.h"
+#include "trace.h"
+#include "deferlog.h"
+#include "console.h"
+#include "telemetry.h"
+#include "board.h"
+#include "gpio.h"
+#include "control.h"
 
 /// Share to communicate the desired temperature setpoint
 Share<int16_t> desired_temp ("Temperature");
@@ -45,12 +46,105 @@ Share<int16_t> desired_temp ("Temperature");
 /// Share to communicate the current temperature reading
 Share<int16_t> temp_reading ("Curr Temp");
 
+/// Share to communicate the thermocouple reading at full resolution
+Share<float> therm_temp ("Therm Temp");
+
+/// Share to communicate whether the heater is turned on
+Share<bool> heater_on ("Heater On");
+
+/// Share to communicate windowed statistics of the chamber's data
+Share<stats_snapshot_t> chamber_stats ("Statistics");
+
+#ifdef STATIC_ALLOCATION
+    /// Memory for the items in @c log_queue
+    static uint8_t log_queue_storage[LOGGER_QUEUE_SIZE * sizeof (sample_t)];
+
+    /// Memory for the FreeRTOS queue which @c log_queue uses
+    static StaticQueue_t log_queue_control;
+
+    /// Queue which carries samples from the sensor task to the logger task
+    Queue<sample_t> log_queue (LOGGER_QUEUE_SIZE, log_queue_storage,
+                               &log_queue_control, "Log Queue");
+#else
+    /// Queue which carries samples from the sensor task to the logger task
+    Queue<sample_t> log_queue (LOGGER_QUEUE_SIZE, "Log Queue");
+#endif
+
+/// The flash partition which holds the settings that survive a reset
+FlashRegion config_flash ("config", 0x10000);
+
+/// Store of the settings which survive a reset, such as the setpoint
+ConfigStore config (config_flash);
+
 /// A pointer to the web server object
 AsyncWebServer* p_server = NULL;
 
 /// String for the input parameter
 const char* PARAM_INT = "inputInt";
 
+/// Indices of the web server's routes in the table of rate limits
+enum web_route_t
+{
+    ROUTE_INDEX,                              ///< The page with the form
+    ROUTE_GET,                                ///< Setpoint entry, writes flash
+    ROUTE_TASKS,                              ///< Task timing report
+    ROUTE_PROFILE,                            ///< CPU profile of the tasks
+    ROUTE_TRACE,                              ///< Binary event trace
+    ROUTE_HISTORY,                            ///< Temperature history
+    ROUTE_LOG,                                ///< Samples from the flash log
+    ROUTE_OTHER                               ///< Anything else; not found
+};
+
+/// Sustained and burst rates allowed per client on each web route
+const route_limit_t route_limits[] =
+{
+//   Per sec  Burst
+    {  5,      10 },                          // ROUTE_INDEX
+    {  1,       3 },                          // ROUTE_GET
+    {  1,       5 },                          // ROUTE_TASKS
+    {  1,       5 },                          // ROUTE_PROFILE
+    {  1,       2 },                          // ROUTE_TRACE
+    {  1,       3 },                          // ROUTE_HISTORY
+    {  1,       2 },                          // ROUTE_LOG
+    {  2,       5 }                           // ROUTE_OTHER
+};
+
+static_assert (sizeof (route_limits) / sizeof (route_limits[0])
+               <= RATE_LIMIT_MAX_ROUTES, "Too many routes for the limiter");
+
+/// Limiter which turns away web requests that come too fast or too many
+RateLimiter web_limiter (route_limits,
+                         sizeof (route_limits) / sizeof (route_limits[0]), 4);
+
+/// The large buffers which are set aside when the program is built
+constexpr memory_item_t memory_budget[] =
+{
+#ifdef STATIC_ALLOCATION
+    { "Task stacks",     TASK_STACK_ARENA_BYTES                          },
+    { "Task blocks",     TASK_TABLE_MAX * sizeof (StaticTask_t)          },
+    { "Log queue",       LOGGER_QUEUE_SIZE * sizeof (sample_t)
+                         + sizeof (StaticQueue_t)                        },
+#endif
+#ifdef TRACE_ENABLED
+    { "Event trace",     TRACE_CORES * TRACE_EVENTS_PER_CORE
+                         * sizeof (trace_event_t)                        },
+#endif
+    { "Data log",        sizeof (TsLog)                                  },
+    { "Settings",        sizeof (ConfigStore)                            },
+    { "History rollups", ROLLUP_RECORDS * sizeof (rollup_record_t)       },
+    { "Statistics",      2 * sizeof (stats_snapshot_t)
+                         + STATS_NUM_CHANNELS * STATS_NUM_WINDOWS
+                           * sizeof (SlidingStats)                       },
+    { "Heap history",    HEAP_HISTORY * sizeof (heap_sample_t)           },
+    { "Deferred log",    DLOG_RING_SIZE * sizeof (dlog_slot_t)          },
+    { "Rate limiter",    sizeof (RateLimiter)                            }
+};
+
+static_assert (memory_total (memory_budget, sizeof (memory_budget)
+                                            / sizeof (memory_budget[0]))
+               <= STATIC_RAM_BUDGET,
+               "The static buffers need more RAM than STATIC_RAM_BUDGET");
+
 // HTML web page to handle input field (inputInt)
 const char index_html[] PROGMEM = R"rawliteral(
     <!DOCTYPE HTML><html><head>
@@ -59,7 +153,7 @@ const char index_html[] PROGMEM = R"rawliteral(
     <meta name="viewport" content="width=device-width, initial-scale=1">
     <script>
         function submitMessage() {
-        alert("Saved value to ESP SPIFFS");
+        alert("Saved setpoint to ESP flash");
         setTimeout(function(){ document.location.reload(false); }, 500);   
         }
     </script></head><body>
@@ -71,62 +165,6 @@ const char index_html[] PROGMEM = R"rawliteral(
     <iframe style="display:none" name="hidden-form"></iframe>
     </body></html>)rawliteral";
 
-/** @brief   Read a character array from a serial device, echoing input.
- *  @details This function reads characters which are typed by a user into a
- *           serial device. It uses the Arduino function @c readBytes(), which
- *           blocks the task which calls this function until a character is
- *           read. When any character is received, it is echoed through the
- *           serial port so the user can see what was typed. 
- * 
- *           @b NOTE: When run on an ESP32 using FreeRTOS, this function must
- *           allow other tasks to run, so that the watchdog timer is reset.
- *           Otherwise the CPU will be reset.  The @c vTaskDelay() call does
- *           this. 
- *  @param   stream The serial device such as @c Serial used to communicate
- *  @param   buffer A character buffer in which to store the string; this
- *           buffer had better be at least @c size characters in length
- *  @param   size At most (this many - 1) characters will be read and stored 
- */
-void enterStringWithEcho (Stream& stream, char* buffer, uint8_t size)
-{
-    int ch_in = 0;                            // One character from the buffer
-    uint8_t count = 0;                        // Counts characters received
-
-    // Read until return is received or too many characters have been read.
-    // The readBytes function blocks while waiting for characters
-    while (true)
-    {
-        ch_in = stream.read ();               // Gets char. or -1 if none there
-        if (ch_in > 0)
-        {
-            stream.print ((char)ch_in);       // Echo the character
-            if (ch_in == '\b' && count)       // If a backspace, back up one
-            {                                 // character and try again
-                count -= 2;
-            }
-            else if (ch_in == '\r')           // Ignore carriage returns
-            {
-            }
-            else if (ch_in == '\n' || count >= (size - 1))
-            {
-                buffer[count] = '\0';         // String must have a \0 at end
-                return;
-            }
-            else
-            {
-                buffer[count++] = ch_in;
-            }
-        }
-        else
-        {
-            // If using FreeRTOS, yield so other tasks can run
-            #ifdef FREERTOS_CONFIG_H
-                vTaskDelay (1);
-            #endif
-        }
-    }
-}
-
 /** @brief   Handle not found error.
  *  @details This function handles a notfound error for the wifi server
  * 
@@ -138,65 +176,47 @@ void notFound(AsyncWebServerRequest *request) {
   request->send(404, "text/plain", "Not found");
 }
 
-/** @brief   Read user input from file.
- *  @details This function reads the user input from a file.
- *           The file is opened and then checked for any errors before attempting
- *           to read the user input.
- * 
- *           @b NOTE: This function is included from 
- *           https://randomnerdtutorials.com/esp32-esp8266-input-data-html-form/
- *  @param   fs SPIFFS adress file
- *  @param   path the path to look for the file
- * 
- *  @return  returns the string read from the file
- */
-String readFile(fs::FS &fs, const char * path){
-  //Serial.printf("Reading file: %s\r\n", path);
-  File file = fs.open(path, "r");
-  //do you have to close files in c++? - Trent
-  if(!file || file.isDirectory()){
-    Serial.println("- empty file or failed to open file");
-    return String();
-  }
-  //Serial.println("- read from file:");
-  String fileContent;
-  while(file.available()){
-    fileContent+=String((char)file.read());
-  }
-  //Serial.println(fileContent);
-  return fileContent;
-}
-
-/** @brief   Write user input to file.
- *  @details This function writes the user input to a file.
- *           The file is opened and then checked for any errors before attempting
- *           to write the user input.
- * 
- *           @b NOTE: This function is included from 
- *           https://randomnerdtutorials.com/esp32-esp8266-input-data-html-form/
- *  @param   fs SPIFFS adress file
- *  @param   path the path to look for the file
- *  @param   message what to write to the file
+/** @brief   Wrap a web request handler so that it is rate limited.
+ *  @details The returned handler checks each request with @c web_limiter
+ *           before anything else is done. Requests which are over the limit
+ *           are answered at once with status 429 or 503 and never reach
+ *           @c handler. The check runs once the server has parsed the
+ *           request, so admitted requests count against the cap on requests
+ *           in flight from then until their client disconnects; connections
+ *           which never send a whole request aren't counted.
+ *  @param   route Index of the route in the table of rate limits
+ *  @param   handler The function which handles admitted requests
+ *  @return  A handler function to be given to @c AsyncWebServer::on()
  */
-void writeFile(fs::FS &fs, const char * path, const char * message){
-  //Serial.printf("Writing file: %s\r\n", path);
-  File file = fs.open(path, "w");
-  if(!file){
-    Serial.println("- failed to open file for writing");
-    return;
-  }
-  if(file.print(message)){
-    //Serial.println("- file written");
-  } else {
-    Serial.println("- write failed");
-  }
+ArRequestHandlerFunction rate_limited (web_route_t route,
+                                       ArRequestHandlerFunction handler)
+{
+    return [route, handler] (AsyncWebServerRequest *request)
+    {
+        uint16_t status = web_limiter.admit (
+            (uint32_t)request->client ()->remoteIP (), route, millis ());
+        if (status != RATE_LIMIT_OK)
+        {
+            AsyncWebServerResponse *response = request->beginResponse (status,
+                "text/plain", (status == RATE_LIMIT_BUSY) ? "Server busy"
+                                                          : "Too many requests");
+            response->addHeader ("Retry-After", "1");
+            request->send (response);
+            return;
+        }
+        request->onDisconnect ([] () { web_limiter.release (); });
+        TRACE_INSTANT (TRACE_WEB_REQUEST, route);
+        handler (request);
+    };
 }
 
 // Replaces placeholder with stored values
 String processor(const String& var){
   //Serial.println(var);
   if(var == "inputInt"){
-    return readFile(SPIFFS, "/inputInt.txt");
+    int16_t setpoint;
+    desired_temp.get(setpoint);
+    return String(setpoint);
   }
   return String();
 }
@@ -209,7 +229,7 @@ String processor(const String& var){
  */
 void task_WiFi (void* p_params)
 {
-    (void)p_params;
+    task_entry_t* p_task = (task_entry_t*)p_params;
 
     // Create a web server object which will listen on TCP port 80
     AsyncWebServer server (80);
@@ -219,9 +239,9 @@ void task_WiFi (void* p_params)
     char essid_buf[36];
     char pw_buf[36];
     Serial << "Enter WiFi SSID: ";
-    enterStringWithEcho (Serial, essid_buf, 34);
+    console_read_line (essid_buf, 34);
     Serial << "Enter WiFi password: ";
-    enterStringWithEcho (Serial, pw_buf, 34);
+    console_read_line (pw_buf, 34);
 
     // Connect to your WiFi network
     Serial << endl << "WiFi connecting to \"" << essid_buf << "\""
@@ -237,20 +257,35 @@ void task_WiFi (void* p_params)
     }
     Serial << endl << "WiFi connected at IP " << WiFi.localIP () << endl;
 
+    // Set the clock from the network so that logged samples get real times
+    configTime (0, 0, "pool.ntp.org");
+
     // Send web page with input fields to client
-    server.on("/", HTTP_GET, [](AsyncWebServerRequest *request){
+    server.on("/", HTTP_GET, rate_limited(ROUTE_INDEX, [](AsyncWebServerRequest *request){
         request->send_P(200, "text/html", index_html);
-        });
+        }));
 
     // Send a GET request to <ESP_IP>/get?input1=<inputMessage>
-    server.on("/get", HTTP_GET, [] (AsyncWebServerRequest *request) {
+    server.on("/get", HTTP_GET, rate_limited(ROUTE_GET, [] (AsyncWebServerRequest *request) {
     String inputMessage;
     String inputParam;
     
-    // GET inputInt value on <ESP_IP>/get?inputInt=<inputMessage>
+    // GET inputInt value on <ESP_IP>/get?inputInt=<inputMessage>; anything
+    // but a whole number of degrees in the allowed range is refused
     if (request->hasParam(PARAM_INT)) {
       inputMessage = request->getParam(PARAM_INT)->value();
-      writeFile(SPIFFS, "/inputInt.txt", inputMessage.c_str());
+      const char* p_text = inputMessage.c_str();
+      char* p_end;
+      long setpoint = strtol(p_text, &p_end, 10);
+      if (p_end == p_text || *p_end != '\0' || setpoint < CONFIG_SETPOINT_MIN
+          || setpoint > CONFIG_SETPOINT_MAX) {
+        request->send(400, "text/plain", "Setpoint must be a whole number from "
+                      + String(CONFIG_SETPOINT_MIN) + " to "
+                      + String(CONFIG_SETPOINT_MAX) + " C");
+        return;
+      }
+      desired_temp.put((int16_t)setpoint);
+      ctrlstate_request_save();
     }
     else {
       inputMessage = "No message sent";
@@ -259,12 +294,96 @@ void task_WiFi (void* p_params)
     request->send(200, "text/html", "HTTP GET request sent to your ESP on input field (" 
                                      + inputParam + ") with value: " + inputMessage +
                                      "<br><a href=\"/\">Return to Home Page</a>");
-    });
-
+    }));
+
+
+    // Send a report of each task's CPU use, timing jitter and stack space
+    server.on("/tasks", HTTP_GET, rate_limited(ROUTE_TASKS, [](AsyncWebServerRequest *request){
+        AsyncResponseStream *response = request->beginResponseStream("text/plain");
+        print_task_table(*response);
+        #ifdef TASK_STACK_DIAGNOSTICS
+            print_stack_suggestions(*response);
+        #endif
+        print_heap(*response);
+        print_memory_budget(*response, memory_budget,
+                            sizeof(memory_budget) / sizeof(memory_budget[0]));
+        web_limiter.print_status(*response);
+        logger_print_status(*response);
+        dlog_print_status(*response);
+        request->send(response);
+        }));
+
+    // Send each task's share of the CPU and each core's idle time
+    server.on("/profile", HTTP_GET, rate_limited(ROUTE_PROFILE, [](AsyncWebServerRequest *request){
+        AsyncResponseStream *response = request->beginResponseStream("text/plain");
+        print_profile(*response);
+        request->send(response);
+        }));
+
+    #ifdef TRACE_ENABLED
+        // Send the latest traced events in binary; tools/trace2json.py
+        // turns them into a timeline which can be viewed in a browser
+        server.on("/trace", HTTP_GET, rate_limited(ROUTE_TRACE, [](AsyncWebServerRequest *request){
+            AsyncResponseStream *response = request->beginResponseStream("application/octet-stream");
+            trace_dump(*response);
+            request->send(response);
+            }));
+    #endif
+
+    // Send temperature history as CSV; <ESP_IP>/history?span=<s>&res=<s>
+    // asks for the last <span> seconds at no coarser than <res> seconds
+    server.on("/history", HTTP_GET, rate_limited(ROUTE_HISTORY, [](AsyncWebServerRequest *request){
+        unsigned long span_s = 3600;
+        unsigned long res_s = 60;
+        if (request->hasParam("span")) {
+            span_s = strtoul(request->getParam("span")->value().c_str(), NULL, 10);
+        }
+        if (request->hasParam("res")) {
+            res_s = strtoul(request->getParam("res")->value().c_str(), NULL, 10);
+        }
+        // No tier reaches further back than the coarsest, and a negative
+        // number parses as a huge one, so both are capped at its span
+        span_s = (span_s < ROLLUP_MAX_SPAN_S) ? span_s : ROLLUP_MAX_SPAN_S;
+        res_s = (res_s < ROLLUP_MAX_SPAN_S) ? res_s : ROLLUP_MAX_SPAN_S;
+        AsyncResponseStream *response = request->beginResponseStream("text/csv");
+        rollup_print_csv(*response, span_s * 1000ULL,
+                         (uint32_t)(res_s * 1000ULL));
+        request->send(response);
+        }));
+
+    // Send logged samples as CSV; <ESP_IP>/log?span=<s> asks for every sample
+    // from the last <span> seconds which has been written to flash, and
+    // <ESP_IP>/log?from=<ms>&to=<ms> for those in a span of the log's time
+    // scale, which the log finds without reading older samples. The CSV
+    // is made chunk by chunk from the mapped flash as the client takes it, or
+    // from one block at a time copied into RAM if the log isn't mapped, so
+    // long spans don't have to fit in RAM
+    server.on("/log", HTTP_GET, rate_limited(ROUTE_LOG, [](AsyncWebServerRequest *request){
+        uint32_t span_s = 600;
+        if (request->hasParam("span")) {
+            span_s = request->getParam("span")->value().toInt();
+        }
+        uint64_t to_ms = logger_time_now();
+        uint64_t span_ms = span_s * 1000ULL;
+        uint64_t from_ms = (span_ms < to_ms) ? to_ms - span_ms : 0;
+        if (request->hasParam("from")) {
+            from_ms = strtoull(request->getParam("from")->value().c_str(), NULL, 10);
+        }
+        if (request->hasParam("to")) {
+            to_ms = strtoull(request->getParam("to")->value().c_str(), NULL, 10);
+        }
+        std::shared_ptr<log_stream_t> p_stream (new log_stream_t);
+        logger_open_csv(*p_stream, from_ms, to_ms);
+        request->send(request->beginChunkedResponse("text/csv",
+            [p_stream](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                (void)index;
+                return logger_fill_csv(*p_stream, buffer, maxLen);
+            }));
+        }));
 
     // Install callback functions to handle web requests
     //server.on ("/", handle_OnConnect);
-    server.onNotFound (notFound);
+    server.onNotFound (rate_limited (ROUTE_OTHER, notFound));
 
     // Get the web server up and running
     server.begin ();
@@ -275,108 +394,353 @@ void task_WiFi (void* p_params)
     {
         //server.handleClient ();
         // To access your stored values on inputInt
-        int yourInputInt = readFile(SPIFFS, "/inputInt.txt").toInt();
-        Serial.print("*** Your inputInt: ");
-        Serial.println(yourInputInt);
-        //desired_temp.put(yourInputInt); --> uses too much stack space?
-        vTaskDelay (5000);
+        int yourInputInt = config.get_int(CONFIG_SETPOINT, 0);
+        DLOG_INFO("*** Your inputInt: %d", yourInputInt);
+        task_wait_period (p_task);
     }
 }
 
-/** @brief   Task which controls the heating element
- *  @param   p_params Pointer to parameters, which is not used
- * 
+/** @brief   Task which keeps an eye on the other tasks' stacks, the heap
+ *           and the CPU time each task uses.
+ *  @details If @c TASK_STACK_DIAGNOSTICS is defined, suggested stack sizes
+ *           are also printed once a minute; if @c PROFILER_SERIAL is defined,
+ *           the CPU profile is printed each time a profiler window ends.
+ *  @param   p_params Pointer to this task's entry in the task table
  */
-void task_heater(void* p_params){
-    (void)p_params;
+void task_monitor (void* p_params)
+{
+    task_entry_t* p_task = (task_entry_t*)p_params;
+    #ifdef TASK_STACK_DIAGNOSTICS
+        uint32_t last_report = millis ();
+    #endif
+    #ifdef PROFILER_SERIAL
+        uint32_t last_profile = millis ();
+    #endif
 
-    int16_t setpoint = 20;
-    int16_t current = 0;
+    for (;;)
+    {
+        check_task_stacks ();
+        heap_update ();
+        profiler_update ();
 
-    //set pin mode to output for heater control
-    pinMode(HEATER_PIN, OUTPUT);
+        #ifdef TASK_STACK_DIAGNOSTICS
+            if (millis () - last_report >= 60000UL)
+            {
+                last_report = millis ();
+                print_stack_suggestions (Serial);
+            }
+        #endif
+        #ifdef PROFILER_SERIAL
+            if (millis () - last_profile >= PROFILER_WINDOW_MS)
+            {
+                last_profile = millis ();
+                print_profile (Serial);
+            }
+        #endif
 
-    for(;;){
-        desired_temp.get(setpoint);
-        temp_reading.get(current);
-        if(current < (setpoint - THRESHOLD)){
-            digitalWrite(HEATER_PIN, 1);
-        }
-        else{
-            digitalWrite(HEATER_PIN, 0);
-        }
-        vTaskDelay(100);
+        task_wait_period (p_task);
     }
 }
 
-/** @brief   Task which reads data from thermocouples.
- *  @param   p_params Pointer to parameters, which is not used
- * 
+/** @brief   Console command which lists the commands.
+ *  @param   printer Reference to the stream on which to print
+ *  @param   p_args The rest of the command line, which is ignored
  */
-void task_sensor(void* p_params){
-    (void)p_params;
+static void command_help (Print& printer, char* p_args)
+{
+    (void)p_args;
+    console_print_help (printer);
+}
 
-    Adafruit_MAX31856 therm1 = Adafruit_MAX31856(CS1_PIN, SDI, SDO, SCK);
-    pinMode(DRDY_PIN, INPUT);
+/** @brief   Console command which prints the shares and queues.
+ *  @param   printer Reference to the stream on which to print
+ *  @param   p_args The rest of the command line, which is ignored
+ */
+static void command_shares (Print& printer, char* p_args)
+{
+    (void)p_args;
+    print_all_shares (printer);
+}
 
-    if (!therm1.begin()) {
-        Serial.println("Could not initialize thermocouple.");
-        while (1) delay(10);
+/** @brief   Console command which sets and saves the setpoint.
+ *  @param   printer Reference to the stream on which to print
+ *  @param   p_args The new setpoint in degrees C
+ */
+static void command_set (Print& printer, char* p_args)
+{
+    char* p_end;
+    long setpoint = strtol (p_args, &p_end, 10);
+
+    if (p_end == p_args || *p_end != '\0' || setpoint < CONFIG_SETPOINT_MIN
+        || setpoint > CONFIG_SETPOINT_MAX)
+    {
+        printer.printf ("Usage: set <setpoint from %d to %d C>\n",
+                        CONFIG_SETPOINT_MIN, CONFIG_SETPOINT_MAX);
+        return;
     }
+    desired_temp.put ((int16_t)setpoint);
+    ctrlstate_request_save ();
+    printer.printf ("Setpoint is now %ld C\n", setpoint);
+}
 
-    therm1.setThermocoupleType(MAX31856_TCTYPE_T);
-    therm1.setConversionMode(MAX31856_CONTINUOUS);
+/** @brief   Console command which prints the temperature statistics.
+ *  @param   printer Reference to the stream on which to print
+ *  @param   p_args The rest of the command line, which is ignored
+ */
+static void command_stats (Print& printer, char* p_args)
+{
+    (void)p_args;
+    stats_print (printer);
+}
 
-    for(;;){
-        int count = 0;
-        while (digitalRead(DRDY_PIN)) {
-            if (count++ > 200) {
-                count = 0;
-                Serial.print(".");
-            }
+/** @brief   Console command which prints the tasks' timing and the heap.
+ *  @param   printer Reference to the stream on which to print
+ *  @param   p_args The rest of the command line, which is ignored
+ */
+static void command_tasks (Print& printer, char* p_args)
+{
+    (void)p_args;
+    print_task_table (printer);
+    print_heap (printer);
+}
+
+/** @brief   Console command which prints the state of the logs.
+ *  @param   printer Reference to the stream on which to print
+ *  @param   p_args The rest of the command line, which is ignored
+ */
+static void command_log (Print& printer, char* p_args)
+{
+    (void)p_args;
+    logger_print_status (printer);
+    dlog_print_status (printer);
+}
+
+/** @brief   Console command which starts, stops or prints the event trace.
+ *  @param   printer Reference to the stream on which to print
+ *  @param   p_args "on", "off", or the number of events per core to print
+ */
+static void command_trace (Print& printer, char* p_args)
+{
+#ifdef TRACE_ENABLED
+    if (strcmp (p_args, "on") == 0 || strcmp (p_args, "off") == 0)
+    {
+        trace_enable (p_args[1] == 'n');
+        printer.printf ("Tracing is %s\n", p_args);
+        return;
+    }
+    int count = atoi (p_args);
+    trace_print (printer, (count > 0) ? count : 20);
+#else
+    (void)p_args;
+    printer.println ("Tracing isn't built in; build with -DTRACE_ENABLED");
+#endif
+}
+
+/** @brief   Console command which starts, stops or prints the CPU profile.
+ *  @param   printer Reference to the stream on which to print
+ *  @param   p_args "start", "stop", or nothing to print the profile
+ */
+static void command_profile (Print& printer, char* p_args)
+{
+    if (strcmp (p_args, "start") == 0 || strcmp (p_args, "stop") == 0)
+    {
+        profiler_enable (p_args[2] == 'a');
+        printer.printf ("Profiling %s\n", (p_args[2] == 'a') ? "started"
+                                                             : "stopped");
+        return;
+    }
+    print_profile (printer);
+}
+
+#ifdef TELEMETRY_ENABLED
+/** @brief   Console command which starts or stops binary telemetry.
+ *  @param   printer Reference to the stream on which to print
+ *  @param   p_args "on" or "off"
+ */
+static void command_telemetry (Print& printer, char* p_args)
+{
+    if (strcmp (p_args, "on") != 0 && strcmp (p_args, "off") != 0)
+    {
+        printer.println ("Usage: telemetry on|off");
+        return;
+    }
+    telemetry_enable (p_args[1] == 'n');
+}
+#endif
+
+/// The commands which can be typed at the serial console
+static const console_command_t console_commands[] =
+{
+//    Name       Help text                                       Handler
+    { "help",    "List the commands",                            command_help    },
+    { "shares",  "Show the shares and queues with their values", command_shares  },
+    { "set",     "set <C>: change the setpoint and save it",     command_set     },
+    { "stats",   "Show temperature and heater statistics",       command_stats   },
+    { "tasks",   "Show task timing, stacks and the heap",        command_tasks   },
+    { "log",     "Show the data log and the deferred log",       command_log     },
+    { "trace",   "trace [on|off|<events>]: show traced events",  command_trace   },
+    { "profile", "profile [start|stop]: show CPU use per task",  command_profile },
+#ifdef TELEMETRY_ENABLED
+    { "telemetry", "telemetry on|off: start or stop binary records", command_telemetry },
+#endif
+};
+
+/** @brief   Table which describes all the tasks in this program.
+ *  @details Network tasks are pinned to the same core as the WiFi stack and
+ *           the web server's TCP task, while the sensing and control tasks
+ *           get the other core to themselves so network traffic can't delay
+ *           them. The WiFi task needs a lot of stack space to prevent it
+ *           crashing; the MQTT task formats JSON messages on its stack, and
+ *           the sensor task copies statistics snapshots into a share. The
+ *           logger and journal have the lowest priority because writing
+ *           flash is slow; they run when there is work for them, so they
+ *           have no period. Messages logged with the @c DLOG_ macros are
+ *           printed by the deferred log task, on the network core, so the
+ *           control tasks never wait for the serial port; the console also
+ *           runs there, waking only when characters arrive. When built with
+ *           @c -DTELEMETRY_ENABLED, the telemetry task sends binary records
+ *           from the network core too. The monitor warns if any task comes close
+ *           to filling its stack; build with @c -DTASK_STACK_DIAGNOSTICS to
+ *           have it suggest stack sizes which fit what the tasks really use.
+ */
+task_entry_t task_table[] =
+{
+//    Function            Name       Stack Pri Core          Period (ms)
+    { task_WiFi,          "WiFi",    4500, 1,  NETWORK_CORE, 5000           },
+    { task_mqtt,          "MQTT",    4096, 1,  NETWORK_CORE, MQTT_SAMPLE_MS },
+    { task_sensor,        "sensor",  2048, 1,  CONTROL_CORE, 500            },
+    { task_heater,        "heater",  1000, 3,  CONTROL_CORE, 100            },
+    { task_logger,        "logger",  3072, 0,  NETWORK_CORE, 0              },
+    { task_journal,       "journal", 2048, 0,  NETWORK_CORE, 0              },
+    { task_monitor,       "monitor", 2048, 0,  NETWORK_CORE, STACK_CHECK_MS },
+    { task_deferlog,      "dlog",    2560, 0,  NETWORK_CORE, 50             },
+    { task_console,       "console", 3072, 0,  NETWORK_CORE, 0              },
+#ifdef TELEMETRY_ENABLED
+    { task_telemetry,     "telem",   2048, 1,  NETWORK_CORE, TELEMETRY_PERIOD_MS },
+#endif
+};
+
+/** @brief   Move the setpoint from the file in which older firmware kept it
+ *           into the settings store.
+ *  @details Before the settings store, the setpoint was saved as text in
+ *           @c /inputInt.txt. If the store has no setpoint yet and that file
+ *           exists, its value is stored if it is a whole number in the
+ *           allowed range. The file is then removed, so this happens once,
+ *           unless the store could not save the value.
+ */
+static void import_old_setpoint (void)
+{
+    const char* OLD_PATH = "/inputInt.txt";
+    fs::FS& files = storage.files ();
+    if (config.get_int (CONFIG_SETPOINT, INT32_MIN) != INT32_MIN
+        || !files.exists (OLD_PATH))
+    {
+        return;
+    }
+
+    char buffer[16];
+    text_view_t text = read_file (files, OLD_PATH, buffer, sizeof (buffer));
+    char* p_end;
+    long setpoint = strtol (text.p_data, &p_end, 10);
+    if (p_end != text.p_data && *p_end == '\0'
+        && setpoint >= CONFIG_SETPOINT_MIN && setpoint <= CONFIG_SETPOINT_MAX)
+    {
+        // Keep the file for the next startup if the store can't take it
+        if (!config.put_int (CONFIG_SETPOINT, setpoint))
+        {
+            return;
         }
-        Serial.println(therm1.readThermocoupleTemperature());
-        vTaskDelay (500);
+        Serial.printf ("Moved setpoint %ld C from %s to the settings store\n",
+                       setpoint, OLD_PATH);
     }
+    files.remove (OLD_PATH);
 }
 
+
 /** @brief   Set up the ESP32
  *  @details This program runs the tasks to control the heater
  *           and run the web server.
  */
 void setup (void) 
 {
-    if(!SPIFFS.begin(true)){
-      Serial.println("An Error has occurred while mounting SPIFFS");
+    #ifdef TELEMETRY_ENABLED
+        // Binary records need a faster port and room to queue whole frames
+        Serial.setTxBufferSize (TELEMETRY_TX_BUFFER);
+        Serial.begin (TELEMETRY_BAUD);
+    #else
+        Serial.begin (115200);
+    #endif
+    delay (1000);
+    Serial.printf ("Environmental chamber on the %s board\n", board.name);
+
+    // Mount the file system, which may move files over from SPIFFS
+    if(!storage_begin()){
+      Serial.println("An Error has occurred while mounting the file system");
       return;
     }
+    #ifdef GPIO_BENCHMARK
+        gpio_benchmark (Serial);
+    #endif
+
+    // Find the controller's state from before the reset, then load saved
+    // settings and start with the saved setpoint. If the settings are lost,
+    // the journal's copy of the setpoint is better than a default. A saved
+    // setpoint outside the allowed range is ignored
+    int16_t setpoint = 20;
+    if (ctrlstate_begin ())
+    {
+        const controller_state_t& state = ctrlstate_recovered ();
+        if (state.setpoint >= CONFIG_SETPOINT_MIN
+            && state.setpoint <= CONFIG_SETPOINT_MAX)
+        {
+            setpoint = state.setpoint;
+        }
+        Serial.printf ("Recovered state from startup %lu: setpoint %d C, "
+                       "%.2f C, heater %s\n", (unsigned long)state.boot_count,
+                       state.setpoint, (double)state.temperature,
+                       state.heater_on ? "on" : "off");
+    }
+    if (!config.begin ())
+    {
+        Serial.println ("Settings partition \"config\" not found");
+    }
+    import_old_setpoint ();
+    int32_t saved = config.get_int (CONFIG_SETPOINT, setpoint);
+    if (saved >= CONFIG_SETPOINT_MIN && saved <= CONFIG_SETPOINT_MAX)
+    {
+        setpoint = saved;
+    }
+    desired_temp.put (setpoint);
 
-    Serial.begin (115200);
-    delay (1000);
+    // After a warm reset, carry on from the heater task's last snapshot so
+    // that the heater doesn't act on a reading of zero until the sensor has
+    // been read. A setpoint outside the allowed range is ignored, as above
+    warm_state_t warm;
+    if (warmstart_restore (warm))
+    {
+        if (warm.setpoint >= CONFIG_SETPOINT_MIN
+            && warm.setpoint <= CONFIG_SETPOINT_MAX)
+        {
+            desired_temp.put (warm.setpoint);
+        }
+        temp_reading.put (warm.current);
+        therm_temp.put (warm.temperature);
+        heater_on.put (warm.heater_on);
+        HeaterPin::begin ();
+        HeaterPin::write (warm.heater_on);
+        Serial.printf ("Resumed after warm reset: setpoint %d C, %.2f C\n",
+                       warm.setpoint, (double)warm.temperature);
+    }
 
-    // Create a task to run the WiFi connection. This task needs a lot of stack
-    // space to prevent it crashing
-    
-    xTaskCreate (task_WiFi,
-                 "WiFi",
-                 4500,
-                 NULL,
-                 1,
-                 NULL);
-                 
-    xTaskCreate (task_sensor,
-                "sensor",
-                1000,
-                NULL,
-                1,
-                NULL);
-
-    xTaskCreate (task_heater,
-                "heater",
-                1000,
-                NULL,
-                3,
-                NULL);
+    #ifdef STATIC_ALLOCATION
+        print_memory_budget (Serial, memory_budget, sizeof (memory_budget)
+                                                    / sizeof (memory_budget[0]));
+    #endif
+
+    // Create the tasks described in the task table
+    console_begin (console_commands, sizeof (console_commands)
+                                     / sizeof (console_commands[0]));
+    create_tasks (task_table, sizeof (task_table) / sizeof (task_table[0]));
 }
 
 
@@ -0,0 +1,132 @@
+/** @file    membudget.cpp
+ *  @brief   Source code for keeping track of how the program uses RAM.
+ *  @details The heap is measured over all memory which can be addressed a
+ *           byte at a time. Its history is kept in a ring buffer which the
+ *           monitor task writes and the web server reads, so both take turns
+ *           in a critical section.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <Arduino.h>
+#include "taskshare.h"
+#include "ringbuffer.h"
+#include "membudget.h"
+#ifdef ESP32
+    #include <esp_heap_caps.h>
+#endif
+
+
+/// Samples of the heap, oldest first
+static RingBuffer<heap_sample_t, HEAP_HISTORY> heap_history;
+
+/// Time at which the last sample was taken
+static uint32_t last_sample_ms = 0;
+
+#ifdef ESP32
+    /// A mutex used on ESP32's for critical sections around the history
+    static portMUX_TYPE heap_mutex = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+
+/** @brief   Print the items in a memory budget and their total.
+ *  @param   printer Reference to a serial device or stream on which to print
+ *  @param   p_items Pointer to an array of budget items
+ *  @param   num_items The number of items in the array
+ */
+void print_memory_budget (Print& printer, const memory_item_t* p_items,
+                          size_t num_items)
+{
+    printer.println ("Static memory           Bytes");
+    printer.println ("-------------           -----");
+    for (size_t index = 0; index < num_items; index++)
+    {
+        printer.printf ("%-22s%7lu\n", p_items[index].name,
+                        (unsigned long)p_items[index].bytes);
+    }
+    printer.printf ("%-22s%7lu of %lu\n", "Total",
+                    (unsigned long)memory_total (p_items, num_items),
+                    (unsigned long)STATIC_RAM_BUDGET);
+}
+
+
+/** @brief   Measure the heap now.
+ *  @param   sample Reference to a sample which receives the measurements
+ */
+static void measure_heap (heap_sample_t& sample)
+{
+    sample.time_s = millis () / 1000;
+#ifdef ESP32
+    sample.free_bytes = heap_caps_get_free_size (MALLOC_CAP_8BIT);
+    sample.largest_block = heap_caps_get_largest_free_block (MALLOC_CAP_8BIT);
+#else
+    sample.free_bytes = 0;
+    sample.largest_block = 0;
+#endif
+}
+
+
+/** @brief   Take a sample of the heap if it's time for one.
+ *  @details This is meant to be called often by a low priority task; a
+ *           sample is kept every @c HEAP_SAMPLE_MS, and the first one when
+ *           this is first called.
+ */
+void heap_update (void)
+{
+    if (heap_history.available () > 0
+        && millis () - last_sample_ms < HEAP_SAMPLE_MS)
+    {
+        return;
+    }
+    last_sample_ms = millis ();
+
+    heap_sample_t sample;
+    measure_heap (sample);
+    SHARE_ENTER_CRITICAL (&heap_mutex);
+    heap_history.put (sample);
+    SHARE_EXIT_CRITICAL (&heap_mutex);
+}
+
+
+/** @brief   Print the state of the heap now and its history.
+ *  @details Fragmentation is shown as the share of the free heap which is
+ *           not in the largest free block.
+ *  @param   printer Reference to a serial device or stream on which to print
+ */
+void print_heap (Print& printer)
+{
+    heap_sample_t now;
+    measure_heap (now);
+
+#ifdef ESP32
+    uint32_t lowest = heap_caps_get_minimum_free_size (MALLOC_CAP_8BIT);
+#else
+    uint32_t lowest = 0;
+#endif
+    printer.printf ("Heap: %lu bytes free, largest block %lu, fewest free "
+                    "%lu, %u%% fragmented\n", (unsigned long)now.free_bytes,
+                    (unsigned long)now.largest_block, (unsigned long)lowest,
+                    now.free_bytes ? (unsigned)(100 - (uint64_t)100
+                                     * now.largest_block / now.free_bytes)
+                                   : 0);
+
+    printer.println ("Time (s)      Free   Largest");
+    for (uint16_t index = 0; ; index++)
+    {
+        heap_sample_t sample;
+        SHARE_ENTER_CRITICAL (&heap_mutex);
+        bool have = index < heap_history.available ();
+        if (have)
+        {
+            sample = heap_history.peek (index);
+        }
+        SHARE_EXIT_CRITICAL (&heap_mutex);
+        if (!have)
+        {
+            break;
+        }
+        printer.printf ("%8lu  %8lu  %8lu\n", (unsigned long)sample.time_s,
+                        (unsigned long)sample.free_bytes,
+                        (unsigned long)sample.largest_block);
+    }
+}
@@ -0,0 +1,85 @@
+/** @file    membudget.h
+ *  @brief   Headers for keeping track of how the program uses RAM.
+ *  @details Two things are tracked. The memory budget lists the large
+ *           buffers which are set aside when the program is built; its total
+ *           is worked out by the compiler, so a @c static_assert can stop
+ *           the build if the buffers outgrow @c STATIC_RAM_BUDGET. The heap
+ *           tracker samples the free heap and the largest free block from
+ *           time to time. If the largest block shrinks while the free heap
+ *           stays the same, the heap is becoming fragmented; both should
+ *           stay flat over days of running.
+ *
+ *           Building with @c STATIC_ALLOCATION puts the tasks' stacks, the
+ *           queues and the mutexes in static memory, so the heap is only
+ *           used by the WiFi stack, the web server and the libraries.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _MEMBUDGET_H_
+#define _MEMBUDGET_H_
+
+#include <Arduino.h>
+
+
+#ifndef STATIC_RAM_BUDGET
+/// Most bytes which the buffers in the memory budget may use together
+#define STATIC_RAM_BUDGET 131072
+#endif
+
+#ifndef HEAP_SAMPLE_MS
+/// Time between samples of the heap, in milliseconds
+#define HEAP_SAMPLE_MS 3600000UL
+#endif
+
+/// Number of samples of the heap which are kept
+#define HEAP_HISTORY 72
+
+
+/** @brief   One item in the memory budget.
+ */
+struct memory_item_t
+{
+    const char* name;                         ///< What the memory is for
+    uint32_t    bytes;                        ///< How much there is
+};
+
+
+/** @brief   The state of the heap at one time.
+ */
+struct heap_sample_t
+{
+    uint32_t time_s;                          ///< Seconds since startup
+    uint32_t free_bytes;                      ///< Free heap
+    uint32_t largest_block;                   ///< Largest free block
+};
+
+
+/** @brief   Add up the bytes in the items of a memory budget.
+ *  @details This can be worked out by the compiler, so it can be used in a
+ *           @c static_assert.
+ *  @param   p_items Pointer to an array of budget items
+ *  @param   num_items The number of items in the array
+ *  @return  The total number of bytes
+ */
+constexpr uint32_t memory_total (const memory_item_t* p_items,
+                                 size_t num_items)
+{
+    return num_items ? p_items->bytes + memory_total (p_items + 1,
+                                                      num_items - 1)
+                     : 0;
+}
+
+
+// Print the items in a memory budget and their total
+void print_memory_budget (Print& printer, const memory_item_t* p_items,
+                          size_t num_items);
+
+// Take a sample of the heap if it's time for one
+void heap_update (void);
+
+// Print the state of the heap now and its history
+void print_heap (Print& printer);
+
+#endif // _MEMBUDGET_H_
@@ -0,0 +1,55 @@
+/** @file    mqtt_encode.cpp
+ *  @brief   Source code for the encoder which turns batches of samples into
+ *           the MQTT task's JSON messages.
+ *  @details The encoder is kept apart from @c task_mqtt.cpp, which needs the
+ *           WiFi and MQTT libraries, so that it can be built and timed on a
+ *           PC by the benchmarks in @c bench/.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <Arduino.h>
+#include "task_mqtt.h"
+
+
+/** @brief   Encode a batch of samples as a compact JSON message.
+ *  @details The message holds the time of the first sample and, for each
+ *           sample, its time offset from the first one in milliseconds, the
+ *           temperature, the setpoint and the heater state:
+ *           @code
+ *           {"t0":81500,"s":[[0,23.25,40,1],[500,23.50,40,1]]}
+ *           @endcode
+ *  @param   buffer A character buffer in which to put the message
+ *  @param   size The size of @c buffer in bytes
+ *  @param   p_samples Pointer to an array of samples to be encoded
+ *  @param   how_many The number of samples in the array
+ *  @return  The length of the message, or 0 if it didn't fit in @c buffer
+ */
+size_t mqtt_encode_batch (char* buffer, size_t size, const sample_t* p_samples,
+                          uint16_t how_many)
+{
+    if (how_many == 0)
+    {
+        return 0;
+    }
+
+    uint32_t t0 = p_samples[0].time_ms;
+    size_t length = snprintf (buffer, size, "{\"t0\":%lu,\"s\":[",
+                              (unsigned long)t0);
+
+    for (uint16_t index = 0; index < how_many && length < size; index++)
+    {
+        const sample_t& smp = p_samples[index];
+        length += snprintf (buffer + length, size - length, "%s[%lu,%.2f,%d,%u]",
+                            index ? "," : "",
+                            (unsigned long)(smp.time_ms - t0),
+                            (double)smp.temperature, smp.setpoint,
+                            smp.heater_on);
+    }
+    if (length < size)
+    {
+        length += snprintf (buffer + length, size - length, "]}");
+    }
+
+    return (length < size) ? length : 0;
+}
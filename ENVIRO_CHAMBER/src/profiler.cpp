@@ -0,0 +1,484 @@
+/** @file    profiler.cpp
+ *  @brief   Source code for a profiler which shows where the CPU time goes.
+ *  @details Each window, the run time counters of every task are read and
+ *           compared with those read at the end of the previous window. The
+ *           monitor task does the reading and the web server the printing,
+ *           so the results are only touched inside a critical section.
+ *
+ *           The ESP32's run time counters are 32 bits wide, so a window
+ *           must be shorter than the time in which they wrap around, which
+ *           is over an hour at one count per microsecond.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <Arduino.h>
+#include "profiler.h"
+#ifdef ESP32
+    #include "FreeRTOS.h"
+    #include "esp_timer.h"
+    #include "tasktable.h"
+#else
+    #include <pthread.h>
+    #include <time.h>
+    #include <stdio.h>
+    #ifdef __linux__
+        #include <unistd.h>
+        #include <sys/syscall.h>
+    #endif
+#endif
+
+
+/** @brief   One reading of the counters of a task or thread.
+ */
+struct profile_reading_t
+{
+    const void* id;                           ///< Task handle or thread ID
+    const char* name;                         ///< Name of task or thread
+    int8_t      core;                         ///< Core, or -1 if not pinned
+    uint64_t    time;                         ///< Time it has run
+    uint32_t    switches;                     ///< Times it has been switched in
+};
+
+
+/// What is known about each task or thread
+static profile_entry_t entries[PROFILER_MAX_TASKS];
+
+/// Number of tasks or threads in @c entries
+static uint8_t num_entries = 0;
+
+/// Place in the results for the window which is being measured
+static uint8_t window = 0;
+
+/// Number of windows which have been finished, up to @c PROFILER_WINDOWS
+static uint8_t windows_done = 0;
+
+/// Total run time counted at the end of the previous window
+static uint64_t last_total = 0;
+
+/// Time at which the window being measured began
+static uint32_t window_start_ms = 0;
+
+/// Set @c true once the counters have been read for the first time
+static bool started = false;
+
+/// Counters are only read while this is @c true
+static bool enabled = true;
+
+/// The readings taken at the end of a window
+static profile_reading_t readings[PROFILER_MAX_TASKS];
+
+#ifdef ESP32
+    /// A mutex used on ESP32's for critical sections around the results
+    static portMUX_TYPE profile_mutex = portMUX_INITIALIZER_UNLOCKED;
+
+    #define PROFILE_LOCK()   portENTER_CRITICAL (&profile_mutex)
+    #define PROFILE_UNLOCK() portEXIT_CRITICAL (&profile_mutex)
+
+    #if configGENERATE_RUN_TIME_STATS
+        /// The state of each task as reported by FreeRTOS
+        static TaskStatus_t task_status[PROFILER_MAX_TASKS];
+
+        /// Share of each window which each core spent idle, in 0.1%
+        static uint16_t idle_permille[PROFILER_MAX_CORES][PROFILER_WINDOWS];
+    #endif
+#else
+    /** @brief   A thread which has asked to be profiled.
+     */
+    struct host_thread_t
+    {
+        const char* name;                     ///< Name to be printed
+        clockid_t   clock;                    ///< The thread's CPU clock
+        long        tid;                      ///< Linux thread ID, or 0
+    };
+
+    /// The threads which are profiled
+    static host_thread_t threads[PROFILER_MAX_TASKS];
+
+    /// Number of threads in @c threads
+    static uint8_t num_threads = 0;
+
+    /// A mutex which protects the results and the list of threads
+    static pthread_mutex_t profile_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+    #define PROFILE_LOCK()   pthread_mutex_lock (&profile_mutex)
+    #define PROFILE_UNLOCK() pthread_mutex_unlock (&profile_mutex)
+#endif
+
+
+/** @brief   Find how much a counter has gone up, allowing for wrap-around.
+ *  @param   now The counter's value now
+ *  @param   then The counter's value at the end of the previous window
+ *  @return  The difference
+ */
+static uint64_t counter_delta (uint64_t now, uint64_t then)
+{
+#ifdef ESP32
+    return (uint32_t)((uint32_t)now - (uint32_t)then);
+#else
+    return now - then;
+#endif
+}
+
+
+/** @brief   Let the calling thread be profiled.
+ *  @details On the ESP32 every FreeRTOS task is profiled without this being
+ *           called, so it does nothing there.
+ *  @param   p_name The name to be shown for the thread; it must not be freed
+ */
+void profiler_add_thread (const char* p_name)
+{
+#ifdef ESP32
+    (void)p_name;
+#else
+    PROFILE_LOCK ();
+    if (num_threads < PROFILER_MAX_TASKS)
+    {
+        host_thread_t& thread = threads[num_threads];
+        thread.name = p_name;
+        thread.tid = 0;
+        if (pthread_getcpuclockid (pthread_self (), &thread.clock) == 0)
+        {
+            #ifdef __linux__
+                thread.tid = syscall (SYS_gettid);
+            #endif
+            num_threads++;
+        }
+    }
+    PROFILE_UNLOCK ();
+#endif
+}
+
+
+/** @brief   Read the run time counters of every task or thread.
+ *  @param   total Reference to a number which receives the total time
+ *           counted, in the same units as the tasks' run times
+ *  @return  The number of readings put in @c readings
+ */
+static uint8_t read_counters (uint64_t& total)
+{
+    uint8_t count = 0;
+
+#if defined ESP32 && configGENERATE_RUN_TIME_STATS
+    uint32_t total_time = 0;
+    count = uxTaskGetSystemState (task_status, PROFILER_MAX_TASKS,
+                                  &total_time);
+    total = total_time;
+    for (uint8_t index = 0; index < count; index++)
+    {
+        const TaskStatus_t& status = task_status[index];
+        profile_reading_t& reading = readings[index];
+        const task_entry_t* p_task = find_task (status.xHandle);
+
+        reading.id = status.xHandle;
+        reading.name = status.pcTaskName;
+        #if configTASKLIST_INCLUDE_COREID
+            reading.core = (status.xCoreID < portNUM_PROCESSORS)
+                           ? status.xCoreID : -1;
+        #else
+            reading.core = p_task ? p_task->core : -1;
+        #endif
+        reading.time = status.ulRunTimeCounter;
+        reading.switches = p_task ? p_task->timing.wakeups
+                                  : PROFILER_NO_COUNT;
+    }
+#elif defined ESP32
+    // Without FreeRTOS's run time statistics, the time from each wakeup of
+    // a periodic task to its next wait, which task_wait_period() adds up,
+    // stands in for its run time. Only the low 32 bits are read, which is
+    // all that counter_delta() uses, so a read can't be torn
+    total = (uint32_t)esp_timer_get_time ();
+    const task_entry_t* p_task;
+    for (uint8_t index = 0; count < PROFILER_MAX_TASKS
+                            && (p_task = task_at (index)) != NULL; index++)
+    {
+        if (p_task->period_ms == 0 || p_task->handle == NULL)
+        {
+            continue;
+        }
+        profile_reading_t& reading = readings[count++];
+        reading.id = p_task->handle;
+        reading.name = p_task->name;
+        reading.core = p_task->core;
+        reading.time = (uint32_t)p_task->timing.run_us;
+        reading.switches = p_task->timing.wakeups;
+    }
+#else
+    struct timespec now;
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    total = (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+
+    for ( ; count < num_threads; count++)
+    {
+        const host_thread_t& thread = threads[count];
+        profile_reading_t& reading = readings[count];
+        struct timespec used;
+
+        reading.id = &thread;
+        reading.name = thread.name;
+        reading.core = -1;
+        reading.time = 0;
+        if (clock_gettime (thread.clock, &used) == 0)
+        {
+            reading.time = (uint64_t)used.tv_sec * 1000000000ULL
+                           + used.tv_nsec;
+        }
+
+        // The third number in schedstat counts the times the thread ran
+        reading.switches = PROFILER_NO_COUNT;
+        #ifdef __linux__
+            char path[48];
+            unsigned long long on_cpu, waiting, slices;
+            snprintf (path, sizeof (path), "/proc/self/task/%ld/schedstat",
+                      thread.tid);
+            FILE* p_file = fopen (path, "r");
+            if (p_file != NULL)
+            {
+                if (fscanf (p_file, "%llu %llu %llu", &on_cpu, &waiting,
+                            &slices) == 3)
+                {
+                    reading.switches = (uint32_t)slices;
+                }
+                fclose (p_file);
+            }
+        #endif
+    }
+#endif
+
+    return count;
+}
+
+
+/** @brief   Find a task's entry in the results, adding one if it's new.
+ *  @param   reading The reading of the task's counters
+ *  @return  A pointer to the entry, or @c NULL if the results are full
+ */
+static profile_entry_t* find_entry (const profile_reading_t& reading)
+{
+    for (uint8_t index = 0; index < num_entries; index++)
+    {
+        if (entries[index].id == reading.id)
+        {
+            return &entries[index];
+        }
+    }
+    if (num_entries >= PROFILER_MAX_TASKS)
+    {
+        return NULL;
+    }
+
+    // A new task is measured from now on
+    profile_entry_t& entry = entries[num_entries++];
+    memset (&entry, 0, sizeof (entry));
+    entry.id = reading.id;
+    entry.last_time = reading.time;
+    entry.last_switches = reading.switches;
+    entry.switches = PROFILER_NO_COUNT;
+    return &entry;
+}
+
+
+/** @brief   Read the tasks' run times and finish a window if it's time.
+ *  @details This is meant to be called often by a low priority task; it
+ *           does nothing until @c PROFILER_WINDOW_MS has passed since the
+ *           last window ended. The first call only starts the first window.
+ */
+void profiler_update (void)
+{
+    if (!enabled
+        || (started && millis () - window_start_ms < PROFILER_WINDOW_MS))
+    {
+        return;
+    }
+
+#ifndef ESP32
+    PROFILE_LOCK ();
+#endif
+    uint64_t total;
+    uint8_t count = read_counters (total);
+#ifndef ESP32
+    PROFILE_UNLOCK ();
+#endif
+    uint64_t elapsed = counter_delta (total, last_total);
+    bool measured = started && elapsed > 0;
+
+    PROFILE_LOCK ();
+    for (uint8_t index = 0; index < num_entries; index++)
+    {
+        entries[index].seen = false;
+    }
+    for (uint8_t index = 0; index < count; index++)
+    {
+        const profile_reading_t& reading = readings[index];
+        profile_entry_t* p_entry = find_entry (reading);
+        if (p_entry == NULL)
+        {
+            continue;
+        }
+
+        p_entry->seen = true;
+        p_entry->name = reading.name;
+        p_entry->core = reading.core;
+        if (measured)
+        {
+            uint64_t ran = counter_delta (reading.time, p_entry->last_time);
+            uint64_t share = ran * 1000 / elapsed;
+            p_entry->permille[window] = (share < 1000) ? share : 1000;
+            p_entry->switches = (reading.switches == PROFILER_NO_COUNT
+                                 || p_entry->last_switches
+                                    == PROFILER_NO_COUNT)
+                                ? PROFILER_NO_COUNT
+                                : reading.switches - p_entry->last_switches;
+        }
+        p_entry->last_time = reading.time;
+        p_entry->last_switches = reading.switches;
+
+        #if defined ESP32 && configGENERATE_RUN_TIME_STATS
+            for (uint8_t core = 0; core < portNUM_PROCESSORS
+                                   && core < PROFILER_MAX_CORES; core++)
+            {
+                if (reading.id == xTaskGetIdleTaskHandleForCPU (core))
+                {
+                    idle_permille[core][window] = p_entry->permille[window];
+                }
+            }
+        #endif
+    }
+
+    // Forget tasks which have been deleted
+    uint8_t kept = 0;
+    for (uint8_t index = 0; index < num_entries; index++)
+    {
+        if (entries[index].seen)
+        {
+            entries[kept++] = entries[index];
+        }
+    }
+    num_entries = kept;
+
+    if (measured)
+    {
+        window = (window + 1) % PROFILER_WINDOWS;
+        windows_done += (windows_done < PROFILER_WINDOWS) ? 1 : 0;
+    }
+    PROFILE_UNLOCK ();
+
+    last_total = total;
+    window_start_ms = millis ();
+    started = true;
+}
+
+
+/** @brief   Start or stop profiling.
+ *  @details Profiling is on when the program starts. Starting it again
+ *           throws away the results so far, so that the next results only
+ *           cover what happens from now on.
+ *  @param   on @c true to start profiling, @c false to stop
+ */
+void profiler_enable (bool on)
+{
+    PROFILE_LOCK ();
+    if (on && !enabled)
+    {
+        num_entries = 0;
+        window = 0;
+        windows_done = 0;
+        started = false;
+    }
+    enabled = on;
+    PROFILE_UNLOCK ();
+}
+
+
+/** @brief   Find the CPU share in the latest window and the mean of all the
+ *           windows kept.
+ *  @param   p_permille Pointer to the shares of each window
+ *  @param   latest The place of the latest window
+ *  @param   num_windows The number of windows which have been measured
+ *  @param   mean Reference to a number which receives the mean share
+ *  @return  The share in the latest window
+ */
+static uint16_t shares (const uint16_t* p_permille, uint8_t latest,
+                        uint8_t num_windows, uint16_t& mean)
+{
+    uint32_t sum = 0;
+
+    for (uint8_t back = 0; back < num_windows; back++)
+    {
+        sum += p_permille[(latest + PROFILER_WINDOWS - back)
+                          % PROFILER_WINDOWS];
+    }
+    mean = num_windows ? sum / num_windows : 0;
+    return p_permille[latest];
+}
+
+
+/** @brief   Print each task's CPU share, switches and each core's idle time.
+ *  @details Shares are of one core, so on a dual core processor the shares
+ *           of all the tasks add up to 200%. The switches shown on an ESP32
+ *           are the wakeups of tasks in the task table.
+ *  @param   printer Reference to a serial device or stream on which to print
+ */
+void print_profile (Print& printer)
+{
+    PROFILE_LOCK ();
+    uint8_t num_windows = windows_done;
+    uint8_t latest = (window + PROFILER_WINDOWS - 1) % PROFILER_WINDOWS;
+    uint8_t num_tasks = num_entries;
+    PROFILE_UNLOCK ();
+
+    if (num_windows == 0)
+    {
+        printer.println ("Profile: the first window isn't finished yet");
+        return;
+    }
+    if (!enabled)
+    {
+        printer.println ("Profiling is stopped; these results are old");
+    }
+    printer.printf ("CPU use in the last %lu s and the last %lu s, "
+                    "%% of one core\n",
+                    (unsigned long)(PROFILER_WINDOW_MS / 1000),
+                    (unsigned long)(PROFILER_WINDOW_MS / 1000 * num_windows));
+    printer.println ("Task              Core  Now %  Mean %  Switches");
+    printer.println ("----              ----  -----  ------  --------");
+
+    for (uint8_t index = 0; index < num_tasks; index++)
+    {
+        PROFILE_LOCK ();
+        profile_entry_t entry = entries[index];
+        PROFILE_UNLOCK ();
+
+        uint16_t mean;
+        uint16_t now = shares (entry.permille, latest, num_windows, mean);
+        printer.printf ("%-16.16s  %4s  %3u.%u  %4u.%u  ", entry.name,
+                        (entry.core < 0) ? "-" : (entry.core ? "1" : "0"),
+                        now / 10, now % 10, mean / 10, mean % 10);
+        if (entry.switches == PROFILER_NO_COUNT)
+        {
+            printer.println ("       -");
+        }
+        else
+        {
+            printer.printf ("%8lu\n", (unsigned long)entry.switches);
+        }
+    }
+
+#if defined ESP32 && !configGENERATE_RUN_TIME_STATS
+    printer.println ("Only periodic tasks are shown, with time preempted "
+                     "counted;\nturn on FreeRTOS run time statistics for "
+                     "all tasks and idle time");
+#elif defined ESP32
+    for (uint8_t core = 0; core < portNUM_PROCESSORS
+                           && core < PROFILER_MAX_CORES; core++)
+    {
+        uint16_t mean;
+        PROFILE_LOCK ();
+        uint16_t now = shares (idle_permille[core], latest, num_windows,
+                               mean);
+        PROFILE_UNLOCK ();
+        printer.printf ("Core %u idle: %u.%u%% now, %u.%u%% mean\n", core,
+                        now / 10, now % 10, mean / 10, mean % 10);
+    }
+#endif
+}
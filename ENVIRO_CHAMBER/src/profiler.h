@@ -0,0 +1,83 @@
+/** @file    profiler.h
+ *  @brief   Headers for a profiler which shows where the CPU time goes.
+ *  @details The profiler reads how long each task has run from time to time
+ *           and works out each task's share of a CPU core over windows of
+ *           @c PROFILER_WINDOW_MS, along with how often it was woken and how
+ *           much time each core spent idle. Results are kept for the last
+ *           @c PROFILER_WINDOWS windows, so a burst can be told apart from
+ *           steady load.
+ *
+ *           On the ESP32 the run times come from FreeRTOS's run time
+ *           statistics when they are turned on with
+ *           @c configGENERATE_RUN_TIME_STATS, which takes a custom sdkconfig.
+ *           FreeRTOS doesn't count context switches, so the number of times
+ *           each periodic task was woken, as counted by
+ *           @c task_wait_period(), is shown instead. Unlike the CPU share in
+ *           the task table, these figures don't count time during which a
+ *           task was preempted. With the stock sdkconfig the statistics are
+ *           off, and the time from each wakeup to the next wait, which
+ *           @c task_wait_period() measures with @c esp_timer, is used
+ *           instead; then only periodic tasks are shown, preempted time is
+ *           counted as their own and the cores' idle time is unknown.
+ *
+ *           On a PC the same functions measure threads which have called
+ *           @c profiler_add_thread(), using each thread's CPU time clock; on
+ *           Linux the number of times each thread was switched in is read
+ *           from @c /proc as well.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <Arduino.h>
+
+
+#ifndef PROFILER_WINDOW_MS
+/// Length of each window over which CPU shares are worked out, in ms
+#define PROFILER_WINDOW_MS 10000UL
+#endif
+
+/// Number of windows whose results are kept
+#define PROFILER_WINDOWS 6
+
+/// Largest number of tasks or threads which can be profiled
+#define PROFILER_MAX_TASKS 24
+
+/// Largest number of CPU cores whose idle time is shown
+#define PROFILER_MAX_CORES 2
+
+/// Number of switches shown for a task whose switches aren't counted
+#define PROFILER_NO_COUNT 0xFFFFFFFF
+
+
+/** @brief   What the profiler knows about one task or thread.
+ */
+struct profile_entry_t
+{
+    const void* id;                           ///< Task handle or thread ID
+    const char* name;                         ///< Name of task or thread
+    int8_t      core;                         ///< Core, or -1 if not pinned
+    bool        seen;                         ///< Found at the latest reading
+    uint64_t    last_time;                    ///< Run time at last window
+    uint32_t    last_switches;                ///< Switches at last window
+    uint32_t    switches;                     ///< Switches in last window
+    uint16_t    permille[PROFILER_WINDOWS];   ///< CPU share, 0.1% of a core
+};
+
+
+// Let the calling thread be profiled; only needed on a PC
+void profiler_add_thread (const char* p_name);
+
+// Read the tasks' run times and finish a window if it's time
+void profiler_update (void);
+
+// Start or stop profiling
+void profiler_enable (bool on);
+
+// Print each task's CPU share, switches and each core's idle time
+void print_profile (Print& printer);
+
+#endif // _PROFILER_H_
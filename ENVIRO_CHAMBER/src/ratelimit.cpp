@@ -0,0 +1,194 @@
+/** @file    ratelimit.cpp
+ *  @brief   Source code for a limiter which protects the tasks from web
+ *           traffic.
+ *  @details See @c ratelimit.h for a description of the limiter.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <Arduino.h>
+#include "ratelimit.h"
+
+
+/** @brief   Create a rate limiter with the given limits for each route.
+ *  @param   p_route_limits Pointer to an array which holds the limit for each
+ *           route; it must exist for as long as the limiter does
+ *  @param   routes The number of routes in the array, no more than
+ *           @c RATE_LIMIT_MAX_ROUTES; any past that are never limited by rate
+ *  @param   max_requests_in_flight The largest number of admitted requests
+ *           whose connections may be open at the same time
+ */
+RateLimiter::RateLimiter (const route_limit_t* p_route_limits, uint8_t routes,
+                          uint8_t max_requests_in_flight)
+    : p_limits (p_route_limits),
+      num_routes (routes < RATE_LIMIT_MAX_ROUTES
+                  ? routes : RATE_LIMIT_MAX_ROUTES),
+      max_in_flight (max_requests_in_flight), in_flight (0), num_limited (0),
+      num_busy (0)
+{
+    memset (buckets, 0, sizeof (buckets));
+    memset (overflow, 0, sizeof (overflow));
+    for (uint8_t route = 0; route < num_routes; route++)
+    {
+        overflow[route].route = route;
+        overflow[route].milli_tokens = p_limits[route].burst * 1000UL;
+        overflow[route].in_use = true;
+    }
+    #ifdef ESP32
+        portMUX_TYPE unlocked = portMUX_INITIALIZER_UNLOCKED;
+        mutex = unlocked;
+    #endif
+}
+
+
+/** @brief   Refill a bucket for the time since it was last used, then take a
+ *           token from it if it has one.
+ *  @param   bkt Reference to the bucket
+ *  @param   route The index of the route whose limits apply to the bucket
+ *  @param   now_ms The present time in milliseconds
+ *  @return  True if a token was taken, false if the bucket is empty
+ */
+bool RateLimiter::take_token (bucket_t& bkt, uint8_t route, uint32_t now_ms)
+{
+    const route_limit_t& lim = p_limits[route];
+    uint64_t refill = (uint64_t)(now_ms - bkt.last_ms) * lim.per_second;
+    uint32_t full = lim.burst * 1000UL;
+    bkt.milli_tokens = (full - bkt.milli_tokens > refill)
+                       ? bkt.milli_tokens + (uint32_t)refill : full;
+    bkt.last_ms = now_ms;
+
+    if (bkt.milli_tokens < 1000)
+    {
+        return false;
+    }
+    bkt.milli_tokens -= 1000;
+    return true;
+}
+
+
+/** @brief   Find the token bucket for a client and route.
+ *  @details If no bucket belongs to the client and route, a free bucket is
+ *           given to them. If none is free, the client must first take a
+ *           token from the route's overflow bucket, which every such
+ *           newcomer shares; only then is the bucket which has been unused
+ *           for the longest time taken from its owner. A free bucket starts
+ *           out full; a taken one starts with the overflow token plus a
+ *           second's worth at the route's steady rate, so a crowd which keeps
+ *           the table churning can't turn each overflow token into a whole
+ *           burst. This must be called from within a critical section.
+ *  @param   client The client's IPv4 address
+ *  @param   route The index of the route in the table of limits
+ *  @param   now_ms The present time in milliseconds
+ *  @return  A pointer to the bucket, or @c NULL if the table is full and the
+ *           route's overflow bucket is empty
+ */
+RateLimiter::bucket_t* RateLimiter::find_bucket (uint32_t client,
+                                                 uint8_t route,
+                                                 uint32_t now_ms)
+{
+    uint8_t oldest = 0;
+
+    for (uint8_t index = 0; index < RATE_LIMIT_SLOTS; index++)
+    {
+        bucket_t& bkt = buckets[index];
+        if (bkt.in_use && bkt.client == client && bkt.route == route)
+        {
+            return &bkt;
+        }
+        if (!bkt.in_use)
+        {
+            oldest = index;
+            break;
+        }
+        if (now_ms - bkt.last_ms > now_ms - buckets[oldest].last_ms)
+        {
+            oldest = index;
+        }
+    }
+
+    bucket_t& bkt = buckets[oldest];
+    const route_limit_t& lim = p_limits[route];
+    uint32_t tokens = lim.burst * 1000UL;
+    if (bkt.in_use)
+    {
+        if (!take_token (overflow[route], route, now_ms))
+        {
+            return NULL;
+        }
+
+        // The overflow token pays for this request; the rest is a second's
+        // worth at the route's steady rate
+        uint32_t steady = (lim.per_second + 1) * 1000UL;
+        tokens = (steady < tokens) ? steady : tokens;
+    }
+    bkt.client = client;
+    bkt.route = route;
+    bkt.last_ms = now_ms;
+    bkt.milli_tokens = tokens;
+    bkt.in_use = true;
+    return &bkt;
+}
+
+
+/** @brief   Decide whether a request from a client on a route may be handled.
+ *  @details If the request is admitted, it counts as in flight until
+ *           @c release() is called.
+ *  @param   client The client's IPv4 address
+ *  @param   route The index of the route in the table of limits; routes
+ *           outside the table are never limited by rate
+ *  @param   now_ms The present time in milliseconds, such as from @c millis()
+ *  @return  @c RATE_LIMIT_OK if the request may be handled, or the HTTP
+ *           status with which it should be refused
+ */
+uint16_t RateLimiter::admit (uint32_t client, uint8_t route, uint32_t now_ms)
+{
+    uint16_t status = RATE_LIMIT_OK;
+
+    SHARE_ENTER_CRITICAL (&mutex);
+    if (in_flight >= max_in_flight)
+    {
+        status = RATE_LIMIT_BUSY;
+        num_busy++;
+    }
+    else if (route < num_routes)
+    {
+        bucket_t* p_bkt = find_bucket (client, route, now_ms);
+        if (p_bkt == NULL || !take_token (*p_bkt, route, now_ms))
+        {
+            status = RATE_LIMIT_TOO_MANY;
+            num_limited++;
+        }
+    }
+    if (status == RATE_LIMIT_OK)
+    {
+        in_flight++;
+    }
+    SHARE_EXIT_CRITICAL (&mutex);
+
+    return status;
+}
+
+
+/** @brief   Record that an admitted request's connection has closed.
+ */
+void RateLimiter::release (void)
+{
+    SHARE_ENTER_CRITICAL (&mutex);
+    if (in_flight > 0)
+    {
+        in_flight--;
+    }
+    SHARE_EXIT_CRITICAL (&mutex);
+}
+
+
+/** @brief   Print the number of requests in flight and turned away.
+ *  @param   printer Reference to a serial device or other stream on which to
+ *           print
+ */
+void RateLimiter::print_status (Print& printer)
+{
+    printer.printf ("Web requests: %u of %u in flight, %lu rate limited, "
+                    "%lu refused busy\n", in_flight, max_in_flight,
+                    (unsigned long)num_limited, (unsigned long)num_busy);
+}
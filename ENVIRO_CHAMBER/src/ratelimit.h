@@ -0,0 +1,128 @@
+/** @file    ratelimit.h
+ *  @brief   Headers for a limiter which protects the tasks from web traffic.
+ *  @details A misbehaving dashboard or a network scanner can send requests
+ *           much faster than the chamber needs to answer them, and some
+ *           requests (such as setting the setpoint) write to flash memory.
+ *           This limiter gives each client IP address a token bucket for
+ *           each route, and also caps the number of requests in flight.
+ *           Requests which exceed the limits are answered with an error code
+ *           before any real work is done.
+ *
+ *           All state lives in a fixed-size table inside the limiter object,
+ *           so checking a request never allocates memory. When the table is
+ *           full, a newcomer must first take a token from an overflow bucket
+ *           which all newcomers to its route share, at that route's own
+ *           rate; if it gets one, the bucket which has been idle longest is
+ *           taken from its owner and given to the newcomer. A crowd of
+ *           addresses which outnumbers the buckets thus gets about one
+ *           client's worth of requests, while each client with a bucket of
+ *           its own is never charged for anyone else's traffic.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _RATELIMIT_H_
+#define _RATELIMIT_H_
+
+#include <Arduino.h>
+#include "taskshare.h"
+
+
+/// Number of (client, route) token buckets which are tracked at once
+#define RATE_LIMIT_SLOTS 16
+
+/// Largest number of routes which one limiter can hold limits for
+#define RATE_LIMIT_MAX_ROUTES 8
+
+/// HTTP status returned when a request is allowed to proceed
+#define RATE_LIMIT_OK 200
+
+/// HTTP status returned when a client has used up its token bucket
+#define RATE_LIMIT_TOO_MANY 429
+
+/// HTTP status returned when too many requests are in flight
+#define RATE_LIMIT_BUSY 503
+
+
+/** @brief   The rate allowed on one route of the web server.
+ */
+struct route_limit_t
+{
+    uint16_t per_second;                      ///< Sustained requests per second
+    uint16_t burst;                           ///< Requests allowed in a burst
+};
+
+
+/** @brief   Class which decides whether a web request may be handled.
+ *  @details The web server calls @c admit() once it has parsed a request and
+ *           @c release() when the connection which carried an admitted
+ *           request closes. The cap on requests in flight counts admitted
+ *           requests over that span; it isn't a cap on TCP connections,
+ *           which the web server accepts (and parses) before the limiter
+ *           hears of them. Token counts are kept in thousandths of a token
+ *           so buckets can refill at less than one token per millisecond
+ *           without floating point arithmetic.
+ *
+ *           @section usage_limit Usage
+ *           @code{.cpp}
+ *           const route_limit_t limits[] = { {5, 10}, {1, 3} };
+ *           RateLimiter limiter (limits, 2, 4);
+ *           ...
+ *           uint16_t status = limiter.admit (client_ip, 1, millis ());
+ *           if (status != RATE_LIMIT_OK)
+ *           {
+ *               request->send (status);
+ *           }
+ *           @endcode
+ */
+class RateLimiter
+{
+    protected:
+        /// One token bucket, belonging to one client on one route
+        struct bucket_t
+        {
+            uint32_t client;                  ///< Client's IPv4 address
+            uint32_t last_ms;                 ///< Time bucket was last used
+            uint32_t milli_tokens;            ///< Tokens left, in 1/1000's
+            uint8_t  route;                   ///< Index of route in limits
+            bool     in_use;                  ///< True if bucket is assigned
+        };
+
+        bucket_t buckets[RATE_LIMIT_SLOTS];   ///< Table of token buckets
+        /// Buckets shared by clients who find the table full, one per route
+        bucket_t overflow[RATE_LIMIT_MAX_ROUTES];
+        const route_limit_t* p_limits;        ///< Limits for each route
+        uint8_t num_routes;                   ///< Number of routes in limits
+        uint8_t max_in_flight;                ///< Most requests in flight
+        uint8_t in_flight;                    ///< Requests in flight now
+        uint32_t num_limited;                 ///< Count of 429 responses
+        uint32_t num_busy;                    ///< Count of 503 responses
+
+    #ifdef ESP32
+        /// A mutex used on ESP32's for critical sections
+        portMUX_TYPE mutex;
+    #endif
+
+        // Refill a bucket for the time since it was used and take a token
+        bool take_token (bucket_t& bkt, uint8_t route, uint32_t now_ms);
+
+        // Find the bucket for a client and route, reusing an old one if needed
+        bucket_t* find_bucket (uint32_t client, uint8_t route, uint32_t now_ms);
+
+    public:
+        // Create a rate limiter with the given limits for each route
+        RateLimiter (const route_limit_t* p_route_limits, uint8_t routes,
+                     uint8_t max_requests_in_flight);
+
+        // Decide whether a request from a client on a route may be handled
+        uint16_t admit (uint32_t client, uint8_t route, uint32_t now_ms);
+
+        // Record that an admitted request's connection has closed
+        void release (void);
+
+        // Print the number of requests in flight and turned away
+        void print_status (Print& printer);
+};
+
+#endif // _RATELIMIT_H_
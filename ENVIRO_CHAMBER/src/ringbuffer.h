@@ -0,0 +1,146 @@
+/** @file    ringbuffer.h
+ *  @brief   A fixed-size circular buffer which never allocates memory.
+ *  @details This file contains a template class for a first-in, first-out
+ *           buffer whose storage is a plain array sized at compile time.
+ *           When the buffer is full, putting a new item in overwrites the
+ *           oldest item and a counter of dropped items is incremented, so a
+ *           task which falls behind loses old data rather than blocking or
+ *           running out of heap.
+ *
+ *           This class is @b not thread-safe by itself; it is meant to be
+ *           owned by one task, or to be wrapped in a critical section by a
+ *           class which shares it between tasks.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _RINGBUFFER_H_
+#define _RINGBUFFER_H_
+
+#include <stdint.h>
+
+
+/** @brief   Class for a fixed-size FIFO buffer which overwrites old data.
+ *  @details The buffer holds up to @c Size items of type @c DataType. Items
+ *           are put in at the head and taken out at the tail. If an item is
+ *           put into a full buffer, the oldest item is discarded.
+ *
+ *           @section usage_ring Usage
+ *           @code{.cpp}
+ *           #include "ringbuffer.h"
+ *           ...
+ *           RingBuffer<sample_t, 64> history;  ///< Last 64 samples
+ *           ...
+ *           history.put (a_sample);
+ *           while (history.get (a_sample))
+ *           {
+ *               send_somewhere (a_sample);
+ *           }
+ *           @endcode
+ */
+template <class DataType, uint16_t Size> class RingBuffer
+{
+    protected:
+        DataType buffer[Size];                ///< Storage for the items
+        uint16_t head;                        ///< Index where next item goes
+        uint16_t count;                       ///< Number of items held now
+        uint32_t dropped;                     ///< Items lost to overwriting
+
+    public:
+        /** @brief   Create an empty ring buffer.
+         */
+        RingBuffer (void) : head (0), count (0), dropped (0)
+        {
+        }
+
+        /** @brief   Put an item into the buffer, overwriting the oldest item
+         *           if the buffer is full.
+         *  @param   item The item to be copied into the buffer
+         */
+        void put (const DataType& item)
+        {
+            buffer[head] = item;
+            head = (head + 1 < Size) ? head + 1 : 0;
+            if (count < Size)
+            {
+                count++;
+            }
+            else
+            {
+                dropped++;
+            }
+        }
+
+        /** @brief   Take the oldest item out of the buffer.
+         *  @param   item Reference to a variable which receives the item
+         *  @return  @c true if an item was taken, @c false if buffer is empty
+         */
+        bool get (DataType& item)
+        {
+            if (count == 0)
+            {
+                return false;
+            }
+            item = buffer[tail ()];
+            count--;
+            return true;
+        }
+
+        /** @brief   Look at an item without removing it from the buffer.
+         *  @param   index Which item, counting from 0 for the oldest one
+         *  @return  A reference to the item; @c index must be < @c available()
+         */
+        const DataType& peek (uint16_t index = 0) const
+        {
+            uint16_t where = tail () + index;
+            return buffer[(where < Size) ? where : where - Size];
+        }
+
+        /** @brief   Discard some of the oldest items in the buffer.
+         *  @param   how_many The number of items to be discarded
+         */
+        void discard (uint16_t how_many)
+        {
+            count = (how_many < count) ? count - how_many : 0;
+        }
+
+        /// Remove all items from the buffer.
+        void clear (void)
+        {
+            count = 0;
+        }
+
+        /// Return the number of items which are in the buffer now.
+        uint16_t available (void) const
+        {
+            return count;
+        }
+
+        /// Return @c true if the buffer is full.
+        bool is_full (void) const
+        {
+            return count == Size;
+        }
+
+        /// Return the maximum number of items which the buffer can hold.
+        uint16_t capacity (void) const
+        {
+            return Size;
+        }
+
+        /// Return the number of items which have been lost to overwriting.
+        uint32_t num_dropped (void) const
+        {
+            return dropped;
+        }
+
+    protected:
+        /// Compute the index of the oldest item in the buffer.
+        uint16_t tail (void) const
+        {
+            return (head >= count) ? head - count : head + Size - count;
+        }
+};
+
+#endif // _RINGBUFFER_H_
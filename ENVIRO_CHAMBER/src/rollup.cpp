@@ -0,0 +1,312 @@
+/** @file    rollup.cpp
+ *  @brief   Source code for multi-resolution history of the chamber
+ *           temperature.
+ *  @details See @c rollup.h for a description of the tiers. The tiers are
+ *           written by the sensor task and read by the web server, so both
+ *           sides work inside critical sections; a query copies at most the
+ *           caller's buffer of records before letting go.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <Arduino.h>
+#include <math.h>
+#include "taskshare.h"
+#include "rollup.h"
+
+
+// Storage for the tiers' rings
+static rollup_record_t raw_records[120];      ///< Raw samples, 1 minute
+static rollup_record_t sec10_records[360];    ///< 10 s records, 1 hour
+static rollup_record_t min1_records[720];     ///< 1 min records, 12 hours
+static rollup_record_t min15_records[672];    ///< 15 min records, 1 week
+static rollup_record_t hour1_records[336];    ///< 1 h records, 2 weeks
+
+static_assert (sizeof (raw_records) + sizeof (sec10_records)
+               + sizeof (min1_records) + sizeof (min15_records)
+               + sizeof (hour1_records)
+               == ROLLUP_RECORDS * sizeof (rollup_record_t),
+               "ROLLUP_RECORDS doesn't match the tiers' storage");
+
+/// The tiers of history, finest first; raw samples aren't merged
+static RollupTier tiers[ROLLUP_NUM_TIERS] =
+{
+    RollupTier (raw_records,   120, 0UL),
+    RollupTier (sec10_records, 360, 10000UL),
+    RollupTier (min1_records,  720, 60000UL),
+    RollupTier (min15_records, 672, 900000UL),
+    RollupTier (hour1_records, 336, 3600000UL)
+};
+
+/// Time of the newest sample, extended to 64 bits
+static uint64_t latest_ms = 0;
+
+#ifdef ESP32
+    /// A mutex used on ESP32's for critical sections around the tiers
+    static portMUX_TYPE rollup_mutex = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+
+/** @brief   Extend a 32 bit time from @c millis() to 64 bits.
+ *  @details The time is taken to be the first one at or after the newest
+ *           sample whose low 32 bits match, which is right as long as samples
+ *           come less than 49.7 days apart. This must be called inside the
+ *           tiers' critical section, as @c latest_ms is 64 bits.
+ *  @param   time_ms The time, which may have wrapped around
+ *  @return  The time in milliseconds since startup
+ */
+static uint64_t extend_ms (uint32_t time_ms)
+{
+    return latest_ms + (uint32_t)(time_ms - (uint32_t)latest_ms);
+}
+
+
+/** @brief   Create a tier which stores its records in the given array.
+ *  @param   p_storage Pointer to an array in which records are kept
+ *  @param   size The number of records which fit in the array
+ *  @param   bucket_ms The width of each bucket, or 0 if records from the
+ *           tier below are to be stored without merging
+ */
+RollupTier::RollupTier (rollup_record_t* p_storage, uint16_t size,
+                        uint32_t bucket_ms)
+    : p_records (p_storage), capacity (size), head (0), count (0),
+      width_ms (bucket_ms), partial_sum (0)
+{
+    memset (&partial, 0, sizeof (partial));
+}
+
+
+/** @brief   Return the record at a position counting from the oldest one.
+ *  @param   index The position of the record, which must be < @c count
+ *  @return  A reference to the record
+ */
+const rollup_record_t& RollupTier::at (uint16_t index) const
+{
+    uint16_t where = (head >= count) ? head - count : head + capacity - count;
+    where += index;
+    return p_records[(where < capacity) ? where : where - capacity];
+}
+
+
+/** @brief   Merge a finer record into the tier.
+ *  @details If the record belongs to a later bucket than the one being
+ *           filled, the partial bucket is finished, stored in the ring and
+ *           copied to @c completed. The record then starts the new bucket.
+ *  @param   record A record from the next finer tier
+ *  @param   completed Reference to a record which receives a finished bucket
+ *  @return  @c true if a bucket was finished and copied into @c completed
+ */
+bool RollupTier::add (const rollup_record_t& record, rollup_record_t& completed)
+{
+    bool finished = false;
+    uint64_t start = width_ms ? record.start_ms - record.start_ms % width_ms
+                              : record.start_ms;
+
+    if (width_ms == 0 || (partial.count > 0 && start != partial.start_ms))
+    {
+        if (width_ms == 0)
+        {
+            completed = record;
+        }
+        else
+        {
+            partial.mean = partial_sum / (int32_t)partial.count;
+            completed = partial;
+            partial.count = 0;
+        }
+        p_records[head] = completed;
+        head = (head + 1 < capacity) ? head + 1 : 0;
+        count = (count < capacity) ? count + 1 : capacity;
+        finished = true;
+
+        if (width_ms == 0)
+        {
+            return finished;
+        }
+    }
+
+    if (partial.count == 0)
+    {
+        partial = record;
+        partial.start_ms = start;
+        partial_sum = (int32_t)record.mean * record.count;
+    }
+    else
+    {
+        partial.min = (record.min < partial.min) ? record.min : partial.min;
+        partial.max = (record.max > partial.max) ? record.max : partial.max;
+        partial.count += record.count;
+        partial_sum += (int32_t)record.mean * record.count;
+    }
+    return finished;
+}
+
+
+/** @brief   Copy the records which overlap a span of time.
+ *  @details The first record is found by binary search, so the cost of a
+ *           query depends on the number of records returned rather than the
+ *           size of the tier. The bucket now being filled is included last.
+ *  @param   from_ms The start of the span
+ *  @param   to_ms The end of the span
+ *  @param   p_out Pointer to an array which receives the records
+ *  @param   max_out The number of records which fit in the array
+ *  @return  The number of records copied
+ */
+uint16_t RollupTier::query (uint64_t from_ms, uint64_t to_ms,
+                            rollup_record_t* p_out, uint16_t max_out) const
+{
+    uint32_t span = width_ms ? width_ms : 1;
+    uint16_t low = 0;
+    uint16_t high = count;
+    uint16_t found = 0;
+
+    // Find the first record which ends after the start of the span
+    while (low < high)
+    {
+        uint16_t middle = low + (high - low) / 2;
+        if (at (middle).start_ms + span <= from_ms)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    for ( ; low < count && found < max_out; low++)
+    {
+        const rollup_record_t& rec = at (low);
+        if (rec.start_ms > to_ms)
+        {
+            return found;
+        }
+        p_out[found++] = rec;
+    }
+
+    if (width_ms && partial.count > 0 && found < max_out
+        && partial.start_ms <= to_ms && partial.start_ms + span > from_ms)
+    {
+        p_out[found] = partial;
+        p_out[found++].mean = partial_sum / (int32_t)partial.count;
+    }
+    return found;
+}
+
+
+/** @brief   Add a sample to the raw tier and roll it up through the others.
+ *  @details This function is called by the sensor task each time it takes a
+ *           reading. A sample whose temperature isn't a finite number, as
+ *           when the thermocouple can't be read, is left out.
+ *  @param   smp The newest sample of the chamber's condition
+ */
+void rollup_add_sample (const sample_t& smp)
+{
+    rollup_record_t record;
+    rollup_record_t completed;
+
+    if (!isfinite (smp.temperature))
+    {
+        return;
+    }
+    float hundredths = smp.temperature * 100.0f;
+    hundredths = constrain (hundredths, (float)INT16_MIN, (float)INT16_MAX);
+
+    record.min = record.max = record.mean = (int16_t)hundredths;
+    record.count = 1;
+
+    SHARE_ENTER_CRITICAL (&rollup_mutex);
+    latest_ms = extend_ms (smp.time_ms);
+    record.start_ms = latest_ms;
+    for (uint8_t tier = 0; tier < ROLLUP_NUM_TIERS; tier++)
+    {
+        if (!tiers[tier].add (record, completed))
+        {
+            break;
+        }
+        record = completed;
+    }
+    SHARE_EXIT_CRITICAL (&rollup_mutex);
+}
+
+
+/** @brief   Get history over a span of time at no coarser than a given
+ *           resolution.
+ *  @details The coarsest tier whose buckets are no wider than
+ *           @c resolution_ms answers the query. If that tier doesn't reach
+ *           back to @c from_ms, its records are returned anyway, as finer
+ *           tiers reach back even less far.
+ *  @param   from_ms The start of the span, in milliseconds since startup
+ *  @param   to_ms The end of the span, in milliseconds since startup; these
+ *           are 64 bit times which don't wrap around
+ *  @param   resolution_ms The widest bucket which is acceptable
+ *  @param   p_out Pointer to an array which receives the records
+ *  @param   max_out The number of records which fit in the array
+ *  @param   p_width_ms Pointer to a variable which receives the width of the
+ *           buckets returned, or @c NULL if it isn't needed
+ *  @return  The number of records copied
+ */
+uint16_t rollup_query (uint64_t from_ms, uint64_t to_ms,
+                       uint32_t resolution_ms, rollup_record_t* p_out,
+                       uint16_t max_out, uint32_t* p_width_ms)
+{
+    uint8_t tier = ROLLUP_NUM_TIERS - 1;
+    while (tier > 0 && tiers[tier].width () > resolution_ms)
+    {
+        tier--;
+    }
+    if (p_width_ms != NULL)
+    {
+        *p_width_ms = tiers[tier].width ();
+    }
+
+    SHARE_ENTER_CRITICAL (&rollup_mutex);
+    uint16_t found = tiers[tier].query (from_ms, to_ms, p_out, max_out);
+    SHARE_EXIT_CRITICAL (&rollup_mutex);
+
+    return found;
+}
+
+
+/** @brief   Print recent history as comma separated values.
+ *  @details Records are fetched a few at a time so that a long history can be
+ *           printed without a large buffer. Each line holds the start time
+ *           of a bucket in seconds since startup, the minimum, maximum and
+ *           mean temperatures and the number of samples.
+ *  @param   printer Reference to a serial device or other stream on which to
+ *           print
+ *  @param   span_ms How far back from now the history should reach
+ *  @param   resolution_ms The widest bucket which is acceptable
+ */
+void rollup_print_csv (Print& printer, uint64_t span_ms,
+                       uint32_t resolution_ms)
+{
+    const uint8_t CHUNK = 16;
+    rollup_record_t records[CHUNK];
+    uint32_t width;
+
+    SHARE_ENTER_CRITICAL (&rollup_mutex);
+    uint64_t now = extend_ms (millis ());
+    SHARE_EXIT_CRITICAL (&rollup_mutex);
+    uint64_t from = (now > span_ms) ? now - span_ms : 0;
+
+    printer.println ("time_s,min_C,max_C,mean_C,count");
+    for (;;)
+    {
+        uint16_t found = rollup_query (from, now, resolution_ms, records, CHUNK,
+                                       &width);
+        for (uint16_t index = 0; index < found; index++)
+        {
+            const rollup_record_t& rec = records[index];
+            printer.printf ("%lu,%.2f,%.2f,%.2f,%u\n",
+                            (unsigned long)(rec.start_ms / 1000),
+                            rec.min / 100.0, rec.max / 100.0, rec.mean / 100.0,
+                            rec.count);
+        }
+        if (found < CHUNK)
+        {
+            break;
+        }
+        from = records[found - 1].start_ms + (width ? width : 1);
+    }
+}
@@ -0,0 +1,124 @@
+/** @file    rollup.h
+ *  @brief   Headers for multi-resolution history of the chamber temperature.
+ *  @details Raw samples at 2 Hz would fill memory in minutes, but trends over
+ *           a week are still needed. This module keeps the temperature
+ *           history in tiers of increasingly coarse time buckets: raw
+ *           samples, then 10 second, 1 minute, 15 minute and 1 hour
+ *           summaries. Each tier is a fixed-size ring of records holding the
+ *           minimum, maximum, mean and number of samples in a bucket. When a
+ *           tier finishes a bucket, the record is passed up to the next
+ *           coarser tier, so every update takes constant time.
+ *
+ *           A query asks for a span of time at some resolution and is
+ *           answered from the coarsest tier which is at least that fine, so
+ *           reading a week of history touches a few hundred records.
+ *
+ *           Times are kept in 64 bits, extended from the 32 bit times of the
+ *           samples, because @c millis() wraps around after 49.7 days, which
+ *           is not much longer than the hour tier reaches back.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _ROLLUP_H_
+#define _ROLLUP_H_
+
+#include <Arduino.h>
+#include "sample.h"
+
+
+/// The tiers of history, from finest to coarsest
+enum rollup_tier_t
+{
+    ROLLUP_RAW,                               ///< Each sample, about 1 minute
+    ROLLUP_10_SEC,                            ///< 10 s buckets, 1 hour
+    ROLLUP_1_MIN,                             ///< 1 min buckets, 12 hours
+    ROLLUP_15_MIN,                            ///< 15 min buckets, 1 week
+    ROLLUP_1_HOUR,                            ///< 1 h buckets, 2 weeks
+    ROLLUP_NUM_TIERS                          ///< Number of tiers
+};
+
+
+/// Number of records kept by all the tiers together
+#define ROLLUP_RECORDS (120 + 360 + 720 + 672 + 336)
+
+/// How far back the coarsest tier reaches, in seconds
+#define ROLLUP_MAX_SPAN_S (336UL * 3600UL)
+
+
+/** @brief   Summary of the temperature during one bucket of time.
+ *  @details Temperatures are kept in hundredths of a degree C so that a
+ *           record takes 16 bytes and the tiers fit in a modest amount of
+ *           RAM.
+ */
+struct rollup_record_t
+{
+    uint64_t start_ms;                        ///< Start time of the bucket
+    int16_t  min;                             ///< Lowest temperature, C/100
+    int16_t  max;                             ///< Highest temperature, C/100
+    int16_t  mean;                            ///< Mean temperature, C/100
+    uint16_t count;                           ///< Number of raw samples
+};
+
+
+/** @brief   Class for one tier of history: a ring of bucket summaries.
+ *  @details Records are kept in time order. Records arriving from the next
+ *           finer tier are merged into a partial bucket until one arrives
+ *           which belongs to a later bucket; then the partial bucket is
+ *           stored as a record and returned to the caller so it can be
+ *           passed on to the next coarser tier.
+ */
+class RollupTier
+{
+    protected:
+        rollup_record_t* p_records;           ///< Storage for the ring
+        uint16_t capacity;                    ///< Number of records in ring
+        uint16_t head;                        ///< Where the next record goes
+        uint16_t count;                       ///< Number of stored records
+        uint32_t width_ms;                    ///< Width of a bucket in ms
+        rollup_record_t partial;              ///< Bucket being filled in
+        int32_t  partial_sum;                 ///< Sum of means times counts
+
+        // Return the record at a position counting from the oldest one
+        const rollup_record_t& at (uint16_t index) const;
+
+    public:
+        // Create a tier which stores its records in the given array
+        RollupTier (rollup_record_t* p_storage, uint16_t size,
+                    uint32_t bucket_ms);
+
+        // Merge a finer record into the tier, returning a completed bucket
+        bool add (const rollup_record_t& record, rollup_record_t& completed);
+
+        // Copy the records which overlap a span of time
+        uint16_t query (uint64_t from_ms, uint64_t to_ms,
+                        rollup_record_t* p_out, uint16_t max_out) const;
+
+        /// Return the width of this tier's buckets in milliseconds.
+        uint32_t width (void) const
+        {
+            return width_ms;
+        }
+
+        /// Return the start time of the oldest record, or 0 if none.
+        uint64_t oldest_ms (void) const
+        {
+            return count ? at (0).start_ms : 0;
+        }
+};
+
+
+// Add a sample to the raw tier and roll it up through the others
+void rollup_add_sample (const sample_t& smp);
+
+// Get history over a span of time at no coarser than a given resolution
+uint16_t rollup_query (uint64_t from_ms, uint64_t to_ms,
+                       uint32_t resolution_ms, rollup_record_t* p_out,
+                       uint16_t max_out, uint32_t* p_width_ms = NULL);
+
+// Print history as comma separated values, one line per record
+void rollup_print_csv (Print& printer, uint64_t span_ms,
+                       uint32_t resolution_ms);
+
+#endif // _ROLLUP_H_
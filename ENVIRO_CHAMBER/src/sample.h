@@ -0,0 +1,26 @@
+/** @file    sample.h
+ *  @brief   The record which holds one snapshot of the chamber's condition.
+ *  @details Tasks which report, store or analyze chamber data pass samples of
+ *           this type around, so that every consumer sees the same fields.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _SAMPLE_H_
+#define _SAMPLE_H_
+
+#include <stdint.h>
+
+
+/** @brief   One snapshot of the chamber's measured and desired condition.
+ */
+struct sample_t
+{
+    uint32_t time_ms;                         ///< Time taken, ms since boot
+    float    temperature;                     ///< Thermocouple reading in C
+    int16_t  setpoint;                        ///< Desired temperature in C
+    uint8_t  heater_on;                       ///< 1 if heater is on, else 0
+};
+
+#endif // _SAMPLE_H_
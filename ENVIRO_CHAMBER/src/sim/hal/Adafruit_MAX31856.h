@@ -0,0 +1,53 @@
+/** @file    Adafruit_MAX31856.h
+ *  @brief   A stand-in for Adafruit's MAX31856 driver which reads the
+ *           simulated amplifier in @c sim_devices.cpp.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _SIM_ADAFRUIT_MAX31856_H_
+#define _SIM_ADAFRUIT_MAX31856_H_
+
+#include <Arduino.h>
+
+
+/// Types of thermocouple, of which the simulation ignores all but the name
+typedef enum
+{
+    MAX31856_TCTYPE_B, MAX31856_TCTYPE_E, MAX31856_TCTYPE_J,
+    MAX31856_TCTYPE_K, MAX31856_TCTYPE_N, MAX31856_TCTYPE_R,
+    MAX31856_TCTYPE_S, MAX31856_TCTYPE_T
+} max31856_thermocoupletype_t;
+
+/// Ways in which the amplifier can convert
+typedef enum
+{
+    MAX31856_ONESHOT, MAX31856_ONESHOT_NOWAIT, MAX31856_CONTINUOUS
+} max31856_conversion_mode_t;
+
+
+/** @brief   A MAX31856 thermocouple amplifier on the simulated board.
+ */
+class Adafruit_MAX31856
+{
+protected:
+    int8_t cs_pin;                            ///< The chip select pin
+
+public:
+    Adafruit_MAX31856 (int8_t spi_cs, int8_t spi_mosi = -1,
+                       int8_t spi_miso = -1, int8_t spi_clk = -1)
+        : cs_pin (spi_cs)
+    {
+        (void)spi_mosi;
+        (void)spi_miso;
+        (void)spi_clk;
+    }
+
+    bool begin (void);
+    void setThermocoupleType (max31856_thermocoupletype_t type);
+    void setConversionMode (max31856_conversion_mode_t mode);
+    float readThermocoupleTemperature (void);
+};
+
+#endif // _SIM_ADAFRUIT_MAX31856_H_
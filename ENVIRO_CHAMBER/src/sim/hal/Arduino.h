@@ -0,0 +1,168 @@
+/** @file    Arduino.h
+ *  @brief   The parts of the Arduino core which the firmware's simulated
+ *           tasks use, for building them on a PC.
+ *  @details Time comes from the simulator's virtual clock, pins are the
+ *           simulated ones in @c gpio.h, and @c Serial prints to standard
+ *           output; a @c slow_client fault from @c sim_faults.h leaves it no
+ *           room to send. @c ESP32 isn't defined, so code with an ESP32 and a PC
+ *           version builds the PC one.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _SIM_ARDUINO_H_
+#define _SIM_ARDUINO_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include "sim_faults.h"
+#include "WString.h"
+
+
+#define LOW          0x0                      ///< A pin's low level
+#define HIGH         0x1                      ///< A pin's high level
+#define INPUT        0x01                     ///< Pin mode, input
+#define OUTPUT       0x03                     ///< Pin mode, output
+#define INPUT_PULLUP 0x05                     ///< Pin mode, input with pullup
+#define DEC          10                       ///< Print numbers in decimal
+#define HEX          16                       ///< Print numbers in hex
+
+/// Limit a number to a range, as Arduino's macro does
+#define constrain(amt, low, high) \
+    ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+
+/** @brief   Base class for things which can be printed on, as in Arduino.
+ */
+class Print
+{
+public:
+    virtual ~Print (void) { }
+
+    /// Print one byte; every printer must do this
+    virtual size_t write (uint8_t byte) = 0;
+
+    /// Print a block of bytes, one at a time unless a child does better
+    virtual size_t write (const uint8_t* p_buffer, size_t size)
+    {
+        size_t count = 0;
+        while (size--)
+        {
+            count += write (*p_buffer++);
+        }
+        return count;
+    }
+
+    size_t write (const char* p_str)
+    {
+        return write ((const uint8_t*)p_str, strlen (p_str));
+    }
+
+    size_t print (const char* p_str)  { return write (p_str); }
+    size_t print (char ch)            { return write ((uint8_t)ch); }
+    size_t print (int number, int base = DEC)
+    {
+        return print ((long)number, base);
+    }
+    size_t print (unsigned int number, int base = DEC)
+    {
+        return print ((unsigned long)number, base);
+    }
+    size_t print (long number, int base = DEC)
+    {
+        return (base == DEC) ? printf ("%ld", number)
+                             : print ((unsigned long)number, base);
+    }
+    size_t print (unsigned long number, int base = DEC)
+    {
+        return printf ((base == HEX) ? "%lX" : "%lu", number);
+    }
+    size_t print (double number, int digits = 2)
+    {
+        return printf ("%.*f", digits, number);
+    }
+
+    size_t println (void)             { return write ("\r\n"); }
+    template <class T> size_t println (T value)
+    {
+        return print (value) + println ();
+    }
+
+    /// Print formatted text, as @c printf() does
+    __attribute__ ((format (printf, 2, 3)))
+    size_t printf (const char* p_format, ...)
+    {
+        char buffer[256];
+        va_list args;
+        va_start (args, p_format);
+        int length = vsnprintf (buffer, sizeof (buffer), p_format, args);
+        va_end (args);
+        if (length < 0)
+        {
+            return 0;
+        }
+        return write ((const uint8_t*)buffer,
+                      ((size_t)length < sizeof (buffer)) ? length
+                                                         : sizeof (buffer) - 1);
+    }
+};
+
+
+/** @brief   A serial port which prints to standard output and never has
+ *           anything to read.
+ *  @details Printing always works, but code which checks for room first,
+ *           as the telemetry task does, finds none during a slow client
+ *           fault.
+ */
+class HardwareSerial : public Print
+{
+public:
+    void begin (unsigned long baud)   { (void)baud; }
+    int available (void)              { return 0; }
+    int read (void)                   { return -1; }
+    int availableForWrite (void)
+    {
+        return sim_fault_hit (SIM_FAULT_SLOW_CLIENT) ? 0 : 4096;
+    }
+    void flush (void)                 { fflush (stdout); }
+
+    size_t write (uint8_t byte)
+    {
+        return (fputc (byte, stdout) != EOF) ? 1 : 0;
+    }
+    size_t write (const uint8_t* p_buffer, size_t size)
+    {
+        return fwrite (p_buffer, 1, size, stdout);
+    }
+    using Print::write;
+};
+
+/// The serial port, which prints to standard output
+extern HardwareSerial Serial;
+
+
+// The time in milliseconds on the simulator's clock
+unsigned long millis (void);
+
+// The time in microseconds on the simulator's clock
+unsigned long micros (void);
+
+// Block the calling task for some milliseconds of simulated time
+void delay (uint32_t ms);
+
+// Set a simulated pin's mode
+void pinMode (uint8_t pin, uint8_t mode);
+
+// Set a simulated pin's level
+void digitalWrite (uint8_t pin, uint8_t level);
+
+// Get a simulated pin's level
+int digitalRead (uint8_t pin);
+
+#endif // _SIM_ARDUINO_H_
@@ -0,0 +1,217 @@
+/** @file    FS.h
+ *  @brief   The parts of the ESP32's file system classes which the firmware
+ *           uses, for building it on a PC.
+ *  @details An @c fs::FS is a directory on the PC, and the firmware's paths
+ *           are taken to be inside it, so @c "/log.csv" in a file system
+ *           made with @c FS("/tmp/chamber") is @c /tmp/chamber/log.csv.
+ *           Files are read and written with the C library's @c FILE, which
+ *           buffers much as LittleFS does. A @c File can be moved but not
+ *           copied, and it closes itself when it goes out of scope. The
+ *           @c flash_open and @c flash_write faults in @c sim_faults.h make
+ *           opening files and writing to them fail.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _SIM_FS_H_
+#define _SIM_FS_H_
+
+#include <Arduino.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "sim_faults.h"
+
+
+/// Longest path, including the file system's directory, which can be opened
+#define FS_MAX_PATH 256
+
+
+namespace fs
+{
+
+/** @brief   An open file, or a directory, in a file system on the PC.
+ */
+class File : public Print
+{
+protected:
+    FILE* p_file;                             ///< The open file, or @c NULL
+    bool  directory;                          ///< The path was a directory
+
+public:
+    using Print::write;
+
+    /// Make a file which isn't open, or one for a stream which is
+    File (FILE* p_stream = NULL, bool is_directory = false)
+        : p_file (p_stream), directory (is_directory)
+    {
+    }
+
+    /// Take over an open file from another @c File
+    File (File&& other) : p_file (other.p_file), directory (other.directory)
+    {
+        other.p_file = NULL;
+        other.directory = false;
+    }
+
+    /// Close this file and take over an open file from another @c File
+    File& operator = (File&& other)
+    {
+        if (this != &other)
+        {
+            close ();
+            p_file = other.p_file;
+            directory = other.directory;
+            other.p_file = NULL;
+            other.directory = false;
+        }
+        return *this;
+    }
+
+    File (const File&) = delete;
+    File& operator = (const File&) = delete;
+
+    ~File (void)
+    {
+        close ();
+    }
+
+    /// Return @c true if the file or directory is open
+    explicit operator bool (void) const
+    {
+        return p_file != NULL || directory;
+    }
+
+    /// Return @c true if what was opened is a directory
+    bool isDirectory (void) const
+    {
+        return directory;
+    }
+
+    size_t write (uint8_t byte)
+    {
+        return write (&byte, 1);
+    }
+
+    size_t write (const uint8_t* p_buffer, size_t size)
+    {
+        if (p_file == NULL || sim_fault_hit (SIM_FAULT_FLASH_WRITE))
+        {
+            return 0;
+        }
+        return fwrite (p_buffer, 1, size, p_file);
+    }
+
+    /// Read up to @c size bytes, returning how many were read
+    size_t read (uint8_t* p_buffer, size_t size)
+    {
+        return p_file ? fread (p_buffer, 1, size, p_file) : 0;
+    }
+
+    /// Read one byte, or return -1 at the end of the file
+    int read (void)
+    {
+        return p_file ? fgetc (p_file) : -1;
+    }
+
+    /// Return nonzero if there are bytes left to be read; unlike Arduino's,
+    /// this only peeks at the next byte, so it costs no call to the system
+    int available (void)
+    {
+        int next = p_file ? fgetc (p_file) : EOF;
+        if (next == EOF)
+        {
+            return 0;
+        }
+        ungetc (next, p_file);
+        return 1;
+    }
+
+    /// Return the number of bytes in the file
+    size_t size (void) const
+    {
+        struct stat info;
+        if (p_file == NULL || fstat (fileno (p_file), &info) != 0)
+        {
+            return 0;
+        }
+        return (size_t)info.st_size;
+    }
+
+    void flush (void)
+    {
+        if (p_file)
+        {
+            fflush (p_file);
+        }
+    }
+
+    void close (void)
+    {
+        if (p_file)
+        {
+            fclose (p_file);
+            p_file = NULL;
+        }
+        directory = false;
+    }
+};
+
+
+/** @brief   A file system which is a directory on the PC.
+ */
+class FS
+{
+protected:
+    const char* p_root;                       ///< Directory holding the files
+
+    /// Put the PC's path for one of this file system's paths in @c buffer
+    bool full_path (const char* path, char* buffer) const
+    {
+        int length = snprintf (buffer, FS_MAX_PATH, "%s%s", p_root, path);
+        return length > 0 && length < FS_MAX_PATH;
+    }
+
+public:
+    /// Make a file system whose files are kept in a directory on the PC
+    FS (const char* p_directory) : p_root (p_directory)
+    {
+    }
+
+    /// Open a file with a mode of @c "r", @c "w" or @c "a", as on the ESP32
+    File open (const char* path, const char* mode = "r")
+    {
+        char name[FS_MAX_PATH];
+        struct stat info;
+        if (!full_path (path, name) || sim_fault_hit (SIM_FAULT_FLASH_OPEN))
+        {
+            return File ();
+        }
+        if (stat (name, &info) == 0 && S_ISDIR (info.st_mode))
+        {
+            return File (NULL, true);
+        }
+        return File (fopen (name, mode));
+    }
+
+    /// Return @c true if a file or directory exists
+    bool exists (const char* path)
+    {
+        char name[FS_MAX_PATH];
+        return full_path (path, name) && access (name, F_OK) == 0;
+    }
+
+    /// Delete a file, returning @c true if it was there to delete
+    bool remove (const char* path)
+    {
+        char name[FS_MAX_PATH];
+        return full_path (path, name) && unlink (name) == 0;
+    }
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+
+#endif // _SIM_FS_H_
@@ -0,0 +1,88 @@
+/** @file    FreeRTOS.h
+ *  @brief   The parts of FreeRTOS which the firmware's simulated tasks use,
+ *           for building them on a PC.
+ *  @details Tasks are the simulator's fibers and a tick is one millisecond,
+ *           as on the ESP32. Only one task runs at a time and none is ever
+ *           switched out in the middle of its code, so critical sections
+ *           have nothing to do. When built with @c -DSIM_THREADS, as the
+ *           benchmarks are, code may instead be run by several threads at
+ *           once, and critical sections take a spinlock as @c portMUX does
+ *           on the ESP32.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _SIM_FREERTOS_H_
+#define _SIM_FREERTOS_H_
+
+#include <stdint.h>
+#include "sim.h"
+
+
+typedef int32_t     BaseType_t;               ///< Signed word
+typedef uint32_t    UBaseType_t;              ///< Unsigned word
+typedef uint32_t    TickType_t;               ///< A time in ticks
+typedef uint8_t     StackType_t;              ///< A byte, as on the ESP32
+typedef sim_task_t* TaskHandle_t;             ///< A simulated task
+typedef void (*TaskFunction_t) (void*);       ///< A task's function
+
+/// Control block of a static task; the simulator doesn't use it
+struct StaticTask_t
+{
+    uint8_t unused;                           ///< Makes the type complete
+};
+
+#define pdFALSE              0
+#define pdTRUE               1
+#define pdPASS               1
+#define pdFAIL               0
+#define portMAX_DELAY        0xFFFFFFFFUL
+#define configTICK_RATE_HZ   1000
+#define portTICK_PERIOD_MS   1
+#define pdMS_TO_TICKS(ms)    ((TickType_t)(ms))
+
+#ifdef SIM_THREADS
+    // Take and give back the spinlock which guards critical sections
+    void sim_enter_critical (void);
+    void sim_exit_critical (void);
+
+    #define portENTER_CRITICAL()       sim_enter_critical ()
+    #define portEXIT_CRITICAL()        sim_exit_critical ()
+#else
+    #define portENTER_CRITICAL()       do { } while (0)
+    #define portEXIT_CRITICAL()        do { } while (0)
+#endif
+#define portENTER_CRITICAL_FROM_ISR()  0
+#define portEXIT_CRITICAL_FROM_ISR(x)  do { (void)(x); } while (0)
+#define portYIELD_FROM_ISR()           do { } while (0)
+
+
+// Create a task, ignoring its stack size and core
+BaseType_t xTaskCreatePinnedToCore (TaskFunction_t function,
+                                    const char* name, uint32_t stack_size,
+                                    void* p_param, UBaseType_t priority,
+                                    TaskHandle_t* p_handle, BaseType_t core);
+
+// Block the calling task for some ticks
+void vTaskDelay (TickType_t ticks);
+
+// Block the calling task until a number of ticks after the last wakeup
+void vTaskDelayUntil (TickType_t* p_previous, TickType_t increment);
+
+// Get the number of ticks since the simulation began
+TickType_t xTaskGetTickCount (void);
+
+// Get the calling task's handle
+TaskHandle_t xTaskGetCurrentTaskHandle (void);
+
+// Get the least free stack, in bytes, which a task has had
+UBaseType_t uxTaskGetStackHighWaterMark (TaskHandle_t task);
+
+// Add to a task's notification count
+BaseType_t xTaskNotifyGive (TaskHandle_t task);
+
+// Wait for notifications and take them
+uint32_t ulTaskNotifyTake (BaseType_t clear, TickType_t ticks_to_wait);
+
+#endif // _SIM_FREERTOS_H_
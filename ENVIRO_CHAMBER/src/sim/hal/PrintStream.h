@@ -0,0 +1,34 @@
+/** @file    PrintStream.h
+ *  @brief   The @c << operators of the PrintStream library, for building on
+ *           a PC.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _SIM_PRINTSTREAM_H_
+#define _SIM_PRINTSTREAM_H_
+
+#include <Arduino.h>
+
+
+/// Ends a line when sent to a printer with @c <<
+enum print_endl_t { endl };
+
+
+/// Print anything which @c Print::print() can
+template <class T>
+inline Print& operator << (Print& printer, T value)
+{
+    printer.print (value);
+    return printer;
+}
+
+/// End the line
+inline Print& operator << (Print& printer, print_endl_t)
+{
+    printer.println ();
+    return printer;
+}
+
+#endif // _SIM_PRINTSTREAM_H_
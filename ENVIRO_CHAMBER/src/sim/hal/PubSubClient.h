@@ -0,0 +1,350 @@
+/** @file    PubSubClient.h
+ *  @brief   The parts of the PubSubClient MQTT library which the MQTT task
+ *           uses, for building it on a PC.
+ *  @details Packets are MQTT 3.1.1 with QoS 0, sent through a @c WiFiClient
+ *           from @c WiFi.h, so the task can talk to a real broker such as
+ *           Mosquitto or to a test's stand-in. As in the library, one buffer
+ *           holds each packet going out or coming in, so a message which
+ *           doesn't fit in it can't be published; @c connect() waits for the
+ *           broker's answer, and @c loop() hands messages which have come to
+ *           the callback and pings the broker when it has been quiet.
+ *
+ *           Waits for the rest of a packet are in real time, not the
+ *           simulator's, since it's a real socket on the other end.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _SIM_PUBSUBCLIENT_H_
+#define _SIM_PUBSUBCLIENT_H_
+
+#include <Arduino.h>
+#include <poll.h>
+#include "WiFi.h"
+
+
+/// Size of the packet buffer until @c setBufferSize() changes it
+#define MQTT_MAX_PACKET_SIZE 256
+
+/// Seconds between packets after which the broker is pinged
+#define MQTT_KEEPALIVE 15
+
+/// Seconds to wait for the broker's answer or the rest of a packet
+#define MQTT_SOCKET_TIMEOUT 15
+
+/// Bytes of a packet's fixed header, at most
+#define MQTT_MAX_HEADER_SIZE 5
+
+#define MQTTCONNECT     0x10                  ///< Client asks for a session
+#define MQTTCONNACK     0x20                  ///< Broker answers a connect
+#define MQTTPUBLISH     0x30                  ///< A message on a topic
+#define MQTTSUBSCRIBE   0x82                  ///< Client asks for a topic
+#define MQTTSUBACK      0x90                  ///< Broker answers a subscribe
+#define MQTTPINGREQ     0xC0                  ///< Ping
+#define MQTTPINGRESP    0xD0                  ///< Answer to a ping
+#define MQTTDISCONNECT  0xE0                  ///< Client ends its session
+
+
+/** @brief   An MQTT client, as in the PubSubClient library.
+ */
+class PubSubClient
+{
+public:
+    /// Function which is given each message that comes on a subscribed topic
+    typedef void (*callback_t) (char* topic, uint8_t* payload,
+                                unsigned int length);
+
+protected:
+    WiFiClient* p_client;                     ///< Connection to the broker
+    const char* p_domain;                     ///< Broker's name or address
+    uint16_t    port;                         ///< Broker's TCP port
+    callback_t  p_callback;                   ///< Given incoming messages
+    uint8_t*    p_buffer;                     ///< Holds one packet
+    uint16_t    buffer_size;                  ///< Bytes in the buffer
+    uint16_t    next_msg_id;                  ///< ID of the next subscribe
+    uint32_t    last_out_ms;                  ///< When a packet was last sent
+    bool        session;                      ///< True once connected
+
+    /// Read one byte, waiting for it no longer than the socket timeout
+    bool read_byte (uint8_t& byte)
+    {
+        struct pollfd waiting = { p_client->fd (), POLLIN, 0 };
+        while (p_client->available () == 0)
+        {
+            if (!p_client->connected ()
+                || poll (&waiting, 1, MQTT_SOCKET_TIMEOUT * 1000) <= 0)
+            {
+                return false;
+            }
+            waiting.fd = p_client->fd ();
+        }
+        byte = (uint8_t)p_client->read ();
+        return true;
+    }
+
+    /// Read a whole packet into the buffer; return its length, or 0 if it
+    /// didn't come or was too big, in which case the session is ended
+    size_t read_packet (void)
+    {
+        uint8_t byte;
+        uint32_t remaining = 0;
+        uint32_t scale = 1;
+        size_t length = 0;
+
+        if (!read_byte (p_buffer[length++]))
+        {
+            return fail ();
+        }
+        do
+        {
+            if (!read_byte (byte) || length >= MQTT_MAX_HEADER_SIZE)
+            {
+                return fail ();
+            }
+            p_buffer[length++] = byte;
+            remaining += (byte & 0x7F) * scale;
+            scale <<= 7;
+        }
+        while (byte & 0x80);
+
+        if (length + remaining > buffer_size)
+        {
+            return fail ();
+        }
+        for (uint32_t count = 0; count < remaining; count++)
+        {
+            if (!read_byte (p_buffer[length++]))
+            {
+                return fail ();
+            }
+        }
+        return length;
+    }
+
+    /// End the session after something has gone wrong
+    size_t fail (void)
+    {
+        session = false;
+        p_client->stop ();
+        return 0;
+    }
+
+    /// Put a fixed header in front of the variable part of a packet, which
+    /// starts at @c MQTT_MAX_HEADER_SIZE in the buffer, and send it all
+    bool send_packet (uint8_t type, size_t length)
+    {
+        uint8_t header[MQTT_MAX_HEADER_SIZE];
+        size_t header_length = 1;
+        size_t remaining = length;
+        header[0] = type;
+        do
+        {
+            uint8_t digit = remaining & 0x7F;
+            remaining >>= 7;
+            header[header_length++] = digit | (remaining ? 0x80 : 0);
+        }
+        while (remaining > 0);
+
+        uint8_t* p_start = p_buffer + MQTT_MAX_HEADER_SIZE - header_length;
+        memcpy (p_start, header, header_length);
+        last_out_ms = millis ();
+        return p_client->write (p_start, header_length + length)
+               == header_length + length;
+    }
+
+    /// Write a string as MQTT does, with its length in front; return the
+    /// place after it
+    size_t put_string (const char* p_text, size_t place)
+    {
+        size_t length = strlen (p_text);
+        p_buffer[place++] = (uint8_t)(length >> 8);
+        p_buffer[place++] = (uint8_t)length;
+        memcpy (p_buffer + place, p_text, length);
+        return place + length;
+    }
+
+public:
+    PubSubClient (WiFiClient& client)
+        : p_client (&client), p_domain (NULL), port (0), p_callback (NULL),
+          p_buffer ((uint8_t*)malloc (MQTT_MAX_PACKET_SIZE)),
+          buffer_size (MQTT_MAX_PACKET_SIZE), next_msg_id (1),
+          last_out_ms (0), session (false)
+    {
+    }
+
+    PubSubClient (const PubSubClient&) = delete;
+    PubSubClient& operator = (const PubSubClient&) = delete;
+
+    ~PubSubClient (void)
+    {
+        free (p_buffer);
+    }
+
+    PubSubClient& setServer (const char* p_host, uint16_t host_port)
+    {
+        p_domain = p_host;
+        port = host_port;
+        return *this;
+    }
+
+    PubSubClient& setCallback (callback_t callback)
+    {
+        p_callback = callback;
+        return *this;
+    }
+
+    /// Change the size of the packet buffer; return false if there's no room
+    bool setBufferSize (uint16_t size)
+    {
+        uint8_t* p_new = size ? (uint8_t*)realloc (p_buffer, size) : NULL;
+        if (p_new == NULL)
+        {
+            return false;
+        }
+        p_buffer = p_new;
+        buffer_size = size;
+        return true;
+    }
+
+    /// Open a session with the broker, with a clean session and no login
+    bool connect (const char* p_id)
+    {
+        static const uint8_t header[] =
+            { 0, 4, 'M', 'Q', 'T', 'T', 4, 0x02, 0, MQTT_KEEPALIVE };
+
+        if (connected ())
+        {
+            return true;
+        }
+        if (MQTT_MAX_HEADER_SIZE + sizeof (header) + 2 + strlen (p_id)
+            > buffer_size || !p_client->connect (p_domain, port))
+        {
+            return false;
+        }
+        memcpy (p_buffer + MQTT_MAX_HEADER_SIZE, header, sizeof (header));
+        size_t place = put_string (p_id,
+                                   MQTT_MAX_HEADER_SIZE + sizeof (header));
+        if (!send_packet (MQTTCONNECT, place - MQTT_MAX_HEADER_SIZE)
+            || read_packet () != 4 || p_buffer[0] != MQTTCONNACK
+            || p_buffer[3] != 0)
+        {
+            fail ();
+            return false;
+        }
+        session = true;
+        return true;
+    }
+
+    /// Find whether a session with the broker is open
+    bool connected (void)
+    {
+        if (session && !p_client->connected ())
+        {
+            session = false;
+        }
+        return session;
+    }
+
+    /// Hand any messages which have come to the callback and keep the
+    /// session alive; return false if there's no session
+    bool loop (void)
+    {
+        if (!connected ())
+        {
+            return false;
+        }
+        while (session && p_client->available () > 0)
+        {
+            size_t length = read_packet ();
+            if (length == 0)
+            {
+                return false;
+            }
+            if ((p_buffer[0] & 0xF0) != MQTTPUBLISH || p_callback == NULL)
+            {
+                continue;
+            }
+
+            // The topic is moved back a byte to end it with a zero, as the
+            // library does; QoS 0 messages have no ID after it
+            size_t header = 1;
+            while (p_buffer[header++] & 0x80)
+            {
+            }
+            uint16_t topic_length = (p_buffer[header] << 8)
+                                    | p_buffer[header + 1];
+            if (header + 2 + topic_length > length)
+            {
+                continue;
+            }
+            char* p_topic = (char*)p_buffer + header + 1;
+            memmove (p_topic, p_topic + 1, topic_length);
+            p_topic[topic_length] = '\0';
+            size_t payload = header + 2 + topic_length;
+            p_callback (p_topic, p_buffer + payload, length - payload);
+        }
+        if (millis () - last_out_ms >= MQTT_KEEPALIVE * 1000UL
+            && !send_packet (MQTTPINGREQ, 0))
+        {
+            fail ();
+        }
+        return session;
+    }
+
+    /// Publish a message with QoS 0; return false if there's no session or
+    /// the message doesn't fit in the buffer
+    bool publish (const char* p_topic, const uint8_t* p_payload,
+                  unsigned int length, bool retained = false)
+    {
+        if (!connected () || MQTT_MAX_HEADER_SIZE + 2 + strlen (p_topic)
+                             + length > buffer_size)
+        {
+            return false;
+        }
+        size_t place = put_string (p_topic, MQTT_MAX_HEADER_SIZE);
+        memcpy (p_buffer + place, p_payload, length);
+        if (!send_packet (MQTTPUBLISH | (retained ? 1 : 0),
+                          place + length - MQTT_MAX_HEADER_SIZE))
+        {
+            fail ();
+            return false;
+        }
+        return true;
+    }
+
+    /// Ask for the messages on a topic with QoS 0; the broker's answer is
+    /// read and passed over by @c loop()
+    bool subscribe (const char* p_topic)
+    {
+        if (!connected () || MQTT_MAX_HEADER_SIZE + 5 + strlen (p_topic)
+                             > buffer_size)
+        {
+            return false;
+        }
+        size_t place = MQTT_MAX_HEADER_SIZE;
+        p_buffer[place++] = (uint8_t)(next_msg_id >> 8);
+        p_buffer[place++] = (uint8_t)next_msg_id;
+        next_msg_id = (next_msg_id == 0xFFFF) ? 1 : next_msg_id + 1;
+        place = put_string (p_topic, place);
+        p_buffer[place++] = 0;
+        if (!send_packet (MQTTSUBSCRIBE, place - MQTT_MAX_HEADER_SIZE))
+        {
+            fail ();
+            return false;
+        }
+        return true;
+    }
+
+    /// End the session
+    void disconnect (void)
+    {
+        if (session)
+        {
+            send_packet (MQTTDISCONNECT, 0);
+        }
+        fail ();
+    }
+};
+
+#endif // _SIM_PUBSUBCLIENT_H_
@@ -0,0 +1,127 @@
+/** @file    WString.h
+ *  @brief   The parts of Arduino's @c String class which the benchmarks use,
+ *           for building them on a PC.
+ *  @details Memory is managed as the Arduino core does it: appending grows
+ *           the buffer with @c realloc() to exactly the new length, so
+ *           building a string one character at a time costs an allocation
+ *           per character, just as it does on the ESP32.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _SIM_WSTRING_H_
+#define _SIM_WSTRING_H_
+
+#include <stdlib.h>
+#include <string.h>
+
+
+/** @brief   A string of characters on the heap, as in Arduino.
+ */
+class String
+{
+protected:
+    char*  p_buffer;                          ///< The characters, or @c NULL
+    size_t capacity;                          ///< Characters which fit
+    size_t len;                               ///< Characters in the string
+
+    /// Make room for a number of characters, as Arduino's reserve() does
+    bool reserve (size_t size)
+    {
+        if (p_buffer != NULL && capacity >= size)
+        {
+            return true;
+        }
+        char* p_new = (char*)realloc (p_buffer, size + 1);
+        if (p_new == NULL)
+        {
+            return false;
+        }
+        if (p_buffer == NULL)
+        {
+            p_new[0] = '\0';
+        }
+        p_buffer = p_new;
+        capacity = size;
+        return true;
+    }
+
+    /// Add characters to the end of the string
+    bool concat (const char* p_text, size_t length)
+    {
+        if (!reserve (len + length))
+        {
+            return false;
+        }
+        memcpy (p_buffer + len, p_text, length);
+        len += length;
+        p_buffer[len] = '\0';
+        return true;
+    }
+
+public:
+    /// Make an empty string
+    String (void) : p_buffer (NULL), capacity (0), len (0)
+    {
+        reserve (0);
+    }
+
+    /// Make a string holding one character
+    explicit String (char ch) : p_buffer (NULL), capacity (0), len (0)
+    {
+        concat (&ch, 1);
+    }
+
+    /// Make a copy of another string
+    String (const String& other) : p_buffer (NULL), capacity (0), len (0)
+    {
+        reserve (0);
+        concat (other.c_str (), other.len);
+    }
+
+    String& operator = (const String& other)
+    {
+        if (this != &other)
+        {
+            len = 0;
+            reserve (0);
+            p_buffer[0] = '\0';
+            concat (other.c_str (), other.len);
+        }
+        return *this;
+    }
+
+    ~String (void)
+    {
+        free (p_buffer);
+    }
+
+    /// Append another string
+    String& operator += (const String& other)
+    {
+        concat (other.c_str (), other.len);
+        return *this;
+    }
+
+    /// Append one character
+    String& operator += (char ch)
+    {
+        concat (&ch, 1);
+        return *this;
+    }
+
+    /// Return the number of characters in the string
+    size_t length (void) const
+    {
+        return len;
+    }
+
+    /// Return the characters, ending in a zero
+    const char* c_str (void) const
+    {
+        return p_buffer ? p_buffer : "";
+    }
+};
+
+#endif // _SIM_WSTRING_H_
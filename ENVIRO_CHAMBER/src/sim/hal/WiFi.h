@@ -0,0 +1,197 @@
+/** @file    WiFi.h
+ *  @brief   The parts of the ESP32's WiFi library which the MQTT task uses,
+ *           for building it on a PC.
+ *  @details The network is the PC's own, reached through sockets. While a
+ *           @c wifi_drop fault from @c sim_faults.h is in effect,
+ *           @c WiFi.status() says the network is gone, clients can neither
+ *           connect nor send, and a client which was connected finds its
+ *           connection closed, as it does on the ESP32 once the TCP stack
+ *           gives up on it.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _SIM_WIFI_H_
+#define _SIM_WIFI_H_
+
+#include <Arduino.h>
+#include <errno.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+
+/// States of the WiFi connection, as in the ESP32's library
+enum wl_status_t
+{
+    WL_IDLE_STATUS   = 0,                     ///< Not trying to join
+    WL_CONNECTED     = 3,                     ///< Joined to a network
+    WL_DISCONNECTED  = 6                      ///< Not joined
+};
+
+
+/** @brief   The WiFi interface, which is joined unless a fault says not.
+ */
+class WiFiClass
+{
+public:
+    /// Find whether a network has been joined
+    wl_status_t status (void)
+    {
+        return sim_fault_hit (SIM_FAULT_WIFI_DROP) ? WL_DISCONNECTED
+                                                   : WL_CONNECTED;
+    }
+};
+
+/// The WiFi interface
+extern WiFiClass WiFi;
+
+
+/** @brief   A TCP connection, as in the ESP32's library.
+ *  @details Reading never waits; @c available() tells how much can be read
+ *           at once, as on the ESP32. Each write is sent at once rather than
+ *           held back to be sent with the next, so whatever is on the other
+ *           end of the socket sees it as soon as the write returns.
+ */
+class WiFiClient
+{
+protected:
+    int sock;                                 ///< The socket, or -1
+
+public:
+    WiFiClient (void) : sock (-1) { }
+    WiFiClient (const WiFiClient&) = delete;
+    WiFiClient& operator = (const WiFiClient&) = delete;
+
+    ~WiFiClient (void)
+    {
+        stop ();
+    }
+
+    /// Connect to a host; return 1 if connected or 0 if not
+    int connect (const char* p_host, uint16_t port)
+    {
+        char service[8];
+        struct addrinfo hints;
+        struct addrinfo* p_addresses;
+
+        stop ();
+        if (sim_fault_hit (SIM_FAULT_WIFI_DROP))
+        {
+            return 0;
+        }
+        memset (&hints, 0, sizeof (hints));
+        hints.ai_socktype = SOCK_STREAM;
+        snprintf (service, sizeof (service), "%u", port);
+        if (getaddrinfo (p_host, service, &hints, &p_addresses) != 0)
+        {
+            return 0;
+        }
+        for (struct addrinfo* p_addr = p_addresses; p_addr != NULL && sock < 0;
+             p_addr = p_addr->ai_next)
+        {
+            sock = socket (p_addr->ai_family, p_addr->ai_socktype,
+                           p_addr->ai_protocol);
+            if (sock >= 0 && ::connect (sock, p_addr->ai_addr,
+                                        p_addr->ai_addrlen) != 0)
+            {
+                close (sock);
+                sock = -1;
+            }
+        }
+        freeaddrinfo (p_addresses);
+        if (sock < 0)
+        {
+            return 0;
+        }
+        int no_delay = 1;
+        setsockopt (sock, IPPROTO_TCP, TCP_NODELAY, &no_delay,
+                    sizeof (no_delay));
+        return 1;
+    }
+
+    /// Send bytes; return how many were sent, which is all or none
+    size_t write (const uint8_t* p_buffer, size_t size)
+    {
+        if (!connected ())
+        {
+            return 0;
+        }
+        for (size_t done = 0; done < size; )
+        {
+            ssize_t sent = send (sock, p_buffer + done, size - done,
+                                 MSG_NOSIGNAL);
+            if (sent <= 0)
+            {
+                stop ();
+                return 0;
+            }
+            done += sent;
+        }
+        return size;
+    }
+
+    /// Return the number of bytes which can be read without waiting
+    int available (void)
+    {
+        int count = 0;
+        if (sock < 0 || ioctl (sock, FIONREAD, &count) != 0)
+        {
+            return 0;
+        }
+        return count;
+    }
+
+    /// Read one byte, or return -1 if none has come
+    int read (void)
+    {
+        uint8_t byte;
+        return (sock >= 0 && recv (sock, &byte, 1, MSG_DONTWAIT) == 1)
+               ? byte : -1;
+    }
+
+    /// Find whether the connection is open, or has unread bytes left
+    uint8_t connected (void)
+    {
+        if (sock < 0)
+        {
+            return 0;
+        }
+        if (sim_fault_hit (SIM_FAULT_WIFI_DROP))
+        {
+            stop ();
+            return 0;
+        }
+        uint8_t byte;
+        ssize_t result = recv (sock, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+        if (result == 0 || (result < 0 && errno != EAGAIN
+                                       && errno != EWOULDBLOCK))
+        {
+            stop ();
+            return 0;
+        }
+        return 1;
+    }
+
+    /// Close the connection
+    void stop (void)
+    {
+        if (sock >= 0)
+        {
+            close (sock);
+            sock = -1;
+        }
+    }
+
+    /// Return the socket, so a caller can wait for it to be readable
+    int fd (void) const
+    {
+        return sock;
+    }
+};
+
+#endif // _SIM_WIFI_H_
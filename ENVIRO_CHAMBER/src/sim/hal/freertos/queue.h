@@ -0,0 +1,51 @@
+/** @file    queue.h
+ *  @brief   FreeRTOS queues for the firmware's simulated tasks.
+ *  @details A task which is waiting to send or receive is woken in the
+ *           order in which it began to wait.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _SIM_QUEUE_H_
+#define _SIM_QUEUE_H_
+
+#include "FreeRTOS.h"
+
+
+/// A simulated queue; its contents are private to @c sim_rtos.cpp
+struct sim_queue_t;
+
+typedef sim_queue_t* QueueHandle_t;           ///< A simulated queue
+
+/// Control block of a static queue; the simulator doesn't use it
+struct StaticQueue_t
+{
+    uint8_t unused;                           ///< Makes the type complete
+};
+
+
+// Create a queue, taking memory from the heap
+QueueHandle_t xQueueCreate (UBaseType_t length, UBaseType_t item_size);
+
+// Create a queue in memory given by the caller
+QueueHandle_t xQueueCreateStatic (UBaseType_t length, UBaseType_t item_size,
+                                  uint8_t* p_storage,
+                                  StaticQueue_t* p_control);
+
+// Put an item at the back of a queue, waiting if it's full
+BaseType_t xQueueSendToBack (QueueHandle_t queue, const void* p_item,
+                             TickType_t ticks_to_wait);
+
+// Put an item at the back of a queue from an event, without waiting
+BaseType_t xQueueSendToBackFromISR (QueueHandle_t queue, const void* p_item,
+                                    BaseType_t* p_woken);
+
+// Take an item from the front of a queue, waiting if it's empty
+BaseType_t xQueueReceive (QueueHandle_t queue, void* p_item,
+                          TickType_t ticks_to_wait);
+
+// Get the number of items in a queue
+UBaseType_t uxQueueMessagesWaiting (QueueHandle_t queue);
+
+#endif // _SIM_QUEUE_H_
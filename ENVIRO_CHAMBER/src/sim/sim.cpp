@@ -0,0 +1,610 @@
+/** @file    sim.cpp
+ *  @brief   Source code for a discrete-event simulator which runs the
+ *           firmware's tasks on a PC under a virtual clock.
+ *  @details Tasks are fibers made with @c makecontext() and switched with
+ *           @c swapcontext(). Only the scheduler, which runs on the program's
+ *           own stack, switches to a task, and a task only ever switches back
+ *           to the scheduler, so there's no preemption in the middle of a
+ *           task's code. The events are kept in a binary heap.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <ucontext.h>
+#include "gpio.h"
+#include "sim.h"
+
+
+/// Byte written over each stack so that the unused part can be measured
+#define SIM_STACK_PAINT 0xA5
+
+
+/** @brief   A simulated task.
+ */
+struct sim_task_t
+{
+    ucontext_t  context;                      ///< Registers while switched out
+    void      (*function) (void*);            ///< Function which runs task
+    void*       p_param;                      ///< Parameter for the function
+    const char* name;                         ///< Name, shown on printouts
+    uint8_t*    p_stack;                      ///< Bottom of the task's stack
+    uint8_t     priority;                     ///< Priority; larger is higher
+    bool        ready;                        ///< Waiting to be run
+    bool        blocked;                      ///< In sim_block(), wakeable
+    bool        woken;                        ///< Left sim_block() by a wake
+    bool        taking;                       ///< Waiting for a notification
+    uint32_t    generation;                   ///< Changed each time it blocks
+    uint64_t    ready_order;                  ///< When it became ready
+    uint32_t    notifications;                ///< Notifications not yet taken
+};
+
+
+/** @brief   Something which will happen at a given virtual time.
+ *  @details An event either calls a function or makes a task ready. Waking
+ *           a task is ignored if the task has blocked again since the event
+ *           was scheduled, which is how timeouts are cancelled.
+ */
+struct sim_event_t
+{
+    uint64_t       time_us;                   ///< When it happens
+    uint64_t       order;                     ///< Breaks ties in time
+    sim_callback_t callback;                  ///< Function, or NULL for task
+    void*          p_arg;                     ///< Function's parameter
+    sim_task_t*    p_task;                    ///< Task to be made ready
+    uint32_t       generation;                ///< Task's generation then
+};
+
+
+/// The tasks, in the order in which they were created
+static sim_task_t tasks[SIM_MAX_TASKS];
+
+/// The number of tasks which have been created
+static uint8_t num_tasks = 0;
+
+/// Heap of the events which haven't happened yet, the next at the top
+static sim_event_t events[SIM_MAX_EVENTS];
+
+/// The number of events in the heap
+static uint16_t num_events = 0;
+
+/// The virtual time in microseconds
+static uint64_t now_us = 0;
+
+/// Counts events as they're scheduled, so equal times keep their order
+static uint64_t event_count = 0;
+
+/// Counts tasks as they become ready, so equal priorities take turns
+static uint64_t ready_count = 0;
+
+/// The task which is running, or NULL while the scheduler is
+static sim_task_t* p_running = NULL;
+
+/// The scheduler's registers while a task runs
+static ucontext_t scheduler_context;
+
+/// State of the random number generator
+static uint64_t random_state = 0;
+
+/// The number of times the scheduler has switched to a task
+static uint64_t switch_count = 0;
+
+
+/** @brief   Start the virtual clock at zero and seed the random numbers.
+ *  @details This must be called before any tasks or events are created.
+ *  @param   seed The seed; the same seed gives the same simulation
+ */
+void sim_begin (uint32_t seed)
+{
+    now_us = 0;
+    num_events = 0;
+    event_count = 0;
+    random_state = seed;
+}
+
+
+/** @brief   Get the virtual time since the simulation began.
+ *  @return  The time in microseconds
+ */
+uint64_t sim_now_us (void)
+{
+    return now_us;
+}
+
+
+/** @brief   Get a random number which depends only on the seed and earlier
+ *           calls.
+ *  @details This is the SplitMix64 generator, which is quick, passes the
+ *           usual statistical tests and gives the same numbers on any PC.
+ *  @return  A random 32 bit number
+ */
+uint32_t sim_random (void)
+{
+    uint64_t z = (random_state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (uint32_t)((z ^ (z >> 31)) >> 32);
+}
+
+
+/** @brief   Get a random number from a uniform distribution.
+ *  @return  A number which is at least 0 and less than 1
+ */
+float sim_random_uniform (void)
+{
+    return (float)(sim_random () >> 8) / 16777216.0f;
+}
+
+
+/** @brief   Get a random number from a normal distribution.
+ *  @details The Box-Muller method is used, taking two uniform numbers for
+ *           each result.
+ *  @return  A number from a distribution with mean 0 and deviation 1
+ */
+float sim_random_normal (void)
+{
+    float u1 = 1.0f - sim_random_uniform ();
+    float u2 = sim_random_uniform ();
+    return sqrtf (-2.0f * logf (u1)) * cosf (6.2831853f * u2);
+}
+
+
+/** @brief   Find whether one event comes before another.
+ *  @param   a The first event
+ *  @param   b The second event
+ *  @return  @c true if @c a comes first
+ */
+static inline bool earlier (const sim_event_t& a, const sim_event_t& b)
+{
+    return (a.time_us != b.time_us) ? (a.time_us < b.time_us)
+                                    : (a.order < b.order);
+}
+
+
+/** @brief   Put an event into the heap.
+ *  @details The simulation can't carry on correctly if events are lost, so
+ *           it stops if the heap is full.
+ *  @param   event The event, whose @c order is filled in here
+ */
+static void push_event (sim_event_t event)
+{
+    if (num_events >= SIM_MAX_EVENTS)
+    {
+        fprintf (stderr, "Simulator: more than %u events waiting\n",
+                 SIM_MAX_EVENTS);
+        exit (1);
+    }
+    event.order = event_count++;
+
+    uint16_t place = num_events++;
+    while (place > 0 && earlier (event, events[(place - 1) / 2]))
+    {
+        events[place] = events[(place - 1) / 2];
+        place = (place - 1) / 2;
+    }
+    events[place] = event;
+}
+
+
+/** @brief   Take the next event out of the heap.
+ *  @return  The event, which the heap must not be empty of
+ */
+static sim_event_t pop_event (void)
+{
+    sim_event_t next = events[0];
+    sim_event_t last = events[--num_events];
+    uint16_t place = 0;
+
+    for (;;)
+    {
+        uint16_t child = place * 2 + 1;
+        if (child >= num_events)
+        {
+            break;
+        }
+        if (child + 1 < num_events && earlier (events[child + 1],
+                                               events[child]))
+        {
+            child++;
+        }
+        if (!earlier (events[child], last))
+        {
+            break;
+        }
+        events[place] = events[child];
+        place = child;
+    }
+    events[place] = last;
+    return next;
+}
+
+
+/** @brief   Call a function when the virtual clock reaches a time.
+ *  @details The function is called by the scheduler, not from a task, so it
+ *           must not block. Events at the same time happen in the order in
+ *           which they were scheduled.
+ *  @param   time_us The time in microseconds; a time which has passed is
+ *           taken to mean now
+ *  @param   callback The function to be called
+ *  @param   p_arg A parameter given to the function
+ */
+void sim_call_at (uint64_t time_us, sim_callback_t callback, void* p_arg)
+{
+    sim_event_t event;
+    event.time_us = (time_us > now_us) ? time_us : now_us;
+    event.callback = callback;
+    event.p_arg = p_arg;
+    event.p_task = NULL;
+    event.generation = 0;
+    push_event (event);
+}
+
+
+/** @brief   Put a task in line to be run.
+ *  @param   p_task Pointer to the task
+ */
+static void make_ready (sim_task_t* p_task)
+{
+    p_task->ready = true;
+    p_task->ready_order = ready_count++;
+}
+
+
+/** @brief   Switch from the running task back to the scheduler.
+ *  @details This returns when the scheduler next runs the task.
+ */
+static void leave (void)
+{
+    swapcontext (&p_running->context, &scheduler_context);
+}
+
+
+/** @brief   The function at the bottom of each task's stack.
+ *  @details Tasks shouldn't return, but one which does is never run again.
+ */
+static void task_start (void)
+{
+    p_running->function (p_running->p_param);
+    p_running->ready = false;
+    p_running->blocked = false;
+    leave ();
+}
+
+
+/** @brief   Fill in a task's context so that it starts in @c task_start()
+ *           on its own stack.
+ *  @details This is kept apart from @c sim_create_task() so that nothing but
+ *           the two pointers, which don't change, is live across the call
+ *           to @c getcontext(), which returns twice as @c setjmp() does.
+ *  @param   p_context The context to fill in
+ *  @param   p_stack The bottom of the task's stack
+ */
+static void make_context (ucontext_t* const p_context, uint8_t* const p_stack)
+{
+    getcontext (p_context);
+    p_context->uc_stack.ss_sp = p_stack;
+    p_context->uc_stack.ss_size = SIM_STACK_BYTES;
+    p_context->uc_link = NULL;
+    makecontext (p_context, task_start, 0);
+}
+
+
+/** @brief   Create a task which is ready to run.
+ *  @details Every task gets @c SIM_STACK_BYTES of stack whatever size the
+ *           task table asks for, as code built for a PC uses more stack.
+ *  @param   function The function which runs the task
+ *  @param   name The task's name, which must exist as long as the task does
+ *  @param   p_param A parameter given to the function
+ *  @param   priority The task's priority; larger numbers are higher
+ *  @return  Pointer to the task, or @c NULL if too many have been created
+ *           or there was no memory for its stack
+ */
+sim_task_t* sim_create_task (void (*function) (void*), const char* name,
+                             void* p_param, uint8_t priority)
+{
+    if (num_tasks >= SIM_MAX_TASKS)
+    {
+        return NULL;
+    }
+    uint8_t* p_stack = (uint8_t*)malloc (SIM_STACK_BYTES);
+    if (p_stack == NULL)
+    {
+        return NULL;
+    }
+    sim_task_t* p_task = &tasks[num_tasks++];
+    memset (p_task, 0, sizeof (*p_task));
+    p_task->function = function;
+    p_task->p_param = p_param;
+    p_task->name = name;
+    p_task->priority = priority;
+    p_task->p_stack = p_stack;
+    memset (p_task->p_stack, SIM_STACK_PAINT, SIM_STACK_BYTES);
+
+    make_context (&p_task->context, p_stack);
+
+    make_ready (p_task);
+    return p_task;
+}
+
+
+/** @brief   Find the ready task which should run next.
+ *  @return  The highest priority ready task which has waited longest, or
+ *           @c NULL if no task is ready
+ */
+static sim_task_t* next_ready (void)
+{
+    sim_task_t* p_best = NULL;
+
+    for (uint8_t index = 0; index < num_tasks; index++)
+    {
+        sim_task_t* p_task = &tasks[index];
+        if (p_task->ready
+            && (p_best == NULL || p_task->priority > p_best->priority
+                || (p_task->priority == p_best->priority
+                    && p_task->ready_order < p_best->ready_order)))
+        {
+            p_best = p_task;
+        }
+    }
+    return p_best;
+}
+
+
+/** @brief   Run the tasks and events until the virtual clock reaches a time.
+ *  @details Events which are due happen first, then the ready tasks run one
+ *           at a time until none is ready, then the clock moves to the next
+ *           event. Tasks which are still blocked at the end stay as they
+ *           are, so this can be called again to carry on.
+ *  @param   end_us The time at which to stop, in microseconds
+ */
+void sim_run_until (uint64_t end_us)
+{
+    for (;;)
+    {
+        while (num_events > 0 && events[0].time_us <= now_us)
+        {
+            sim_event_t event = pop_event ();
+            if (event.callback != NULL)
+            {
+                event.callback (event.p_arg);
+            }
+            else if (event.generation == event.p_task->generation)
+            {
+                event.p_task->blocked = false;
+                make_ready (event.p_task);
+            }
+        }
+
+        sim_task_t* p_task = next_ready ();
+        if (p_task != NULL)
+        {
+            p_task->ready = false;
+            p_running = p_task;
+            switch_count++;
+            swapcontext (&scheduler_context, &p_task->context);
+            p_running = NULL;
+            continue;
+        }
+
+        if (num_events == 0 || events[0].time_us > end_us)
+        {
+            now_us = end_us;
+            gpio_sim_time_us = (uint32_t)now_us;
+            return;
+        }
+        now_us = events[0].time_us;
+        gpio_sim_time_us = (uint32_t)now_us;
+    }
+}
+
+
+/** @brief   Get the task which is running.
+ *  @return  Pointer to the task, or @c NULL if the scheduler or an event's
+ *           function is running
+ */
+sim_task_t* sim_current_task (void)
+{
+    return p_running;
+}
+
+
+/** @brief   Get a task's name.
+ *  @param   p_task Pointer to the task
+ *  @return  The name given when the task was created
+ */
+const char* sim_task_name (const sim_task_t* p_task)
+{
+    return p_task->name;
+}
+
+
+/** @brief   Schedule the running task to be made ready at a time.
+ *  @param   wake_us The time in microseconds
+ */
+static void schedule_wake (uint64_t wake_us)
+{
+    sim_event_t event;
+    event.time_us = (wake_us > now_us) ? wake_us : now_us;
+    event.callback = NULL;
+    event.p_arg = NULL;
+    event.p_task = p_running;
+    event.generation = ++p_running->generation;
+    push_event (event);
+}
+
+
+/** @brief   Block the calling task until a time.
+ *  @details Outside a task, nothing can wait, so this does nothing.
+ *  @param   wake_us The time at which the task is to be made ready
+ */
+void sim_sleep_until (uint64_t wake_us)
+{
+    if (p_running == NULL)
+    {
+        return;
+    }
+    schedule_wake (wake_us);
+    leave ();
+}
+
+
+/** @brief   Block the calling task until it's woken or until a time.
+ *  @param   deadline_us The time at which to give up, or @c SIM_FOREVER
+ *  @return  @c true if @c sim_wake() woke the task, @c false if the deadline
+ *           came first
+ */
+bool sim_block (uint64_t deadline_us)
+{
+    if (p_running == NULL)
+    {
+        return false;
+    }
+    sim_task_t* p_self = p_running;
+    p_self->blocked = true;
+    p_self->woken = false;
+    if (deadline_us != SIM_FOREVER)
+    {
+        schedule_wake (deadline_us);
+    }
+    else
+    {
+        ++p_self->generation;
+    }
+    leave ();
+    p_self->blocked = false;
+    return p_self->woken;
+}
+
+
+/** @brief   Wake a task which is blocked in @c sim_block().
+ *  @details If the woken task has a higher priority than the running one,
+ *           the running task is put back in line and the woken one runs at
+ *           once, as FreeRTOS would do. Waking a task which isn't blocked
+ *           does nothing.
+ *  @param   p_task Pointer to the task to be woken
+ */
+void sim_wake (sim_task_t* p_task)
+{
+    if (!p_task->blocked)
+    {
+        return;
+    }
+    p_task->blocked = false;
+    p_task->woken = true;
+    p_task->generation++;
+    make_ready (p_task);
+
+    if (p_running != NULL && p_task->priority > p_running->priority)
+    {
+        make_ready (p_running);
+        leave ();
+    }
+}
+
+
+/** @brief   Let the clock move to the next event while the calling task
+ *           polls.
+ *  @details Nothing outside the running task can change until an event
+ *           happens, so the task waits for the next one; other tasks which
+ *           become ready then run first if their priority is higher.
+ */
+void sim_poll (void)
+{
+    if (p_running == NULL || num_events == 0)
+    {
+        return;
+    }
+    schedule_wake (events[0].time_us);
+    leave ();
+}
+
+
+/** @brief   Move the clock on while the calling task keeps the CPU.
+ *  @details This stands for work which stops every task for a while, such
+ *           as writing to flash, during which an ESP32 can't run code from
+ *           flash on either core. Tasks which were due in the meantime run
+ *           late, once the calling task blocks.
+ *  @param   duration_us How long the work takes, in microseconds
+ */
+void sim_stall (uint32_t duration_us)
+{
+    now_us += duration_us;
+    gpio_sim_time_us = (uint32_t)now_us;
+}
+
+
+/** @brief   Add to a task's count of notifications and wake it if it's
+ *           waiting for one.
+ *  @param   p_task Pointer to the task
+ */
+void sim_notify (sim_task_t* p_task)
+{
+    p_task->notifications++;
+    if (p_task->taking)
+    {
+        sim_wake (p_task);
+    }
+}
+
+
+/** @brief   Wait for notifications to the calling task and take them.
+ *  @param   clear @c true to take all the notifications, @c false to take
+ *           one
+ *  @param   deadline_us The time at which to give up, or @c SIM_FOREVER
+ *  @return  The count of notifications before any were taken
+ */
+uint32_t sim_notify_take (bool clear, uint64_t deadline_us)
+{
+    sim_task_t* p_self = p_running;
+    if (p_self == NULL)
+    {
+        return 0;
+    }
+    if (p_self->notifications == 0 && deadline_us > now_us)
+    {
+        p_self->taking = true;
+        sim_block (deadline_us);
+        p_self->taking = false;
+    }
+
+    uint32_t count = p_self->notifications;
+    if (clear)
+    {
+        p_self->notifications = 0;
+    }
+    else if (count > 0)
+    {
+        p_self->notifications--;
+    }
+    return count;
+}
+
+
+/** @brief   Find how much of a task's stack has never been used.
+ *  @details The stack grows down, so the unused part is at the bottom and
+ *           still holds the paint written when the task was made.
+ *  @param   p_task Pointer to the task
+ *  @return  The number of bytes which have never been used
+ */
+uint32_t sim_stack_unused (const sim_task_t* p_task)
+{
+    uint32_t unused = 0;
+    while (unused < SIM_STACK_BYTES
+           && p_task->p_stack[unused] == SIM_STACK_PAINT)
+    {
+        unused++;
+    }
+    return unused;
+}
+
+
+/** @brief   Get the number of times the scheduler has switched to a task.
+ *  @return  The number of switches since the program started
+ */
+uint64_t sim_switches (void)
+{
+    return switch_count;
+}
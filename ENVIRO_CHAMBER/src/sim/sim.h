@@ -0,0 +1,115 @@
+/** @file    sim.h
+ *  @brief   Headers for a discrete-event simulator which runs the firmware's
+ *           tasks on a PC under a virtual clock.
+ *  @details Each task is a fiber with its own stack, and only one runs at a
+ *           time. A task runs without any virtual time passing until it
+ *           blocks in @c vTaskDelayUntil(), a queue, a notification or
+ *           @c delay(); then the scheduler runs the highest priority task
+ *           which is ready, or else moves the clock straight to the next
+ *           event. Events are kept in order of time and then of when they
+ *           were scheduled, ready tasks of equal priority take turns in the
+ *           order they became ready, and all randomness comes from
+ *           @c sim_random(), so a run with the same seed does exactly the
+ *           same thing every time. A week of the chamber takes seconds.
+ *
+ *           Both ESP32 cores are modelled as one sequence of task runs. As
+ *           task bodies take no virtual time, this matches a two-core run in
+ *           which the tasks never overlap. A task which waits by polling a
+ *           pin can't see the pin change until some event happens, so
+ *           polling moves the clock to the next event rather than spinning.
+ *
+ *           The headers in @c sim/hal stand in for the Arduino, FreeRTOS,
+ *           MAX31856, WiFi and PubSubClient headers, and @c sim_devices.h
+ *           models the chamber and its thermocouple amplifier. Build and run with
+ *           @c pio @c run @c -e @c sim and
+ *           @c .pio/build/sim/program @c --days @c 7 @c --seed @c 1 .
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _SIM_H_
+#define _SIM_H_
+
+#include <stdint.h>
+
+
+/// Bytes of stack given to each task; a PC needs more than an ESP32
+#define SIM_STACK_BYTES 65536
+
+/// Largest number of tasks which can be simulated
+#define SIM_MAX_TASKS 16
+
+/// Largest number of events which can be waiting at once
+#define SIM_MAX_EVENTS 256
+
+/// A time which never comes, for waiting without a timeout
+#define SIM_FOREVER UINT64_MAX
+
+
+/// A function called when an event comes due
+typedef void (*sim_callback_t) (void* p_arg);
+
+/// A simulated task; its contents are private to @c sim.cpp
+struct sim_task_t;
+
+
+// Start the virtual clock at zero and seed the random numbers
+void sim_begin (uint32_t seed);
+
+// Get the virtual time in microseconds since the simulation began
+uint64_t sim_now_us (void);
+
+// Get a random number which depends only on the seed and earlier calls
+uint32_t sim_random (void);
+
+// Get a random number from a uniform distribution over [0, 1)
+float sim_random_uniform (void);
+
+// Get a random number from a normal distribution, mean 0, deviation 1
+float sim_random_normal (void);
+
+// Call a function when the virtual clock reaches a time
+void sim_call_at (uint64_t time_us, sim_callback_t callback, void* p_arg);
+
+// Create a task which is ready to run
+sim_task_t* sim_create_task (void (*function) (void*), const char* name,
+                             void* p_param, uint8_t priority);
+
+// Run the tasks and events until the virtual clock reaches a time
+void sim_run_until (uint64_t end_us);
+
+// Get the task which is running, or NULL if the scheduler is
+sim_task_t* sim_current_task (void);
+
+// Get a task's name
+const char* sim_task_name (const sim_task_t* p_task);
+
+// Block the calling task until a time
+void sim_sleep_until (uint64_t wake_us);
+
+// Block the calling task until it's woken or until a time
+bool sim_block (uint64_t deadline_us);
+
+// Wake a task which is blocked in sim_block()
+void sim_wake (sim_task_t* p_task);
+
+// Let the clock move to the next event while the calling task polls
+void sim_poll (void);
+
+// Move the clock on while the calling task keeps the CPU
+void sim_stall (uint32_t duration_us);
+
+// Add to a task's count of notifications and wake it if it's waiting
+void sim_notify (sim_task_t* p_task);
+
+// Wait for notifications to the calling task and take them
+uint32_t sim_notify_take (bool clear, uint64_t deadline_us);
+
+// Find how much of a task's stack has never been used
+uint32_t sim_stack_unused (const sim_task_t* p_task);
+
+// Get the number of times the scheduler has switched to a task
+uint64_t sim_switches (void);
+
+#endif // _SIM_H_
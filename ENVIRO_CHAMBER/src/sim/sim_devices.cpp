@@ -0,0 +1,181 @@
+/** @file    sim_devices.cpp
+ *  @brief   Source code for simulated models of the chamber and of its
+ *           thermocouple amplifier.
+ *  @details The chamber's temperature is brought up to date at each
+ *           conversion, using the exact solution of its first order model
+ *           with the heater held as it was at the end of the interval. The
+ *           heater task and the conversions both run every 100 ms, so this
+ *           is never more than one period behind.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <Arduino.h>
+#include <Adafruit_MAX31856.h>
+#include "board.h"
+#include "gpio.h"
+#include "sim.h"
+#include "sim_devices.h"
+#include "sim_faults.h"
+
+
+/// Number of microseconds in a day, over which the room's temperature swings
+#define SIM_DAY_US 86400000000ULL
+
+
+/// The chamber's properties
+static sim_chamber_t params;
+
+/// The chamber's temperature, in degrees C
+static float temperature = 0.0f;
+
+/// Time at which the chamber's temperature was last brought up to date
+static uint64_t updated_us = 0;
+
+/// Total time for which the heater has been on
+static uint64_t heater_us = 0;
+
+/// The latest conversion, which is read from the amplifier
+static float latched = 0.0f;
+
+/// Whether conversions have been started
+static bool converting = false;
+
+
+/** @brief   Let time pass when a task reads the same pin twice at once.
+ *  @details A task which reads a pin again without blocking in between is
+ *           polling it, and the pin can't change before the next event, so
+ *           the task waits for that event instead of spinning.
+ *  @param   pin The pin which is being read
+ */
+static void pin_read (uint8_t pin)
+{
+    static uint8_t last_pin = GPIO_NUM_PINS;
+    static uint64_t last_us = SIM_FOREVER;
+
+    if (pin == last_pin && sim_now_us () == last_us)
+    {
+        sim_poll ();
+    }
+    last_pin = pin;
+    last_us = sim_now_us ();
+}
+
+
+/** @brief   Start the models, with the chamber at room temperature.
+ *  @details This also makes tasks which poll pins wait for events.
+ *  @param   chamber The chamber's properties
+ */
+void sim_devices_begin (const sim_chamber_t& chamber)
+{
+    params = chamber;
+    temperature = chamber.ambient_c;
+    updated_us = sim_now_us ();
+    heater_us = 0;
+    converting = false;
+    gpio_sim_level[board.drdy_pin] = 1;
+    gpio_sim_read_hook = pin_read;
+}
+
+
+/** @brief   Bring the chamber's temperature up to date.
+ */
+static void update_chamber (void)
+{
+    uint64_t now = sim_now_us ();
+    float dt = (now - updated_us) * 1e-6f;
+    bool heating = gpio_sim_level[board.heater_pin] != 0;
+
+    float ambient = params.ambient_c + params.ambient_swing_c
+                    * sinf (6.2831853f * (float)(now % SIM_DAY_US)
+                            / (float)SIM_DAY_US);
+    float target = ambient + (heating ? params.heater_rise_c : 0.0f);
+    temperature = target + (temperature - target)
+                           * expf (-dt / params.time_constant_s);
+
+    if (heating)
+    {
+        heater_us += now - updated_us;
+    }
+    updated_us = now;
+}
+
+
+/** @brief   Finish a conversion and start the next one.
+ *  @param   p_arg Not used
+ */
+static void conversion_done (void* p_arg)
+{
+    (void)p_arg;
+    update_chamber ();
+    float reading = temperature + params.noise_c * sim_random_normal ();
+    latched = roundf (reading / SIM_RESOLUTION_C) * SIM_RESOLUTION_C;
+    if (!sim_fault_hit (SIM_FAULT_DRDY_STUCK))
+    {
+        gpio_sim_level[board.drdy_pin] = 0;
+    }
+    sim_call_at (sim_now_us () + SIM_CONVERSION_US, conversion_done, NULL);
+}
+
+
+/** @brief   Get the chamber's temperature as of the last conversion.
+ *  @return  The temperature in degrees C, without noise
+ */
+float sim_chamber_temperature (void)
+{
+    return temperature;
+}
+
+
+/** @brief   Get the total time for which the heater has been on.
+ *  @return  The time in microseconds, up to the last conversion
+ */
+uint64_t sim_heater_on_us (void)
+{
+    return heater_us;
+}
+
+
+/** @brief   Start talking to the amplifier.
+ *  @return  @c true if there's an amplifier on this chip select and it
+ *           answers
+ */
+bool Adafruit_MAX31856::begin (void)
+{
+    return cs_pin == board.cs_pins[0] && !sim_fault_hit (SIM_FAULT_SPI_BEGIN);
+}
+
+
+/** @brief   Set the type of thermocouple, which the model ignores.
+ *  @param   type The type of thermocouple
+ */
+void Adafruit_MAX31856::setThermocoupleType (max31856_thermocoupletype_t type)
+{
+    (void)type;
+}
+
+
+/** @brief   Start converting; only continuous conversion is modelled.
+ *  @param   mode How the amplifier is to convert
+ */
+void Adafruit_MAX31856::setConversionMode (max31856_conversion_mode_t mode)
+{
+    if (mode == MAX31856_CONTINUOUS && !converting)
+    {
+        converting = true;
+        sim_call_at (sim_now_us () + SIM_CONVERSION_US, conversion_done,
+                     NULL);
+    }
+}
+
+
+/** @brief   Read the latest conversion, which lets data ready go high.
+ *  @details When the SPI bus fails, the chip still sees its registers read
+ *           but every bit comes back as zero, which is a reading of 0 C.
+ *  @return  The temperature in degrees C
+ */
+float Adafruit_MAX31856::readThermocoupleTemperature (void)
+{
+    gpio_sim_level[board.drdy_pin] = 1;
+    return sim_fault_hit (SIM_FAULT_SPI_READ) ? 0.0f : latched;
+}
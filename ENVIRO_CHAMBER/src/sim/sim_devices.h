@@ -0,0 +1,53 @@
+/** @file    sim_devices.h
+ *  @brief   Headers for simulated models of the chamber and of its
+ *           thermocouple amplifier.
+ *  @details The chamber is a single thermal mass which loses heat to the
+ *           room and gains it from the heater while the heater's pin is
+ *           high. The room's temperature swings a little over each day. The
+ *           MAX31856 converts every @c SIM_CONVERSION_US in continuous mode,
+ *           adding noise to each reading and rounding it to the chip's
+ *           resolution, and pulls its data ready pin low until the reading
+ *           is taken. Only the amplifier on the board's first chip select
+ *           is fitted; @c begin() fails on the others. Faults scheduled in
+ *           @c sim_faults.h can make @c begin() and readings fail and keep
+ *           data ready from going low.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _SIM_DEVICES_H_
+#define _SIM_DEVICES_H_
+
+#include <stdint.h>
+
+
+/// Time the simulated MAX31856 takes for each conversion, in microseconds
+#define SIM_CONVERSION_US 100000
+
+/// The MAX31856's resolution, in degrees C
+#define SIM_RESOLUTION_C 0.0078125f
+
+
+/** @brief   The properties of the simulated chamber.
+ */
+struct sim_chamber_t
+{
+    float ambient_c;                          ///< Mean room temperature, C
+    float ambient_swing_c;                    ///< Room's daily swing, +/- C
+    float time_constant_s;                    ///< Time to settle 63%, s
+    float heater_rise_c;                      ///< Rise with heater on, C
+    float noise_c;                            ///< Deviation of readings, C
+};
+
+
+// Start the models, with the chamber at room temperature
+void sim_devices_begin (const sim_chamber_t& chamber);
+
+// Get the chamber's temperature as of the last conversion
+float sim_chamber_temperature (void);
+
+// Get the total time for which the heater has been on
+uint64_t sim_heater_on_us (void);
+
+#endif // _SIM_DEVICES_H_
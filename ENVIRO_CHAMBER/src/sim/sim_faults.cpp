@@ -0,0 +1,282 @@
+/** @file    sim_faults.cpp
+ *  @brief   Source code for faults which can be injected into the simulated
+ *           hardware on a schedule.
+ *  @details The schedule is short, so each use of the hardware just looks
+ *           through all of it for faults of the right kind which are in
+ *           effect at the virtual time.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <Arduino.h>
+#include "sim.h"
+#include "sim_faults.h"
+
+
+/// Names of the kinds of fault, as used in schedules
+static const char* const kind_names[SIM_FAULT_NUM_KINDS] =
+{
+    "spi_begin", "spi_read", "drdy_stuck", "flash_open", "flash_write",
+    "wifi_drop", "slow_client"
+};
+
+/// The schedule of faults, in the order in which they were added
+static sim_fault_t faults[SIM_MAX_FAULTS];
+
+/// The number of faults in the schedule
+static uint8_t num_faults = 0;
+
+
+/** @brief   Forget all the faults in the schedule.
+ */
+void sim_fault_clear (void)
+{
+    num_faults = 0;
+}
+
+
+/** @brief   Add a fault to the schedule.
+ *  @param   kind What goes wrong
+ *  @param   start_us The virtual time at which the fault starts
+ *  @param   duration_us How long the fault lasts, or @c SIM_FOREVER
+ *  @param   chance The chance, from 0 to 1, that each use of the hardware
+ *           fails while the fault lasts
+ *  @return  @c true if the fault was added, @c false if the schedule is full
+ */
+bool sim_fault_add (sim_fault_kind_t kind, uint64_t start_us,
+                    uint64_t duration_us, float chance)
+{
+    if (num_faults >= SIM_MAX_FAULTS || kind >= SIM_FAULT_NUM_KINDS)
+    {
+        return false;
+    }
+    sim_fault_t& fault = faults[num_faults++];
+    fault.kind = kind;
+    fault.start_us = start_us;
+    fault.end_us = (duration_us > SIM_FOREVER - start_us)
+                   ? SIM_FOREVER : start_us + duration_us;
+    fault.chance = chance;
+    fault.hits = 0;
+    fault.recovery_us = 0;
+    fault.recovered = false;
+    return true;
+}
+
+
+/** @brief   Add a fault to the schedule from one line of a schedule file.
+ *  @details A line holds a kind, a start time and a duration in seconds and
+ *           an optional chance; a duration of @c forever never ends. Blank
+ *           lines and lines which begin with @c '#' are skipped.
+ *  @param   p_line The line
+ *  @return  @c true if the line was a fault or was skipped, @c false if it
+ *           couldn't be understood or the schedule is full
+ */
+bool sim_fault_parse (const char* p_line)
+{
+    char name[32];
+    char duration[32];
+    double start_s = 0.0;
+    float chance = 1.0f;
+
+    while (*p_line == ' ' || *p_line == '\t')
+    {
+        p_line++;
+    }
+    if (*p_line == '#' || *p_line == '\n' || *p_line == '\r'
+        || *p_line == '\0')
+    {
+        return true;
+    }
+    if (sscanf (p_line, "%31s %lf %31s %f", name, &start_s, duration,
+                &chance) < 3 || start_s < 0.0 || chance < 0.0f)
+    {
+        return false;
+    }
+
+    uint64_t duration_us = SIM_FOREVER;
+    if (strcmp (duration, "forever") != 0)
+    {
+        char* p_end;
+        double duration_s = strtod (duration, &p_end);
+        if (*p_end != '\0' || duration_s < 0.0)
+        {
+            return false;
+        }
+        duration_us = (uint64_t)(duration_s * 1e6);
+    }
+
+    for (uint8_t kind = 0; kind < SIM_FAULT_NUM_KINDS; kind++)
+    {
+        if (strcmp (name, kind_names[kind]) == 0)
+        {
+            return sim_fault_add ((sim_fault_kind_t)kind,
+                                  (uint64_t)(start_s * 1e6), duration_us,
+                                  chance);
+        }
+    }
+    return false;
+}
+
+
+/** @brief   Add the faults in a schedule file to the schedule.
+ *  @param   p_path The file's path on the PC
+ *  @return  @c true if every line was understood, @c false if not; the
+ *           first line which wasn't is printed on standard error
+ */
+bool sim_fault_load (const char* p_path)
+{
+    FILE* p_file = fopen (p_path, "r");
+    if (p_file == NULL)
+    {
+        perror (p_path);
+        return false;
+    }
+
+    char line[128];
+    uint16_t number = 0;
+    bool all_ok = true;
+    while (all_ok && fgets (line, sizeof (line), p_file) != NULL)
+    {
+        number++;
+        if (!sim_fault_parse (line))
+        {
+            fprintf (stderr, "%s:%u: bad fault: %s", p_path, number, line);
+            all_ok = false;
+        }
+    }
+    fclose (p_file);
+    return all_ok;
+}
+
+
+/** @brief   Find whether a use of the hardware should fail now.
+ *  @details The simulated hardware calls this each time it's used. Each
+ *           fault of the given kind which is in effect gets a chance to make
+ *           the use fail, and the first which does counts it as a hit.
+ *  @param   kind The kind of fault which would make this use fail
+ *  @return  @c true if the use should fail
+ */
+bool sim_fault_hit (sim_fault_kind_t kind)
+{
+    uint64_t now = sim_now_us ();
+
+    for (uint8_t index = 0; index < num_faults; index++)
+    {
+        sim_fault_t& fault = faults[index];
+        if (fault.kind != kind || now < fault.start_us || now >= fault.end_us)
+        {
+            continue;
+        }
+        if (fault.chance >= 1.0f || sim_random_uniform () < fault.chance)
+        {
+            fault.hits++;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/** @brief   Tell the fault layer whether an output of the firmware was right.
+ *  @details The first right output after a fault has ended marks the time at
+ *           which the firmware recovered from it.
+ *  @param   right @c true if the output was what it should have been
+ */
+void sim_fault_sample (bool right)
+{
+    if (!right)
+    {
+        return;
+    }
+    uint64_t now = sim_now_us ();
+    for (uint8_t index = 0; index < num_faults; index++)
+    {
+        sim_fault_t& fault = faults[index];
+        if (!fault.recovered && now >= fault.end_us)
+        {
+            fault.recovered = true;
+            fault.recovery_us = now - fault.end_us;
+        }
+    }
+}
+
+
+/** @brief   Get the longest time any fault took to recover from.
+ *  @details A fault which has ended but hasn't been recovered from counts
+ *           the time since it ended.
+ *  @return  The time in microseconds, or 0 if no fault has ended
+ */
+uint64_t sim_fault_worst_recovery_us (void)
+{
+    uint64_t now = sim_now_us ();
+    uint64_t worst = 0;
+
+    for (uint8_t index = 0; index < num_faults; index++)
+    {
+        const sim_fault_t& fault = faults[index];
+        uint64_t taken = fault.recovered ? fault.recovery_us
+                         : (now >= fault.end_us) ? now - fault.end_us : 0;
+        worst = (taken > worst) ? taken : worst;
+    }
+    return worst;
+}
+
+
+/** @brief   Get one of the faults in the schedule.
+ *  @param   index The fault's place in the schedule, from 0
+ *  @return  Pointer to the fault, or @c NULL if there's no such fault
+ */
+const sim_fault_t* sim_fault_get (uint8_t index)
+{
+    return (index < num_faults) ? &faults[index] : NULL;
+}
+
+
+/** @brief   Get the name of a kind of fault, as used in schedules.
+ *  @param   kind The kind of fault
+ *  @return  The name
+ */
+const char* sim_fault_name (sim_fault_kind_t kind)
+{
+    return (kind < SIM_FAULT_NUM_KINDS) ? kind_names[kind] : "unknown";
+}
+
+
+/** @brief   Print the schedule and what each fault did.
+ *  @details A fault which hasn't been recovered from shows a recovery time
+ *           of @c - .
+ *  @param   printer The printer to which to print
+ */
+void sim_fault_print (Print& printer)
+{
+    if (num_faults == 0)
+    {
+        return;
+    }
+    printer.printf ("%-12s %10s %10s %6s %8s %10s\r\n", "Fault", "Start s",
+                    "End s", "Chance", "Hits", "Recover s");
+    for (uint8_t index = 0; index < num_faults; index++)
+    {
+        const sim_fault_t& fault = faults[index];
+        printer.printf ("%-12s %10.1f ", sim_fault_name (fault.kind),
+                        fault.start_us * 1e-6);
+        if (fault.end_us == SIM_FOREVER)
+        {
+            printer.printf ("%10s ", "forever");
+        }
+        else
+        {
+            printer.printf ("%10.1f ", fault.end_us * 1e-6);
+        }
+        printer.printf ("%6.2f %8lu ", (double)fault.chance,
+                        (unsigned long)fault.hits);
+        if (fault.recovered)
+        {
+            printer.printf ("%10.1f\r\n", fault.recovery_us * 1e-6);
+        }
+        else
+        {
+            printer.printf ("%10s\r\n", "-");
+        }
+    }
+}
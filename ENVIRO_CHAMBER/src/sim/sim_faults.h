@@ -0,0 +1,107 @@
+/** @file    sim_faults.h
+ *  @brief   Headers for faults which can be injected into the simulated
+ *           hardware on a schedule.
+ *  @details A schedule is a list of faults, each with a kind, a time at
+ *           which it starts, how long it lasts and the chance that each use
+ *           of the hardware fails while it lasts. The simulated hardware
+ *           asks @c sim_fault_hit() each time it's used whether that use
+ *           should fail, and fails in the way the real part would:
+ *           - @c spi_begin: @c Adafruit_MAX31856::begin() returns @c false
+ *           - @c spi_read: a reading comes back as all zero bits, 0 C
+ *           - @c drdy_stuck: data ready stays high after conversions
+ *           - @c flash_open: opening a file fails, as if it isn't mounted
+ *           - @c flash_write: writes to files write nothing
+ *           - @c wifi_drop: the network can't be reached
+ *           - @c slow_client: the serial port has no room to send
+ *
+ *           A schedule is written one fault to a line, times in seconds:
+ *           @code
+ *           # kind       start   duration  [chance]
+ *           spi_read     3600    60        0.2
+ *           drdy_stuck   7200    30
+ *           @endcode
+ *           Only one random number is drawn for each use of a part which
+ *           has a fault with a chance below 1 in effect, so a run with no
+ *           faults is the same as one without the fault layer.
+ *
+ *           To measure recovery, whatever checks the firmware's output
+ *           calls @c sim_fault_sample() for each output, saying whether it
+ *           was right. A fault's recovery time runs from its end to the
+ *           first right output after that.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _SIM_FAULTS_H_
+#define _SIM_FAULTS_H_
+
+#include <stdint.h>
+
+class Print;
+
+
+/// Largest number of faults in a schedule
+#define SIM_MAX_FAULTS 32
+
+
+/// The kinds of fault which the simulated hardware can have
+enum sim_fault_kind_t : uint8_t
+{
+    SIM_FAULT_SPI_BEGIN,                      ///< Amplifier doesn't answer
+    SIM_FAULT_SPI_READ,                       ///< Readings are all zeros
+    SIM_FAULT_DRDY_STUCK,                     ///< Data ready stays high
+    SIM_FAULT_FLASH_OPEN,                     ///< Files can't be opened
+    SIM_FAULT_FLASH_WRITE,                    ///< Writes to files fail
+    SIM_FAULT_WIFI_DROP,                      ///< Network can't be reached
+    SIM_FAULT_SLOW_CLIENT,                    ///< No room to send data
+    SIM_FAULT_NUM_KINDS                       ///< How many kinds there are
+};
+
+
+/** @brief   One fault in a schedule, and what it has done so far.
+ */
+struct sim_fault_t
+{
+    sim_fault_kind_t kind;                    ///< What goes wrong
+    uint64_t         start_us;                ///< When it starts
+    uint64_t         end_us;                  ///< When it stops
+    float            chance;                  ///< Chance each use fails
+    uint32_t         hits;                    ///< Uses which have failed
+    uint64_t         recovery_us;             ///< End to first right output
+    bool             recovered;               ///< A right output has come
+};
+
+
+// Forget all the faults in the schedule
+void sim_fault_clear (void);
+
+// Add a fault to the schedule
+bool sim_fault_add (sim_fault_kind_t kind, uint64_t start_us,
+                    uint64_t duration_us, float chance = 1.0f);
+
+// Add a fault to the schedule from one line of a schedule file
+bool sim_fault_parse (const char* p_line);
+
+// Add the faults in a schedule file to the schedule
+bool sim_fault_load (const char* p_path);
+
+// Find whether a use of the hardware should fail now
+bool sim_fault_hit (sim_fault_kind_t kind);
+
+// Tell the fault layer whether an output of the firmware was right
+void sim_fault_sample (bool right);
+
+// Get the longest time any fault took to recover from
+uint64_t sim_fault_worst_recovery_us (void);
+
+// Get one of the faults in the schedule
+const sim_fault_t* sim_fault_get (uint8_t index);
+
+// Get the name of a kind of fault, as used in schedules
+const char* sim_fault_name (sim_fault_kind_t kind);
+
+// Print the schedule and what each fault did
+void sim_fault_print (Print& printer);
+
+#endif // _SIM_FAULTS_H_
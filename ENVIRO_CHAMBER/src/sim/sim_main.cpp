@@ -0,0 +1,663 @@
+/** @file    sim_main.cpp
+ *  @brief   The main program of the chamber's simulator, which runs the
+ *           firmware's sensor and heater tasks on a PC under a virtual clock.
+ *  @details The sensor and heater tasks are the firmware's own, from
+ *           @c control.cpp, and they're created from a task table with the
+ *           same periods and priorities as in @c main_enviro.cpp. The WiFi
+ *           task can't run without a network, so a user task in its place
+ *           polls every 5 s as it does and now and then changes the setpoint,
+ *           as someone using the web page would. The flash log is replaced
+ *           by a task which takes samples from the log queue and adds them
+ *           to a digest, so two runs can be compared with one number.
+ *
+ *           Faults from @c sim_faults.h can be scheduled from a file with
+ *           @c --faults or one at a time with @c --fault. The recorder finds
+ *           the longest gap between samples and, for each fault, how long
+ *           after it ended the first right reading came. With @c --max-gap-s
+ *           or @c --max-recovery-s, the program exits with status 2 if the
+ *           worst case is longer, so a script can check the firmware's
+ *           recovery.
+ *
+ *           With @c --flood, a stand-in for the web server gets that many
+ *           requests per second from @c --flood-clients addresses and checks
+ *           each with the firmware's rate limiter. An admitted request for
+ *           @c /get changes the setpoint and wakes a stand-in for the journal
+ *           task, which saves it to flash; while flash is written, no task
+ *           can run. The heater task's worst timing jitter is found in any
+ *           run, and with @c --max-jitter-ms the program exits with status 2
+ *           if it's worse, so a script can check that a flood can't upset
+ *           the heater's timing by more than that.
+ *
+ *           With @c --console, the firmware's console from @c console.cpp
+ *           reads commands from standard input once the days have been
+ *           simulated; @c run carries the simulation on for a while, so the
+ *           chamber can be looked at and its setpoint changed as it would
+ *           be over the serial port.
+ *
+ *           Usage: @c program [--days D] [--seed S] [--csv FILE]
+ *                  [--faults FILE] [--fault "KIND START DURATION [CHANCE]"]
+ *                  [--max-gap-s S] [--max-recovery-s S] [--console]
+ *                  [--flood RATE] [--flood-clients N] [--max-jitter-ms MS]
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <Arduino.h>
+#include <time.h>
+#include "taskshare.h"
+#include "taskqueue.h"
+#include "tasktable.h"
+#include "sample.h"
+#include "stats.h"
+#include "deferlog.h"
+#include "console.h"
+#include "configstore.h"
+#include "ratelimit.h"
+#include "control.h"
+#include "sim.h"
+#include "sim_devices.h"
+#include "sim_faults.h"
+
+
+/// Number of samples the log queue holds, as in @c task_logger.h
+#define SIM_LOG_QUEUE_SIZE 32
+
+/// Mean time between the simulated user's changes of setpoint, in seconds
+#define SIM_USER_CHANGE_S (6 * 3600)
+
+/// Period of the simulated user's polls, as the WiFi task's, in ms
+#define SIM_USER_PERIOD_MS 5000
+
+/// A reading this close to the chamber's true temperature counts as right
+#define SIM_RIGHT_C 0.5f
+
+/// Period of the stand-in for the web server's TCP task, in ms; it doesn't
+/// divide the heater's period, so saves come at every point in its cycle
+#define SIM_FLOOD_PERIOD_MS 7
+
+/// Address of the first client which floods the web server, 10.0.0.0
+#define SIM_FLOOD_BASE_IP 0x0A000000UL
+
+/// One flood request in this many is for @c /get; the rest are for the page
+#define SIM_FLOOD_GET_EVERY 4
+
+/// Time for which writing a saved setpoint to flash stops the tasks, in us
+#define SIM_FLASH_SAVE_US 1500
+
+/// Time for which erasing a sector of flash stops the tasks, in us
+#define SIM_FLASH_ERASE_US 45000
+
+/// Number of saves after which a sector of flash has to be erased
+#define SIM_FLASH_SAVES_PER_ERASE 256
+
+
+/// Share to communicate the desired temperature setpoint
+Share<int16_t> desired_temp ("Temperature");
+
+/// Share to communicate the current temperature reading
+Share<int16_t> temp_reading ("Curr Temp");
+
+/// Share to communicate the thermocouple reading at full resolution
+Share<float> therm_temp ("Therm Temp");
+
+/// Share to communicate whether the heater is turned on
+Share<bool> heater_on ("Heater On");
+
+/// Share to communicate windowed statistics of the chamber's data
+Share<stats_snapshot_t> chamber_stats ("Statistics");
+
+/// Queue which carries samples from the sensor task to the recorder
+Queue<sample_t> log_queue (SIM_LOG_QUEUE_SIZE, "Log Queue");
+
+
+/// The routes of the web server which the flood asks for
+enum sim_route_t
+{
+    SIM_ROUTE_INDEX,                          ///< The page with the form
+    SIM_ROUTE_GET                             ///< Setpoint entry, saved
+};
+
+/// Rate limits of those routes, as in @c main_enviro.cpp
+static const route_limit_t sim_route_limits[] =
+{
+//   Per second  Burst
+    {  5,      10 },                          // SIM_ROUTE_INDEX
+    {  1,       3 }                           // SIM_ROUTE_GET
+};
+
+/// The rate limiter which checks the flood's requests, as the web server's
+static RateLimiter sim_limiter (sim_route_limits,
+                                sizeof (sim_route_limits)
+                                / sizeof (sim_route_limits[0]), 4);
+
+
+/** @brief   What the recorder task has found in the samples.
+ */
+struct sim_results_t
+{
+    uint32_t samples;                         ///< Samples taken
+    uint32_t changes;                         ///< Changes of setpoint
+    uint32_t dropped_polls;                   ///< Polls lost to WiFi drops
+    uint32_t last_ms;                         ///< Time of the latest sample
+    uint32_t max_gap_ms;                      ///< Longest time between them
+    uint64_t digest;                          ///< FNV-1a hash of the samples
+    float    min_c;                           ///< Lowest reading
+    float    max_c;                           ///< Highest reading
+    double   sum_c;                           ///< Sum of readings
+    double   sum_error_c;                     ///< Sum of reading - setpoint
+    uint32_t requests;                        ///< Web requests in the flood
+    uint32_t admitted;                        ///< Requests the limiter let in
+    uint32_t flash_saves;                     ///< Saves of the setpoint
+    uint32_t max_jitter_us;                   ///< Heater's worst jitter
+};
+
+/// The recorder's results so far
+static sim_results_t results;
+
+/// File to which samples are written as CSV, or @c NULL
+static FILE* p_csv = NULL;
+
+/// Web requests per second in the flood, or 0 for none
+static double flood_rate = 0.0;
+
+/// Number of client addresses from which the flood comes
+static uint32_t flood_clients = 64;
+
+/// The simulated tasks, which are listed near the end of this file
+extern task_entry_t task_table[];
+
+
+/** @brief   Add some bytes to an FNV-1a hash.
+ *  @param   hash The hash so far
+ *  @param   p_data Pointer to the bytes
+ *  @param   size The number of bytes
+ *  @return  The new hash
+ */
+static uint64_t fnv1a (uint64_t hash, const void* p_data, size_t size)
+{
+    const uint8_t* p_byte = (const uint8_t*)p_data;
+    while (size--)
+    {
+        hash = (hash ^ *p_byte++) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+
+/** @brief   Find the heater task's worst timing jitter so far.
+ *  @details The task table keeps the worst jitter of the last window and of
+ *           the one being measured, so this must be called at least once a
+ *           window to miss nothing.
+ *  @return  The worst jitter found in this and earlier calls, in us
+ */
+static uint32_t heater_jitter_us (void)
+{
+    for (task_entry_t* p_row = task_table; ; p_row++)
+    {
+        if (p_row->function == task_heater)
+        {
+            const task_timing_t& tmg = p_row->timing;
+            uint32_t worst = (tmg.jitter_max_us > tmg.jitter_peak_us)
+                             ? tmg.jitter_max_us : tmg.jitter_peak_us;
+            if (worst > results.max_jitter_us)
+            {
+                results.max_jitter_us = worst;
+            }
+            return results.max_jitter_us;
+        }
+    }
+}
+
+
+/** @brief   Task which stands in for someone changing the setpoint on the
+ *           web page.
+ *  @details While the WiFi is down, the page can't be reached and the
+ *           setpoint stays as it is.
+ *  @param   p_params Pointer to this task's entry in the task table
+ */
+void task_user (void* p_params)
+{
+    task_entry_t* p_task = (task_entry_t*)p_params;
+    const float chance = (float)SIM_USER_PERIOD_MS
+                         / (SIM_USER_CHANGE_S * 1000.0f);
+
+    for (;;)
+    {
+        heater_jitter_us ();
+        if (sim_fault_hit (SIM_FAULT_WIFI_DROP))
+        {
+            results.dropped_polls++;
+        }
+        else if (sim_random_uniform () < chance)
+        {
+            desired_temp.put ((int16_t)(25 + sim_random () % 36));
+            results.changes++;
+        }
+        task_wait_period (p_task);
+    }
+}
+
+
+/** @brief   Task which stands in for the logger, taking samples from the
+ *           log queue and adding them to the results.
+ *  @details Each member of a sample is hashed on its own, so the digest
+ *           doesn't depend on padding. Samples come through the queue at
+ *           once, so each is checked against the chamber's temperature at
+ *           the conversion it was read from.
+ *  @param   p_params Pointer to this task's entry in the task table
+ */
+void task_recorder (void* p_params)
+{
+    (void)p_params;
+    sample_t smp;
+
+    for (;;)
+    {
+        log_queue.get (smp);
+        results.samples++;
+        uint32_t gap = smp.time_ms - results.last_ms;
+        results.max_gap_ms = (gap > results.max_gap_ms) ? gap
+                                                        : results.max_gap_ms;
+        results.last_ms = smp.time_ms;
+        sim_fault_sample (fabsf (smp.temperature - sim_chamber_temperature ())
+                          < SIM_RIGHT_C);
+        results.digest = fnv1a (results.digest, &smp.time_ms,
+                                sizeof (smp.time_ms));
+        results.digest = fnv1a (results.digest, &smp.temperature,
+                                sizeof (smp.temperature));
+        results.digest = fnv1a (results.digest, &smp.setpoint,
+                                sizeof (smp.setpoint));
+        results.digest = fnv1a (results.digest, &smp.heater_on,
+                                sizeof (smp.heater_on));
+        results.min_c = (smp.temperature < results.min_c) ? smp.temperature
+                                                          : results.min_c;
+        results.max_c = (smp.temperature > results.max_c) ? smp.temperature
+                                                          : results.max_c;
+        results.sum_c += smp.temperature;
+        results.sum_error_c += smp.temperature - smp.setpoint;
+        if (p_csv != NULL)
+        {
+            fprintf (p_csv, "%lu,%.4f,%d,%u\n", (unsigned long)smp.time_ms,
+                     (double)smp.temperature, smp.setpoint, smp.heater_on);
+        }
+    }
+}
+
+
+/** @brief   Task which stands in for the web server's TCP task while it's
+ *           flooded with requests.
+ *  @details Each request comes from one of @c flood_clients addresses and
+ *           is checked by the rate limiter as the firmware's web server
+ *           does. An admitted request for @c /get changes the setpoint and
+ *           asks the journal to save it, as in @c main_enviro.cpp.
+ *  @param   p_params Pointer to this task's entry in the flood's task table
+ */
+void task_flood (void* p_params)
+{
+    task_entry_t* p_task = (task_entry_t*)p_params;
+    TaskHandle_t journal = p_task[1].handle;
+    double owed = 0.0;
+
+    for (;;)
+    {
+        owed += flood_rate * p_task->period_ms / 1000.0;
+        for ( ; owed >= 1.0; owed -= 1.0)
+        {
+            uint32_t client = SIM_FLOOD_BASE_IP
+                              + sim_random () % flood_clients;
+            uint8_t route = (sim_random () % SIM_FLOOD_GET_EVERY == 0)
+                            ? SIM_ROUTE_GET : SIM_ROUTE_INDEX;
+            results.requests++;
+            if (sim_limiter.admit (client, route, millis ()) != RATE_LIMIT_OK)
+            {
+                continue;
+            }
+            results.admitted++;
+            if (route == SIM_ROUTE_GET)
+            {
+                desired_temp.put ((int16_t)(25 + sim_random () % 36));
+                xTaskNotifyGive (journal);
+            }
+            sim_limiter.release ();
+        }
+        task_wait_period (p_task);
+    }
+}
+
+
+/** @brief   Task which stands in for the journal task, saving the setpoint
+ *           to flash when asked.
+ *  @details Writing flash stops every task while it's done, and now and then
+ *           a sector has to be erased first, which takes much longer.
+ *  @param   p_params Not used
+ */
+void task_saver (void* p_params)
+{
+    (void)p_params;
+
+    for (;;)
+    {
+        ulTaskNotifyTake (pdTRUE, portMAX_DELAY);
+        results.flash_saves++;
+        sim_stall ((results.flash_saves % SIM_FLASH_SAVES_PER_ERASE == 0)
+                   ? SIM_FLASH_ERASE_US : SIM_FLASH_SAVE_US);
+    }
+}
+
+
+/** @brief   Console command which lists the commands.
+ *  @param   printer Reference to the stream on which to print
+ *  @param   p_args The rest of the command line, which is ignored
+ */
+static void command_help (Print& printer, char* p_args)
+{
+    (void)p_args;
+    console_print_help (printer);
+}
+
+
+/** @brief   Console command which prints the shares and queues.
+ *  @param   printer Reference to the stream on which to print
+ *  @param   p_args The rest of the command line, which is ignored
+ */
+static void command_shares (Print& printer, char* p_args)
+{
+    (void)p_args;
+    print_all_shares (printer);
+}
+
+
+/** @brief   Console command which changes the setpoint.
+ *  @param   printer Reference to the stream on which to print
+ *  @param   p_args The new setpoint in degrees C
+ */
+static void command_set (Print& printer, char* p_args)
+{
+    char* p_end;
+    long setpoint = strtol (p_args, &p_end, 10);
+
+    if (p_end == p_args || *p_end != '\0' || setpoint < CONFIG_SETPOINT_MIN
+        || setpoint > CONFIG_SETPOINT_MAX)
+    {
+        printer.printf ("Usage: set <setpoint from %d to %d C>\n",
+                        CONFIG_SETPOINT_MIN, CONFIG_SETPOINT_MAX);
+        return;
+    }
+    desired_temp.put ((int16_t)setpoint);
+    printer.printf ("Setpoint is now %ld C\n", setpoint);
+}
+
+
+/** @brief   Console command which prints the temperature statistics.
+ *  @param   printer Reference to the stream on which to print
+ *  @param   p_args The rest of the command line, which is ignored
+ */
+static void command_stats (Print& printer, char* p_args)
+{
+    (void)p_args;
+    stats_print (printer);
+}
+
+
+/** @brief   Console command which prints the tasks' timing.
+ *  @param   printer Reference to the stream on which to print
+ *  @param   p_args The rest of the command line, which is ignored
+ */
+static void command_tasks (Print& printer, char* p_args)
+{
+    (void)p_args;
+    print_task_table (printer);
+}
+
+
+/** @brief   Console command which carries the simulation on for a while.
+ *  @param   printer Reference to the stream on which to print
+ *  @param   p_args The number of minutes to simulate
+ */
+static void command_run (Print& printer, char* p_args)
+{
+    char* p_end;
+    double minutes = strtod (p_args, &p_end);
+
+    if (p_end == p_args || *p_end != '\0' || minutes <= 0.0)
+    {
+        printer.println ("Usage: run <minutes>");
+        return;
+    }
+    int16_t setpoint;
+    sim_run_until (sim_now_us () + (uint64_t)(minutes * 60e6));
+    dlog_drain (printer);
+    desired_temp.get (setpoint);
+    printer.printf ("Time is %.1f h; %.2f C, setpoint %d C\n",
+                    sim_now_us () / 3600e6,
+                    (double)sim_chamber_temperature (), setpoint);
+}
+
+
+/// The commands which can be typed at the console with @c --console
+static const console_command_t console_commands[] =
+{
+//    Name      Help text                                       Handler
+    { "help",   "List the commands",                            command_help   },
+    { "shares", "Show the shares and queues with their values", command_shares },
+    { "set",    "set <C>: change the setpoint",                 command_set    },
+    { "stats",  "Show temperature and heater statistics",       command_stats  },
+    { "tasks",  "Show task timing",                             command_tasks  },
+    { "run",    "run <minutes>: carry on simulating",           command_run    },
+};
+
+
+/// The simulated tasks, which have the same periods and priorities as on
+/// the ESP32; the deferred log prints less often, as only warnings are kept.
+/// The handle, timing and stack members are filled in at run time
+task_entry_t task_table[] =
+{
+//    Function       Name      Stack Pri Core          Period (ms)         Run time
+    { task_user,     "user",   4500, 1,  NETWORK_CORE, SIM_USER_PERIOD_MS, NULL, {}, {} },
+    { task_sensor,   "sensor", 2048, 1,  CONTROL_CORE, 500,                NULL, {}, {} },
+    { task_heater,   "heater", 1000, 3,  CONTROL_CORE, 100,                NULL, {}, {} },
+    { task_recorder, "logger", 3072, 0,  NETWORK_CORE, 0,                  NULL, {}, {} },
+    { task_deferlog, "dlog",   2560, 0,  NETWORK_CORE, 1000,               NULL, {}, {} },
+};
+
+/// The tasks which are added with @c --flood; the journal's stand-in must
+/// follow the flood's, which finds its handle there
+task_entry_t flood_task_table[] =
+{
+//    Function       Name       Stack Pri Core          Period (ms)          Run time
+    { task_flood,    "flood",   4096, 3,  NETWORK_CORE, SIM_FLOOD_PERIOD_MS, NULL, {}, {} },
+    { task_saver,    "journal", 2048, 0,  NETWORK_CORE, 0,                   NULL, {}, {} },
+};
+
+
+/** @brief   Run the simulation and print what happened.
+ *  @param   argc The number of words on the command line
+ *  @param   argv The words on the command line
+ *  @return  0 if the simulation ran, 1 if the command line was wrong, or 2
+ *           if the sensor stopped or recovered for longer than allowed or
+ *           the heater's timing jitter was worse than allowed
+ */
+int main (int argc, char** argv)
+{
+    double days = 7.0;
+    uint32_t seed = 1;
+    const char* p_csv_name = NULL;
+    double max_gap_s = 0.0;
+    double max_recovery_s = 0.0;
+    double max_jitter_ms = 0.0;
+    bool console = false;
+
+    for (int index = 1; index < argc; index++)
+    {
+        if (strcmp (argv[index], "--days") == 0 && index + 1 < argc)
+        {
+            days = atof (argv[++index]);
+        }
+        else if (strcmp (argv[index], "--seed") == 0 && index + 1 < argc)
+        {
+            seed = strtoul (argv[++index], NULL, 0);
+        }
+        else if (strcmp (argv[index], "--csv") == 0 && index + 1 < argc)
+        {
+            p_csv_name = argv[++index];
+        }
+        else if (strcmp (argv[index], "--faults") == 0 && index + 1 < argc)
+        {
+            if (!sim_fault_load (argv[++index]))
+            {
+                return 1;
+            }
+        }
+        else if (strcmp (argv[index], "--fault") == 0 && index + 1 < argc
+                 && sim_fault_parse (argv[index + 1]))
+        {
+            index++;
+        }
+        else if (strcmp (argv[index], "--max-gap-s") == 0 && index + 1 < argc)
+        {
+            max_gap_s = atof (argv[++index]);
+        }
+        else if (strcmp (argv[index], "--max-recovery-s") == 0
+                 && index + 1 < argc)
+        {
+            max_recovery_s = atof (argv[++index]);
+        }
+        else if (strcmp (argv[index], "--console") == 0)
+        {
+            console = true;
+        }
+        else if (strcmp (argv[index], "--flood") == 0 && index + 1 < argc)
+        {
+            flood_rate = atof (argv[++index]);
+        }
+        else if (strcmp (argv[index], "--flood-clients") == 0
+                 && index + 1 < argc)
+        {
+            flood_clients = strtoul (argv[++index], NULL, 0);
+            flood_clients = flood_clients ? flood_clients : 1;
+        }
+        else if (strcmp (argv[index], "--max-jitter-ms") == 0
+                 && index + 1 < argc)
+        {
+            max_jitter_ms = atof (argv[++index]);
+        }
+        else
+        {
+            fprintf (stderr, "Usage: %s [--days D] [--seed S] [--csv FILE]\n"
+                     "    [--faults FILE] [--fault \"KIND START DURATION "
+                     "[CHANCE]\"]\n    [--max-gap-s S] [--max-recovery-s S] "
+                     "[--console]\n    [--flood RATE] [--flood-clients N] "
+                     "[--max-jitter-ms MS]\n",
+                     argv[0]);
+            return 1;
+        }
+    }
+    if (p_csv_name != NULL)
+    {
+        p_csv = fopen (p_csv_name, "w");
+        if (p_csv == NULL)
+        {
+            perror (p_csv_name);
+            return 1;
+        }
+        fprintf (p_csv, "time_ms,temperature,setpoint,heater_on\n");
+    }
+
+    // A small chamber in a room which warms up during the day
+    const sim_chamber_t chamber = { 20.0f, 3.0f, 1200.0f, 80.0f, 0.05f };
+
+    sim_begin (seed);
+    sim_devices_begin (chamber);
+    desired_temp.put (40);
+    results.digest = 0xCBF29CE484222325ULL;
+    results.min_c = 1e9f;
+    results.max_c = -1e9f;
+
+    Serial.printf ("Simulating %.2f days of the %s board, seed %lu\n", days,
+                   board.name, (unsigned long)seed);
+    clock_t started = clock ();
+    create_tasks (task_table, sizeof (task_table) / sizeof (task_table[0]));
+    if (flood_rate > 0.0)
+    {
+        create_tasks (flood_task_table, sizeof (flood_task_table)
+                                        / sizeof (flood_task_table[0]));
+    }
+    sim_run_until ((uint64_t)(days * 86400e6));
+    double seconds = (double)(clock () - started) / CLOCKS_PER_SEC;
+    if (console)
+    {
+        dlog_drain (Serial);
+        console_begin (console_commands, sizeof (console_commands)
+                                         / sizeof (console_commands[0]));
+        console_run_stdin (Serial);
+        Serial.println ();
+    }
+
+    uint32_t count = results.samples ? results.samples : 1;
+    Serial.printf ("Samples: %lu, digest %016llx\n",
+                   (unsigned long)results.samples,
+                   (unsigned long long)results.digest);
+    Serial.printf ("Temperature: min %.2f, mean %.2f, max %.2f C; "
+                   "mean error %.2f C\n", (double)results.min_c,
+                   results.sum_c / count, (double)results.max_c,
+                   results.sum_error_c / count);
+    Serial.printf ("Heater on %.1f%% of the time; %lu setpoint changes\n",
+                   sim_heater_on_us () * 100.0 / (sim_now_us () + 1),
+                   (unsigned long)results.changes);
+    stats_print (Serial);
+    dlog_drain (Serial);
+
+    // The sensor may have stopped for good, so the time since the last
+    // sample counts as a gap too
+    uint32_t gap = (uint32_t)(sim_now_us () / 1000) - results.last_ms;
+    double worst_gap_s = ((gap > results.max_gap_ms) ? gap
+                                                     : results.max_gap_ms)
+                         * 1e-3;
+    double worst_recovery_s = sim_fault_worst_recovery_us () * 1e-6;
+    sim_fault_print (Serial);
+    Serial.printf ("Longest gap between samples %.1f s; worst recovery "
+                   "%.1f s; %lu polls lost to WiFi drops\n", worst_gap_s,
+                   worst_recovery_s, (unsigned long)results.dropped_polls);
+
+    double worst_jitter_ms = heater_jitter_us () * 1e-3;
+    Serial.printf ("Heater's worst timing jitter %.1f ms\n", worst_jitter_ms);
+    if (flood_rate > 0.0)
+    {
+        Serial.printf ("Flood of %lu requests from %lu clients; %lu admitted, "
+                       "%lu setpoint saves\n",
+                       (unsigned long)results.requests,
+                       (unsigned long)flood_clients,
+                       (unsigned long)results.admitted,
+                       (unsigned long)results.flash_saves);
+        sim_limiter.print_status (Serial);
+    }
+
+    // The run time isn't part of the results, so it goes to stderr
+    fprintf (stderr, "%llu task switches in %.2f s\n",
+             (unsigned long long)sim_switches (), seconds);
+    if (p_csv != NULL)
+    {
+        fclose (p_csv);
+    }
+
+    bool too_slow = false;
+    if (max_gap_s > 0.0 && worst_gap_s > max_gap_s)
+    {
+        fprintf (stderr, "Gap of %.1f s is longer than %.1f s\n", worst_gap_s,
+                 max_gap_s);
+        too_slow = true;
+    }
+    if (max_recovery_s > 0.0 && worst_recovery_s > max_recovery_s)
+    {
+        fprintf (stderr, "Recovery of %.1f s is longer than %.1f s\n",
+                 worst_recovery_s, max_recovery_s);
+        too_slow = true;
+    }
+    if (max_jitter_ms > 0.0 && worst_jitter_ms > max_jitter_ms)
+    {
+        fprintf (stderr, "Heater jitter of %.1f ms is worse than %.1f ms\n",
+                 worst_jitter_ms, max_jitter_ms);
+        too_slow = true;
+    }
+    return too_slow ? 2 : 0;
+}
@@ -0,0 +1,321 @@
+/** @file    sim_rtos.cpp
+ *  @brief   Source code for the FreeRTOS and Arduino functions which the
+ *           firmware's tasks call when they run in the simulator.
+ *  @details Everything which waits turns into a call to the simulator's
+ *           @c sim_sleep_until() or @c sim_block(), and everything which
+ *           tells the time reads its virtual clock.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "FreeRTOS.h"
+#include "freertos/queue.h"
+#include "gpio.h"
+#include "sim.h"
+#ifdef SIM_THREADS
+    #include <atomic>
+#endif
+
+
+/** @brief   A list of the tasks which are waiting on a queue, in the order
+ *           in which they began to wait.
+ */
+struct sim_waiters_t
+{
+    sim_task_t* tasks[SIM_MAX_TASKS];         ///< The waiting tasks
+    uint8_t     count;                        ///< How many are waiting
+};
+
+
+/** @brief   A simulated queue.
+ */
+struct sim_queue_t
+{
+    uint8_t*      p_items;                    ///< Memory for the items
+    UBaseType_t   length;                     ///< How many items fit
+    UBaseType_t   item_size;                  ///< Bytes in each item
+    UBaseType_t   head;                       ///< Place of the front item
+    UBaseType_t   count;                      ///< Items in the queue
+    sim_waiters_t receivers;                  ///< Waiting for an item
+    sim_waiters_t senders;                    ///< Waiting for room
+};
+
+
+/// The serial port, which prints to standard output
+HardwareSerial Serial;
+
+/// The WiFi interface, which is down while a @c wifi_drop fault lasts
+WiFiClass WiFi;
+
+#ifdef SIM_THREADS
+    /// The spinlock which guards all critical sections, as one @c portMUX
+    /// would if every share used the same one
+    static std::atomic_flag critical_lock = ATOMIC_FLAG_INIT;
+#endif
+
+
+/** @brief   Turn a number of ticks to wait into a time to stop waiting.
+ *  @param   ticks The number of ticks, or @c portMAX_DELAY to wait forever
+ *  @return  The time in microseconds, or @c SIM_FOREVER
+ */
+static uint64_t deadline (TickType_t ticks)
+{
+    return (ticks == portMAX_DELAY) ? SIM_FOREVER
+                                    : sim_now_us () + ticks * 1000ULL;
+}
+
+
+/** @brief   Add the calling task to the end of a list of waiting tasks.
+ *  @param   waiters The list
+ */
+static void add_waiter (sim_waiters_t& waiters)
+{
+    waiters.tasks[waiters.count++] = sim_current_task ();
+}
+
+
+/** @brief   Take the calling task out of a list of waiting tasks.
+ *  @param   waiters The list
+ */
+static void remove_waiter (sim_waiters_t& waiters)
+{
+    sim_task_t* p_self = sim_current_task ();
+    for (uint8_t index = 0; index < waiters.count; index++)
+    {
+        if (waiters.tasks[index] == p_self)
+        {
+            memmove (&waiters.tasks[index], &waiters.tasks[index + 1],
+                     (waiters.count - index - 1) * sizeof (sim_task_t*));
+            waiters.count--;
+            return;
+        }
+    }
+}
+
+
+/** @brief   Wake the task which has waited longest in a list, if any.
+ *  @param   waiters The list
+ */
+static void wake_first (sim_waiters_t& waiters)
+{
+    if (waiters.count > 0)
+    {
+        sim_wake (waiters.tasks[0]);
+    }
+}
+
+
+BaseType_t xTaskCreatePinnedToCore (TaskFunction_t function,
+                                    const char* name, uint32_t stack_size,
+                                    void* p_param, UBaseType_t priority,
+                                    TaskHandle_t* p_handle, BaseType_t core)
+{
+    (void)stack_size;
+    (void)core;
+    TaskHandle_t task = sim_create_task (function, name, p_param, priority);
+    if (p_handle != NULL)
+    {
+        *p_handle = task;
+    }
+    return (task != NULL) ? pdPASS : pdFAIL;
+}
+
+
+void vTaskDelay (TickType_t ticks)
+{
+    sim_sleep_until (sim_now_us () + ticks * 1000ULL);
+}
+
+
+void vTaskDelayUntil (TickType_t* p_previous, TickType_t increment)
+{
+    *p_previous += increment;
+    uint64_t wake_us = *p_previous * 1000ULL;
+    if (wake_us > sim_now_us ())
+    {
+        sim_sleep_until (wake_us);
+    }
+}
+
+
+TickType_t xTaskGetTickCount (void)
+{
+    return (TickType_t)(sim_now_us () / 1000);
+}
+
+
+TaskHandle_t xTaskGetCurrentTaskHandle (void)
+{
+    return sim_current_task ();
+}
+
+
+UBaseType_t uxTaskGetStackHighWaterMark (TaskHandle_t task)
+{
+    return sim_stack_unused (task);
+}
+
+
+BaseType_t xTaskNotifyGive (TaskHandle_t task)
+{
+    sim_notify (task);
+    return pdPASS;
+}
+
+
+uint32_t ulTaskNotifyTake (BaseType_t clear, TickType_t ticks_to_wait)
+{
+    return sim_notify_take (clear != pdFALSE, deadline (ticks_to_wait));
+}
+
+
+QueueHandle_t xQueueCreateStatic (UBaseType_t length, UBaseType_t item_size,
+                                  uint8_t* p_storage,
+                                  StaticQueue_t* p_control)
+{
+    (void)p_control;
+    sim_queue_t* p_queue = (sim_queue_t*)calloc (1, sizeof (sim_queue_t));
+    p_queue->p_items = p_storage;
+    p_queue->length = length;
+    p_queue->item_size = item_size;
+    return p_queue;
+}
+
+
+QueueHandle_t xQueueCreate (UBaseType_t length, UBaseType_t item_size)
+{
+    return xQueueCreateStatic (length, item_size,
+                               (uint8_t*)malloc (length * item_size), NULL);
+}
+
+
+BaseType_t xQueueSendToBack (QueueHandle_t queue, const void* p_item,
+                             TickType_t ticks_to_wait)
+{
+    uint64_t until = deadline (ticks_to_wait);
+    while (queue->count >= queue->length)
+    {
+        if (ticks_to_wait == 0 || sim_current_task () == NULL)
+        {
+            return pdFALSE;
+        }
+        add_waiter (queue->senders);
+        bool woken = sim_block (until);
+        remove_waiter (queue->senders);
+        if (!woken && queue->count >= queue->length)
+        {
+            return pdFALSE;
+        }
+    }
+
+    UBaseType_t place = (queue->head + queue->count) % queue->length;
+    memcpy (queue->p_items + place * queue->item_size, p_item,
+            queue->item_size);
+    queue->count++;
+    wake_first (queue->receivers);
+    return pdTRUE;
+}
+
+
+BaseType_t xQueueSendToBackFromISR (QueueHandle_t queue, const void* p_item,
+                                    BaseType_t* p_woken)
+{
+    if (p_woken != NULL)
+    {
+        *p_woken = pdFALSE;
+    }
+    return xQueueSendToBack (queue, p_item, 0);
+}
+
+
+BaseType_t xQueueReceive (QueueHandle_t queue, void* p_item,
+                          TickType_t ticks_to_wait)
+{
+    uint64_t until = deadline (ticks_to_wait);
+    while (queue->count == 0)
+    {
+        if (ticks_to_wait == 0 || sim_current_task () == NULL)
+        {
+            return pdFALSE;
+        }
+        add_waiter (queue->receivers);
+        bool woken = sim_block (until);
+        remove_waiter (queue->receivers);
+        if (!woken && queue->count == 0)
+        {
+            return pdFALSE;
+        }
+    }
+
+    memcpy (p_item, queue->p_items + queue->head * queue->item_size,
+            queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    wake_first (queue->senders);
+    return pdTRUE;
+}
+
+
+UBaseType_t uxQueueMessagesWaiting (QueueHandle_t queue)
+{
+    return queue->count;
+}
+
+
+#ifdef SIM_THREADS
+    void sim_enter_critical (void)
+    {
+        while (critical_lock.test_and_set (std::memory_order_acquire))
+        {
+        }
+    }
+
+
+    void sim_exit_critical (void)
+    {
+        critical_lock.clear (std::memory_order_release);
+    }
+#endif
+
+
+unsigned long millis (void)
+{
+    return (unsigned long)(sim_now_us () / 1000);
+}
+
+
+unsigned long micros (void)
+{
+    return (unsigned long)(uint32_t)sim_now_us ();
+}
+
+
+void delay (uint32_t ms)
+{
+    vTaskDelay (ms);
+}
+
+
+void pinMode (uint8_t pin, uint8_t mode)
+{
+    gpio_sim_level[pin] = (mode == INPUT_PULLUP) ? 1 : gpio_sim_level[pin];
+}
+
+
+void digitalWrite (uint8_t pin, uint8_t level)
+{
+    gpio_sim_level[pin] = level ? 1 : 0;
+    gpio_sim_record (pin, gpio_sim_level[pin]);
+}
+
+
+int digitalRead (uint8_t pin)
+{
+    if (gpio_sim_read_hook != NULL)
+    {
+        gpio_sim_read_hook (pin);
+    }
+    return gpio_sim_level[pin];
+}
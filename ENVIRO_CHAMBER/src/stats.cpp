@@ -0,0 +1,386 @@
+/** @file    stats.cpp
+ *  @brief   Source code for sliding-window statistics of the chamber's data.
+ *  @details See @c stats.h for a description of how the statistics are kept.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <Arduino.h>
+#include <math.h>
+#include "taskshare.h"
+#include "stats.h"
+
+
+// Share which holds the newest statistics; it lives in main_enviro.cpp
+extern Share<stats_snapshot_t> chamber_stats;
+
+
+/// Statistics keepers for each channel and window; buckets are 1/60 window
+static SlidingStats channel_stats[STATS_NUM_CHANNELS][STATS_NUM_WINDOWS] =
+{
+    { SlidingStats (1000UL), SlidingStats (10000UL), SlidingStats (60000UL) },
+    { SlidingStats (1000UL), SlidingStats (10000UL), SlidingStats (60000UL) }
+};
+
+/// The snapshot is built here rather than on the sensor task's small stack
+static stats_snapshot_t snapshot;
+
+
+/** @brief   Create a statistics keeper whose buckets are a given width.
+ *  @param   width_ms The width of each time bucket in milliseconds; the
+ *           window is @c STATS_BUCKETS times this long
+ */
+SlidingStats::SlidingStats (uint32_t width_ms)
+    : bucket_ms (width_ms)
+{
+    reset ();
+}
+
+
+/** @brief   Forget all data, leaving an empty window.
+ */
+void SlidingStats::reset (void)
+{
+    memset (buckets, 0, sizeof (buckets));
+    memset (&current, 0, sizeof (current));
+    memset (&min_deque, 0, sizeof (min_deque));
+    memset (&max_deque, 0, sizeof (max_deque));
+    started = false;
+    shift = 0.0f;
+    total_count = 0;
+    sum_dev = KahanSum ();
+    sum_sq_dev = KahanSum ();
+}
+
+
+/** @brief   Add or remove a completed bucket's share of the running sums.
+ *  @details With @c d the difference between the bucket's mean and the shift
+ *           value, the bucket adds @c n*d to the sum of deviations and
+ *           @c m2+n*d*d to the sum of squared deviations.
+ *  @param   bkt The bucket to be added or removed
+ *  @param   sign 1.0 to add the bucket or -1.0 to remove it
+ */
+void SlidingStats::accumulate (const bucket_t& bkt, float sign)
+{
+    float dev = bkt.mean - shift;
+
+    sum_dev.add (sign * bkt.count * dev);
+    sum_sq_dev.add (sign * (bkt.m2 + bkt.count * dev * dev));
+    if (sign > 0.0f)
+    {
+        total_count += bkt.count;
+    }
+    else
+    {
+        total_count -= bkt.count;
+    }
+}
+
+
+/** @brief   Put a completed bucket's extreme value into a monotonic deque.
+ *  @details Entries at the back which can never again be the extreme value
+ *           of the window, because the new bucket's value is at least as
+ *           extreme and will stay in the window longer, are removed first.
+ *           The front of the deque is then always the window's extreme.
+ *  @param   deq The deque
+ *  @param   seq The number of the bucket
+ *  @param   value The bucket's minimum or maximum
+ *  @param   is_max @c true for a deque of maxima, @c false for minima
+ */
+void SlidingStats::push_extreme (extreme_deque_t& deq, uint32_t seq,
+                                 float value, bool is_max)
+{
+    while (deq.count > 0)
+    {
+        uint8_t back = (deq.head + deq.count - 1) % STATS_BUCKETS;
+        if (is_max ? (deq.value[back] > value) : (deq.value[back] < value))
+        {
+            break;
+        }
+        deq.count--;
+    }
+
+    uint8_t where = (deq.head + deq.count) % STATS_BUCKETS;
+    deq.seq[where] = seq;
+    deq.value[where] = value;
+    deq.count++;
+}
+
+
+/** @brief   Remove entries for buckets which have left the window.
+ *  @param   deq The deque
+ *  @param   oldest The number of the oldest bucket still in the window
+ */
+void SlidingStats::expire_extremes (extreme_deque_t& deq, uint32_t oldest)
+{
+    while (deq.count > 0 && deq.seq[deq.head] < oldest)
+    {
+        deq.head = (deq.head + 1) % STATS_BUCKETS;
+        deq.count--;
+    }
+}
+
+
+/** @brief   Move the window ahead so that the given bucket is the current one.
+ *  @details The current bucket is stored as a completed one, buckets which
+ *           fall out of the window are removed from the sums, and buckets
+ *           for which no data arrived are left empty. If the gap is longer
+ *           than the window, or time appears to go backwards, everything is
+ *           forgotten. Each step is constant time; the sums are recomputed
+ *           from the buckets once per trip around the window, and also when
+ *           the data has moved away from the shift.
+ *  @param   seq The number of the bucket in which the newest sample falls
+ */
+void SlidingStats::advance (uint32_t seq)
+{
+    if (seq < current.seq || seq - current.seq >= STATS_BUCKETS)
+    {
+        reset ();
+        started = true;
+        current.seq = seq;
+        return;
+    }
+
+    while (current.seq < seq)
+    {
+        // Save the current bucket, whose slot was emptied one step earlier
+        uint32_t done = current.seq;
+        buckets[done % STATS_BUCKETS] = current;
+        if (current.count > 0)
+        {
+            accumulate (current, 1.0f);
+            push_extreme (min_deque, done, current.min, false);
+            push_extreme (max_deque, done, current.max, true);
+        }
+
+        // Start a new bucket and empty the slot of the one leaving the window
+        memset (&current, 0, sizeof (current));
+        current.seq = done + 1;
+        bucket_t& leaving = buckets[current.seq % STATS_BUCKETS];
+        if (leaving.count > 0)
+        {
+            accumulate (leaving, -1.0f);
+            leaving.count = 0;
+        }
+    }
+
+    uint32_t oldest = (seq >= STATS_BUCKETS) ? seq + 1 - STATS_BUCKETS : 0;
+    expire_extremes (min_deque, oldest);
+    expire_extremes (max_deque, oldest);
+
+    // Once per trip around the ring, or whenever the data has moved further
+    // from the shift than it is spread, move the shift to the window's mean
+    // and recompute the sums from the buckets about it
+    if (seq % STATS_BUCKETS == 0 || off_centre ())
+    {
+        recentre ();
+    }
+}
+
+
+/** @brief   Find whether the window's mean is further from the shift than
+ *           the data is spread about its mean.
+ *  @details When it is, most of the sum of squared deviations is the offset
+ *           rather than the variance, and the variance is being lost to
+ *           rounding. A variance which rounding has made negative counts as
+ *           off centre too.
+ *  @return  @c true if the sums should be recomputed about a new shift
+ */
+bool SlidingStats::off_centre (void) const
+{
+    if (total_count < 2)
+    {
+        return false;
+    }
+    float offset = sum_dev.get () / total_count;
+    float spread = sum_sq_dev.get () / total_count - offset * offset;
+    return offset * offset > spread;
+}
+
+
+/** @brief   Move the shift to the mean of the window and recompute the sums.
+ *  @details Data which has moved far from the shift, as after a change of
+ *           setpoint, has deviations much larger than its spread, and single
+ *           precision sums of their squares lose the variance. The mean is
+ *           found in double precision from the bucket means, then the sums
+ *           are rebuilt from the buckets about it, which also clears away
+ *           the rounding errors of the incremental updates. The current
+ *           bucket isn't in the sums; its deviations are taken about the new
+ *           shift when the statistics are computed.
+ */
+void SlidingStats::recentre (void)
+{
+    double weighted = 0.0;
+    uint32_t count = 0;
+    for (uint8_t index = 0; index < STATS_BUCKETS; index++)
+    {
+        if (buckets[index].count > 0)
+        {
+            weighted += (double)buckets[index].count * buckets[index].mean;
+            count += buckets[index].count;
+        }
+    }
+    if (count > 0)
+    {
+        shift = (float)(weighted / count);
+    }
+
+    total_count = 0;
+    sum_dev = KahanSum ();
+    sum_sq_dev = KahanSum ();
+    for (uint8_t index = 0; index < STATS_BUCKETS; index++)
+    {
+        if (buckets[index].count > 0)
+        {
+            accumulate (buckets[index], 1.0f);
+        }
+    }
+}
+
+
+/** @brief   Add a sample taken at the given time.
+ *  @param   time_ms The time at which the sample was taken, in milliseconds
+ *  @param   value The value of the sample
+ */
+void SlidingStats::add (uint32_t time_ms, float value)
+{
+    uint32_t seq = time_ms / bucket_ms;
+
+    if (!started)
+    {
+        started = true;
+        current.seq = seq;
+    }
+    else if (seq != current.seq)
+    {
+        advance (seq);
+    }
+
+    // The first sample in an empty window sets the shift for the sums
+    if (total_count == 0 && current.count == 0)
+    {
+        shift = value;
+        sum_dev = KahanSum ();
+        sum_sq_dev = KahanSum ();
+    }
+
+    // Welford's method for the mean and squared deviations within a bucket
+    if (current.count == 0)
+    {
+        current.min = value;
+        current.max = value;
+    }
+    else
+    {
+        current.min = (value < current.min) ? value : current.min;
+        current.max = (value > current.max) ? value : current.max;
+    }
+    current.count++;
+    float delta = value - current.mean;
+    current.mean += delta / current.count;
+    current.m2 += delta * (value - current.mean);
+}
+
+
+/** @brief   Compute the statistics of the samples in the window.
+ *  @param   result Reference to a structure which receives the statistics;
+ *           if the window is empty, its count is zero and the other members
+ *           are zero as well
+ */
+void SlidingStats::get (window_stats_t& result) const
+{
+    uint32_t count = total_count + current.count;
+
+    memset (&result, 0, sizeof (result));
+    if (count == 0)
+    {
+        return;
+    }
+
+    float dev = current.mean - shift;
+    float sum = sum_dev.get () + current.count * dev;
+    float sum_sq = sum_sq_dev.get () + current.m2
+                   + current.count * dev * dev;
+
+    result.count = count;
+    result.mean = shift + sum / count;
+    if (count > 1)
+    {
+        float variance = (sum_sq - sum * sum / count) / (count - 1);
+        result.variance = (variance > 0.0f) ? variance : 0.0f;
+        result.stddev = sqrtf (result.variance);
+    }
+
+    result.min = current.min;
+    result.max = current.max;
+    if (current.count == 0)
+    {
+        result.min = min_deque.value[min_deque.head];
+        result.max = max_deque.value[max_deque.head];
+    }
+    else
+    {
+        if (min_deque.count > 0 && min_deque.value[min_deque.head] < result.min)
+        {
+            result.min = min_deque.value[min_deque.head];
+        }
+        if (max_deque.count > 0 && max_deque.value[max_deque.head] > result.max)
+        {
+            result.max = max_deque.value[max_deque.head];
+        }
+    }
+}
+
+
+/** @brief   Feed a sample into the statistics and publish a new snapshot.
+ *  @details This function is called by the sensor task each time it takes a
+ *           reading. It must only be called from one task.
+ *  @param   smp The newest sample of the chamber's condition
+ */
+void stats_add_sample (const sample_t& smp)
+{
+    float values[STATS_NUM_CHANNELS];
+    values[STATS_TEMPERATURE] = smp.temperature;
+    values[STATS_HEATER_DUTY] = smp.heater_on ? 1.0f : 0.0f;
+
+    snapshot.time_ms = smp.time_ms;
+    for (uint8_t chan = 0; chan < STATS_NUM_CHANNELS; chan++)
+    {
+        for (uint8_t win = 0; win < STATS_NUM_WINDOWS; win++)
+        {
+            channel_stats[chan][win].add (smp.time_ms, values[chan]);
+            channel_stats[chan][win].get (snapshot.stats[chan][win]);
+        }
+    }
+    chamber_stats.put (snapshot);
+}
+
+
+/** @brief   Print the newest statistics of every channel over every window.
+ *  @param   printer Reference to a serial device or stream on which to print
+ */
+void stats_print (Print& printer)
+{
+    static const char* const channel_names[STATS_NUM_CHANNELS] =
+        { "Temperature", "Heater duty" };
+    static const char* const window_names[STATS_NUM_WINDOWS] =
+        { "1 min", "10 min", "1 hour" };
+    stats_snapshot_t latest;
+
+    chamber_stats.get (latest);
+    printer.printf ("Statistics at %lu ms\n", (unsigned long)latest.time_ms);
+    printer.println ("Channel      Window  Count      Min      Max     Mean"
+                     "  Std dev");
+    for (uint8_t chan = 0; chan < STATS_NUM_CHANNELS; chan++)
+    {
+        for (uint8_t win = 0; win < STATS_NUM_WINDOWS; win++)
+        {
+            const window_stats_t& stat = latest.stats[chan][win];
+            printer.printf ("%-12s %-6s %6lu %8.2f %8.2f %8.2f %8.3f\n",
+                            channel_names[chan], window_names[win],
+                            (unsigned long)stat.count, (double)stat.min,
+                            (double)stat.max, (double)stat.mean,
+                            (double)stat.stddev);
+        }
+    }
+}
@@ -0,0 +1,195 @@
+/** @file    stats.h
+ *  @brief   Headers for sliding-window statistics of the chamber's data.
+ *  @details The sensor task feeds each sample into this module, which keeps
+ *           the minimum, maximum, mean, variance and standard deviation of
+ *           each data channel over the last minute, ten minutes and hour.
+ *           Each update takes constant time however long the window is: the
+ *           window is divided into @c STATS_BUCKETS time buckets, minima and
+ *           maxima come from monotonic deques of bucket extremes, and the
+ *           moments come from compensated running sums which are updated as
+ *           buckets enter and leave the window.
+ *
+ *           After each update a snapshot of all the statistics is put into
+ *           the share @c chamber_stats, from which any task can copy it.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#include <Arduino.h>
+#include "sample.h"
+
+
+/// Number of time buckets into which each window is divided
+#define STATS_BUCKETS 60
+
+
+/// The lengths of time over which statistics are kept
+enum stats_window_t
+{
+    STATS_1_MIN,                              ///< The last minute
+    STATS_10_MIN,                             ///< The last ten minutes
+    STATS_1_HOUR,                             ///< The last hour
+    STATS_NUM_WINDOWS                         ///< Number of windows
+};
+
+
+/// The data channels for which statistics are kept
+enum stats_channel_t
+{
+    STATS_TEMPERATURE,                        ///< Temperature in degrees C
+    STATS_HEATER_DUTY,                        ///< Heater on time, 0.0 to 1.0
+    STATS_NUM_CHANNELS                        ///< Number of channels
+};
+
+
+/** @brief   Statistics of one channel over one window of time.
+ */
+struct window_stats_t
+{
+    uint32_t count;                           ///< Number of samples in window
+    float    min;                             ///< Smallest value in window
+    float    max;                             ///< Largest value in window
+    float    mean;                            ///< Mean of values in window
+    float    variance;                        ///< Sample variance in window
+    float    stddev;                          ///< Sample standard deviation
+};
+
+
+/** @brief   Statistics of every channel over every window at one time.
+ */
+struct stats_snapshot_t
+{
+    uint32_t time_ms;                         ///< Time of the newest sample
+    window_stats_t stats[STATS_NUM_CHANNELS][STATS_NUM_WINDOWS];
+};
+
+
+/** @brief   A sum of floating point numbers with Kahan compensation.
+ *  @details Long running sums in single precision lose the low bits of small
+ *           values added to large totals. This class keeps the lost bits in
+ *           a second variable and adds them back in on later additions.
+ */
+class KahanSum
+{
+    protected:
+        float sum;                            ///< The running total
+        float compensation;                   ///< Low-order bits lost so far
+
+    public:
+        /// Create a sum which starts at zero.
+        KahanSum (void) : sum (0.0f), compensation (0.0f)
+        {
+        }
+
+        /** @brief   Add a number to the sum.
+         *  @param   value The number to be added; it may be negative
+         */
+        void add (float value)
+        {
+            float corrected = value - compensation;
+            float total = sum + corrected;
+            compensation = (total - sum) - corrected;
+            sum = total;
+        }
+
+        /// Return the value of the sum.
+        float get (void) const
+        {
+            return sum;
+        }
+};
+
+
+/** @brief   Class which keeps statistics of one channel over one window.
+ *  @details The window is @c STATS_BUCKETS buckets of @c bucket_ms each. The
+ *           bucket holding the newest sample is still filling up; it and the
+ *           @c STATS_BUCKETS - 1 buckets before it make up the window. Within
+ *           a bucket, the mean and sum of squared deviations are kept with
+ *           Welford's method. Across buckets, the sums are taken about a
+ *           shift value close to the data, which keeps single precision
+ *           arithmetic from cancelling away the variance. When the data
+ *           moves further from the shift than it is spread, and in any case
+ *           once per trip around the window, the shift is moved to the
+ *           window's mean and the sums are recomputed from the stored
+ *           buckets, so the shift follows the data and rounding errors can't
+ *           accumulate forever.
+ */
+class SlidingStats
+{
+    protected:
+        /// Summary of the samples which arrived during one bucket's time
+        struct bucket_t
+        {
+            uint32_t seq;                     ///< Bucket number; time / width
+            uint16_t count;                   ///< Samples in the bucket
+            float    min;                     ///< Smallest sample in bucket
+            float    max;                     ///< Largest sample in bucket
+            float    mean;                    ///< Mean of samples in bucket
+            float    m2;                      ///< Sum of squared deviations
+        };
+
+        /// A deque of bucket extremes whose values only rise (or only fall)
+        struct extreme_deque_t
+        {
+            uint32_t seq[STATS_BUCKETS];      ///< Bucket numbers in the deque
+            float    value[STATS_BUCKETS];    ///< Extreme values of buckets
+            uint8_t  head;                    ///< Index of the oldest entry
+            uint8_t  count;                   ///< Number of entries
+        };
+
+        uint32_t bucket_ms;                   ///< Width of a bucket in ms
+        bucket_t buckets[STATS_BUCKETS];      ///< Completed buckets by seq
+        bucket_t current;                     ///< Bucket now filling up
+        bool     started;                     ///< True once data has arrived
+        float    shift;                       ///< Value subtracted from data
+        uint32_t total_count;                 ///< Samples in complete buckets
+        KahanSum sum_dev;                     ///< Sum of (x - shift)
+        KahanSum sum_sq_dev;                  ///< Sum of (x - shift)^2
+        extreme_deque_t min_deque;            ///< Rising deque of bucket mins
+        extreme_deque_t max_deque;            ///< Falling deque of bucket maxes
+
+        // Move the window ahead so that the given bucket is the current one
+        void advance (uint32_t seq);
+
+        // Find whether the data has moved too far from the shift
+        bool off_centre (void) const;
+
+        // Move the shift to the mean of the window and recompute the sums
+        void recentre (void);
+
+        // Add or remove a completed bucket's share of the running sums
+        void accumulate (const bucket_t& bkt, float sign);
+
+        // Put a completed bucket's extreme into a monotonic deque
+        static void push_extreme (extreme_deque_t& deq, uint32_t seq,
+                                  float value, bool is_max);
+
+        // Remove entries for buckets which have left the window from a deque
+        static void expire_extremes (extreme_deque_t& deq, uint32_t oldest);
+
+    public:
+        // Create a statistics keeper whose buckets are a given width
+        SlidingStats (uint32_t width_ms);
+
+        // Forget all data
+        void reset (void);
+
+        // Add a sample taken at the given time
+        void add (uint32_t time_ms, float value);
+
+        // Compute the statistics of the samples in the window
+        void get (window_stats_t& result) const;
+};
+
+
+// Feed a sample into the statistics and publish a new snapshot
+void stats_add_sample (const sample_t& smp);
+
+// Print the newest statistics of every channel over every window
+void stats_print (Print& printer);
+
+#endif // _STATS_H_
@@ -0,0 +1,120 @@
+/** @file    storage.cpp
+ *  @brief   Source code for the file system in which this program keeps files.
+ *  @details By default the files are kept in LittleFS. Building with
+ *           @c -DSTORAGE_USE_SPIFFS keeps them in SPIFFS as before.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <Arduino.h>
+#include <PrintStream.h>
+#include <SPIFFS.h>
+#include <LittleFS.h>
+#include "fileio.h"
+#include "storage.h"
+
+
+/// Backend for the old SPIFFS file system, used to move files out of it
+static ArduinoStorage<fs::SPIFFSFS> spiffs_storage (SPIFFS, "SPIFFS");
+
+#ifdef STORAGE_USE_SPIFFS
+    /// The storage backend which the program uses for its files
+    StorageBackend& storage = spiffs_storage;
+#else
+    /// Backend for LittleFS, which the program normally uses
+    static ArduinoStorage<fs::LittleFSFS> littlefs_storage (LittleFS,
+                                                            "LittleFS");
+
+    /// The storage backend which the program uses for its files
+    StorageBackend& storage = littlefs_storage;
+#endif
+
+
+/** @brief   Move all the files in SPIFFS into the storage backend.
+ *  @details SPIFFS and LittleFS share one partition, so the files can't be
+ *           copied directly. They are read into a buffer in RAM, the
+ *           partition is formatted for the new file system, and the files are
+ *           written back. Files which don't fit in the buffer are left out.
+ *           SPIFFS has no directories, so every file is in the root.
+ *  @return  @c true if the new file system was mounted, @c false if not
+ */
+static bool migrate_from_spiffs (void)
+{
+    struct
+    {
+        char   path[32];                      ///< Full path of the file
+        size_t offset;                        ///< Where it is in the buffer
+        size_t length;                        ///< Size of the file
+    } entries[STORAGE_MIGRATE_MAX_FILES];
+    uint8_t num_files = 0;
+    size_t used = 0;
+
+    uint8_t* p_data = (uint8_t*)malloc (STORAGE_MIGRATE_MAX_BYTES);
+    if (p_data == NULL)
+    {
+        spiffs_storage.unmount ();
+        return storage.mount (true);
+    }
+
+    File root = spiffs_storage.files ().open ("/");
+    File file = root.openNextFile ();
+    while (file)
+    {
+        size_t length = file.size ();
+        if (num_files < STORAGE_MIGRATE_MAX_FILES
+            && strlen (file.path ()) < sizeof (entries[0].path)
+            && used + length <= STORAGE_MIGRATE_MAX_BYTES
+            && file.read (p_data + used, length) == length)
+        {
+            strcpy (entries[num_files].path, file.path ());
+            entries[num_files].offset = used;
+            entries[num_files].length = length;
+            num_files++;
+            used += length;
+        }
+        else
+        {
+            Serial << "Storage: can't move " << file.path () << endl;
+        }
+        file.close ();
+        file = root.openNextFile ();
+    }
+    root.close ();
+    spiffs_storage.unmount ();
+
+    bool mounted = storage.mount (true);
+    for (uint8_t index = 0; mounted && index < num_files; index++)
+    {
+        if (!write_file (storage.files (), entries[index].path,
+                         p_data + entries[index].offset,
+                         entries[index].length))
+        {
+            Serial << "Storage: can't write " << entries[index].path << endl;
+        }
+    }
+    free (p_data);
+
+    Serial << "Storage: moved " << num_files << " files from SPIFFS to "
+           << storage.name () << endl;
+    return mounted;
+}
+
+
+/** @brief   Mount the file system, moving files over from SPIFFS the first
+ *           time.
+ *  @details If the partition holds neither file system, as when a board is
+ *           new, it is formatted.
+ *  @return  @c true if the file system is ready to use, @c false if not
+ */
+bool storage_begin (void)
+{
+    if (storage.mount (false))
+    {
+        return true;
+    }
+    if (&storage != &spiffs_storage && spiffs_storage.mount (false))
+    {
+        return migrate_from_spiffs ();
+    }
+    return storage.mount (true);
+}
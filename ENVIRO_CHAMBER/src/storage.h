@@ -0,0 +1,130 @@
+/** @file    storage.h
+ *  @brief   Headers for the file system in which this program keeps files.
+ *  @details Files used to be kept in SPIFFS, which has no directories, is
+ *           slow to open and seek in large files, and can stall for a long
+ *           time collecting garbage when nearly full. Files are now kept in
+ *           LittleFS in the same partition. The rest of the program reaches
+ *           the file system through a @c StorageBackend, so that another can
+ *           be swapped in without changing it.
+ *
+ *           The first time this version starts on a board whose partition
+ *           still holds SPIFFS, the files are read into RAM, the partition
+ *           is formatted for LittleFS and the files are written back.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _STORAGE_H_
+#define _STORAGE_H_
+
+#include <Arduino.h>
+#include <FS.h>
+
+
+#ifndef STORAGE_MIGRATE_MAX_BYTES
+/// Largest total size of the files which can be moved from SPIFFS
+#define STORAGE_MIGRATE_MAX_BYTES 32768
+#endif
+
+#ifndef STORAGE_MIGRATE_MAX_FILES
+/// Largest number of files which can be moved from SPIFFS
+#define STORAGE_MIGRATE_MAX_FILES 16
+#endif
+
+
+/** @brief   Base class for a file system which can be mounted and used.
+ */
+class StorageBackend
+{
+    public:
+        // Mount the file system, formatting the partition if asked to
+        virtual bool mount (bool format_on_fail) = 0;
+
+        // Unmount the file system
+        virtual void unmount (void) = 0;
+
+        // Return the object through which files are opened
+        virtual fs::FS& files (void) = 0;
+
+        // Return the name of the file system
+        virtual const char* name (void) const = 0;
+
+        // Return the size of the file system in bytes
+        virtual size_t total_bytes (void) = 0;
+
+        // Return the number of bytes in use
+        virtual size_t used_bytes (void) = 0;
+};
+
+
+/** @brief   A storage backend for one of the Arduino core's file systems.
+ *  @details @c FsType is the class of the file system object, such as
+ *           @c fs::LittleFSFS or @c fs::SPIFFSFS. Both use the partition
+ *           labeled @c spiffs unless told otherwise.
+ */
+template <class FsType> class ArduinoStorage : public StorageBackend
+{
+    protected:
+        FsType&     file_system;              ///< The Arduino file system
+        const char* p_name;                   ///< Name for messages
+
+    public:
+        /** @brief   Create a backend for an Arduino file system object.
+         *  @param   a_file_system The file system object, such as @c LittleFS
+         *  @param   a_name The name of the file system, used in messages
+         */
+        ArduinoStorage (FsType& a_file_system, const char* a_name)
+            : file_system (a_file_system), p_name (a_name)
+        {
+        }
+
+        /** @brief   Mount the file system, formatting the partition if asked.
+         *  @param   format_on_fail @c true to format the partition if it
+         *           doesn't hold this kind of file system
+         *  @return  @c true if the file system was mounted
+         */
+        bool mount (bool format_on_fail)
+        {
+            return file_system.begin (format_on_fail);
+        }
+
+        /// Unmount the file system.
+        void unmount (void)
+        {
+            file_system.end ();
+        }
+
+        /// Return the object through which files are opened.
+        fs::FS& files (void)
+        {
+            return file_system;
+        }
+
+        /// Return the name of the file system.
+        const char* name (void) const
+        {
+            return p_name;
+        }
+
+        /// Return the size of the file system in bytes.
+        size_t total_bytes (void)
+        {
+            return file_system.totalBytes ();
+        }
+
+        /// Return the number of bytes in use.
+        size_t used_bytes (void)
+        {
+            return file_system.usedBytes ();
+        }
+};
+
+
+// The storage backend which the program uses for its files
+extern StorageBackend& storage;
+
+// Mount the file system, moving files over from SPIFFS the first time
+bool storage_begin (void);
+
+#endif // _STORAGE_H_
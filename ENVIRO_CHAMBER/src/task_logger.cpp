@@ -0,0 +1,289 @@
+/** @file    task_logger.cpp
+ *  @brief   Source code for a task which saves measurements in a log in flash.
+ *  @details The log is used by the logger task, which writes it, and by the
+ *           web server, which reads it; the two take turns by means of a
+ *           FreeRTOS mutex. A mutex is used instead of a critical section
+ *           because flash operations can take many milliseconds.
+ *
+ *           The samples' times are given by @c millis(), which restarts at
+ *           zero with each reset; they are converted to milliseconds since
+ *           1970 once the clock has been set from the network, so that the
+ *           log's times keep increasing across resets.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <Arduino.h>
+#include <PrintStream.h>
+#include <sys/time.h>
+#include "FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "taskqueue.h"
+#include "tasktable.h"
+#include "task_logger.h"
+#include "trace.h"
+
+
+// The queue of samples to be logged lives in main_enviro.cpp
+extern Queue<sample_t> log_queue;
+
+
+/// The flash partition in which the log is kept
+static FlashRegion log_flash ("tslog", 0x13E000);
+
+/// The compressed log of samples
+static TsLog data_log (log_flash);
+
+/// Mutex which lets one task at a time use @c data_log
+static SemaphoreHandle_t log_mutex = NULL;
+
+#ifdef STATIC_ALLOCATION
+    /// Memory for @c log_mutex, so that it isn't taken from the heap
+    static StaticSemaphore_t log_mutex_buffer;
+#endif
+
+/// Set @c true when the log has been found and its index rebuilt
+static bool log_ready = false;
+
+/// Number of milliseconds between checks for samples to be expired
+#define LOGGER_EXPIRE_PERIOD_MS 3600000UL
+
+/// Any time in the log after this, 2020-Jan-01, is a time of day
+#define LOGGER_CLOCK_SET_MS 1577836800000ULL
+
+/// The first line of a CSV listing of samples
+static const char CSV_HEADER[] = "time_ms,temperature,setpoint,heater\n";
+
+/// Format of each line of a CSV listing of samples
+#define CSV_FORMAT "%llu,%.2f,%d,%u\n"
+
+
+/** @brief   Wait for the log's mutex and take it.
+ *  @details The wait and the time the mutex is held can be traced.
+ */
+static void lock_log (void)
+{
+    TRACE_BEGIN (TRACE_LOCK_WAIT, TRACE_LOCK_LOG);
+    xSemaphoreTake (log_mutex, portMAX_DELAY);
+    TRACE_END (TRACE_LOCK_WAIT, TRACE_LOCK_LOG);
+    TRACE_BEGIN (TRACE_LOCK_HELD, TRACE_LOCK_LOG);
+}
+
+
+/** @brief   Give back the log's mutex.
+ */
+static void unlock_log (void)
+{
+    TRACE_END (TRACE_LOCK_HELD, TRACE_LOCK_LOG);
+    xSemaphoreGive (log_mutex);
+}
+
+
+/** @brief   Return the time now in the log's time scale, in milliseconds.
+ *  @details If the clock has been set from the network this is the time
+ *           since 1970; if not, it's the time since startup.
+ *  @return  The time in milliseconds
+ */
+uint64_t logger_time_now (void)
+{
+    struct timeval now;
+
+    gettimeofday (&now, NULL);
+
+    // Any time before 2020 means that the clock hasn't been set
+    if (now.tv_sec < (time_t)(LOGGER_CLOCK_SET_MS / 1000))
+    {
+        return millis ();
+    }
+    return (uint64_t)now.tv_sec * 1000ULL + now.tv_usec / 1000;
+}
+
+
+/** @brief   Erase the parts of the log which are older than the retention
+ *           time.
+ *  @details Nothing is erased until the clock has been set, as until then
+ *           the log's times can't be compared with the time now.
+ */
+static void expire_old_samples (void)
+{
+    uint64_t now_ms = logger_time_now ();
+    uint64_t keep_ms = LOGGER_RETENTION_DAYS * 86400000ULL;
+
+    if (keep_ms == 0 || now_ms < LOGGER_CLOCK_SET_MS + keep_ms)
+    {
+        return;
+    }
+    lock_log ();
+    data_log.expire (now_ms - keep_ms);
+    unlock_log ();
+}
+
+
+/** @brief   The task which writes samples into the log.
+ *  @details The task waits for samples to arrive in @c log_queue, so it runs
+ *           only as often as the sensor task produces them. It should have a
+ *           low priority, as writing a block to flash takes a while. About
+ *           once an hour it also erases samples older than the retention
+ *           time, @c LOGGER_RETENTION_DAYS.
+ *  @param   p_params Pointer to this task's entry in the task table
+ */
+void task_logger (void* p_params)
+{
+    (void)p_params;
+
+    #ifdef STATIC_ALLOCATION
+        log_mutex = xSemaphoreCreateMutexStatic (&log_mutex_buffer);
+    #else
+        log_mutex = xSemaphoreCreateMutex ();
+    #endif
+    log_ready = (log_mutex != NULL) && data_log.begin ();
+    if (!log_ready)
+    {
+        Serial << "Data log partition \"" << log_flash.label ()
+               << "\" not found; samples will not be logged" << endl;
+    }
+
+    sample_t smp;
+    log_record_t record;
+    uint32_t last_expire = millis () - LOGGER_EXPIRE_PERIOD_MS;
+    for (;;)
+    {
+        log_queue.get (smp);
+        if (!log_ready)
+        {
+            continue;
+        }
+
+        if (millis () - last_expire >= LOGGER_EXPIRE_PERIOD_MS)
+        {
+            last_expire = millis ();
+            expire_old_samples ();
+        }
+
+        // Work out when the sample was taken from how long it has waited
+        record.time_ms = logger_time_now () - (millis () - smp.time_ms);
+        record.temperature = smp.temperature;
+        record.setpoint = smp.setpoint;
+        record.heater_on = smp.heater_on;
+
+        TRACE_BEGIN (TRACE_LOG_APPEND, record.heater_on);
+        lock_log ();
+        data_log.append (record);
+        unlock_log ();
+        TRACE_END (TRACE_LOG_APPEND, record.heater_on);
+    }
+}
+
+
+/** @brief   Print the size and state of the log.
+ *  @param   printer Reference to a serial device or stream on which to print
+ */
+void logger_print_status (Print& printer)
+{
+    if (!log_ready)
+    {
+        printer << "Data log: not available" << endl;
+        return;
+    }
+
+    lock_log ();
+    uint32_t samples = data_log.samples ();
+    uint32_t bytes = data_log.bytes ();
+    uint16_t blocks = data_log.capacity ();
+    uint16_t used = data_log.segments_used ();
+    uint16_t expired = data_log.expired ();
+    unlock_log ();
+
+    printer.printf ("Data log: %lu samples in %lu bytes since startup, "
+                    "%.1f bits/sample, %u blocks of %u bytes\n",
+                    (unsigned long)samples, (unsigned long)bytes,
+                    samples ? 8.0 * bytes / samples : 0.0, blocks,
+                    TSLOG_BLOCK_SIZE);
+    printer.printf ("Data log: %u of %u segments in use, %u expired after "
+                    "%u days\n", used, blocks / TSLOG_SEGMENT_BLOCKS, expired,
+                    LOGGER_RETENTION_DAYS);
+}
+
+
+/** @brief   Start a CSV listing of the logged samples in a span of time.
+ *  @details The first line of the listing names the columns. If the log's
+ *           region isn't mapped, blocks are read into the stream's buffer
+ *           one at a time as the listing goes on.
+ *  @param   stream The log stream which keeps track of the listing
+ *  @param   from_ms The start of the span, in the log's time scale
+ *  @param   to_ms The end of the span, in the log's time scale
+ */
+void logger_open_csv (log_stream_t& stream, uint64_t from_ms, uint64_t to_ms)
+{
+    strcpy (stream.line, CSV_HEADER);
+    stream.line_length = strlen (CSV_HEADER);
+    stream.line_sent = 0;
+    stream.done = !log_ready;
+
+    if (!stream.done)
+    {
+        lock_log ();
+        data_log.seek (stream.cursor, from_ms, to_ms,
+                       data_log.is_mapped () ? NULL : stream.block);
+        unlock_log ();
+    }
+}
+
+
+/** @brief   Fill a buffer with the next part of a CSV listing.
+ *  @details Samples are decoded and formatted one line at a time
+ *           straight into the buffer. A line which doesn't fit is finished
+ *           in the next call. The log is locked only while this runs, so
+ *           the logger can carry on between chunks.
+ *  @param   stream The log stream which keeps track of the listing
+ *  @param   p_buffer Pointer to the buffer to be filled
+ *  @param   max_length The size of the buffer
+ *  @return  The number of bytes put in the buffer, which is 0 at the end
+ */
+size_t logger_fill_csv (log_stream_t& stream, uint8_t* p_buffer,
+                        size_t max_length)
+{
+    size_t used = 0;
+    log_record_t record;
+
+    if (!stream.done)
+    {
+        lock_log ();
+    }
+    for (;;)
+    {
+        size_t left = stream.line_length - stream.line_sent;
+        size_t piece = (left < max_length - used) ? left : max_length - used;
+        memcpy (p_buffer + used, stream.line + stream.line_sent, piece);
+        used += piece;
+        stream.line_sent += piece;
+
+        if (stream.line_sent < stream.line_length || stream.done)
+        {
+            break;
+        }
+        if (!data_log.next (stream.cursor, record))
+        {
+            stream.done = true;
+            unlock_log ();
+            stream.line_length = 0;
+            stream.line_sent = 0;
+            break;
+        }
+        stream.line_length = snprintf (stream.line, sizeof (stream.line),
+                                       CSV_FORMAT,
+                                       (unsigned long long)record.time_ms,
+                                       (double)record.temperature,
+                                       record.setpoint, record.heater_on);
+        if (stream.line_length >= sizeof (stream.line))
+        {
+            stream.line_length = sizeof (stream.line) - 1;
+        }
+        stream.line_sent = 0;
+    }
+    if (!stream.done)
+    {
+        unlock_log ();
+    }
+    return used;
+}
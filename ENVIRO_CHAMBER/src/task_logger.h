@@ -0,0 +1,65 @@
+/** @file    task_logger.h
+ *  @brief   Headers for a task which saves measurements in a log in flash.
+ *  @details The sensor task puts each sample into a queue; the logger task
+ *           takes the samples from the queue, stamps them with the time of
+ *           day and adds them to a compressed log kept in the @c tslog flash
+ *           partition. See @c tslog.h for the format of the log.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _TASK_LOGGER_H_
+#define _TASK_LOGGER_H_
+
+#include <Arduino.h>
+#include "sample.h"
+#include "tslog.h"
+
+
+#ifndef LOGGER_QUEUE_SIZE
+/// Number of samples which can wait in the queue for the logger task
+#define LOGGER_QUEUE_SIZE 32
+#endif
+
+#ifndef LOGGER_RETENTION_DAYS
+/// Samples older than this many days are erased from the log; 0 keeps all
+#define LOGGER_RETENTION_DAYS 30
+#endif
+
+
+/** @brief   The state of a CSV listing of logged samples which is sent in
+ *           chunks, such as a chunked web response.
+ *  @details Samples are decoded from flash straight into each chunk as it
+ *           is filled, so the listing takes no RAM apart from this object,
+ *           however many samples it holds. If the log's region can't be
+ *           mapped, each block is copied into @c block first.
+ */
+struct log_stream_t
+{
+    tslog_cursor_t cursor;                    ///< Place reached in the log
+    char           line[48];                  ///< Line being sent
+    uint8_t        line_length;               ///< Characters in the line
+    uint8_t        line_sent;                 ///< Characters already sent
+    bool           done;                      ///< The last line has been made
+    uint8_t        block[TSLOG_BLOCK_SIZE];   ///< Copy of a block, if needed
+};
+
+
+// The task which writes samples into the log
+void task_logger (void* p_params);
+
+// Print the size and state of the log
+void logger_print_status (Print& printer);
+
+// Start a CSV listing of the logged samples in a span of time
+void logger_open_csv (log_stream_t& stream, uint64_t from_ms, uint64_t to_ms);
+
+// Fill a buffer with the next part of a CSV listing
+size_t logger_fill_csv (log_stream_t& stream, uint8_t* p_buffer,
+                        size_t max_length);
+
+// Return the time now in the log's time scale, in milliseconds
+uint64_t logger_time_now (void);
+
+#endif // _TASK_LOGGER_H_
@@ -0,0 +1,223 @@
+/** @file    task_mqtt.cpp
+ *  @brief   Source code for a task which publishes chamber telemetry over MQTT.
+ *  @details Samples are taken from the chamber's shares every
+ *           @c MQTT_SAMPLE_MS milliseconds and put into a ring buffer. Every
+ *           @c MQTT_PUBLISH_MS milliseconds the buffered samples are sent to
+ *           the topic @c MQTT_TOPIC_BASE/samples in batches of at most
+ *           @c MQTT_BATCH_SIZE, and a status message is sent to
+ *           @c MQTT_TOPIC_BASE/status. Messages arriving on
+ *           @c MQTT_TOPIC_BASE/setpoint change the desired temperature.
+ *
+ *           When the broker can't be reached, sampling continues and the ring
+ *           buffer keeps the newest @c MQTT_BUFFER_SAMPLES samples. After a
+ *           reconnection no more than @c MQTT_DRAIN_BATCHES batches are sent
+ *           per sample period, so that catching up doesn't flood the network
+ *           stack and starve the other tasks.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <Arduino.h>
+#include <PrintStream.h>
+#include <WiFi.h>
+#include <PubSubClient.h>
+#include "taskshare.h"
+#include "ringbuffer.h"
+#include "task_mqtt.h"
+#include "tasktable.h"
+#include "configstore.h"
+#include "ctrlstate.h"
+
+
+// Shares which hold the chamber's condition; they live in main_enviro.cpp
+extern Share<int16_t> desired_temp;
+extern Share<float> therm_temp;
+extern Share<bool> heater_on;
+
+
+/// Samples waiting to be published
+static RingBuffer<sample_t, MQTT_BUFFER_SAMPLES> mqtt_ring;
+
+/// Number of messages which have been published since startup
+static uint32_t mqtt_messages_sent = 0;
+
+/// Number of payload bytes which have been published since startup
+static uint32_t mqtt_bytes_sent = 0;
+
+
+/** @brief   Handle a message which arrives on a subscribed topic.
+ *  @details The only subscribed topic is the setpoint topic. Its payload must
+ *           be a whole number of degrees C from @c CONFIG_SETPOINT_MIN to
+ *           @c CONFIG_SETPOINT_MAX; anything else is ignored. This
+ *           function is called from within @c PubSubClient::loop(), so it
+ *           runs in the MQTT task.
+ *  @param   topic The topic on which the message arrived
+ *  @param   payload The contents of the message, which are not terminated
+ *  @param   length The number of bytes in @c payload
+ */
+static void mqtt_callback (char* topic, uint8_t* payload, unsigned int length)
+{
+    (void)topic;
+
+    char text[8];
+    if (length == 0 || length >= sizeof (text))
+    {
+        return;
+    }
+    memcpy (text, payload, length);
+    text[length] = '\0';
+
+    char* p_end;
+    long value = strtol (text, &p_end, 10);
+    if (p_end == text || *p_end != '\0' || value < CONFIG_SETPOINT_MIN
+        || value > CONFIG_SETPOINT_MAX)
+    {
+        Serial << "MQTT: bad setpoint \"" << text << "\"" << endl;
+        return;
+    }
+    desired_temp.put ((int16_t)value);
+    ctrlstate_request_save ();
+}
+
+
+/** @brief   Copy the present condition of the chamber into a sample.
+ *  @param   smp Reference to the sample which is to be filled in
+ */
+static void take_sample (sample_t& smp)
+{
+    bool heater;
+
+    smp.time_ms = millis ();
+    therm_temp.get (smp.temperature);
+    desired_temp.get (smp.setpoint);
+    heater_on.get (heater);
+    smp.heater_on = heater ? 1 : 0;
+}
+
+
+/** @brief   Publish one batch of the oldest samples in the ring buffer.
+ *  @details Samples are only removed from the buffer if the broker accepted
+ *           the message, so nothing is lost when a connection drops partway
+ *           through a publication.
+ *  @param   client The MQTT client through which to publish
+ *  @return  @c true if a batch was published, @c false if not
+ */
+static bool publish_batch (PubSubClient& client)
+{
+    static char message[MQTT_PACKET_SIZE];
+    sample_t batch[MQTT_BATCH_SIZE];
+
+    uint16_t how_many = mqtt_ring.available ();
+    how_many = (how_many < MQTT_BATCH_SIZE) ? how_many : MQTT_BATCH_SIZE;
+    for (uint16_t index = 0; index < how_many; index++)
+    {
+        batch[index] = mqtt_ring.peek (index);
+    }
+
+    size_t length = mqtt_encode_batch (message, sizeof (message), batch,
+                                       how_many);
+    if (length == 0 || !client.publish (MQTT_TOPIC_BASE "/samples",
+                                        (const uint8_t*)message, length))
+    {
+        return false;
+    }
+
+    mqtt_ring.discard (how_many);
+    mqtt_messages_sent++;
+    mqtt_bytes_sent += length;
+    return true;
+}
+
+
+/** @brief   Publish a retained message describing the chamber and this task.
+ *  @param   client The MQTT client through which to publish
+ *  @param   smp The most recent sample of the chamber's condition
+ */
+static void publish_status (PubSubClient& client, const sample_t& smp)
+{
+    char message[192];
+
+    int length = snprintf (message, sizeof (message),
+        "{\"up\":%lu,\"temp\":%.2f,\"set\":%d,\"heater\":%u,\"buffered\":%u,"
+        "\"dropped\":%lu,\"msgs\":%lu,\"bytes\":%lu}",
+        (unsigned long)smp.time_ms, (double)smp.temperature, smp.setpoint,
+        smp.heater_on, mqtt_ring.available (),
+        (unsigned long)mqtt_ring.num_dropped (),
+        (unsigned long)mqtt_messages_sent, (unsigned long)mqtt_bytes_sent);
+
+    if (length > 0 && client.publish (MQTT_TOPIC_BASE "/status",
+                                      (const uint8_t*)message, length, true))
+    {
+        mqtt_messages_sent++;
+        mqtt_bytes_sent += length;
+    }
+}
+
+
+/** @brief   Task which publishes telemetry to and receives setpoints from an
+ *           MQTT broker.
+ *  @details This task runs at a fixed rate of one sample per
+ *           @c MQTT_SAMPLE_MS whether or not a network is available, and
+ *           connects to the broker once the WiFi task has joined a network.
+ *           It never blocks for longer than it takes to attempt one
+ *           connection to the broker.
+ *  @param   p_params Pointer to this task's entry in the task table
+ */
+void task_mqtt (void* p_params)
+{
+    task_entry_t* p_task = (task_entry_t*)p_params;
+
+    WiFiClient net;
+    PubSubClient client (net);
+    sample_t smp;
+
+    client.setServer (MQTT_BROKER, MQTT_PORT);
+    client.setCallback (mqtt_callback);
+    client.setBufferSize (MQTT_PACKET_SIZE);
+
+    uint32_t last_publish = millis ();
+    uint32_t last_attempt = last_publish - MQTT_RETRY_MS;
+
+    for (;;)
+    {
+        take_sample (smp);
+        mqtt_ring.put (smp);
+
+        if (client.connected ())
+        {
+            client.loop ();
+
+            // Catch up on a backlog a little at a time, or send the most
+            // recent samples when it's time for a regular publication
+            bool backlog = mqtt_ring.available () > MQTT_BATCH_SIZE;
+            if (backlog || smp.time_ms - last_publish >= MQTT_PUBLISH_MS)
+            {
+                for (uint8_t batch = 0; batch < MQTT_DRAIN_BATCHES
+                     && mqtt_ring.available (); batch++)
+                {
+                    if (!publish_batch (client))
+                    {
+                        break;
+                    }
+                }
+            }
+            if (smp.time_ms - last_publish >= MQTT_PUBLISH_MS)
+            {
+                publish_status (client, smp);
+                last_publish = smp.time_ms;
+            }
+        }
+        else if (WiFi.status () == WL_CONNECTED
+                 && smp.time_ms - last_attempt >= MQTT_RETRY_MS)
+        {
+            last_attempt = smp.time_ms;
+            if (client.connect (MQTT_CLIENT_ID))
+            {
+                client.subscribe (MQTT_TOPIC_BASE "/setpoint");
+                Serial << "MQTT connected to " << MQTT_BROKER << endl;
+            }
+        }
+
+        task_wait_period (p_task);
+    }
+}
@@ -0,0 +1,76 @@
+/** @file    task_mqtt.h
+ *  @brief   Headers for a task which publishes chamber telemetry over MQTT.
+ *  @details The MQTT task samples the chamber's shares at a fixed rate, groups
+ *           the samples into batches and publishes them to a broker. It also
+ *           subscribes to a setpoint topic so the plant's supervisory system
+ *           can change the desired temperature. While the broker can't be
+ *           reached, samples are kept in a bounded ring buffer and are sent
+ *           at a limited rate once the connection comes back.
+ *
+ *           Each of the settings below may be overridden with a @c -D flag
+ *           in the @c build_flags of @c platformio.ini.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _TASK_MQTT_H_
+#define _TASK_MQTT_H_
+
+#include <Arduino.h>
+#include "sample.h"
+
+
+#ifndef MQTT_BROKER
+/// Host name or IP address of the MQTT broker
+#define MQTT_BROKER "mqtt.local"
+#endif
+#ifndef MQTT_PORT
+/// TCP port on which the MQTT broker listens
+#define MQTT_PORT 1883
+#endif
+#ifndef MQTT_CLIENT_ID
+/// Client ID with which this chamber identifies itself to the broker
+#define MQTT_CLIENT_ID "enviro-chamber"
+#endif
+#ifndef MQTT_TOPIC_BASE
+/// Prefix of all topics used by this chamber
+#define MQTT_TOPIC_BASE "enviro/chamber1"
+#endif
+#ifndef MQTT_SAMPLE_MS
+/// Time between samples put into the telemetry buffer, in milliseconds
+#define MQTT_SAMPLE_MS 500
+#endif
+#ifndef MQTT_PUBLISH_MS
+/// Time between publications of sample batches and status, in milliseconds
+#define MQTT_PUBLISH_MS 5000
+#endif
+#ifndef MQTT_RETRY_MS
+/// Time between attempts to reconnect to the broker, in milliseconds
+#define MQTT_RETRY_MS 5000
+#endif
+#ifndef MQTT_BATCH_SIZE
+/// Largest number of samples sent in one published message
+#define MQTT_BATCH_SIZE 16
+#endif
+#ifndef MQTT_BUFFER_SAMPLES
+/// Number of samples which can be held while the broker is unreachable
+#define MQTT_BUFFER_SAMPLES 512
+#endif
+#ifndef MQTT_DRAIN_BATCHES
+/// Largest number of batches sent per sample period when catching up
+#define MQTT_DRAIN_BATCHES 2
+#endif
+
+/// Size of the buffer which holds one encoded MQTT message, in bytes
+#define MQTT_PACKET_SIZE (64 + 40 * MQTT_BATCH_SIZE)
+
+
+// Encode a batch of samples as a JSON message
+size_t mqtt_encode_batch (char* buffer, size_t size, const sample_t* p_samples,
+                          uint16_t how_many);
+
+// Task which publishes telemetry to and receives setpoints from a broker
+void task_mqtt (void* p_params);
+
+#endif // _TASK_MQTT_H_
@@ -0,0 +1,178 @@
+/** @file    taskqueue.h
+ *  @brief   Queues which carry streams of data between tasks.
+ *  @details This file contains a template class for queues which pass items
+ *           of data from one task to another in a thread-safe manner. Where a
+ *           @c Share holds only the most recent value of something, a queue
+ *           holds every item until the receiving task takes it, so it is
+ *           used when each item matters, such as samples which are to be
+ *           logged. The queue is a thin wrapper around a FreeRTOS queue which
+ *           makes it type-safe and puts it in the list of shared data items
+ *           printed by @c print_all_shares().
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _TASKQUEUE_H_
+#define _TASKQUEUE_H_
+
+#include <PrintStream.h>                    // For "<<" printing in lists
+#include "baseshare.h"                      // Base class for shared data items
+#include "FreeRTOS.h"                       // Main header for FreeRTOS
+#include "freertos/queue.h"                 // Header for FreeRTOS queues
+
+
+/** @brief   Class for a queue which carries data items between tasks.
+ *  @details The sending task calls @c put() and the receiving task calls
+ *           @c get(). If the queue is full, @c put() waits for at most the
+ *           given number of ticks and then gives up, counting the item as
+ *           lost, so a slow receiver can't stall an important sender.
+ *
+ *           @section usage_queue Usage
+ *           In the file which contains @c setup():
+ *           @code{.cpp}
+ *           #include "taskqueue.h"
+ *           ...
+ *           /// Samples waiting to be written to the data log
+ *           Queue<sample_t> log_queue (32, "Log Queue");
+ *           @endcode
+ *           In the sending task:
+ *           @code
+ *           log_queue.put (a_sample);
+ *           @endcode
+ *           In the receiving task, which waits until an item arrives:
+ *           @code
+ *           sample_t got_sample;
+ *           log_queue.get (got_sample);
+ *           @endcode
+ */
+template <class DataType> class Queue : public BaseShare
+{
+    protected:
+        QueueHandle_t handle;                 ///< Handle of the FreeRTOS queue
+        uint16_t      buf_size;               ///< Most items the queue holds
+        uint16_t      max_full;               ///< Most items ever waiting
+        uint32_t      num_lost;               ///< Items which didn't fit
+
+    public:
+        /** @brief   Construct a queue.
+         *  @details The FreeRTOS queue is created on the heap when the queue
+         *           object is constructed. If the heap is exhausted, the
+         *           handle is @c NULL and all puts fail.
+         *  @param   queue_size The number of items which the queue can hold
+         *  @param   p_name A name to be shown in the list of task shares
+         *           (default @c NULL)
+         */
+        Queue<DataType> (uint16_t queue_size, const char* p_name = NULL)
+            : BaseShare (p_name), buf_size (queue_size), max_full (0),
+              num_lost (0)
+        {
+            handle = xQueueCreate (queue_size, sizeof (DataType));
+        }
+
+        /** @brief   Construct a queue which keeps its items in memory given
+         *           by the caller.
+         *  @details Nothing is taken from the heap, so this is used when the
+         *           program is built with @c STATIC_ALLOCATION. The memory
+         *           must exist for as long as the queue does.
+         *  @param   queue_size The number of items which the queue can hold
+         *  @param   p_storage Pointer to an array of at least
+         *           @c queue_size times @c sizeof(DataType) bytes
+         *  @param   p_control Pointer to the FreeRTOS queue's control block
+         *  @param   p_name A name to be shown in the list of task shares
+         *           (default @c NULL)
+         */
+        Queue<DataType> (uint16_t queue_size, uint8_t* p_storage,
+                         StaticQueue_t* p_control, const char* p_name = NULL)
+            : BaseShare (p_name), buf_size (queue_size), max_full (0),
+              num_lost (0)
+        {
+            handle = xQueueCreateStatic (queue_size, sizeof (DataType),
+                                         p_storage, p_control);
+        }
+
+        /** @brief   Put an item into the queue.
+         *  @param   item The item to be copied into the queue
+         *  @param   ticks_to_wait How long to wait if the queue is full
+         *           (default 0, which means don't wait)
+         *  @return  @c true if the item was queued, @c false if it was lost
+         */
+        bool put (const DataType& item, TickType_t ticks_to_wait = 0)
+        {
+            if (handle == NULL
+                || xQueueSendToBack (handle, &item, ticks_to_wait) != pdTRUE)
+            {
+                num_lost++;
+                return false;
+            }
+            uint16_t waiting = uxQueueMessagesWaiting (handle);
+            max_full = (waiting > max_full) ? waiting : max_full;
+            return true;
+        }
+
+        /** @brief   Put an item into the queue from within an ISR.
+         *  @param   item The item to be copied into the queue
+         *  @return  @c true if the item was queued, @c false if it was lost
+         */
+        bool ISR_put (const DataType& item)
+        {
+            BaseType_t woken = pdFALSE;
+            if (handle == NULL
+                || xQueueSendToBackFromISR (handle, &item, &woken) != pdTRUE)
+            {
+                num_lost++;
+                return false;
+            }
+            if (woken == pdTRUE)
+            {
+                portYIELD_FROM_ISR ();
+            }
+            return true;
+        }
+
+        /** @brief   Take the oldest item from the queue.
+         *  @param   item Reference to a variable which receives the item
+         *  @param   ticks_to_wait How long to wait for an item to arrive
+         *           (default @c portMAX_DELAY, which means wait forever)
+         *  @return  @c true if an item was received, @c false if none came
+         */
+        bool get (DataType& item, TickType_t ticks_to_wait = portMAX_DELAY)
+        {
+            return handle != NULL
+                   && xQueueReceive (handle, &item, ticks_to_wait) == pdTRUE;
+        }
+
+        /// Return the number of items waiting in the queue.
+        uint16_t available (void)
+        {
+            return handle ? uxQueueMessagesWaiting (handle) : 0;
+        }
+
+        /// Return the number of items which were lost because of a full queue.
+        uint32_t lost (void)
+        {
+            return num_lost;
+        }
+
+        /** @brief   Print the queue's name, type and fill statistics.
+         *  @details After printing this queue's information, the next item in
+         *           the linked list of shares is asked to print its own.
+         *  @param   printer Reference to a serial device on which to print
+         */
+        void print_in_list (Print& printer)
+        {
+            printer.printf ("%-16squeue\t%u/%u", name, max_full, buf_size);
+            if (num_lost)
+            {
+                printer.printf (" (%lu lost)", (unsigned long)num_lost);
+            }
+            printer << endl;
+
+            if (p_next != NULL)
+            {
+                p_next->print_in_list (printer);
+            }
+        }
+};
+
+#endif  // _TASKQUEUE_H_
@@ -34,6 +34,7 @@
 #ifndef _TASKSHARE_H_
 #define _TASKSHARE_H_
 
+#include <PrintStream.h>                    // For "<<" printing in lists
 #include "baseshare.h"                      // Base class for shared data items
 #include "FreeRTOS.h"                       // Main header for FreeRTOS
 
@@ -0,0 +1,301 @@
+/** @file    tasktable.cpp
+ *  @brief   Source code for a table-driven way to create and time the tasks.
+ *  @details See @c tasktable.h for a description of the task table. Jitter is
+ *           measured as the difference between a task's period and the time
+ *           which actually passed between two of its wakeups; CPU share is
+ *           the fraction of each window which the task spent between waking
+ *           up and calling @c task_wait_period() again. Time spent preempted
+ *           by higher priority tasks is counted as the task's own, so the
+ *           CPU share is an upper bound.
+ *
+ *           On the ESP32 stack sizes and high water marks are in bytes, not
+ *           in words as in other ports of FreeRTOS.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <Arduino.h>
+#include "tasktable.h"
+#include "trace.h"
+
+
+/// Pointer to the table of tasks which was used to create the tasks
+static task_entry_t* p_task_table = NULL;
+
+/// Number of tasks in the task table
+static uint8_t task_table_size = 0;
+
+#ifdef STATIC_ALLOCATION
+    /// Memory from which the tasks' stacks are taken, aligned as the
+    /// Xtensa processor's stack pointer must be
+    static StackType_t stack_arena[TASK_STACK_ARENA_BYTES
+                                   / sizeof (StackType_t)]
+        __attribute__ ((aligned (16)));
+
+    /// The tasks' control blocks
+    static StaticTask_t task_blocks[TASK_TABLE_MAX];
+#endif
+
+
+/** @brief   Create all the tasks described in a table.
+ *  @details Each task is created with @c xTaskCreatePinnedToCore() and given
+ *           a pointer to its own row of the table as its parameter. The table
+ *           must exist for as long as the program runs, so it should be a
+ *           global or @c static array. If @c STATIC_ALLOCATION is defined,
+ *           @c xTaskCreateStaticPinnedToCore() is used instead, with each
+ *           stack rounded up to 16 bytes and taken from an arena of
+ *           @c TASK_STACK_ARENA_BYTES; a task which doesn't fit isn't
+ *           created.
+ *  @param   p_table Pointer to an array of task descriptions
+ *  @param   num_tasks The number of tasks in the array
+ *  @return  @c true if all the tasks were created, @c false if any failed
+ */
+bool create_tasks (task_entry_t* p_table, uint8_t num_tasks)
+{
+    bool all_ok = true;
+    #ifdef STATIC_ALLOCATION
+        uint32_t arena_used = 0;
+    #endif
+
+    p_task_table = p_table;
+    task_table_size = num_tasks;
+
+    for (uint8_t index = 0; index < num_tasks; index++)
+    {
+        task_entry_t& task = p_table[index];
+
+        memset (&task.timing, 0, sizeof (task.timing));
+        memset (&task.stack, 0, sizeof (task.stack));
+        #ifdef STATIC_ALLOCATION
+            uint32_t bytes = (task.stack_size + 15) & ~15UL;
+            task.handle = NULL;
+            if (index < TASK_TABLE_MAX
+                && arena_used + bytes <= TASK_STACK_ARENA_BYTES)
+            {
+                task.handle = xTaskCreateStaticPinnedToCore (
+                    task.function, task.name, task.stack_size, &task,
+                    task.priority, stack_arena + arena_used
+                                   / sizeof (StackType_t),
+                    &task_blocks[index], task.core);
+            }
+            arena_used += bytes;
+            if (task.handle == NULL)
+            {
+                Serial.printf ("Cannot create task %s; static stacks need "
+                               "%lu of %u bytes\n", task.name,
+                               (unsigned long)arena_used,
+                               TASK_STACK_ARENA_BYTES);
+                all_ok = false;
+            }
+        #else
+            if (xTaskCreatePinnedToCore (task.function, task.name,
+                                         task.stack_size, &task,
+                                         task.priority, &task.handle,
+                                         task.core) != pdPASS)
+            {
+                Serial.printf ("Cannot create task %s\n", task.name);
+                task.handle = NULL;
+                all_ok = false;
+            }
+        #endif
+    }
+    return all_ok;
+}
+
+
+/** @brief   Delay a task until its next period, measuring its CPU use and
+ *           jitter.
+ *  @details This function is called at the end of each run through a
+ *           periodic task's loop instead of @c vTaskDelay(). It uses
+ *           @c vTaskDelayUntil() so that the period does not drift with the
+ *           time the task takes to run.
+ *  @param   p_task Pointer to the calling task's row in the task table, which
+ *           was given to the task as its parameter
+ */
+void task_wait_period (task_entry_t* p_task)
+{
+    task_timing_t& tmg = p_task->timing;
+    uint32_t now = micros ();
+
+    // The first call only starts the clocks
+    if (!tmg.started)
+    {
+        tmg.started = true;
+        tmg.wake_tick = xTaskGetTickCount ();
+        tmg.wake_us = now;
+        tmg.window_us = now;
+    }
+    tmg.busy_us += now - tmg.wake_us;
+    tmg.run_us += now - tmg.wake_us;
+
+    // Where this function's frame is shows how deep the task's stack is
+    // while it waits, without looking into its control block
+    p_task->stack.p_waiting = (const uint8_t*)__builtin_frame_address (0);
+
+    TRACE_END (TRACE_TASK_RUN, tmg.wakeups);
+    vTaskDelayUntil (&tmg.wake_tick, pdMS_TO_TICKS (p_task->period_ms));
+    TRACE_BEGIN (TRACE_TASK_RUN, tmg.wakeups + 1);
+
+    // Jitter is how far the time between wakeups differs from the period
+    now = micros ();
+    int32_t error = (int32_t)(now - tmg.wake_us)
+                    - (int32_t)(p_task->period_ms * 1000UL);
+    uint32_t jitter = (error < 0) ? -error : error;
+    tmg.jitter_sum_us += jitter;
+    tmg.jitter_peak_us = (jitter > tmg.jitter_peak_us) ? jitter
+                                                       : tmg.jitter_peak_us;
+    tmg.wake_us = now;
+    tmg.runs++;
+    tmg.wakeups++;
+
+    // At the end of each window, save the results and start over
+    uint32_t elapsed = now - tmg.window_us;
+    if (elapsed >= TASK_STATS_WINDOW_MS * 1000UL)
+    {
+        tmg.cpu_permille = (uint16_t)((uint64_t)tmg.busy_us * 1000 / elapsed);
+        tmg.jitter_avg_us = tmg.jitter_sum_us / tmg.runs;
+        tmg.jitter_max_us = tmg.jitter_peak_us;
+        tmg.window_us = now;
+        tmg.busy_us = 0;
+        tmg.jitter_sum_us = 0;
+        tmg.jitter_peak_us = 0;
+        tmg.runs = 0;
+    }
+}
+
+
+/** @brief   Find a task's row in the task table from its handle.
+ *  @param   handle The task's handle
+ *  @return  A pointer to the task's row, or @c NULL if it isn't in the table
+ */
+const task_entry_t* find_task (TaskHandle_t handle)
+{
+    for (uint8_t index = 0; index < task_table_size; index++)
+    {
+        if (p_task_table[index].handle == handle)
+        {
+            return &p_task_table[index];
+        }
+    }
+    return NULL;
+}
+
+
+/** @brief   Find a row of the task table from its place in the table.
+ *  @param   index The place of the row, starting from 0
+ *  @return  A pointer to the row, or @c NULL if the table has no such row
+ */
+const task_entry_t* task_at (uint8_t index)
+{
+    return (index < task_table_size) ? &p_task_table[index] : NULL;
+}
+
+
+/** @brief   Print a table showing each task's placement and measured timing.
+ *  @details The CPU share and jitter shown are those measured during the most
+ *           recently completed window of @c TASK_STATS_WINDOW_MS.
+ *  @param   printer Reference to a serial device or other stream on which to
+ *           print the table
+ */
+void print_task_table (Print& printer)
+{
+    printer.println ("Task        Core Pri Period  CPU %  Jitter avg/max (us)"
+                     "  Stack  Free now/min");
+    printer.println ("----        ---- --- ------  -----  -------------------"
+                     "  -----  ------------");
+
+    for (uint8_t index = 0; index < task_table_size; index++)
+    {
+        const task_entry_t& task = p_task_table[index];
+
+        printer.printf ("%-12s%4d%4u%7lu%5u.%u  %8lu/%-8lu  %5lu  %5lu/%-5lu\n",
+                        task.name, (int)task.core, (unsigned)task.priority,
+                        (unsigned long)task.period_ms,
+                        task.timing.cpu_permille / 10,
+                        task.timing.cpu_permille % 10,
+                        (unsigned long)task.timing.jitter_avg_us,
+                        (unsigned long)task.timing.jitter_max_us,
+                        (unsigned long)task.stack_size,
+                        (unsigned long)task.stack.free_now,
+                        (unsigned long)task.stack.free_min);
+    }
+}
+
+
+/** @brief   Measure the free space in every task's stack, warning if it's
+ *           low.
+ *  @details A warning is printed once for each task whose worst case free
+ *           space falls below @c STACK_WARN_BYTES.
+ */
+void check_task_stacks (void)
+{
+    for (uint8_t index = 0; index < task_table_size; index++)
+    {
+        task_entry_t& task = p_task_table[index];
+        task_stack_t& stk = task.stack;
+        if (task.handle == NULL)
+        {
+            continue;
+        }
+
+        stk.free_min = uxTaskGetStackHighWaterMark (task.handle);
+        stk.free_now = stk.free_min;
+        #ifdef ESP32
+            // The stack grows down towards its start from where the task was
+            // when it last waited for its next period
+            const uint8_t* p_start = pxTaskGetStackStart (task.handle);
+            const uint8_t* p_top = stk.p_waiting;
+            if (p_top > p_start && p_top < p_start + task.stack_size)
+            {
+                stk.free_now = p_top - p_start;
+            }
+        #endif
+
+        if (stk.free_min < STACK_WARN_BYTES && !stk.warned)
+        {
+            Serial.printf ("Warning: task %s has used %lu of %lu bytes of "
+                           "stack\n", task.name,
+                           (unsigned long)(task.stack_size - stk.free_min),
+                           (unsigned long)task.stack_size);
+            stk.warned = true;
+        }
+    }
+}
+
+
+/** @brief   Print stack sizes which would fit each task's measured use.
+ *  @details The suggestion is the most stack the task has used, plus a
+ *           quarter and @c STACK_SUGGEST_MARGIN bytes, rounded up to a
+ *           multiple of 256 bytes. The measurements only cover what the task
+ *           has done since startup, so suggestions should be taken after the
+ *           program has run through everything it does, such as reconnecting
+ *           to WiFi and serving each web page.
+ *  @param   printer Reference to a serial device or other stream on which to
+ *           print the suggestions
+ */
+void print_stack_suggestions (Print& printer)
+{
+    int32_t total = 0;
+
+    printer.println ("Task        Stack   Used  Suggest");
+    printer.println ("----        -----   ----  -------");
+
+    for (uint8_t index = 0; index < task_table_size; index++)
+    {
+        const task_entry_t& task = p_task_table[index];
+        if (task.handle == NULL)
+        {
+            continue;
+        }
+
+        uint32_t used = task.stack_size - task.stack.free_min;
+        uint32_t suggest = (used + used / 4 + STACK_SUGGEST_MARGIN + 255)
+                           & ~255UL;
+        total += (int32_t)task.stack_size - (int32_t)suggest;
+        printer.printf ("%-12s%5lu  %5lu  %7lu\n", task.name,
+                        (unsigned long)task.stack_size, (unsigned long)used,
+                        (unsigned long)suggest);
+    }
+    printer.printf ("Bytes which the suggestions would free: %ld\n",
+                    (long)total);
+}
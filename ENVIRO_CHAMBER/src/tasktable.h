@@ -0,0 +1,150 @@
+/** @file    tasktable.h
+ *  @brief   Headers for a table-driven way to create and time the tasks.
+ *  @details Rather than calling @c xTaskCreate() once per task with numbers
+ *           scattered through @c setup(), the program describes each task in
+ *           one row of a table: its name, function, stack size, priority, the
+ *           CPU core on which it must run and the period at which it runs.
+ *           The tasks are then all created from the table, each pinned to its
+ *           core, and each one measures its own CPU share and timing jitter
+ *           as it waits for its next period. A low priority monitor task
+ *           samples how much of each task's stack has never been used and
+ *           warns when the headroom runs low.
+ *
+ *           If @c STATIC_ALLOCATION is defined, the tasks' stacks and control
+ *           blocks are taken from arrays which are set aside when the
+ *           program is built rather than from the heap.
+ *
+ *           On the ESP32 the WiFi stack and the web server's TCP task live on
+ *           core 0, so network tasks belong there while the sensing and
+ *           control tasks are pinned to core 1, out of the way of network
+ *           traffic.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _TASKTABLE_H_
+#define _TASKTABLE_H_
+
+#include <Arduino.h>
+#include "FreeRTOS.h"
+
+
+/// Core on which the WiFi stack and network tasks run
+#define NETWORK_CORE 0
+
+/// Core on which the sensing and control tasks run
+#define CONTROL_CORE 1
+
+/// Time over which each task's CPU share and jitter are measured, in ms
+#define TASK_STATS_WINDOW_MS 10000
+
+#ifndef STACK_CHECK_MS
+/// Time between checks of the tasks' stacks, in milliseconds
+#define STACK_CHECK_MS 1000
+#endif
+
+#ifndef STACK_WARN_BYTES
+/// A warning is printed when a task's stack has less than this many bytes
+/// which have never been used
+#define STACK_WARN_BYTES 256
+#endif
+
+#ifndef TASK_TABLE_MAX
+/// Largest number of tasks which can be created when they're static
+#define TASK_TABLE_MAX 10
+#endif
+
+#ifndef TASK_STACK_ARENA_BYTES
+/// Bytes set aside for all the tasks' stacks together when they're static
+#define TASK_STACK_ARENA_BYTES 26624
+#endif
+
+/// Bytes added to the measured stack use, beyond a quarter more, when a
+/// stack size is suggested
+#define STACK_SUGGEST_MARGIN 256
+
+
+/** @brief   Timing measurements which a periodic task makes of itself.
+ *  @details The measurements are accumulated over a window of
+ *           @c TASK_STATS_WINDOW_MS milliseconds, then copied into the
+ *           @c cpu_permille, @c jitter_avg_us and @c jitter_max_us results
+ *           so that they can be printed while the next window is measured.
+ */
+struct task_timing_t
+{
+    bool       started;                       ///< True once task first waits
+    TickType_t wake_tick;                     ///< Tick at which to wake next
+    uint32_t   wake_us;                       ///< Time of most recent wakeup
+    uint32_t   window_us;                     ///< Start of measuring window
+    uint32_t   busy_us;                       ///< Time spent running in window
+    uint32_t   jitter_sum_us;                 ///< Sum of jitter in window
+    uint32_t   jitter_peak_us;                ///< Worst jitter in window
+    uint32_t   runs;                          ///< Periods run in window
+    uint16_t   cpu_permille;                  ///< CPU share, last window, 0.1%
+    uint32_t   jitter_avg_us;                 ///< Mean jitter, last window
+    uint32_t   jitter_max_us;                 ///< Worst jitter, last window
+    uint32_t   wakeups;                       ///< Periods run since startup
+    uint64_t   run_us;                        ///< Time run since startup
+};
+
+
+/** @brief   Measurements of the space left in a task's stack.
+ *  @details The worst case comes from FreeRTOS's high water mark, the
+ *           least free space there has been since the task started. The
+ *           space free now is found from where the task's stack was when it
+ *           last waited in @c task_wait_period(); it shows how much of the
+ *           worst case is due to rare deep calls. Tasks which don't call
+ *           that function show only the worst case.
+ */
+struct task_stack_t
+{
+    const uint8_t* p_waiting;                 ///< Stack frame where it waited
+    uint32_t free_now;                        ///< Bytes free at last check
+    uint32_t free_min;                        ///< Fewest bytes ever free
+    bool     warned;                          ///< A warning has been printed
+};
+
+
+/** @brief   One row in the table which describes the program's tasks.
+ *  @details The first six members are filled in by the programmer; the task
+ *           handle and timing measurements are filled in at run time. A
+ *           pointer to its row is given to each task as its parameter, so
+ *           the task can call @c task_wait_period() with it.
+ */
+struct task_entry_t
+{
+    TaskFunction_t function;                  ///< Function which runs task
+    const char*    name;                      ///< Name, shown on printouts
+    uint32_t       stack_size;                ///< Stack size in bytes
+    UBaseType_t    priority;                  ///< Priority; larger is higher
+    BaseType_t     core;                      ///< Core to which task is pinned
+    uint32_t       period_ms;                 ///< Period, or 0 if not periodic
+    TaskHandle_t   handle;                    ///< Handle, set when created
+    task_timing_t  timing;                    ///< Measured CPU use and jitter
+    task_stack_t   stack;                     ///< Measured stack headroom
+};
+
+
+// Create all the tasks described in a table
+bool create_tasks (task_entry_t* p_table, uint8_t num_tasks);
+
+// Delay a task until its next period, measuring its CPU use and jitter
+void task_wait_period (task_entry_t* p_task);
+
+// Find a task's row in the task table from its handle
+const task_entry_t* find_task (TaskHandle_t handle);
+
+// Find a row of the task table from its place in the table
+const task_entry_t* task_at (uint8_t index);
+
+// Print a table showing each task's placement and measured timing
+void print_task_table (Print& printer);
+
+// Measure the free space in every task's stack, warning if it's low
+void check_task_stacks (void);
+
+// Print stack sizes which would fit each task's measured use
+void print_stack_suggestions (Print& printer);
+
+#endif // _TASKTABLE_H_
@@ -0,0 +1,146 @@
+/** @file    telemetry.cpp
+ *  @brief   Source code for a task which streams samples over the serial port
+ *           in binary.
+ *  @details The record is taken from the shares which the sensor and heater
+ *           tasks keep up to date, so the telemetry task adds no work to the
+ *           control loop; it only copies values which are already there.
+ *           The sensor is read twice a second, so faster records show the
+ *           same temperature until the next reading, but the heater's state
+ *           and the setpoint follow the heater task's 100 ms period.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <Arduino.h>
+#include "taskshare.h"
+#include "tasktable.h"
+#include "crc.h"
+#include "telemetry.h"
+
+
+// The shares which hold the chamber's state live in main_enviro.cpp
+extern Share<int16_t> desired_temp;
+extern Share<float> therm_temp;
+extern Share<bool> heater_on;
+
+
+/// Records are only sent while this is @c true
+static volatile bool sending = true;
+
+
+/** @brief   Encode a block of bytes with COBS so that it has no zero bytes.
+ *  @details Each zero is replaced by the distance to the next zero, and a
+ *           distance byte is put at the start; a run of 254 bytes with no
+ *           zero gets a distance byte of 255 and no zero. The output is at
+ *           most one byte longer than the input for blocks of up to 254
+ *           bytes.
+ *  @param   p_in Pointer to the bytes to be encoded
+ *  @param   length The number of bytes to be encoded
+ *  @param   p_out Pointer to a buffer with room for @c length + 1 bytes, plus
+ *           one more for each further 254 bytes
+ *  @return  The number of bytes put in @c p_out
+ */
+size_t cobs_encode (const uint8_t* p_in, size_t length, uint8_t* p_out)
+{
+    size_t code_place = 0;
+    size_t used = 1;
+    uint8_t code = 1;
+
+    for (size_t index = 0; index < length; index++)
+    {
+        if (p_in[index] == 0)
+        {
+            p_out[code_place] = code;
+            code_place = used++;
+            code = 1;
+            continue;
+        }
+        p_out[used++] = p_in[index];
+        if (++code == 0xFF)
+        {
+            p_out[code_place] = code;
+            code_place = used++;
+            code = 1;
+        }
+    }
+    p_out[code_place] = code;
+    return used;
+}
+
+
+/** @brief   Make a frame, ready to be sent, from a record.
+ *  @details The record's CRC-32 is put after it and the two are encoded with
+ *           COBS between zero delimiters. The ESP32 is little endian, so the
+ *           record goes as it is.
+ *  @param   record The record to be sent
+ *  @param   p_frame Pointer to a buffer of @c TELEMETRY_MAX_FRAME bytes
+ *  @return  The number of bytes put in @c p_frame
+ */
+size_t telemetry_frame (const telemetry_record_t& record, uint8_t* p_frame)
+{
+    uint8_t payload[sizeof (telemetry_record_t) + 4];
+
+    uint32_t crc = crc32 (&record, sizeof (record));
+    memcpy (payload, &record, sizeof (record));
+    memcpy (payload + sizeof (record), &crc, sizeof (crc));
+
+    size_t length = 0;
+    p_frame[length++] = 0;
+    length += cobs_encode (payload, sizeof (payload), p_frame + length);
+    p_frame[length++] = 0;
+    return length;
+}
+
+
+/** @brief   Start or stop sending records.
+ *  @details Records are sent from startup when telemetry is built in.
+ *  @param   on @c true to send records, @c false to stop
+ */
+void telemetry_enable (bool on)
+{
+    sending = on;
+}
+
+
+/** @brief   The task which sends records over the serial port.
+ *  @details Each period a record is built from the shares, framed and put
+ *           in the UART driver's transmit buffer if there's room for all of
+ *           it. This task should run on the network core at a low priority.
+ *  @param   p_params Pointer to this task's entry in the task table
+ */
+void task_telemetry (void* p_params)
+{
+    task_entry_t* p_task = (task_entry_t*)p_params;
+    telemetry_record_t record;
+    uint8_t frame[TELEMETRY_MAX_FRAME];
+    uint16_t sequence = 0;
+    uint32_t dropped = 0;
+
+    for (;;)
+    {
+        if (sending)
+        {
+            bool heater;
+            record.type = TELEMETRY_SAMPLE;
+            record.sequence = sequence++;
+            record.time_us = micros ();
+            therm_temp.get (record.temperature);
+            desired_temp.get (record.setpoint);
+            heater_on.get (heater);
+            record.heater_on = heater ? 1 : 0;
+            record.dropped = (dropped < 0xFFFF) ? dropped : 0xFFFF;
+
+            size_t length = telemetry_frame (record, frame);
+
+            if ((size_t)Serial.availableForWrite () >= length)
+            {
+                Serial.write (frame, length);
+            }
+            else
+            {
+                dropped++;
+            }
+        }
+        task_wait_period (p_task);
+    }
+}
@@ -0,0 +1,85 @@
+/** @file    telemetry.h
+ *  @brief   Headers for a task which streams samples over the serial port in
+ *           binary.
+ *  @details Text output at 115200 baud manages a few samples per second. When
+ *           built with @c -DTELEMETRY_ENABLED, the serial port runs at
+ *           @c TELEMETRY_BAUD and the telemetry task sends a binary record
+ *           of the chamber's state every @c TELEMETRY_PERIOD_MS. Each record
+ *           is followed by its CRC-32 and framed with COBS, which removes all
+ *           zero bytes so that a zero can mark each end of a frame. A frame
+ *           looks like this:
+ *
+ *               00  COBS (telemetry_record_t, CRC-32 of the record)  00
+ *
+ *           Text printed by other tasks can still go out between frames;
+ *           it never contains a zero, so the decoder can tell it apart from
+ *           frames and shows it separately. The script
+ *           @c tools/telemetry_decode.py reads frames from the serial port or
+ *           a file and writes CSV.
+ *
+ *           Frames are put in the UART driver's transmit ring buffer, from
+ *           which its interrupt handler feeds the hardware FIFO, so the task
+ *           never waits for the port. If there isn't room for a whole frame
+ *           it's dropped, and the count of dropped frames goes out in the
+ *           next record which fits.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _TELEMETRY_H_
+#define _TELEMETRY_H_
+
+#include <Arduino.h>
+
+
+#ifndef TELEMETRY_BAUD
+/// Baud rate of the serial port when telemetry is built in
+#define TELEMETRY_BAUD 921600
+#endif
+
+#ifndef TELEMETRY_PERIOD_MS
+/// Time between records, in milliseconds
+#define TELEMETRY_PERIOD_MS 10
+#endif
+
+/// Size of the UART driver's transmit ring buffer when telemetry is built in
+#define TELEMETRY_TX_BUFFER 4096
+
+/// The value of @c type in a sample record
+#define TELEMETRY_SAMPLE 1
+
+/// Largest frame, with both delimiters, which a record can make
+#define TELEMETRY_MAX_FRAME (sizeof (telemetry_record_t) + 4 + 3)
+
+
+/** @brief   One record of the chamber's state, sent in little endian order.
+ */
+struct telemetry_record_t
+{
+    uint8_t  type;                            ///< Always @c TELEMETRY_SAMPLE
+    uint8_t  heater_on;                       ///< 1 if the heater is on
+    uint16_t sequence;                        ///< Counts records, wrapping
+    uint32_t time_us;                         ///< Time, wraps every 71 min.
+    float    temperature;                     ///< Thermocouple reading, C
+    int16_t  setpoint;                        ///< Desired temperature, C
+    uint16_t dropped;                         ///< Frames dropped so far
+};
+
+static_assert (sizeof (telemetry_record_t) == 16,
+               "Telemetry records must have no padding");
+
+
+// Encode a block of bytes with COBS so that it has no zero bytes
+size_t cobs_encode (const uint8_t* p_in, size_t length, uint8_t* p_out);
+
+// Make a frame, ready to be sent, from a record
+size_t telemetry_frame (const telemetry_record_t& record, uint8_t* p_frame);
+
+// Start or stop sending records
+void telemetry_enable (bool on);
+
+// The task which sends records over the serial port
+void task_telemetry (void* p_params);
+
+#endif // _TELEMETRY_H_
@@ -0,0 +1,233 @@
+/** @file    trace.cpp
+ *  @brief   Source code for a recorder of timed events which shows how the
+ *           tasks take turns.
+ *  @details A writer claims a place by incrementing its ring's head, then
+ *           fills the event in. An interrupt which comes between the two
+ *           claims the next place, so nothing is lost, though the events in
+ *           a ring may then be slightly out of time order; the script which
+ *           reads dumps sorts them. A task which isn't pinned can move to the
+ *           other core between finding its core and claiming a place, which
+ *           is harmless because the increment is atomic across cores.
+ *
+ *           Recording stops while a dump is sent, so the events don't change
+ *           under it; an event whose writer was interrupted while filling it
+ *           in may still be sent half written.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <Arduino.h>
+#include "trace.h"
+#ifdef ESP32
+    #include "FreeRTOS.h"
+    #include <esp_timer.h>
+#else
+    #include <pthread.h>
+    #include <time.h>
+    #define IRAM_ATTR
+#endif
+
+
+/** @brief   The events recorded on one core.
+ */
+struct trace_ring_t
+{
+    uint32_t      head;                       ///< Events ever recorded
+    trace_event_t events[TRACE_EVENTS_PER_CORE];  ///< The latest events
+};
+
+
+/// One ring of events for each core
+static trace_ring_t rings[TRACE_CORES];
+
+/// Events are only recorded while this is @c true
+static volatile bool recording = true;
+
+/// The names of the event IDs, in the order of @c trace_id_t
+static const char* const trace_names[] =
+{
+    "task run",
+    "sensor wait",
+    "sensor read",
+    "heater on",
+    "log append",
+    "lock wait",
+    "lock held",
+    "web request"
+};
+
+static_assert (sizeof (trace_names) / sizeof (trace_names[0])
+               == TRACE_NUM_IDS, "Each trace ID needs a name");
+
+#if defined ESP32 && configUSE_TRACE_FACILITY
+    /// The state of each task, used to name the tasks in a dump
+    static TaskStatus_t task_status[TRACE_MAX_TASKS];
+#endif
+
+
+/** @brief   Record one event in the ring of the core which is running.
+ *  @details This is normally called through the @c TRACE_ macros so that it
+ *           disappears unless @c TRACE_ENABLED is defined. It may be called
+ *           from an interrupt service routine.
+ *  @param   kind What kind of event it is, one of @c trace_kind_t
+ *  @param   id What happened, one of @c trace_id_t
+ *  @param   arg A number which goes with the event
+ */
+void IRAM_ATTR trace_record (uint8_t kind, uint16_t id, uint32_t arg)
+{
+    if (!recording)
+    {
+        return;
+    }
+
+#ifdef ESP32
+    uint8_t core = xPortGetCoreID ();
+    uint32_t task = xPortInIsrContext () ? 0
+                    : (uint32_t)(uintptr_t)xTaskGetCurrentTaskHandle ();
+    uint32_t time_us = (uint32_t)esp_timer_get_time ();
+#else
+    uint8_t core = 0;
+    uint32_t task = (uint32_t)(uintptr_t)pthread_self ();
+    struct timespec now;
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    uint32_t time_us = (uint32_t)((uint64_t)now.tv_sec * 1000000UL
+                                  + now.tv_nsec / 1000);
+#endif
+
+    trace_ring_t& ring = rings[core % TRACE_CORES];
+    uint32_t place = __atomic_fetch_add (&ring.head, 1, __ATOMIC_RELAXED);
+    trace_event_t& event = ring.events[place % TRACE_EVENTS_PER_CORE];
+
+    event.time_us = time_us;
+    event.task = task;
+    event.arg = arg;
+    event.id = id;
+    event.kind = kind;
+    event.core = core;
+}
+
+
+/** @brief   Turn the recording of events on or off.
+ *  @details Recording is on when the program starts. Turning it off keeps
+ *           the latest events from being written over.
+ *  @param   on @c true to record events, @c false to stop
+ */
+void trace_enable (bool on)
+{
+    recording = on;
+}
+
+
+/** @brief   Send a name given to an event ID or a task.
+ *  @param   printer Reference to a stream on which to send the name
+ *  @param   key The event ID or the task's handle
+ *  @param   p_name The name, which is cut short if it's too long
+ */
+static void dump_name (Print& printer, uint32_t key, const char* p_name)
+{
+    trace_name_t entry;
+
+    memset (&entry, 0, sizeof (entry));
+    entry.key = key;
+    strncpy (entry.name, p_name, TRACE_NAME_LENGTH - 1);
+    printer.write ((const uint8_t*)&entry, sizeof (entry));
+}
+
+
+/** @brief   Send all the events in the rings, with names, in binary.
+ *  @details The format is described in @c trace.h. Recording is stopped
+ *           while the events are sent and then set back as it was.
+ *  @param   printer Reference to a stream on which to send the dump
+ */
+void trace_dump (Print& printer)
+{
+    bool was_recording = recording;
+    trace_header_t header;
+    uint32_t heads[TRACE_CORES];
+    uint8_t num_tasks = 0;
+
+    recording = false;
+#if defined ESP32 && configUSE_TRACE_FACILITY
+    num_tasks = uxTaskGetSystemState (task_status, TRACE_MAX_TASKS, NULL);
+#endif
+
+    header.magic = TRACE_MAGIC;
+    header.num_names = TRACE_NUM_IDS;
+    header.num_tasks = num_tasks;
+    header.num_events = 0;
+    header.dropped = 0;
+    for (uint8_t core = 0; core < TRACE_CORES; core++)
+    {
+        heads[core] = __atomic_load_n (&rings[core].head, __ATOMIC_RELAXED);
+        uint32_t count = (heads[core] < TRACE_EVENTS_PER_CORE)
+                         ? heads[core] : TRACE_EVENTS_PER_CORE;
+        header.num_events += count;
+        header.dropped += heads[core] - count;
+    }
+    printer.write ((const uint8_t*)&header, sizeof (header));
+
+    for (uint16_t id = 0; id < TRACE_NUM_IDS; id++)
+    {
+        dump_name (printer, id, trace_names[id]);
+    }
+#if defined ESP32 && configUSE_TRACE_FACILITY
+    for (uint8_t index = 0; index < num_tasks; index++)
+    {
+        dump_name (printer, (uint32_t)(uintptr_t)task_status[index].xHandle,
+                   task_status[index].pcTaskName);
+    }
+#endif
+
+    for (uint8_t core = 0; core < TRACE_CORES; core++)
+    {
+        const trace_ring_t& ring = rings[core];
+        uint32_t count = (heads[core] < TRACE_EVENTS_PER_CORE)
+                         ? heads[core] : TRACE_EVENTS_PER_CORE;
+        for (uint32_t place = heads[core] - count; place != heads[core];
+             place++)
+        {
+            printer.write ((const uint8_t*)&ring.events[place
+                                                  % TRACE_EVENTS_PER_CORE],
+                           sizeof (trace_event_t));
+        }
+    }
+
+    recording = was_recording;
+}
+
+
+/** @brief   Print the latest events as text, each core's oldest first.
+ *  @details This is meant for a quick look over the serial port; for a
+ *           timeline, use @c trace_dump() and @c tools/trace2json.py.
+ *  @param   printer Reference to a serial device or stream on which to print
+ *  @param   max_events The most events to print from each core
+ */
+void trace_print (Print& printer, uint16_t max_events)
+{
+    static const char kind_letters[] = "BEIC";
+    bool was_recording = recording;
+
+    recording = false;
+    printer.println ("Core  Time (us)  Task      Kind  Event        Arg");
+    for (uint8_t core = 0; core < TRACE_CORES; core++)
+    {
+        const trace_ring_t& ring = rings[core];
+        uint32_t head = __atomic_load_n (&ring.head, __ATOMIC_RELAXED);
+        uint32_t count = (head < TRACE_EVENTS_PER_CORE) ? head
+                                                        : TRACE_EVENTS_PER_CORE;
+        count = (count < max_events) ? count : max_events;
+        for (uint32_t place = head - count; place != head; place++)
+        {
+            const trace_event_t& event = ring.events[place
+                                                     % TRACE_EVENTS_PER_CORE];
+            printer.printf ("%4u %10lu  %08lx  %c     %-12s %lu\n",
+                            event.core, (unsigned long)event.time_us,
+                            (unsigned long)event.task,
+                            kind_letters[event.kind & 3],
+                            (event.id < TRACE_NUM_IDS) ? trace_names[event.id]
+                                                       : "?",
+                            (unsigned long)event.arg);
+        }
+    }
+    recording = was_recording;
+}
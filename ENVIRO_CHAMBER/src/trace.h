@@ -0,0 +1,156 @@
+/** @file    trace.h
+ *  @brief   Headers for a recorder of timed events which shows how the tasks
+ *           take turns.
+ *  @details Each CPU core has its own ring buffer of fixed size events, each
+ *           holding a time in microseconds, the task which was running, an
+ *           event ID and a 32 bit argument. A place in the ring is claimed
+ *           with an atomic increment, so tasks and interrupt service
+ *           routines can record events without taking a lock or turning off
+ *           interrupts. When a ring is full the oldest events are written
+ *           over, so a dump shows what happened just before something went
+ *           wrong.
+ *
+ *           Events are recorded with the @c TRACE_BEGIN(), @c TRACE_END(),
+ *           @c TRACE_INSTANT() and @c TRACE_COUNTER() macros. Unless the
+ *           program is built with @c -DTRACE_ENABLED they compile to nothing,
+ *           so they can stay in the code. The web server's @c /trace page
+ *           sends the rings in the binary format below; the script
+ *           @c tools/trace2json.py turns that into a Chrome trace which can
+ *           be viewed at https://ui.perfetto.dev or in @c chrome://tracing.
+ *
+ *           A dump holds, in little endian order:
+ *           - A @c trace_header_t
+ *           - @c num_names of @c trace_name_t, naming the event IDs
+ *           - @c num_tasks of @c trace_name_t, naming the tasks
+ *           - @c num_events of @c trace_event_t, each core's oldest first
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <Arduino.h>
+
+
+#ifndef TRACE_EVENTS_PER_CORE
+/// Number of events kept in each core's ring; must be a power of two
+#define TRACE_EVENTS_PER_CORE 256
+#endif
+
+/// Number of cores whose events are kept
+#define TRACE_CORES 2
+
+/// Largest number of tasks whose names are put in a dump
+#define TRACE_MAX_TASKS 24
+
+/// Characters, including the terminating null, in each name in a dump
+#define TRACE_NAME_LENGTH 12
+
+/// The characters which begin every dump, "TRC1" in little endian order
+#define TRACE_MAGIC 0x31435254UL
+
+static_assert ((TRACE_EVENTS_PER_CORE & (TRACE_EVENTS_PER_CORE - 1)) == 0,
+               "TRACE_EVENTS_PER_CORE must be a power of two");
+
+
+/// The IDs of the events which can be recorded
+enum trace_id_t : uint16_t
+{
+    TRACE_TASK_RUN,                           ///< A periodic task's loop runs
+    TRACE_SENSOR_WAIT,                        ///< Waiting for a conversion
+    TRACE_SENSOR_READ,                        ///< Reading the thermocouple
+    TRACE_HEATER_ON,                          ///< Counter, heater on or off
+    TRACE_LOG_APPEND,                         ///< A sample is logged
+    TRACE_LOCK_WAIT,                          ///< Waiting for a mutex
+    TRACE_LOCK_HELD,                          ///< Holding a mutex
+    TRACE_WEB_REQUEST,                        ///< Instant, a web request
+    TRACE_NUM_IDS                             ///< Number of IDs; keep last
+};
+
+/// Arguments of lock events which tell which mutex was used
+enum trace_lock_t : uint32_t
+{
+    TRACE_LOCK_LOG,                           ///< The data log's mutex
+    TRACE_LOCK_CONFIG                         ///< The settings' mutex
+};
+
+/// The kinds of events, which match Chrome trace phases
+enum trace_kind_t : uint8_t
+{
+    TRACE_KIND_BEGIN,                         ///< Something starts
+    TRACE_KIND_END,                           ///< Something ends
+    TRACE_KIND_INSTANT,                       ///< Something happens
+    TRACE_KIND_COUNTER                        ///< A value changes
+};
+
+
+/** @brief   One event recorded in a ring.
+ */
+struct trace_event_t
+{
+    uint32_t time_us;                         ///< Time, wraps every 71 min.
+    uint32_t task;                            ///< Task's handle; 0 in an ISR
+    uint32_t arg;                             ///< Number which goes with it
+    uint16_t id;                              ///< What happened
+    uint8_t  kind;                            ///< One of @c trace_kind_t
+    uint8_t  core;                            ///< Core it happened on
+};
+
+static_assert (sizeof (trace_event_t) == 16, "Trace events must be packed");
+
+
+/** @brief   The start of a dump.
+ */
+struct trace_header_t
+{
+    uint32_t magic;                           ///< Always @c TRACE_MAGIC
+    uint16_t num_names;                       ///< Event names which follow
+    uint16_t num_tasks;                       ///< Task names which follow
+    uint32_t num_events;                      ///< Events which follow
+    uint32_t dropped;                         ///< Events written over
+};
+
+
+/** @brief   A name given to an event ID or a task in a dump.
+ */
+struct trace_name_t
+{
+    uint32_t key;                             ///< Event ID or task handle
+    char     name[TRACE_NAME_LENGTH];         ///< Name, ending in a null
+};
+
+
+#ifdef TRACE_ENABLED
+    /// Record the start of something which takes time
+    #define TRACE_BEGIN(id, arg)    trace_record (TRACE_KIND_BEGIN, (id), (arg))
+    /// Record the end of something which was begun with @c TRACE_BEGIN()
+    #define TRACE_END(id, arg)      trace_record (TRACE_KIND_END, (id), (arg))
+    /// Record something which happens at an instant
+    #define TRACE_INSTANT(id, arg)  trace_record (TRACE_KIND_INSTANT, (id), \
+                                                  (arg))
+    /// Record the new value of something which changes
+    #define TRACE_COUNTER(id, arg)  trace_record (TRACE_KIND_COUNTER, (id), \
+                                                  (arg))
+#else
+    #define TRACE_BEGIN(id, arg)    do { } while (0)
+    #define TRACE_END(id, arg)      do { } while (0)
+    #define TRACE_INSTANT(id, arg)  do { } while (0)
+    #define TRACE_COUNTER(id, arg)  do { } while (0)
+#endif
+
+
+// Record one event in the ring of the core which is running
+void trace_record (uint8_t kind, uint16_t id, uint32_t arg);
+
+// Turn the recording of events on or off
+void trace_enable (bool on);
+
+// Send all the events in the rings, with names, in binary
+void trace_dump (Print& printer);
+
+// Print the latest events as text, each core's oldest first
+void trace_print (Print& printer, uint16_t max_events);
+
+#endif // _TRACE_H_
@@ -0,0 +1,944 @@
+/** @file    tslog.cpp
+ *  @brief   Source code for a compressed log of measurements kept in flash.
+ *  @details See @c tslog.h for a description of the log's format. Numbers
+ *           which may be zero or small are written with a prefix code:
+ *
+ *           | Prefix | Field that follows         |
+ *           |--------|----------------------------|
+ *           | 0      | none; the value is zero    |
+ *           | 10     | @c widths[0] bits          |
+ *           | 110    | @c widths[1] bits          |
+ *           | 1110   | @c widths[2] bits          |
+ *           | 1111   | @c widths[3] bits          |
+ *
+ *           Signed numbers are first zig-zag encoded so that small negative
+ *           numbers become small positive ones.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
+#include "crc.h"
+#include "tslog.h"
+
+
+/// Field widths for the delta of delta of timestamps, in milliseconds
+static const uint8_t time_widths[4] = { 7, 9, 12, 32 };
+
+/// Field widths for changes in temperature, in hundredths of a degree
+static const uint8_t temp_widths[4] = { 6, 9, 12, 17 };
+
+
+/** @brief   Map a signed number to an unsigned one so small magnitudes of
+ *           either sign become small numbers: 0, -1, 1, -2... to 0, 1, 2, 3...
+ *  @param   value The signed number
+ *  @return  The zig-zag encoded number
+ */
+static inline uint32_t zigzag (int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+
+/** @brief   Undo zig-zag encoding.
+ *  @param   value The zig-zag encoded number
+ *  @return  The original signed number
+ */
+static inline int32_t unzigzag (uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+
+/** @brief   Write a number with the smallest prefix-coded field that fits.
+ *  @param   writer The bit writer
+ *  @param   value The number, which must fit in @c widths[3] bits
+ *  @param   widths Sizes of the four fields, smallest first
+ */
+static void put_coded (BitWriter& writer, uint32_t value,
+                       const uint8_t widths[4])
+{
+    if (value == 0)
+    {
+        writer.put (0, 1);
+        return;
+    }
+    for (uint8_t size = 0; size < 3; size++)
+    {
+        if (value < (1UL << widths[size]))
+        {
+            writer.put ((0x0E >> (2 - size)) & ~1U, size + 2);
+            writer.put (value, widths[size]);
+            return;
+        }
+    }
+    writer.put (0x0F, 4);
+    writer.put (value, widths[3]);
+}
+
+
+/** @brief   Read a number written by @c put_coded().
+ *  @param   reader The bit reader
+ *  @param   widths Sizes of the four fields, smallest first
+ *  @return  The number
+ */
+static uint32_t get_coded (BitReader& reader, const uint8_t widths[4])
+{
+    uint8_t size = 0;
+    while (size < 4 && reader.get (1))
+    {
+        size++;
+    }
+    if (size == 0)
+    {
+        return 0;
+    }
+    return reader.get (widths[size - 1]);
+}
+
+
+/** @brief   Convert a temperature to hundredths of a degree, within range.
+ *  @param   temperature The temperature in degrees C
+ *  @return  The temperature in hundredths of a degree C
+ */
+static int16_t to_hundredths (float temperature)
+{
+    float scaled = roundf (temperature * 100.0f);
+    if (!(scaled > INT16_MIN))
+    {
+        return INT16_MIN;
+    }
+    return (scaled < INT16_MAX) ? (int16_t)scaled : INT16_MAX;
+}
+
+
+//-----------------------------------------------------------------------------
+
+/** @brief   Start writing at the beginning of a buffer.
+ *  @param   p_buf Pointer to the buffer; its contents are overwritten
+ *  @param   size_bytes The size of the buffer in bytes
+ */
+void BitWriter::begin (uint8_t* p_buf, uint16_t size_bytes)
+{
+    p_buffer = p_buf;
+    size_bits = size_bytes * 8;
+    position = 0;
+    memset (p_buffer, 0, size_bytes);
+}
+
+
+/** @brief   Write the low bits of a number, most significant bit first.
+ *  @details The caller must check @c bits_free() first; bits which don't fit
+ *           are silently dropped.
+ *  @param   value The number whose low bits are written
+ *  @param   bits How many bits to write, from 1 to 32
+ */
+void BitWriter::put (uint32_t value, uint8_t bits)
+{
+    while (bits > 0 && position < size_bits)
+    {
+        uint8_t free_here = 8 - (position & 7);
+        uint8_t now = (bits < free_here) ? bits : free_here;
+        uint8_t piece = (value >> (bits - now)) & ((1U << now) - 1);
+
+        p_buffer[position >> 3] |= piece << (free_here - now);
+        position += now;
+        bits -= now;
+    }
+}
+
+
+/** @brief   Start reading at the beginning of a buffer.
+ *  @param   p_buf Pointer to the buffer
+ *  @param   num_bits The number of valid bits in the buffer
+ */
+void BitReader::begin (const uint8_t* p_buf, uint16_t num_bits)
+{
+    p_buffer = p_buf;
+    size_bits = num_bits;
+    position = 0;
+}
+
+
+/** @brief   Read a number from the given number of bits.
+ *  @details Reading past the end returns zero bits and sets the overrun flag.
+ *  @param   bits How many bits to read, from 1 to 32
+ *  @return  The number
+ */
+uint32_t BitReader::get (uint8_t bits)
+{
+    uint32_t value = 0;
+
+    while (bits > 0)
+    {
+        if (position >= size_bits)
+        {
+            position = size_bits + 1;
+            return value << bits;
+        }
+        uint8_t left_here = 8 - (position & 7);
+        uint8_t now = (bits < left_here) ? bits : left_here;
+        uint8_t piece = (p_buffer[position >> 3] >> (left_here - now))
+                        & ((1U << now) - 1);
+
+        value = (value << now) | piece;
+        position += now;
+        bits -= now;
+    }
+    return value;
+}
+
+
+//-----------------------------------------------------------------------------
+
+/** @brief   Start encoding into an empty payload buffer.
+ *  @param   p_payload Pointer to the buffer which receives the encoded data
+ *  @param   size_bytes The size of the buffer in bytes
+ */
+void TsEncoder::begin (uint8_t* p_payload, uint16_t size_bytes)
+{
+    writer.begin (p_payload, size_bytes);
+    num_samples = 0;
+    prev_time = 0;
+    prev_delta = 0;
+    prev_temp = 0;
+    prev_setpoint = 0;
+}
+
+
+/** @brief   Encode a sample if there is room for it.
+ *  @details The first sample's time isn't encoded because it is kept in the
+ *           block's header. Its temperature and setpoint are written whole.
+ *           The caller must make sure that samples are in time order and no
+ *           more than about 24 days apart.
+ *  @param   record The sample to be encoded
+ *  @return  @c true if the sample was encoded, @c false if the buffer is full
+ */
+bool TsEncoder::add (const log_record_t& record)
+{
+    if (writer.bits_free () < TSLOG_MAX_SAMPLE_BITS)
+    {
+        return false;
+    }
+
+    int16_t temp = to_hundredths (record.temperature);
+
+    if (num_samples == 0)
+    {
+        writer.put ((uint16_t)temp, 16);
+        writer.put ((uint16_t)record.setpoint, 16);
+    }
+    else
+    {
+        int32_t delta = (int32_t)(record.time_ms - prev_time);
+        put_coded (writer, zigzag (delta - prev_delta), time_widths);
+        put_coded (writer, zigzag ((int32_t)temp - prev_temp), temp_widths);
+        if (record.setpoint == prev_setpoint)
+        {
+            writer.put (0, 1);
+        }
+        else
+        {
+            writer.put (1, 1);
+            writer.put ((uint16_t)record.setpoint, 16);
+        }
+        prev_delta = delta;
+    }
+    writer.put (record.heater_on ? 1 : 0, 1);
+
+    prev_time = record.time_ms;
+    prev_temp = temp;
+    prev_setpoint = record.setpoint;
+    num_samples++;
+    return true;
+}
+
+
+/** @brief   Start decoding the payload of a block.
+ *  @param   header The block's header, which gives the number of samples,
+ *           the number of bits and the time of the first sample
+ *  @param   p_payload Pointer to the encoded data
+ */
+void TsDecoder::begin (const tslog_header_t& header, const uint8_t* p_payload)
+{
+    reader.begin (p_payload, header.bits);
+    remaining = header.count;
+    num_decoded = 0;
+    prev_time = header.first_ms;
+    prev_delta = 0;
+    prev_temp = 0;
+    prev_setpoint = 0;
+}
+
+
+/** @brief   Decode the next sample.
+ *  @param   record Reference to a record which receives the sample
+ *  @return  @c true if a sample was decoded, @c false if there are no more
+ *           or the data is damaged
+ */
+bool TsDecoder::next (log_record_t& record)
+{
+    if (remaining == 0)
+    {
+        return false;
+    }
+
+    if (num_decoded == 0)
+    {
+        prev_temp = (int16_t)reader.get (16);
+        prev_setpoint = (int16_t)reader.get (16);
+    }
+    else
+    {
+        prev_delta += unzigzag (get_coded (reader, time_widths));
+        prev_time += prev_delta;
+        prev_temp += unzigzag (get_coded (reader, temp_widths));
+        if (reader.get (1))
+        {
+            prev_setpoint = (int16_t)reader.get (16);
+        }
+    }
+
+    record.time_ms = prev_time;
+    record.temperature = prev_temp / 100.0f;
+    record.setpoint = prev_setpoint;
+    record.heater_on = reader.get (1);
+
+    if (reader.overrun ())
+    {
+        remaining = 0;
+        return false;
+    }
+    remaining--;
+    num_decoded++;
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+
+/** @brief   Compute the CRC of a block as if its CRC field held zero.
+ *  @details The block isn't changed, so this works on blocks which are
+ *           read in place from mapped flash.
+ *  @param   p_block Pointer to the block
+ *  @return  The CRC-32 of the block
+ */
+static uint32_t block_crc (const uint8_t* p_block)
+{
+    const uint32_t zero = 0;
+    const size_t crc_at = offsetof (tslog_header_t, crc);
+    const size_t rest = crc_at + sizeof (zero);
+
+    uint32_t crc = crc32 (p_block, crc_at);
+    crc = crc32 (&zero, sizeof (zero), crc);
+    return crc32 (p_block + rest, TSLOG_BLOCK_SIZE - rest, crc);
+}
+
+
+/** @brief   Check whether a block holds valid data.
+ *  @param   p_block Pointer to the block
+ *  @return  @c true if the header makes sense and the CRC is right
+ */
+static bool block_is_valid (const uint8_t* p_block)
+{
+    const tslog_header_t& header = *(const tslog_header_t*)p_block;
+
+    return header.magic == TSLOG_MAGIC && header.count != 0
+           && header.bits <= TSLOG_PAYLOAD_SIZE * 8
+           && block_crc (p_block) == header.crc;
+}
+
+
+/** @brief   Check whether a block's header was written completely.
+ *  @details The CRC is the last field of the header to be written, so if it
+ *           isn't still erased the rest of the header is there. The samples
+ *           after the header may not be; they are checked when read.
+ *  @param   header The header to check
+ *  @return  @c true if the header makes sense
+ */
+static bool header_is_whole (const tslog_header_t& header)
+{
+    return header.magic == TSLOG_MAGIC && header.count != 0
+           && header.bits <= TSLOG_PAYLOAD_SIZE * 8
+           && header.crc != 0xFFFFFFFF && header.first_ms <= header.last_ms;
+}
+
+
+/** @brief   Widen the times of a segment in the index to cover a block.
+ *  @param   segment The segment's entry in the index
+ *  @param   header The header of a block in the segment
+ */
+static void widen (tslog_segment_t& segment, const tslog_header_t& header)
+{
+    uint32_t first_s = (uint32_t)(header.first_ms / 1000);
+    uint32_t last_s = (uint32_t)((header.last_ms + 999) / 1000);
+
+    if (segment.first_s == TSLOG_NO_TIME || first_s < segment.first_s)
+    {
+        segment.first_s = first_s;
+    }
+    if (last_s > segment.last_s)
+    {
+        segment.last_s = last_s;
+    }
+}
+
+
+/** @brief   Check whether a segment may hold samples in a span of time.
+ *  @param   segment The segment's entry in the index
+ *  @param   from_ms The start of the span
+ *  @param   to_ms The end of the span
+ *  @return  @c true if the segment's times overlap the span
+ */
+static bool overlaps (const tslog_segment_t& segment, uint64_t from_ms,
+                      uint64_t to_ms)
+{
+    return segment.first_s != TSLOG_NO_TIME
+           && segment.last_s >= from_ms / 1000
+           && segment.first_s <= to_ms / 1000;
+}
+
+
+/** @brief   Create a log which lives in the given flash region.
+ *  @details Nothing is read or written until @c begin() is called.
+ *  @param   flash The flash region which holds the log
+ */
+TsLog::TsLog (FlashRegion& flash)
+    : region (flash), num_blocks (0), num_segments (0), write_block (0),
+      next_seq (0), samples_logged (0), bytes_written (0),
+      segments_expired (0), p_map (NULL)
+{
+}
+
+
+/** @brief   Start filling a new block in RAM.
+ */
+void TsLog::start_block (void)
+{
+    memset (block.bytes, 0xFF, sizeof (block.bytes));
+    encoder.begin (block.bytes + sizeof (tslog_header_t), TSLOG_PAYLOAD_SIZE);
+}
+
+
+/** @brief   Check whether a block in flash is still erased.
+ *  @param   block_num The number of the block
+ *  @return  @c true if every byte of the block is @c 0xFF
+ */
+bool TsLog::block_is_blank (uint16_t block_num)
+{
+    if (!region.read ((uint32_t)block_num * TSLOG_BLOCK_SIZE, read_buffer,
+                      TSLOG_BLOCK_SIZE))
+    {
+        return false;
+    }
+    for (uint16_t index = 0; index < TSLOG_BLOCK_SIZE; index++)
+    {
+        if (read_buffer[index] != 0xFF)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/** @brief   Get the header of a block without checking the rest of it.
+ *  @param   block_num The number of the block
+ *  @param   header Reference to a header which receives the block's header
+ *  @return  @c true if the header was written completely, @c false if the
+ *           block is blank or its header is damaged
+ */
+bool TsLog::read_header (uint16_t block_num, tslog_header_t& header)
+{
+    uint32_t offset = (uint32_t)block_num * TSLOG_BLOCK_SIZE;
+
+    if (p_map != NULL)
+    {
+        memcpy (&header, p_map + offset, sizeof (header));
+    }
+    else if (!region.read (offset, &header, sizeof (header)))
+    {
+        return false;
+    }
+    return header_is_whole (header);
+}
+
+
+/** @brief   Find the segment which is a given number of places from the
+ *           oldest.
+ *  @details The newest segment is the one holding the last block written;
+ *           the oldest is the one after it, which is erased next.
+ *  @param   age The number of places from the oldest segment, which is 0,
+ *           to the newest, which is one less than the number of segments
+ *  @return  The number of the segment, counted from the start of the region
+ */
+uint16_t TsLog::segment_at (uint16_t age)
+{
+    uint16_t newest = ((write_block + num_blocks - 1) % num_blocks)
+                      / TSLOG_SEGMENT_BLOCKS;
+    return (newest + 1 + age) % num_segments;
+}
+
+
+/** @brief   Work out the latest time reached by each segment, oldest first.
+ *  @details This must be done whenever a segment's times change or the
+ *           oldest segment moves. It takes one pass through the index, which
+ *           is quick next to the flash operation which made it necessary.
+ */
+void TsLog::update_reach (void)
+{
+    uint32_t reach = 0;
+
+    for (uint16_t age = 0; age < num_segments; age++)
+    {
+        tslog_segment_t& segment = segments[segment_at (age)];
+        if (segment.first_s != TSLOG_NO_TIME && segment.last_s > reach)
+        {
+            reach = segment.last_s;
+        }
+        segment.reach_s = reach;
+    }
+}
+
+
+/** @brief   Find the oldest segment which may hold samples after a given
+ *           time.
+ *  @details The segments' reach never decreases from oldest to newest, so
+ *           it is searched by bisection. Every segment older than the one
+ *           found holds only samples from before @c from_ms.
+ *  @param   from_ms The time
+ *  @return  The segment's number of places from the oldest, or the number
+ *           of segments if no segment reaches the time
+ */
+uint16_t TsLog::find_start (uint64_t from_ms)
+{
+    uint64_t from_s = from_ms / 1000;
+    uint16_t low = 0;
+    uint16_t high = num_segments;
+
+    while (low < high)
+    {
+        uint16_t middle = (low + high) / 2;
+        if (segments[segment_at (middle)].reach_s < from_s)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+
+/** @brief   Set a segment's times to show that it holds nothing.
+ *  @param   segment The number of the segment
+ */
+void TsLog::clear_segment (uint16_t segment)
+{
+    segments[segment].first_s = TSLOG_NO_TIME;
+    segments[segment].last_s = 0;
+}
+
+
+/** @brief   Find the region and rebuild the index from the blocks' headers.
+ *  @details The region is mapped into memory if possible, so that blocks can
+ *           be read in place. Only the headers are read, so this takes little
+ *           time even when the log is full. Writing resumes after the block
+ *           with the highest sequence number. If the place where writing
+ *           would resume partway through a sector isn't blank, because the
+ *           power failed while a block was being written, writing skips ahead
+ *           to the next sector.
+ *  @return  @c true if the log is ready, @c false if the region wasn't found
+ */
+bool TsLog::begin (void)
+{
+    if (!region.begin ())
+    {
+        return false;
+    }
+    num_blocks = region.size () / TSLOG_BLOCK_SIZE;
+    num_blocks = (num_blocks < TSLOG_MAX_BLOCKS) ? num_blocks
+                                                 : TSLOG_MAX_BLOCKS;
+    num_segments = num_blocks / TSLOG_SEGMENT_BLOCKS;
+    num_blocks = num_segments * TSLOG_SEGMENT_BLOCKS;
+    p_map = region.map ();
+
+    bool found = false;
+    uint32_t newest_seq = 0;
+    uint16_t newest_block = 0;
+    tslog_header_t header;
+
+    for (uint16_t blk = 0; blk < num_blocks; blk++)
+    {
+        uint16_t segment = blk / TSLOG_SEGMENT_BLOCKS;
+        if (blk % TSLOG_SEGMENT_BLOCKS == 0)
+        {
+            clear_segment (segment);
+        }
+        if (!read_header (blk, header))
+        {
+            continue;
+        }
+        widen (segments[segment], header);
+        if (!found || (int32_t)(header.seq - newest_seq) > 0)
+        {
+            found = true;
+            newest_seq = header.seq;
+            newest_block = blk;
+        }
+    }
+
+    write_block = found ? (newest_block + 1) % num_blocks : 0;
+    next_seq = found ? newest_seq + 1 : 0;
+    // A block at the start of a sector is erased anyway before it's written
+    if (write_block % TSLOG_SEGMENT_BLOCKS != 0 && !block_is_blank (write_block))
+    {
+        write_block = ((write_block / TSLOG_SEGMENT_BLOCKS + 1)
+                       * TSLOG_SEGMENT_BLOCKS) % num_blocks;
+    }
+
+    update_reach ();
+    start_block ();
+    return num_blocks > 0;
+}
+
+
+/** @brief   Read and check one block from flash.
+ *  @param   block_num The number of the block, counted from the start of the
+ *           region
+ *  @param   p_buffer Pointer to a buffer of @c TSLOG_BLOCK_SIZE bytes which
+ *           receives the block
+ *  @return  @c true if the block holds valid data, @c false if it is blank,
+ *           damaged or couldn't be read
+ */
+bool TsLog::read_block (uint16_t block_num, uint8_t* p_buffer)
+{
+    return block_num < num_blocks
+           && region.read ((uint32_t)block_num * TSLOG_BLOCK_SIZE, p_buffer,
+                           TSLOG_BLOCK_SIZE)
+           && block_is_valid (p_buffer);
+}
+
+
+/** @brief   Find a block and check it, reading it in place if possible.
+ *  @details If the region is mapped, the returned pointer points into flash
+ *           and nothing is copied. If not, the block is read into a buffer
+ *           which the next call overwrites.
+ *  @param   block_num The number of the block, counted from the start of the
+ *           region
+ *  @return  A pointer to the block, or @c NULL if it is blank or damaged
+ */
+const uint8_t* TsLog::block_data (uint16_t block_num)
+{
+    if (block_num >= num_blocks)
+    {
+        return NULL;
+    }
+    if (p_map != NULL)
+    {
+        const uint8_t* p_block = p_map + (uint32_t)block_num
+                                         * TSLOG_BLOCK_SIZE;
+        return block_is_valid (p_block) ? p_block : NULL;
+    }
+    return read_block (block_num, read_buffer) ? read_buffer : NULL;
+}
+
+
+/** @brief   Write the block in RAM to flash.
+ *  @details When writing reaches the start of a segment, the segment is
+ *           erased first and its old blocks are removed from the index.
+ *  @return  @c true if the block was written, @c false if there was an error
+ */
+bool TsLog::write_current_block (void)
+{
+    tslog_header_t& header = block.header;
+    uint32_t offset = (uint32_t)write_block * TSLOG_BLOCK_SIZE;
+    uint16_t segment = write_block / TSLOG_SEGMENT_BLOCKS;
+
+    if (write_block % TSLOG_SEGMENT_BLOCKS == 0)
+    {
+        clear_segment (segment);
+        if (!region.erase (offset, FLASH_SECTOR_SIZE))
+        {
+            update_reach ();
+            return false;
+        }
+    }
+
+    header.magic = TSLOG_MAGIC;
+    header.count = encoder.count ();
+    header.seq = next_seq;
+    header.bits = encoder.bits ();
+    header.reserved = 0xFFFF;
+    header.crc = block_crc (block.bytes);
+
+    bool written = region.write (offset, block.bytes, TSLOG_BLOCK_SIZE);
+    if (written)
+    {
+        widen (segments[segment], header);
+        samples_logged += header.count;
+        bytes_written += TSLOG_BLOCK_SIZE;
+    }
+
+    // Move on even after a failure so that one bad spot can't stop the log
+    write_block = (write_block + 1) % num_blocks;
+    next_seq++;
+    update_reach ();
+    start_block ();
+    return written;
+}
+
+
+/** @brief   Add a sample to the log.
+ *  @details If the sample doesn't fit in the block being filled, or its time
+ *           can't be encoded as a difference from the previous one (because
+ *           the clock was set, for example), the block is written to flash
+ *           and the sample starts a new block.
+ *  @param   record The sample to be added
+ *  @return  @c true if all went well, @c false if a block couldn't be written
+ */
+bool TsLog::append (const log_record_t& record)
+{
+    bool all_ok = true;
+
+    if (num_blocks == 0)
+    {
+        return false;
+    }
+
+    if (encoder.count () > 0
+        && (record.time_ms < block.header.last_ms
+            || record.time_ms - block.header.last_ms > 0x3FFFFFFFULL
+            || !encoder.add (record)))
+    {
+        all_ok = write_current_block ();
+    }
+    if (encoder.count () == 0)
+    {
+        encoder.add (record);
+        block.header.first_ms = record.time_ms;
+    }
+    block.header.last_ms = record.time_ms;
+    return all_ok;
+}
+
+
+/** @brief   Write the unfinished block to flash, even though it isn't full.
+ *  @details This is worth doing before a planned reset; otherwise the samples
+ *           in the unfinished block would be lost. The rest of the block's
+ *           space in flash is wasted.
+ *  @return  @c true if the block was written or was empty, @c false if not
+ */
+bool TsLog::flush (void)
+{
+    return encoder.count () == 0 || write_current_block ();
+}
+
+
+/** @brief   Decode every sample in a span of time, passing each to a function.
+ *  @details The index is searched for the first segment which may hold
+ *           samples in the span; from there segments are visited from oldest
+ *           to newest, and only blocks whose headers' times overlap the span
+ *           are read from flash. Samples in the unfinished block in RAM are
+ *           not included.
+ *  @param   from_ms The start of the span
+ *  @param   to_ms The end of the span
+ *  @param   p_func Pointer to a function which is called with each sample
+ *  @param   p_context A pointer which is passed through to @c p_func
+ *  @return  The number of samples passed to @c p_func
+ */
+uint32_t TsLog::query (uint64_t from_ms, uint64_t to_ms,
+                       void (*p_func)(const log_record_t&, void*),
+                       void* p_context)
+{
+    uint32_t found = 0;
+    TsDecoder decoder;
+    tslog_header_t header;
+    log_record_t record;
+
+    for (uint16_t age = find_start (from_ms); age < num_segments; age++)
+    {
+        uint16_t segment = segment_at (age);
+        if (!overlaps (segments[segment], from_ms, to_ms))
+        {
+            continue;
+        }
+
+        uint16_t first = segment * TSLOG_SEGMENT_BLOCKS;
+        for (uint16_t blk = first; blk < first + TSLOG_SEGMENT_BLOCKS; blk++)
+        {
+            const uint8_t* p_block;
+            if (!read_header (blk, header) || header.last_ms < from_ms
+                || header.first_ms > to_ms
+                || (p_block = block_data (blk)) == NULL)
+            {
+                continue;
+            }
+
+            decoder.begin (*(const tslog_header_t*)p_block,
+                           p_block + sizeof (tslog_header_t));
+            while (decoder.next (record))
+            {
+                if (record.time_ms >= from_ms && record.time_ms <= to_ms)
+                {
+                    p_func (record, p_context);
+                    found++;
+                }
+            }
+        }
+    }
+    return found;
+}
+
+
+/** @brief   Set a cursor to read the samples in a span of time.
+ *  @details The index is searched for the first segment which may hold
+ *           samples in the span, so this takes a time which grows only with
+ *           the logarithm of the size of the log.
+ *  @param   cursor The cursor to be set
+ *  @param   from_ms The start of the span
+ *  @param   to_ms The end of the span
+ *  @param   p_copy Pointer to a buffer of @c TSLOG_BLOCK_SIZE bytes into
+ *           which blocks are read if the region isn't mapped, or @c NULL
+ */
+void TsLog::seek (tslog_cursor_t& cursor, uint64_t from_ms, uint64_t to_ms,
+                  uint8_t* p_copy)
+{
+    uint16_t age = find_start (from_ms);
+
+    cursor.from_ms = from_ms;
+    cursor.to_ms = to_ms;
+    cursor.block = (age < num_segments)
+                   ? segment_at (age) * TSLOG_SEGMENT_BLOCKS : 0;
+    cursor.remaining = (num_segments - age) * TSLOG_SEGMENT_BLOCKS;
+    cursor.seq = 0;
+    cursor.in_block = false;
+    cursor.p_copy = p_copy;
+}
+
+
+/** @brief   Decode the next sample in the cursor's span.
+ *  @details Samples are decoded straight from mapped flash, or if the region
+ *           isn't mapped, from a copy of each block in the cursor's buffer.
+ *           Blocks whose headers show that they hold nothing in the span are
+ *           not read. The log's mutex must be held during each call but may
+ *           be let go between calls.
+ *  @param   cursor The cursor, which has been set by @c seek()
+ *  @param   record Reference to a record which receives the sample
+ *  @return  @c true if a sample was found, @c false if there are no more or
+ *           the region isn't mapped and the cursor has no buffer
+ */
+bool TsLog::next (tslog_cursor_t& cursor, log_record_t& record)
+{
+    while ((p_map != NULL || cursor.p_copy != NULL) && cursor.remaining > 0)
+    {
+        uint16_t blk = cursor.block;
+        const uint8_t* p_block = cursor.p_copy;
+        if (p_map != NULL)
+        {
+            p_block = p_map + (uint32_t)blk * TSLOG_BLOCK_SIZE;
+        }
+        tslog_header_t header;
+
+        if (cursor.in_block)
+        {
+            // A mapped block may have been erased and reused since the last
+            // call; a copy can't change
+            const tslog_header_t& now = *(const tslog_header_t*)p_block;
+            if (p_map == NULL
+                || (now.magic == TSLOG_MAGIC && now.seq == cursor.seq))
+            {
+                while (cursor.decoder.next (record))
+                {
+                    if (record.time_ms >= cursor.from_ms
+                        && record.time_ms <= cursor.to_ms)
+                    {
+                        return true;
+                    }
+                }
+            }
+            cursor.in_block = false;
+        }
+        else if (blk % TSLOG_SEGMENT_BLOCKS == 0
+                 && !overlaps (segments[blk / TSLOG_SEGMENT_BLOCKS],
+                               cursor.from_ms, cursor.to_ms))
+        {
+            // Skip the whole segment without looking at its blocks
+            cursor.block = (blk + TSLOG_SEGMENT_BLOCKS) % num_blocks;
+            cursor.remaining -= TSLOG_SEGMENT_BLOCKS;
+            continue;
+        }
+        else if (read_header (blk, header) && header.last_ms >= cursor.from_ms
+                 && header.first_ms <= cursor.to_ms
+                 && (p_map ? block_is_valid (p_block)
+                           : read_block (blk, cursor.p_copy)))
+        {
+            cursor.decoder.begin (header, p_block + sizeof (tslog_header_t));
+            cursor.seq = header.seq;
+            cursor.in_block = true;
+            continue;
+        }
+        cursor.block = (blk + 1) % num_blocks;
+        cursor.remaining--;
+    }
+    return false;
+}
+
+
+/** @brief   Erase the oldest segments if all their samples are before a time.
+ *  @details This enforces a retention time: segments are erased from the
+ *           oldest onwards until one is found which holds a sample at or
+ *           after @c before_ms. The segment being written is never erased.
+ *  @param   before_ms Samples older than this may be erased
+ *  @return  The number of segments which were erased
+ */
+uint16_t TsLog::expire (uint64_t before_ms)
+{
+    uint16_t erased = 0;
+
+    for (uint16_t age = 0; age + 1 < num_segments; age++)
+    {
+        uint16_t segment = segment_at (age);
+        if (segments[segment].first_s == TSLOG_NO_TIME)
+        {
+            continue;
+        }
+        if (segments[segment].last_s >= before_ms / 1000
+            || !region.erase ((uint32_t)segment * FLASH_SECTOR_SIZE,
+                              FLASH_SECTOR_SIZE))
+        {
+            break;
+        }
+        clear_segment (segment);
+        erased++;
+    }
+
+    if (erased > 0)
+    {
+        segments_expired += erased;
+        update_reach ();
+    }
+    return erased;
+}
+
+
+/** @brief   Return the number of segments which hold samples.
+ *  @return  The number of segments which aren't empty
+ */
+uint16_t TsLog::segments_used (void) const
+{
+    uint16_t used = 0;
+
+    for (uint16_t segment = 0; segment < num_segments; segment++)
+    {
+        if (segments[segment].first_s != TSLOG_NO_TIME)
+        {
+            used++;
+        }
+    }
+    return used;
+}
@@ -0,0 +1,374 @@
+/** @file    tslog.h
+ *  @brief   Headers for a compressed log of measurements kept in flash.
+ *  @details Samples are packed into fixed-size blocks with a bit-level code
+ *           modeled on Facebook's Gorilla time series database. Timestamps
+ *           are stored as the change in the time between samples (the
+ *           "delta of delta"), which is zero for a steady sample rate and so
+ *           costs one bit. Temperatures are stored in hundredths of a degree
+ *           as zig-zag encoded differences from the previous sample, using
+ *           one of a few sizes of bit field chosen by a short prefix. The
+ *           setpoint costs one bit unless it changes, and the heater state
+ *           one bit. A typical sample takes about 11 bits instead of the 12
+ *           bytes of a raw record.
+ *
+ *           Each block begins with a header holding its sequence number,
+ *           the times of its first and last samples and a CRC. The blocks are
+ *           written one after another around a flash region. Each flash
+ *           sector of blocks makes a segment, which is erased as a whole:
+ *           when the log is full the oldest segment is erased to make room,
+ *           and segments older than a retention time can be erased early.
+ *
+ *           A sparse index holding the first and last time in each segment
+ *           is kept in RAM. It is rebuilt at startup from the block headers
+ *           alone, without reading or checking the samples. Segments are
+ *           written oldest to newest, so the index is searched by bisection
+ *           to find where a span of time begins. Times can go backwards in
+ *           the log, as when the controller restarts before its clock has
+ *           been set; the search uses the latest time found in each segment
+ *           or any older one, which never decreases, so it is never fooled
+ *           into skipping segments which hold samples in the span.
+ *
+ *           When the region can be mapped into memory, blocks are checked
+ *           and decoded in place in flash, so reading the log needs no RAM
+ *           for copies of the blocks. When it can't, each block is copied
+ *           into RAM with @c read_block() before it is decoded.
+ *
+ *           Times in the log are milliseconds since 1970 when the clock has
+ *           been set from the network, or since startup when it has not.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _TSLOG_H_
+#define _TSLOG_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "flashregion.h"
+
+
+/// Size of each block in the log, in bytes; it must divide a flash sector
+#define TSLOG_BLOCK_SIZE 1024
+
+/// Largest number of blocks which the log can index
+#define TSLOG_MAX_BLOCKS 1280
+
+/// Number written at the start of each valid block
+#define TSLOG_MAGIC 0x4754
+
+/// Largest number of bits which one sample can take when encoded
+#define TSLOG_MAX_SAMPLE_BITS 80
+
+/// Number of blocks in each segment, which is one flash sector
+#define TSLOG_SEGMENT_BLOCKS (FLASH_SECTOR_SIZE / TSLOG_BLOCK_SIZE)
+
+/// Largest number of segments which the log can index
+#define TSLOG_MAX_SEGMENTS (TSLOG_MAX_BLOCKS / TSLOG_SEGMENT_BLOCKS)
+
+/// Time in the index of a segment which holds no blocks
+#define TSLOG_NO_TIME 0xFFFFFFFF
+
+
+/** @brief   One sample as it is stored in and read from the log.
+ */
+struct log_record_t
+{
+    uint64_t time_ms;                         ///< Time of the sample
+    float    temperature;                     ///< Temperature in degrees C
+    int16_t  setpoint;                        ///< Setpoint in degrees C
+    uint8_t  heater_on;                       ///< 1 if heater is on, else 0
+};
+
+
+/** @brief   The header at the beginning of each block in the log.
+ */
+struct tslog_header_t
+{
+    uint16_t magic;                           ///< @c TSLOG_MAGIC if valid
+    uint16_t count;                           ///< Number of samples in block
+    uint32_t seq;                             ///< Block's sequence number
+    uint64_t first_ms;                        ///< Time of the first sample
+    uint64_t last_ms;                         ///< Time of the last sample
+    uint16_t bits;                            ///< Bits of encoded samples
+    uint16_t reserved;                        ///< Unused, must be 0xFFFF
+    uint32_t crc;                             ///< CRC-32 of the whole block
+};
+
+/// Number of bytes in each block which are left for the encoded samples
+#define TSLOG_PAYLOAD_SIZE (TSLOG_BLOCK_SIZE - sizeof (tslog_header_t))
+
+
+/** @brief   The times of the samples in one segment, kept in RAM.
+ *  @details Times are rounded outwards to whole seconds to halve the size
+ *           of the index. A segment which holds no blocks has @c first_s of
+ *           @c TSLOG_NO_TIME.
+ */
+struct tslog_segment_t
+{
+    uint32_t first_s;                         ///< Earliest time, rounded down
+    uint32_t last_s;                          ///< Latest time, rounded up
+    uint32_t reach_s;                         ///< Latest time in this segment
+                                              ///< or any older one
+};
+
+
+/** @brief   Class which packs bit fields into a buffer, most significant bit
+ *           first.
+ */
+class BitWriter
+{
+    protected:
+        uint8_t* p_buffer;                    ///< The buffer being written
+        uint16_t size_bits;                   ///< Size of the buffer in bits
+        uint16_t position;                    ///< Number of bits written
+
+    public:
+        // Start writing at the beginning of a buffer
+        void begin (uint8_t* p_buf, uint16_t size_bytes);
+
+        // Write the low bits of a number
+        void put (uint32_t value, uint8_t bits);
+
+        /// Return the number of bits which have been written.
+        uint16_t bits_used (void) const
+        {
+            return position;
+        }
+
+        /// Return the number of bits for which there is still room.
+        uint16_t bits_free (void) const
+        {
+            return size_bits - position;
+        }
+};
+
+
+/** @brief   Class which unpacks bit fields from a buffer, most significant
+ *           bit first.
+ */
+class BitReader
+{
+    protected:
+        const uint8_t* p_buffer;              ///< The buffer being read
+        uint16_t size_bits;                   ///< Number of valid bits
+        uint16_t position;                    ///< Number of bits read
+
+    public:
+        // Start reading at the beginning of a buffer
+        void begin (const uint8_t* p_buf, uint16_t num_bits);
+
+        // Read a number from the given number of bits
+        uint32_t get (uint8_t bits);
+
+        /// Return @c true if reading has gone past the end of the data.
+        bool overrun (void) const
+        {
+            return position > size_bits;
+        }
+};
+
+
+/** @brief   Class which encodes samples into the payload of a block.
+ */
+class TsEncoder
+{
+    protected:
+        BitWriter writer;                     ///< Writes the bit fields
+        uint16_t  num_samples;                ///< Samples encoded so far
+        uint64_t  prev_time;                  ///< Time of the previous sample
+        int32_t   prev_delta;                 ///< Previous change in time
+        int16_t   prev_temp;                  ///< Previous temperature, C/100
+        int16_t   prev_setpoint;              ///< Previous setpoint
+
+    public:
+        // Start encoding into an empty payload buffer
+        void begin (uint8_t* p_payload, uint16_t size_bytes);
+
+        // Encode a sample if there is room for it
+        bool add (const log_record_t& record);
+
+        /// Return the number of samples which have been encoded.
+        uint16_t count (void) const
+        {
+            return num_samples;
+        }
+
+        /// Return the number of bits of encoded data.
+        uint16_t bits (void) const
+        {
+            return writer.bits_used ();
+        }
+};
+
+
+/** @brief   Class which decodes samples from the payload of a block.
+ */
+class TsDecoder
+{
+    protected:
+        BitReader reader;                     ///< Reads the bit fields
+        uint16_t  remaining;                  ///< Samples not yet decoded
+        uint16_t  num_decoded;                ///< Samples decoded so far
+        uint64_t  prev_time;                  ///< Time of the previous sample
+        int32_t   prev_delta;                 ///< Previous change in time
+        int16_t   prev_temp;                  ///< Previous temperature, C/100
+        int16_t   prev_setpoint;              ///< Previous setpoint
+
+    public:
+        // Start decoding the payload of a block
+        void begin (const tslog_header_t& header, const uint8_t* p_payload);
+
+        // Decode the next sample
+        bool next (log_record_t& record);
+};
+
+
+/** @brief   The place reached by a reader going through the log one sample
+ *           at a time.
+ *  @details A cursor lets a reader take samples a few at a time, such as
+ *           when filling the chunks of a web response, and let go of the
+ *           log's mutex in between. When the region is mapped, blocks are
+ *           decoded in place and if one is overwritten while the cursor is
+ *           in it, the rest of that block is skipped. When it isn't, each
+ *           block is read into a buffer which the reader supplies, and the
+ *           copy is decoded to its end.
+ */
+struct tslog_cursor_t
+{
+    uint64_t  from_ms;                        ///< Start of span being read
+    uint64_t  to_ms;                          ///< End of span being read
+    uint16_t  block;                          ///< Block being read next
+    uint16_t  remaining;                      ///< Blocks left, with @c block
+    uint32_t  seq;                            ///< Sequence number of block
+    bool      in_block;                       ///< A block is being decoded
+    uint8_t*  p_copy;                         ///< Buffer for unmapped blocks
+    TsDecoder decoder;                        ///< Decodes the current block
+};
+
+
+/** @brief   Class which keeps a compressed log of samples in a flash region.
+ *  @details Samples are encoded into a block buffer in RAM; when the buffer
+ *           is full it is written to flash and a new block is started.
+ *           Samples in the unfinished block are lost if the power fails.
+ *           The log does no locking of its own; if more than one task uses
+ *           it, they must take turns by means of a mutex.
+ */
+class TsLog
+{
+    protected:
+        FlashRegion&  region;                 ///< Flash in which log is kept
+        uint16_t      num_blocks;             ///< Blocks which fit in region
+        uint16_t      num_segments;           ///< Segments which fit
+        uint16_t      write_block;            ///< Block to be written next
+        uint32_t      next_seq;               ///< Sequence number for it
+        uint32_t      samples_logged;         ///< Samples written to flash
+        uint32_t      bytes_written;          ///< Bytes written to flash
+        uint16_t      segments_expired;       ///< Segments erased as too old
+
+        /// Times of the samples in each segment
+        tslog_segment_t segments[TSLOG_MAX_SEGMENTS];
+
+        /// The block now being filled with samples
+        union
+        {
+            tslog_header_t header;            ///< Header part of the block
+            uint8_t bytes[TSLOG_BLOCK_SIZE];  ///< The whole block
+        } block;
+        TsEncoder encoder;                    ///< Encodes into @c block
+        uint8_t read_buffer[TSLOG_BLOCK_SIZE];  ///< Holds blocks for queries
+        const uint8_t* p_map;                 ///< The region, if mapped
+
+        // Start filling a new block in RAM
+        void start_block (void);
+
+        // Check whether a block in flash is still erased
+        bool block_is_blank (uint16_t block_num);
+
+        // Write the block in RAM to flash
+        bool write_current_block (void);
+
+        // Get the header of a block without checking the rest of it
+        bool read_header (uint16_t block_num, tslog_header_t& header);
+
+        // Find the segment which is a given number of places from the oldest
+        uint16_t segment_at (uint16_t age);
+
+        // Work out the latest time reached by each segment, oldest first
+        void update_reach (void);
+
+        // Find the oldest segment which may hold samples after a given time
+        uint16_t find_start (uint64_t from_ms);
+
+        // Set a segment's times to show that it holds nothing
+        void clear_segment (uint16_t segment);
+
+    public:
+        // Create a log which lives in the given flash region
+        TsLog (FlashRegion& flash);
+
+        // Find the region and rebuild the index from the blocks' headers
+        bool begin (void);
+
+        // Add a sample to the log
+        bool append (const log_record_t& record);
+
+        // Write the unfinished block to flash, even though it isn't full
+        bool flush (void);
+
+        // Read and check one block from flash
+        bool read_block (uint16_t block_num, uint8_t* p_buffer);
+
+        // Find a block and check it, reading it in place if possible
+        const uint8_t* block_data (uint16_t block_num);
+
+        // Decode every sample in a span of time, passing each to a function
+        uint32_t query (uint64_t from_ms, uint64_t to_ms,
+                        void (*p_func)(const log_record_t&, void*),
+                        void* p_context);
+
+        // Set a cursor to read the samples in a span of time
+        void seek (tslog_cursor_t& cursor, uint64_t from_ms, uint64_t to_ms,
+                   uint8_t* p_copy = NULL);
+
+        // Decode the next sample in the cursor's span
+        bool next (tslog_cursor_t& cursor, log_record_t& record);
+
+        // Erase the oldest segments if all their samples are before a time
+        uint16_t expire (uint64_t before_ms);
+
+        // Return the number of segments which hold samples
+        uint16_t segments_used (void) const;
+
+        /// Return @c true if blocks are read in place from mapped flash.
+        bool is_mapped (void) const
+        {
+            return p_map != NULL;
+        }
+
+        /// Return the number of blocks which the log can hold.
+        uint16_t capacity (void) const
+        {
+            return num_blocks;
+        }
+
+        /// Return the number of samples which have been written to flash.
+        uint32_t samples (void) const
+        {
+            return samples_logged;
+        }
+
+        /// Return the number of bytes which have been written to flash.
+        uint32_t bytes (void) const
+        {
+            return bytes_written;
+        }
+
+        /// Return the number of segments erased by @c expire().
+        uint16_t expired (void) const
+        {
+            return segments_expired;
+        }
+};
+
+#endif // _TSLOG_H_
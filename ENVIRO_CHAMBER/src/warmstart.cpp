@@ -0,0 +1,135 @@
+/** @file    warmstart.cpp
+ *  @brief   Source code for snapshots which let the controller resume after a
+ *           reset.
+ *  @details The age of a snapshot is found from the system time, which on
+ *           an ESP32 is kept by the RTC timer and keeps counting through a
+ *           warm reset, even before the clock has been set from the network.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <Arduino.h>
+#include <stddef.h>
+#include <sys/time.h>
+#include "crc.h"
+#include "warmstart.h"
+#ifdef ESP32
+    #include <esp_system.h>
+    #include <esp_attr.h>
+#endif
+
+
+/// Number which shows that a copy of the snapshot has been written
+#define WARMSTART_MAGIC 0x57524D53
+
+
+#ifdef ESP32
+    /// The two copies of the snapshot, in memory which survives a warm reset
+    RTC_NOINIT_ATTR static warm_state_t snapshots[2];
+#else
+    /// The two copies of the snapshot
+    static warm_state_t snapshots[2];
+#endif
+
+/// The copy which is to be written next
+static uint8_t next_copy = 0;
+
+/// Sequence number for the next copy
+static uint32_t next_seq = 0;
+
+
+/** @brief   Return the system time in microseconds.
+ *  @return  The system time
+ */
+static int64_t system_time_us (void)
+{
+    struct timeval now;
+    gettimeofday (&now, NULL);
+    return (int64_t)now.tv_sec * 1000000LL + now.tv_usec;
+}
+
+
+/** @brief   Check whether one copy of the snapshot is good.
+ *  @param   copy The copy to check
+ *  @return  @c true if it was written completely
+ */
+static bool copy_is_good (const warm_state_t& copy)
+{
+    return copy.magic == WARMSTART_MAGIC
+           && crc32 (&copy, offsetof (warm_state_t, crc)) == copy.crc;
+}
+
+
+/** @brief   Save a snapshot of the controller's state.
+ *  @details This is meant to be called by the heater task every control
+ *           period. Only the heater task may call it.
+ *  @param   setpoint The setpoint in degrees C
+ *  @param   current The reading which the controller is using
+ *  @param   temperature The reading at full resolution
+ *  @param   heater @c true if the heater is on
+ */
+void warmstart_save (int16_t setpoint, int16_t current, float temperature,
+                     bool heater)
+{
+    warm_state_t& copy = snapshots[next_copy];
+
+    // Spoil the copy first, so a reset part way through leaves it bad
+    copy.magic = 0;
+    copy.seq = next_seq++;
+    copy.time_us = system_time_us ();
+    copy.temperature = temperature;
+    copy.setpoint = setpoint;
+    copy.current = current;
+    copy.heater_on = heater ? 1 : 0;
+    memset (copy.reserved, 0, sizeof (copy.reserved));
+    copy.magic = WARMSTART_MAGIC;
+    copy.crc = crc32 (&copy, offsetof (warm_state_t, crc));
+
+    next_copy ^= 1;
+}
+
+
+/** @brief   Find a good, recent snapshot left from before a warm reset.
+ *  @details After the power has been off, RTC memory holds nothing useful
+ *           and the system time has started again, so no snapshot is used.
+ *           Snapshots older than @c WARMSTART_MAX_AGE_MS are not used either,
+ *           as the chamber will have changed since. The copies are spoiled
+ *           once read, so a snapshot is used only once. This must be called
+ *           in @c setup() before the heater task starts.
+ *  @param   state Reference to a snapshot which receives the state
+ *  @return  @c true if a snapshot was found, @c false if not
+ */
+bool warmstart_restore (warm_state_t& state)
+{
+    bool found = false;
+
+#ifdef ESP32
+    esp_reset_reason_t reason = esp_reset_reason ();
+    bool warm = (reason == ESP_RST_SW || reason == ESP_RST_PANIC
+                 || reason == ESP_RST_INT_WDT || reason == ESP_RST_TASK_WDT
+                 || reason == ESP_RST_WDT);
+#else
+    bool warm = true;
+#endif
+
+    for (uint8_t index = 0; warm && index < 2; index++)
+    {
+        const warm_state_t& copy = snapshots[index];
+        if (copy_is_good (copy)
+            && (!found || (int32_t)(copy.seq - state.seq) > 0))
+        {
+            state = copy;
+            found = true;
+        }
+    }
+
+    if (found)
+    {
+        int64_t age_us = system_time_us () - state.time_us;
+        found = (age_us >= 0 && age_us < WARMSTART_MAX_AGE_MS * 1000LL);
+        next_seq = state.seq + 1;
+    }
+    snapshots[0].magic = 0;
+    snapshots[1].magic = 0;
+    return found;
+}
@@ -0,0 +1,56 @@
+/** @file    warmstart.h
+ *  @brief   Headers for snapshots which let the controller resume after a
+ *           reset.
+ *  @details The heater task saves a snapshot of its state every control
+ *           period into RTC slow memory, which keeps its contents through a
+ *           software reset, a watchdog reset or a crash, though not through
+ *           a loss of power. Saving takes a few microseconds, as only a CRC
+ *           is computed and a few words are copied. After such a reset the
+ *           snapshot is restored if it is good and recent, so the heater
+ *           carries on from where it was instead of starting from a reading
+ *           of zero. After a loss of power, the controller state journal in
+ *           flash is used instead; see @c ctrlstate.h.
+ *
+ *           Two copies are kept and written in turn, so that a reset in the
+ *           middle of saving one leaves the other intact.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+// This define prevents this .h file from being included more than once
+#ifndef _WARMSTART_H_
+#define _WARMSTART_H_
+
+#include <Arduino.h>
+
+
+#ifndef WARMSTART_MAX_AGE_MS
+/// Oldest snapshot which is restored, in milliseconds
+#define WARMSTART_MAX_AGE_MS 10000
+#endif
+
+
+/** @brief   A snapshot of the controller's state.
+ */
+struct warm_state_t
+{
+    uint32_t magic;                           ///< Shows the copy was written
+    uint32_t seq;                             ///< Higher for newer copies
+    int64_t  time_us;                         ///< System time when saved
+    float    temperature;                     ///< Full resolution reading
+    int16_t  setpoint;                        ///< Setpoint in degrees C
+    int16_t  current;                         ///< Reading used by controller
+    uint8_t  heater_on;                       ///< 1 if heater was on, else 0
+    uint8_t  reserved[3];                     ///< Unused, 0
+    uint32_t crc;                             ///< CRC-32 of all of the above
+};
+
+
+// Save a snapshot of the controller's state
+void warmstart_save (int16_t setpoint, int16_t current, float temperature,
+                     bool heater);
+
+// Find a good, recent snapshot left from before a warm reset
+bool warmstart_restore (warm_state_t& state);
+
+#endif // _WARMSTART_H_
@@ -0,0 +1,263 @@
+/** @file    test_configstore.cpp
+ *  @brief   Tests of the settings store, including recovery from a power
+ *           failure at every byte of a write.
+ *  @details The store lives in an image file, @c test_config.img, in the
+ *           directory in which the tests are run. A restart is simulated by
+ *           making a new store on the same file. Run with
+ *           @c pio @c test @c -e @c native_configstore.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "configstore.h"
+
+
+/// The label of the test region, which names its image file
+#define TEST_LABEL "test_config"
+
+/// The size of the test region; four sectors is enough to wrap around
+#define TEST_SIZE (4 * FLASH_SECTOR_SIZE)
+
+/// The number of keys which the tests use
+#define TEST_KEYS 6
+
+
+/// The flash region in which each test's store lives
+static FlashRegion* p_flash;
+
+
+/** @brief   Make a store on the test region, as happens at startup.
+ *  @param   store The store, which has just been constructed
+ */
+static void start (ConfigStore& store)
+{
+    TEST_ASSERT_TRUE (store.begin ());
+}
+
+
+/** @brief   Read the whole image file.
+ *  @param   p_image Buffer of @c TEST_SIZE bytes which receives the image
+ */
+static void save_image (uint8_t* p_image)
+{
+    TEST_ASSERT_TRUE (p_flash->read (0, p_image, TEST_SIZE));
+}
+
+
+/** @brief   Put an image back in the image file, undoing all writes since
+ *           it was read.
+ *  @param   p_image The image
+ */
+static void restore_image (const uint8_t* p_image)
+{
+    FILE* p_file = fopen (TEST_LABEL ".img", "r+b");
+    TEST_ASSERT_NOT_NULL (p_file);
+    TEST_ASSERT_EQUAL (TEST_SIZE, fwrite (p_image, 1, TEST_SIZE, p_file));
+    fclose (p_file);
+}
+
+
+void setUp (void)
+{
+    FlashRegion::cut_power_after (-1);
+    remove (TEST_LABEL ".img");
+    p_flash = new FlashRegion (TEST_LABEL, TEST_SIZE);
+}
+
+
+void tearDown (void)
+{
+    FlashRegion::cut_power_after (-1);
+    delete p_flash;
+    remove (TEST_LABEL ".img");
+}
+
+
+/** @brief   Test that values are kept and found again after a restart.
+ */
+void test_values_survive_restart (void)
+{
+    {
+        ConfigStore store (*p_flash);
+        start (store);
+        TEST_ASSERT_EQUAL_INT32 (-7, store.get_int (CONFIG_SETPOINT, -7));
+        TEST_ASSERT_TRUE (store.put_int (CONFIG_SETPOINT, 55));
+        TEST_ASSERT_TRUE (store.put ((uint16_t)2, "chamber", 7));
+        TEST_ASSERT_TRUE (store.put_int (CONFIG_SETPOINT, 60));
+    }
+
+    ConfigStore store (*p_flash);
+    start (store);
+    char text[CONFIG_MAX_VALUE];
+    TEST_ASSERT_EQUAL_INT32 (60, store.get_int (CONFIG_SETPOINT, 0));
+    TEST_ASSERT_EQUAL (7, store.get ((uint16_t)2, text, sizeof (text)));
+    TEST_ASSERT_EQUAL_MEMORY ("chamber", text, 7);
+}
+
+
+/** @brief   Test that an unchanged value isn't written again.
+ */
+void test_same_value_not_written (void)
+{
+    ConfigStore store (*p_flash);
+    start (store);
+    TEST_ASSERT_TRUE (store.put_int (CONFIG_SETPOINT, 40));
+    uint32_t writes = store.writes ();
+    TEST_ASSERT_TRUE (store.put_int (CONFIG_SETPOINT, 40));
+    TEST_ASSERT_EQUAL_UINT32 (writes, store.writes ());
+}
+
+
+/** @brief   Test many changes, which wrap around the region several times,
+ *           and check that every sector is erased about equally often.
+ */
+void test_wraps_around (void)
+{
+    uint32_t erases[TEST_SIZE / FLASH_SECTOR_SIZE] = { 0 };
+    uint32_t last_seq[TEST_SIZE / FLASH_SECTOR_SIZE] = { 0 };
+    int32_t values[TEST_KEYS + 1];
+    {
+        ConfigStore store (*p_flash);
+        start (store);
+        for (int32_t count = 0; count < 5000; count++)
+        {
+            uint16_t key = 1 + count % TEST_KEYS;
+            values[key] = count;
+            TEST_ASSERT_TRUE (store.put_int (key, count));
+
+            // A sector's sequence number changes each time it's opened
+            for (uint16_t sector = 0; sector < TEST_SIZE / FLASH_SECTOR_SIZE;
+                 sector++)
+            {
+                config_sector_t header;
+                p_flash->read (sector * FLASH_SECTOR_SIZE, &header,
+                               sizeof (header));
+                if (header.magic == CONFIG_SECTOR_MAGIC
+                    && header.seq != last_seq[sector])
+                {
+                    last_seq[sector] = header.seq;
+                    erases[sector]++;
+                }
+            }
+        }
+        TEST_ASSERT_GREATER_THAN (10, store.erases ());
+    }
+
+    uint32_t fewest = erases[0];
+    uint32_t most = erases[0];
+    for (uint16_t sector = 1; sector < TEST_SIZE / FLASH_SECTOR_SIZE; sector++)
+    {
+        fewest = (erases[sector] < fewest) ? erases[sector] : fewest;
+        most = (erases[sector] > most) ? erases[sector] : most;
+    }
+    TEST_ASSERT_LESS_OR_EQUAL (fewest + 1, most);
+
+    ConfigStore store (*p_flash);
+    start (store);
+    for (uint16_t key = 1; key <= TEST_KEYS; key++)
+    {
+        TEST_ASSERT_EQUAL_INT32 (values[key], store.get_int (key, -1));
+    }
+}
+
+
+/** @brief   Make the power fail at every byte of one change, restart each
+ *           time and check the store.
+ *  @details After the restart the changed key must have either its old or
+ *           its new value and every other key its old value, and the store
+ *           must be able to take and keep another change.
+ *  @param   num_changes The number of changes made before the one which is
+ *           interrupted, which decides where in the region it falls
+ */
+static void power_loss_at_every_byte (uint32_t num_changes)
+{
+    static uint8_t image[TEST_SIZE];
+    int32_t values[TEST_KEYS + 1];
+    {
+        ConfigStore store (*p_flash);
+        start (store);
+        for (uint32_t count = 0; count < num_changes; count++)
+        {
+            uint16_t key = 1 + count % TEST_KEYS;
+            values[key] = count;
+            TEST_ASSERT_TRUE (store.put_int (key, values[key]));
+        }
+    }
+    save_image (image);
+
+    bool was_cut = true;
+    int32_t cut;
+    for (cut = 0; was_cut; cut++)
+    {
+        restore_image (image);
+        {
+            ConfigStore store (*p_flash);
+            start (store);
+            FlashRegion::cut_power_after (cut);
+            store.put_int (1, -1000);
+            was_cut = FlashRegion::power_was_cut ();
+            FlashRegion::cut_power_after (-1);
+        }
+
+        ConfigStore store (*p_flash);
+        start (store);
+        int32_t value = store.get_int (1, 0);
+        TEST_ASSERT_TRUE_MESSAGE (value == values[1] || value == -1000,
+                                  "Changed key has neither old nor new value");
+        if (!was_cut)
+        {
+            TEST_ASSERT_EQUAL_INT32 (-1000, value);
+        }
+        for (uint16_t key = 2; key <= TEST_KEYS; key++)
+        {
+            TEST_ASSERT_EQUAL_INT32_MESSAGE (values[key],
+                                             store.get_int (key, 0),
+                                             "Unchanged key was lost");
+        }
+
+        TEST_ASSERT_TRUE (store.put_int (2, 12345));
+        ConfigStore again (*p_flash);
+        start (again);
+        TEST_ASSERT_EQUAL_INT32 (12345, again.get_int (2, 0));
+        TEST_ASSERT_EQUAL_INT32 (value, again.get_int (1, 0));
+    }
+    TEST_ASSERT_GREATER_THAN (8, cut);
+}
+
+
+/** @brief   Test a power failure during a change which fits in the sector
+ *           being written.
+ */
+void test_power_loss_in_record (void)
+{
+    power_loss_at_every_byte (20);
+}
+
+
+/** @brief   Test a power failure during a change which moves writing to the
+ *           next sector, so that a sector is erased and compacted.
+ */
+void test_power_loss_in_compaction (void)
+{
+    // Each record takes 12 bytes, so this many fill the first sector
+    power_loss_at_every_byte ((FLASH_SECTOR_SIZE - sizeof (config_sector_t))
+                              / 12);
+}
+
+
+int main (int argc, char** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_values_survive_restart);
+    RUN_TEST (test_same_value_not_written);
+    RUN_TEST (test_wraps_around);
+    RUN_TEST (test_power_loss_in_record);
+    RUN_TEST (test_power_loss_in_compaction);
+    return UNITY_END ();
+}
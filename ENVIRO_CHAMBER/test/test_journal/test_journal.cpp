@@ -0,0 +1,215 @@
+/** @file    test_journal.cpp
+ *  @brief   Tests of the journal, cutting the power at every byte of a save.
+ *  @details The journal lives in an image file, @c test_journal.img, in the
+ *           directory in which the tests are run. A restart is simulated by
+ *           making a new journal on the same file. Run with
+ *           @c pio @c test @c -e @c native_journal.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "journal.h"
+
+
+/// The label of the test region, which names its image file
+#define TEST_LABEL "test_journal"
+
+/// The size of the test region, the two sectors which a journal uses
+#define TEST_SIZE (2 * FLASH_SECTOR_SIZE)
+
+
+/** @brief   A record like the controller's state.
+ */
+struct test_record_t
+{
+    uint64_t time_ms;                         ///< When it was saved
+    float    temperature;                     ///< A reading
+    int16_t  setpoint;                        ///< A setpoint
+    uint16_t version;                         ///< Which save this is
+};
+
+
+/// The flash region in which each test's journal lives
+static FlashRegion* p_flash;
+
+
+/** @brief   Make a record which differs for each version.
+ *  @param   version The version
+ *  @return  The record
+ */
+static test_record_t make_record (uint16_t version)
+{
+    test_record_t record;
+    memset (&record, 0, sizeof (record));
+    record.time_ms = 1000ULL * version;
+    record.temperature = 20.0f + version;
+    record.setpoint = (int16_t)(30 + version);
+    record.version = version;
+    return record;
+}
+
+
+/** @brief   Restart and find which version of the record the journal has.
+ *  @return  The version, or -1 if there is no record
+ */
+static int32_t version_after_restart (void)
+{
+    Journal journal (*p_flash);
+    test_record_t record;
+
+    TEST_ASSERT_TRUE (journal.begin ());
+    if (journal.load (&record, sizeof (record)) != sizeof (record))
+    {
+        return -1;
+    }
+    test_record_t expected = make_record (record.version);
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE (&expected, &record, sizeof (record),
+                                      "Record loaded is damaged");
+    return record.version;
+}
+
+
+/** @brief   Make the power fail at every byte of one save, restart each time
+ *           and check that the journal holds the old or the new record.
+ *  @details After each restart, another save must work and be found.
+ *  @param   num_saves The number of saves before the one which is cut short
+ */
+static void power_loss_at_every_byte (uint16_t num_saves)
+{
+    static uint8_t image[TEST_SIZE];
+    int32_t old_version = -1;
+    {
+        Journal journal (*p_flash);
+        TEST_ASSERT_TRUE (journal.begin ());
+        for (uint16_t version = 1; version <= num_saves; version++)
+        {
+            test_record_t record = make_record (version);
+            TEST_ASSERT_TRUE (journal.save (&record, sizeof (record)));
+            old_version = version;
+        }
+    }
+    TEST_ASSERT_TRUE (p_flash->read (0, image, TEST_SIZE));
+
+    bool was_cut = true;
+    int32_t cut;
+    for (cut = 0; was_cut; cut++)
+    {
+        FILE* p_file = fopen (TEST_LABEL ".img", "r+b");
+        TEST_ASSERT_NOT_NULL (p_file);
+        TEST_ASSERT_EQUAL (TEST_SIZE, fwrite (image, 1, TEST_SIZE, p_file));
+        fclose (p_file);
+
+        const uint16_t new_version = 100;
+        {
+            Journal journal (*p_flash);
+            TEST_ASSERT_TRUE (journal.begin ());
+            test_record_t record = make_record (new_version);
+            FlashRegion::cut_power_after (cut);
+            bool saved = journal.save (&record, sizeof (record));
+            was_cut = FlashRegion::power_was_cut ();
+            FlashRegion::cut_power_after (-1);
+            TEST_ASSERT_TRUE (saved != was_cut);
+        }
+
+        int32_t version = version_after_restart ();
+        TEST_ASSERT_TRUE_MESSAGE (version == old_version
+                                  || version == new_version,
+                                  "Journal has neither old nor new record");
+        if (!was_cut)
+        {
+            TEST_ASSERT_EQUAL_INT32 (new_version, version);
+        }
+
+        // The journal must carry on working after the failure
+        {
+            Journal journal (*p_flash);
+            TEST_ASSERT_TRUE (journal.begin ());
+            test_record_t record = make_record (new_version + 1);
+            TEST_ASSERT_TRUE (journal.save (&record, sizeof (record)));
+        }
+        TEST_ASSERT_EQUAL_INT32 (new_version + 1, version_after_restart ());
+    }
+
+    // An erase and a write of header and record have been cut everywhere
+    TEST_ASSERT_GREATER_THAN ((int32_t)(FLASH_SECTOR_SIZE
+                                        + sizeof (journal_header_t)
+                                        + sizeof (test_record_t)), cut);
+}
+
+
+void setUp (void)
+{
+    FlashRegion::cut_power_after (-1);
+    remove (TEST_LABEL ".img");
+    p_flash = new FlashRegion (TEST_LABEL, TEST_SIZE);
+}
+
+
+void tearDown (void)
+{
+    FlashRegion::cut_power_after (-1);
+    delete p_flash;
+    remove (TEST_LABEL ".img");
+}
+
+
+/** @brief   Test that the newest record is found after a restart.
+ */
+void test_newest_survives_restart (void)
+{
+    TEST_ASSERT_EQUAL_INT32 (-1, version_after_restart ());
+    {
+        Journal journal (*p_flash);
+        TEST_ASSERT_TRUE (journal.begin ());
+        for (uint16_t version = 1; version <= 5; version++)
+        {
+            test_record_t record = make_record (version);
+            TEST_ASSERT_TRUE (journal.save (&record, sizeof (record)));
+            TEST_ASSERT_EQUAL_UINT32 (version - 1, journal.sequence ());
+        }
+    }
+    TEST_ASSERT_EQUAL_INT32 (5, version_after_restart ());
+}
+
+
+/** @brief   Test a power failure during the very first save.
+ */
+void test_power_loss_first_save (void)
+{
+    power_loss_at_every_byte (0);
+}
+
+
+/** @brief   Test a power failure when one copy has been saved, so the other
+ *           slot is still blank.
+ */
+void test_power_loss_second_save (void)
+{
+    power_loss_at_every_byte (1);
+}
+
+
+/** @brief   Test a power failure when both slots hold copies, so the older
+ *           one is erased and written over.
+ */
+void test_power_loss_later_save (void)
+{
+    power_loss_at_every_byte (4);
+}
+
+
+int main (int argc, char** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_newest_survives_restart);
+    RUN_TEST (test_power_loss_first_save);
+    RUN_TEST (test_power_loss_second_save);
+    RUN_TEST (test_power_loss_later_save);
+    return UNITY_END ();
+}
@@ -0,0 +1,517 @@
+/** @file    test_mqtt.cpp
+ *  @brief   Tests of the MQTT task, run in the simulator against a stand-in
+ *           for the broker.
+ *  @details The task is the firmware's own, built with the simulator's
+ *           @c WiFi.h and @c PubSubClient.h, which talk MQTT through a real
+ *           socket. The broker here runs in a thread of its own on
+ *           @c MQTT_BROKER:MQTT_PORT, which the test's environment sets; it
+ *           answers the task, keeps count of what it's sent, and checks
+ *           that the samples arrive in order. The tests share one simulated
+ *           timeline and run in the order listed in @c main(). Run with
+ *           @c pio @c test @c -e @c native_mqtt.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/sockios.h>
+#include "sim.h"
+#include "sim_faults.h"
+#include "taskshare.h"
+#include "tasktable.h"
+#include "task_mqtt.h"
+#include "ctrlstate.h"
+
+
+/// Topic on which the task publishes samples
+#define TOPIC_SAMPLES MQTT_TOPIC_BASE "/samples"
+
+/// Topic on which the task publishes its status
+#define TOPIC_STATUS MQTT_TOPIC_BASE "/status"
+
+/// Topic on which the task takes new setpoints
+#define TOPIC_SETPOINT MQTT_TOPIC_BASE "/setpoint"
+
+/// Longest real time to wait for the broker to catch up, in milliseconds
+#define SETTLE_TIMEOUT_MS 2000
+
+
+// The shares which main_enviro.cpp has in the firmware
+Share<int16_t> desired_temp ("Temperature");
+Share<float> therm_temp ("Therm Temp");
+Share<bool> heater_on ("Heater On");
+
+
+/** @brief   What the stand-in for the broker has seen.
+ */
+struct broker_log_t
+{
+    uint32_t connects;                        ///< Sessions opened
+    uint32_t subscribes;                      ///< Setpoint subscriptions
+    uint32_t sample_msgs;                     ///< Messages of samples
+    uint32_t samples;                         ///< Samples in those messages
+    uint32_t biggest_batch;                   ///< Most samples in a message
+    uint32_t gaps;                            ///< Times samples were missed
+    uint32_t missed;                          ///< Samples missed in all
+    uint32_t status_msgs;                     ///< Status messages
+    bool     status_retained;                 ///< Last status was retained
+    char     status[256];                     ///< Last status message
+};
+
+
+/// The socket on which the broker listens
+static int broker_listener = -1;
+
+/// The socket of the task's session, or -1 if there's none
+static int broker_session = -1;
+
+/// Guards everything the broker shares with the tests
+static pthread_mutex_t broker_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/// True while the broker is handling a packet it has begun to read
+static bool broker_busy = false;
+
+/// What the broker has seen so far
+static broker_log_t broker_log;
+
+/// Time of the sample which should start the next message of samples
+static uint32_t broker_next_ms = 0;
+
+/// Number of times the task has asked for its state to be saved
+static uint32_t save_requests = 0;
+
+/// The task under test, as in main_enviro.cpp's task table
+static task_entry_t mqtt_task_table[] =
+{
+    { task_mqtt, "MQTT", 4096, 1, NETWORK_CORE, MQTT_SAMPLE_MS, NULL, {}, {} }
+};
+
+
+/** @brief   Stand in for the controller's state, and count the requests.
+ */
+void ctrlstate_request_save (void)
+{
+    save_requests++;
+}
+
+
+/** @brief   Read exactly some bytes from the broker's session.
+ *  @param   p_data Pointer to where the bytes go
+ *  @param   length The number of bytes
+ *  @return  True if they came, false if the session closed
+ */
+static bool broker_read (uint8_t* p_data, size_t length)
+{
+    return length == 0
+           || recv (broker_session, p_data, length, MSG_WAITALL)
+              == (ssize_t)length;
+}
+
+
+/** @brief   Write a whole packet to the task's session.
+ *  @param   type The packet's first byte
+ *  @param   p_body Pointer to the rest of the packet
+ *  @param   length The number of bytes in the rest, at most 127
+ */
+static void broker_write (uint8_t type, const uint8_t* p_body, size_t length)
+{
+    uint8_t packet[2 + 127];
+    packet[0] = type;
+    packet[1] = (uint8_t)length;
+    if (length > 0)
+    {
+        memcpy (packet + 2, p_body, length);
+    }
+    send (broker_session, packet, 2 + length, MSG_NOSIGNAL);
+}
+
+
+/** @brief   Check a message of samples and count what's in it.
+ *  @param   p_text The message, ending in a zero
+ */
+static void broker_got_samples (const char* p_text)
+{
+    uint32_t t0 = strtoul (p_text + strlen ("{\"t0\":"), NULL, 10);
+    uint32_t count = 0;
+    for (const char* p_char = strstr (p_text, "[["); p_char != NULL;
+         p_char = strstr (p_char + 1, "],["))
+    {
+        count++;
+    }
+
+    if (broker_log.sample_msgs > 0 && t0 != broker_next_ms)
+    {
+        broker_log.gaps++;
+        broker_log.missed += (t0 - broker_next_ms) / MQTT_SAMPLE_MS;
+    }
+    broker_next_ms = t0 + count * MQTT_SAMPLE_MS;
+    broker_log.sample_msgs++;
+    broker_log.samples += count;
+    if (count > broker_log.biggest_batch)
+    {
+        broker_log.biggest_batch = count;
+    }
+}
+
+
+/** @brief   Handle one packet from the task.
+ *  @return  True if the session carries on, false if it has ended
+ */
+static bool broker_handle_packet (void)
+{
+    static uint8_t body[1024];
+    uint8_t type;
+    uint8_t byte;
+    uint32_t length = 0;
+    uint32_t scale = 1;
+
+    if (!broker_read (&type, 1))
+    {
+        return false;
+    }
+    do
+    {
+        if (!broker_read (&byte, 1))
+        {
+            return false;
+        }
+        length += (byte & 0x7F) * scale;
+        scale <<= 7;
+    }
+    while (byte & 0x80);
+    if (length >= sizeof (body) || !broker_read (body, length))
+    {
+        return false;
+    }
+    body[length] = '\0';
+
+    static const uint8_t connack[] = { 0, 0 };
+    static const uint8_t suback[] = { 0, 0, 0 };
+    uint16_t topic_length = (body[0] << 8) | body[1];
+    char* p_topic = (char*)body + 2;
+    switch (type & 0xF0)
+    {
+        case 0x10:                            // Connect
+            broker_log.connects++;
+            broker_write (0x20, connack, sizeof (connack));
+            break;
+        case 0x80:                            // Subscribe, after its ID
+            if (strncmp ((char*)body + 4, TOPIC_SETPOINT,
+                         strlen (TOPIC_SETPOINT)) == 0)
+            {
+                broker_log.subscribes++;
+            }
+            broker_write (0x90, suback, sizeof (suback));
+            break;
+        case 0x30:                            // Publish
+            if (strncmp (p_topic, TOPIC_SAMPLES, topic_length) == 0)
+            {
+                broker_got_samples (p_topic + topic_length);
+            }
+            else if (strncmp (p_topic, TOPIC_STATUS, topic_length) == 0)
+            {
+                broker_log.status_msgs++;
+                broker_log.status_retained = type & 1;
+                strncpy (broker_log.status, p_topic + topic_length,
+                         sizeof (broker_log.status) - 1);
+            }
+            break;
+        case 0xC0:                            // Ping
+            broker_write (0xD0, NULL, 0);
+            break;
+        case 0xE0:                            // Disconnect
+            return false;
+    }
+    return true;
+}
+
+
+/** @brief   Run the stand-in for the broker, one session at a time.
+ *  @param   p_arg Not used
+ *  @return  Never returns
+ */
+static void* broker_thread (void* p_arg)
+{
+    (void)p_arg;
+
+    for (;;)
+    {
+        int session = accept (broker_listener, NULL, NULL);
+        pthread_mutex_lock (&broker_lock);
+        broker_session = session;
+        pthread_mutex_unlock (&broker_lock);
+
+        for (bool open = true; open; )
+        {
+            struct pollfd waiting = { session, POLLIN, 0 };
+            poll (&waiting, 1, -1);
+            pthread_mutex_lock (&broker_lock);
+            broker_busy = true;
+            open = broker_handle_packet ();
+            broker_busy = false;
+            pthread_mutex_unlock (&broker_lock);
+        }
+
+        pthread_mutex_lock (&broker_lock);
+        close (session);
+        broker_session = -1;
+        pthread_mutex_unlock (&broker_lock);
+    }
+    return NULL;
+}
+
+
+/** @brief   Start the broker listening on @c MQTT_PORT.
+ *  @return  True if it's listening
+ */
+static bool broker_start (void)
+{
+    struct sockaddr_in address;
+    int reuse = 1;
+    pthread_t thread;
+
+    memset (&address, 0, sizeof (address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons (MQTT_PORT);
+    address.sin_addr.s_addr = inet_addr (MQTT_BROKER);
+
+    broker_listener = socket (AF_INET, SOCK_STREAM, 0);
+    setsockopt (broker_listener, SOL_SOCKET, SO_REUSEADDR, &reuse,
+                sizeof (reuse));
+    if (bind (broker_listener, (struct sockaddr*)&address, sizeof (address))
+        != 0 || listen (broker_listener, 1) != 0)
+    {
+        perror ("Broker can't listen");
+        return false;
+    }
+    return pthread_create (&thread, NULL, broker_thread, NULL) == 0;
+}
+
+
+/** @brief   Wait until the broker has handled everything the task has sent
+ *           and the task has had everything the broker sent.
+ */
+static void broker_settle (void)
+{
+    for (uint32_t waited = 0; waited < SETTLE_TIMEOUT_MS; waited++)
+    {
+        int unread = 0;
+        int unsent = 0;
+        pthread_mutex_lock (&broker_lock);
+        if (broker_session >= 0)
+        {
+            ioctl (broker_session, FIONREAD, &unread);
+            ioctl (broker_session, SIOCOUTQ, &unsent);
+        }
+        bool idle = !broker_busy && unread == 0 && unsent == 0;
+        pthread_mutex_unlock (&broker_lock);
+        if (idle)
+        {
+            return;
+        }
+        usleep (1000);
+    }
+    TEST_FAIL_MESSAGE ("Broker didn't settle");
+}
+
+
+/** @brief   Publish a message to the task on the setpoint topic.
+ *  @param   p_payload The message
+ */
+static void broker_send_setpoint (const char* p_payload)
+{
+    uint8_t body[64];
+    size_t length = 0;
+    body[length++] = 0;
+    body[length++] = strlen (TOPIC_SETPOINT);
+    memcpy (body + length, TOPIC_SETPOINT, strlen (TOPIC_SETPOINT));
+    length += strlen (TOPIC_SETPOINT);
+    memcpy (body + length, p_payload, strlen (p_payload));
+    length += strlen (p_payload);
+
+    pthread_mutex_lock (&broker_lock);
+    TEST_ASSERT_TRUE_MESSAGE (broker_session >= 0, "No session to send on");
+    broker_write (0x30, body, length);
+    pthread_mutex_unlock (&broker_lock);
+    broker_settle ();
+}
+
+
+/** @brief   Take a copy of what the broker has seen.
+ *  @return  The copy
+ */
+static broker_log_t broker_seen (void)
+{
+    broker_settle ();
+    pthread_mutex_lock (&broker_lock);
+    broker_log_t copy = broker_log;
+    pthread_mutex_unlock (&broker_lock);
+    return copy;
+}
+
+
+/** @brief   Find a number in the task's last status message.
+ *  @param   p_status The status message
+ *  @param   p_key The name of the number, in quotes and with its colon
+ *  @return  The number, or -1 if it isn't there
+ */
+static long status_value (const char* p_status, const char* p_key)
+{
+    const char* p_found = strstr (p_status, p_key);
+    return p_found ? strtol (p_found + strlen (p_key), NULL, 10) : -1;
+}
+
+
+/** @brief   Run the simulation for a whole number of the task's periods.
+ *  @param   periods The number of periods
+ */
+static void run_periods (uint32_t periods)
+{
+    sim_run_until (sim_now_us () + periods * MQTT_SAMPLE_MS * 1000ULL);
+}
+
+
+/** @brief   The task connects as soon as it starts and subscribes to the
+ *           setpoint topic.
+ */
+static void test_connects_and_subscribes (void)
+{
+    run_periods (1);
+    broker_log_t seen = broker_seen ();
+
+    TEST_ASSERT_EQUAL_UINT (1, seen.connects);
+    TEST_ASSERT_EQUAL_UINT (1, seen.subscribes);
+}
+
+
+/** @brief   Samples go out in batches, in order and with none missed, and a
+ *           retained status message goes with each regular publication.
+ */
+static void test_publishes_samples_and_status (void)
+{
+    run_periods (4 * MQTT_PUBLISH_MS / MQTT_SAMPLE_MS);
+    broker_log_t seen = broker_seen ();
+
+    TEST_ASSERT_GREATER_OR_EQUAL (4, seen.sample_msgs);
+    TEST_ASSERT_LESS_OR_EQUAL (MQTT_BATCH_SIZE, seen.biggest_batch);
+    TEST_ASSERT_EQUAL_UINT (0, seen.gaps);
+    TEST_ASSERT_GREATER_OR_EQUAL (4, seen.status_msgs);
+    TEST_ASSERT_TRUE (seen.status_retained);
+    TEST_ASSERT_EQUAL_INT (0, status_value (seen.status, "\"dropped\":"));
+    TEST_ASSERT_EQUAL_INT (40, status_value (seen.status, "\"set\":"));
+}
+
+
+/** @brief   A setpoint from the broker changes the desired temperature and
+ *           is saved; payloads which aren't a setpoint in range are ignored.
+ */
+static void test_setpoint_from_broker (void)
+{
+    int16_t setpoint;
+    uint32_t saves = save_requests;
+
+    broker_send_setpoint ("37");
+    run_periods (1);
+    desired_temp.get (setpoint);
+    TEST_ASSERT_EQUAL_INT (37, setpoint);
+    TEST_ASSERT_EQUAL_UINT (saves + 1, save_requests);
+
+    const char* bad[] = { "", "abc", "37x", "201", "-51", "123456789" };
+    for (uint8_t index = 0; index < sizeof (bad) / sizeof (bad[0]); index++)
+    {
+        broker_send_setpoint (bad[index]);
+        run_periods (1);
+    }
+    desired_temp.get (setpoint);
+    TEST_ASSERT_EQUAL_INT (37, setpoint);
+    TEST_ASSERT_EQUAL_UINT (saves + 1, save_requests);
+}
+
+
+/** @brief   While WiFi is down the ring keeps the newest samples; once it's
+ *           back the task reconnects and catches up a few batches a period
+ *           without losing any more.
+ */
+static void test_offline_ring_and_drain (void)
+{
+    // Stay down for long enough to fill the ring and then some
+    const uint32_t down_periods = MQTT_BUFFER_SAMPLES + 40;
+    run_periods (MQTT_PUBLISH_MS / MQTT_SAMPLE_MS);
+    broker_log_t before = broker_seen ();
+    sim_fault_add (SIM_FAULT_WIFI_DROP, sim_now_us (),
+                   down_periods * MQTT_SAMPLE_MS * 1000ULL);
+    run_periods (down_periods);
+    broker_log_t offline = broker_seen ();
+    TEST_ASSERT_EQUAL_UINT (before.sample_msgs, offline.sample_msgs);
+
+    // Each period sends no more than a few batches until it has caught up
+    uint32_t catching_up = 0;
+    broker_log_t seen = offline;
+    for (uint32_t period = 0; period < 100; period++)
+    {
+        run_periods (1);
+        broker_log_t now = broker_seen ();
+        TEST_ASSERT_LESS_OR_EQUAL (MQTT_DRAIN_BATCHES,
+                                   now.sample_msgs - seen.sample_msgs);
+        if (now.sample_msgs - seen.sample_msgs == MQTT_DRAIN_BATCHES)
+        {
+            catching_up++;
+        }
+        seen = now;
+    }
+    TEST_ASSERT_EQUAL_UINT (before.connects + 1, seen.connects);
+    TEST_ASSERT_EQUAL_UINT (before.subscribes + 1, seen.subscribes);
+    TEST_ASSERT_GREATER_OR_EQUAL (MQTT_BUFFER_SAMPLES
+                                  / (MQTT_DRAIN_BATCHES * MQTT_BATCH_SIZE),
+                                  catching_up);
+
+    // Only the oldest samples, which didn't fit in the ring, are missing
+    TEST_ASSERT_EQUAL_UINT (1, seen.gaps);
+    TEST_ASSERT_GREATER_THAN (0, seen.missed);
+    TEST_ASSERT_EQUAL_INT (seen.missed,
+                           status_value (seen.status, "\"dropped\":"));
+    TEST_ASSERT_LESS_OR_EQUAL (MQTT_BATCH_SIZE,
+                               status_value (seen.status, "\"buffered\":"));
+}
+
+
+void setUp (void)
+{
+}
+
+
+void tearDown (void)
+{
+}
+
+
+int main (int argc, char** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    if (!broker_start ())
+    {
+        return 1;
+    }
+    sim_begin (1);
+    desired_temp.put (40);
+    therm_temp.put (38.5f);
+    create_tasks (mqtt_task_table, 1);
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_connects_and_subscribes);
+    RUN_TEST (test_publishes_samples_and_status);
+    RUN_TEST (test_setpoint_from_broker);
+    RUN_TEST (test_offline_ring_and_drain);
+    return UNITY_END ();
+}
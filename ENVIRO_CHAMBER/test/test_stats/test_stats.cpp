@@ -0,0 +1,218 @@
+/** @file    test_stats.cpp
+ *  @brief   Tests of the sliding-window statistics against a brute-force
+ *           reference.
+ *  @details Each test feeds samples at the sensor task's rate into a
+ *           @c SlidingStats and, after every sample, compares its results
+ *           with the statistics of the same samples computed directly in
+ *           double precision from a list of every sample in the window.
+ *           Run with @c pio @c test @c -e @c native_stats.
+ *
+ *  @date 2026-Oct-17 Created file
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include <math.h>
+#include "taskshare.h"
+#include "stats.h"
+
+
+/// Time between samples, as in the sensor task, in ms
+#define SAMPLE_MS 500
+
+/// Width of a bucket in the one hour window, in ms
+#define BUCKET_MS 60000UL
+
+/// Largest number of samples which can be in the window
+#define MAX_SAMPLES (STATS_BUCKETS * BUCKET_MS / SAMPLE_MS)
+
+
+/// The statistics module publishes snapshots to this share
+Share<stats_snapshot_t> chamber_stats ("Statistics");
+
+
+/// Every sample in the window, oldest first, with the time it was taken
+static struct
+{
+    uint32_t time_ms;
+    float    value;
+} window[MAX_SAMPLES];
+
+/// Index of the oldest sample in @c window
+static uint32_t oldest;
+
+/// Number of samples in @c window
+static uint32_t count;
+
+
+/** @brief   Add a sample to the reference and drop those which have left
+ *           the window, which holds the current bucket and the 59 before it.
+ *  @param   time_ms The time of the sample
+ *  @param   value The value of the sample
+ */
+static void reference_add (uint32_t time_ms, float value)
+{
+    uint32_t seq = time_ms / BUCKET_MS;
+    uint32_t first = (seq >= STATS_BUCKETS) ? seq + 1 - STATS_BUCKETS : 0;
+    while (count > 0 && window[oldest].time_ms / BUCKET_MS < first)
+    {
+        oldest = (oldest + 1) % MAX_SAMPLES;
+        count--;
+    }
+    uint32_t where = (oldest + count++) % MAX_SAMPLES;
+    window[where].time_ms = time_ms;
+    window[where].value = value;
+}
+
+
+/** @brief   Check the statistics against the reference.
+ *  @param   stats The statistics keeper under test
+ *  @param   tolerance The largest relative error allowed in the mean's
+ *           offset from the data and in the standard deviation
+ */
+static void check (const SlidingStats& stats, double tolerance)
+{
+    double sum = 0.0;
+    float low = window[oldest].value;
+    float high = low;
+    for (uint32_t index = 0; index < count; index++)
+    {
+        float value = window[(oldest + index) % MAX_SAMPLES].value;
+        sum += value;
+        low = (value < low) ? value : low;
+        high = (value > high) ? value : high;
+    }
+    double mean = sum / count;
+    double sum_sq = 0.0;
+    for (uint32_t index = 0; index < count; index++)
+    {
+        double dev = window[(oldest + index) % MAX_SAMPLES].value - mean;
+        sum_sq += dev * dev;
+    }
+    double stddev = (count > 1) ? sqrt (sum_sq / (count - 1)) : 0.0;
+
+    window_stats_t result;
+    stats.get (result);
+    TEST_ASSERT_EQUAL_UINT32 (count, result.count);
+    TEST_ASSERT_EQUAL_FLOAT (low, result.min);
+    TEST_ASSERT_EQUAL_FLOAT (high, result.max);
+    TEST_ASSERT_FLOAT_WITHIN (tolerance * (stddev + 1e-3), mean, result.mean);
+    TEST_ASSERT_FLOAT_WITHIN (tolerance * stddev + 1e-4, stddev,
+                              result.stddev);
+}
+
+
+/** @brief   Make a repeatable pseudo-random number from -1 to 1.
+ *  @param   state The generator's state, which is changed
+ *  @return  The number
+ */
+static float noise (uint32_t& state)
+{
+    state = state * 1664525UL + 1013904223UL;
+    return (float)(state >> 8) / (float)(1UL << 23) - 1.0f;
+}
+
+
+void setUp (void)
+{
+    oldest = 0;
+    count = 0;
+}
+
+
+void tearDown (void)
+{
+}
+
+
+/** @brief   Test a steady temperature with a little sensor noise.
+ */
+void test_steady (void)
+{
+    SlidingStats stats (BUCKET_MS);
+    uint32_t state = 1;
+
+    for (uint32_t time_ms = 0; time_ms < 3 * 3600000UL; time_ms += SAMPLE_MS)
+    {
+        float value = 40.0f + 0.05f * noise (state);
+        stats.add (time_ms, value);
+        reference_add (time_ms, value);
+        check (stats, 0.01);
+    }
+}
+
+
+/** @brief   Test an hour at 20 C followed by a step to a steady 150 C.
+ *  @details The spread after the step is tiny compared with the size of the
+ *           step, which is where a shift left behind at 20 C would lose the
+ *           variance to rounding.
+ */
+void test_step_change (void)
+{
+    SlidingStats stats (BUCKET_MS);
+    uint32_t state = 2;
+
+    for (uint32_t time_ms = 0; time_ms < 4 * 3600000UL; time_ms += SAMPLE_MS)
+    {
+        float base = (time_ms < 3600000UL) ? 20.0f : 150.0f;
+        float value = base + 0.085f * noise (state);
+        stats.add (time_ms, value);
+        reference_add (time_ms, value);
+        check (stats, 0.01);
+    }
+}
+
+
+/** @brief   Test a temperature which wanders as a random walk.
+ */
+void test_random_walk (void)
+{
+    SlidingStats stats (BUCKET_MS);
+    uint32_t state = 3;
+    float value = 60.0f;
+
+    for (uint32_t time_ms = 0; time_ms < 6 * 3600000UL; time_ms += SAMPLE_MS)
+    {
+        value += 0.02f * noise (state);
+        stats.add (time_ms, value);
+        reference_add (time_ms, value);
+        check (stats, 0.01);
+    }
+}
+
+
+/** @brief   Test samples with gaps shorter and longer than the window.
+ */
+void test_gaps (void)
+{
+    SlidingStats stats (BUCKET_MS);
+    uint32_t state = 4;
+    uint32_t time_ms = 0;
+
+    for (uint32_t index = 0; index < 40000; index++)
+    {
+        float value = 30.0f + 5.0f * noise (state);
+        stats.add (time_ms, value);
+        reference_add (time_ms, value);
+        check (stats, 0.01);
+
+        // Now and then the sensor stops for a few minutes or a few hours
+        uint32_t pick = (uint32_t)((noise (state) + 1.0f) * 5000.0f);
+        time_ms += (pick == 0) ? 5 * 3600000UL
+                   : (pick < 10) ? 300000UL : SAMPLE_MS;
+    }
+}
+
+
+int main (int argc, char** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_steady);
+    RUN_TEST (test_step_change);
+    RUN_TEST (test_random_walk);
+    RUN_TEST (test_gaps);
+    return UNITY_END ();
+}
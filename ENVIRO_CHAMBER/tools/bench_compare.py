@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""Compare the benchmark results of two builds of the firmware.
+
+Build and run the benchmarks on each commit, saving the JSON they print:
+
+    pio run -e bench && .pio/build/bench/program > new.json
+    python3 tools/bench_compare.py old.json new.json
+
+Each benchmark is shown with its time per operation before and after and
+the change in percent. Benchmarks which got slower by more than the
+threshold are marked, and the exit status is 1 if there are any, so the
+script can fail a build. Times on a shared machine wander by a few percent
+from run to run, so the default threshold is 10 %.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    """Read a results file into a dictionary of ns_per_op by name."""
+    with open(path) as source:
+        results = json.load(source)
+    return {bench["name"]: bench["ns_per_op"]
+            for bench in results["benchmarks"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("before", help="results of the older build")
+    parser.add_argument("after", help="results of the newer build")
+    parser.add_argument("-t", "--threshold", type=float, default=10.0,
+                        help="slowdown in percent which counts as a "
+                             "regression (default 10)")
+    args = parser.parse_args()
+
+    before = load(args.before)
+    after = load(args.after)
+    regressions = 0
+
+    print("%-24s %12s %12s %9s" % ("benchmark", "before ns", "after ns",
+                                   "change"))
+    for name, new in after.items():
+        old = before.get(name)
+        if old is None:
+            print("%-24s %12s %12.2f %9s" % (name, "-", new, "new"))
+            continue
+        change = (new - old) * 100.0 / old if old else 0.0
+        mark = ""
+        if change > args.threshold:
+            mark = "  <-- slower"
+            regressions += 1
+        print("%-24s %12.2f %12.2f %+8.1f%%%s" % (name, old, new, change,
+                                                  mark))
+    for name in before:
+        if name not in after:
+            print("%-24s %12.2f %12s %9s" % (name, before[name], "-",
+                                             "gone"))
+
+    if regressions:
+        print("%d benchmark(s) slower by more than %.0f %%"
+              % (regressions, args.threshold), file=sys.stderr)
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+"""Decode the binary telemetry which the environmental chamber sends.
+
+Build the firmware with -DTELEMETRY_ENABLED, then read records straight from
+the serial port (this needs pyserial) or from a file which was captured
+earlier, and write them as CSV:
+
+    python3 tools/telemetry_decode.py /dev/ttyUSB0 -o samples.csv
+    python3 tools/telemetry_decode.py capture.bin > samples.csv
+
+The CSV has one header line and plain numeric columns, so it can be loaded
+with pandas.read_csv() and saved as Parquet without any conversion. Text
+which the firmware prints between frames is passed to standard error, as
+are counts of bad frames and gaps in the sequence numbers when the input
+ends. The frame format is described in src/telemetry.h.
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+RECORD = struct.Struct("<BBHIfhH")
+SAMPLE = 1
+COLUMNS = "time_us,sequence,temperature,setpoint,heater_on,dropped"
+
+
+def cobs_decode(data):
+    """Undo COBS encoding; return None if the data isn't valid COBS."""
+    out = bytearray()
+    index = 0
+    while index < len(data):
+        code = data[index]
+        if code == 0 or index + code > len(data):
+            return None
+        out += data[index + 1:index + code]
+        index += code
+        if code != 0xFF and index < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+class Decoder:
+    """Splits a byte stream into frames and turns good frames into rows."""
+
+    def __init__(self, output, text):
+        self.output = output
+        self.text = text
+        self.pending = bytearray()
+        self.good = 0
+        self.bad = 0
+        self.gaps = 0
+        self.last_sequence = None
+        self.time_base = 0
+        self.last_time = None
+
+    def feed(self, data):
+        """Handle some bytes from the input."""
+        self.pending += data
+        while True:
+            end = self.pending.find(0)
+            if end < 0:
+                break
+            chunk = bytes(self.pending[:end])
+            del self.pending[:end + 1]
+            if chunk:
+                self.frame(chunk)
+
+    def frame(self, chunk):
+        """Handle the bytes between two zeros."""
+        payload = cobs_decode(chunk)
+        if payload is None or len(payload) != RECORD.size + 4 \
+                or zlib.crc32(payload[:RECORD.size]) != \
+                struct.unpack_from("<I", payload, RECORD.size)[0] \
+                or payload[0] != SAMPLE:
+            # Printable bytes are text from the firmware, not a broken frame
+            if all(32 <= byte < 127 or byte in (9, 10, 13) for byte in chunk):
+                self.text.write(chunk.decode("ascii"))
+                self.text.flush()
+            else:
+                self.bad += 1
+            return
+
+        _, heater, sequence, time_us, temperature, setpoint, dropped = \
+            RECORD.unpack_from(payload)
+        if self.last_sequence is not None \
+                and sequence != (self.last_sequence + 1) & 0xFFFF:
+            self.gaps += 1
+        self.last_sequence = sequence
+
+        # The firmware's microsecond counter wraps every 71 minutes
+        if self.last_time is not None and time_us < self.last_time:
+            self.time_base += 1 << 32
+        self.last_time = time_us
+
+        self.good += 1
+        self.output.write("%d,%d,%.3f,%d,%d,%d\n" % (
+            self.time_base + time_us, sequence, temperature, setpoint,
+            heater, dropped))
+
+    def report(self):
+        """Print how many frames were good and bad."""
+        sys.stderr.write("%d records, %d bad frames, %d sequence gaps\n"
+                         % (self.good, self.bad, self.gaps))
+
+
+def open_input(path, baud):
+    """Open a serial port, a file, or standard input for '-'."""
+    if path == "-":
+        return sys.stdin.buffer
+    if path.startswith("/dev/") or path.upper().startswith("COM"):
+        try:
+            import serial
+        except ImportError:
+            sys.exit("reading a serial port needs pyserial: "
+                     "pip install pyserial")
+        return serial.Serial(path, baud, timeout=0.1)
+    return open(path, "rb")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("input", help="serial port, file, or - for stdin")
+    parser.add_argument("-b", "--baud", type=int, default=921600,
+                        help="baud rate of a serial port (default 921600)")
+    parser.add_argument("-o", "--output", help="CSV file (default stdout)")
+    args = parser.parse_args()
+
+    source = open_input(args.input, args.baud)
+    output = open(args.output, "w") if args.output else sys.stdout
+    output.write(COLUMNS + "\n")
+    decoder = Decoder(output, sys.stderr)
+    try:
+        while True:
+            data = source.read(4096)
+            if data is None:
+                continue
+            if not data and not hasattr(source, "in_waiting"):
+                break
+            decoder.feed(data)
+    except KeyboardInterrupt:
+        pass
+    output.flush()
+    decoder.report()
+
+
+if __name__ == "__main__":
+    main()
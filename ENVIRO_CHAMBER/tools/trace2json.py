@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""Turn an event trace dumped by the environmental chamber into a Chrome trace.
+
+Fetch a dump from a board built with -DTRACE_ENABLED and convert it:
+
+    curl -o trace.bin http://<ESP_IP>/trace
+    python3 tools/trace2json.py trace.bin trace.json
+
+then open trace.json at https://ui.perfetto.dev or in chrome://tracing. Each
+CPU core is shown as a process and each task as a thread on it; events
+recorded in interrupt service routines are shown on a thread named "ISR".
+The binary format is described in src/trace.h.
+"""
+
+import json
+import struct
+import sys
+
+MAGIC = 0x31435254
+HEADER = struct.Struct("<IHHII")
+NAME = struct.Struct("<I12s")
+EVENT = struct.Struct("<IIIHBB")
+PHASES = {0: "B", 1: "E", 2: "i", 3: "C"}
+LOCK_NAMES = {0: "log", 1: "config"}
+
+
+def read_names(data, offset, count):
+    """Read a table of names, returning it as a dictionary and the offset
+    just past it."""
+    names = {}
+    for _ in range(count):
+        key, raw = NAME.unpack_from(data, offset)
+        names[key] = raw.split(b"\0", 1)[0].decode("ascii", "replace")
+        offset += NAME.size
+    return names, offset
+
+
+def unwrap(events):
+    """Turn each core's 32 bit microsecond times, which wrap every 71
+    minutes, into times which keep increasing."""
+    last = {}
+    extra = {}
+    for event in events:
+        core = event["core"]
+        if core in last and event["time"] < last[core] - 0x80000000:
+            extra[core] = extra.get(core, 0) + 0x100000000
+        elif core in last and event["time"] > last[core] + 0x80000000:
+            # A late event from before the counter wrapped
+            event["time"] -= 0x100000000
+        last[core] = event["time"] & 0xFFFFFFFF
+        event["time"] += extra.get(core, 0)
+
+
+def convert(data):
+    """Convert a dump to a dictionary in the Chrome trace event format."""
+    magic, num_names, num_tasks, num_events, dropped = \
+        HEADER.unpack_from(data, 0)
+    if magic != MAGIC:
+        raise ValueError("not an event trace dump")
+    offset = HEADER.size
+    event_names, offset = read_names(data, offset, num_names)
+    task_names, offset = read_names(data, offset, num_tasks)
+
+    events = []
+    for _ in range(num_events):
+        time_us, task, arg, ident, kind, core = \
+            EVENT.unpack_from(data, offset)
+        offset += EVENT.size
+        events.append({"time": time_us, "task": task, "arg": arg,
+                       "id": ident, "kind": kind, "core": core})
+    unwrap(events)
+    events.sort(key=lambda event: event["time"])
+    start = events[0]["time"] if events else 0
+
+    trace = []
+    open_spans = {}
+    threads = set()
+    for event in events:
+        name = event_names.get(event["id"], "event %d" % event["id"])
+        if name.startswith("lock"):
+            name += " " + LOCK_NAMES.get(event["arg"], str(event["arg"]))
+        key = (event["core"], event["task"], name)
+
+        # Drop ends whose beginnings were written over in the ring
+        if event["kind"] == 0:
+            open_spans[key] = open_spans.get(key, 0) + 1
+        elif event["kind"] == 1:
+            if open_spans.get(key, 0) == 0:
+                continue
+            open_spans[key] -= 1
+
+        record = {"name": name, "ph": PHASES.get(event["kind"], "i"),
+                  "ts": event["time"] - start, "pid": event["core"],
+                  "tid": event["task"]}
+        if event["kind"] == 3:
+            record["args"] = {name: event["arg"]}
+        else:
+            record["args"] = {"arg": event["arg"]}
+            if event["kind"] == 2:
+                record["s"] = "t"
+        trace.append(record)
+        threads.add((event["core"], event["task"]))
+
+    for core in sorted({core for core, _ in threads}):
+        trace.append({"name": "process_name", "ph": "M", "pid": core,
+                      "args": {"name": "Core %d" % core}})
+    for core, task in sorted(threads):
+        label = "ISR" if task == 0 else \
+            task_names.get(task, "task %08x" % task)
+        trace.append({"name": "thread_name", "ph": "M", "pid": core,
+                      "tid": task, "args": {"name": label}})
+
+    return {"traceEvents": trace, "displayTimeUnit": "ms",
+            "otherData": {"events lost": dropped}}
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        sys.exit("usage: trace2json.py <dump> [<output.json>]")
+    with open(sys.argv[1], "rb") as dump:
+        result = convert(dump.read())
+    if len(sys.argv) == 3:
+        with open(sys.argv[2], "w") as output:
+            json.dump(result, output)
+    else:
+        json.dump(result, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()